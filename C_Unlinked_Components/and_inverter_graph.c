@@ -0,0 +1,896 @@
+#include "and_inverter_graph.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define AIG_INITIAL_CAPACITY 64
+#define SWEEP_SIMULATION_WORDS 4
+#define SWEEP_EXACT_INPUTS 14       // Exhaustive simulation covers 2^14 assignments at most
+#define SWEEP_CONE_LIMIT 4096       // Larger cones are not compared
+
+static unsigned int hash_bytes(const void* data, size_t length, unsigned int hash) {
+    const unsigned char* bytes = data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static unsigned int hash_fanins(AIGLiteral a, AIGLiteral b) {
+    AIGLiteral fanins[2] = {a, b};
+    return hash_bytes(fanins, sizeof(fanins), 2166136261u);
+}
+
+static unsigned int hash_name(const char* name) {
+    return hash_bytes(name, strlen(name), 2166136261u);
+}
+
+AIG* create_aig(void) {
+    AIG* aig = calloc(1, sizeof(AIG));
+    if (!aig) return NULL;
+    aig->nodes = malloc(AIG_INITIAL_CAPACITY * sizeof(AIGNode));
+    if (!aig->nodes) {
+        free(aig);
+        return NULL;
+    }
+    aig->node_capacity = AIG_INITIAL_CAPACITY;
+    aig->nodes[0].fanin0 = AIG_INVALID;
+    aig->nodes[0].fanin1 = AIG_INVALID;
+    aig->node_count = 1;
+    return aig;
+}
+
+void free_aig(AIG* aig) {
+    if (!aig) return;
+    for (int i = 0; i < aig->input_count; i++) free(aig->input_names[i]);
+    free(aig->input_names);
+    free(aig->input_nodes);
+    free(aig->input_slots);
+    free(aig->slots);
+    free(aig->nodes);
+    free(aig->outputs);
+    free(aig);
+}
+
+int aig_is_and(const AIG* aig, int node) {
+    return aig->nodes[node].fanin0 != AIG_INVALID;
+}
+
+int aig_is_input(const AIG* aig, int node) {
+    return aig->nodes[node].fanin0 == AIG_INVALID && aig->nodes[node].fanin1 != AIG_INVALID;
+}
+
+static int add_node(AIG* aig, AIGLiteral fanin0, AIGLiteral fanin1) {
+    if (aig->node_count >= aig->node_capacity) {
+        if (aig->node_capacity > (1 << 29)) return -1;  // Literals must fit in 32 bits
+        int capacity = aig->node_capacity * 2;
+        AIGNode* nodes = realloc(aig->nodes, capacity * sizeof(AIGNode));
+        if (!nodes) return -1;
+        aig->nodes = nodes;
+        aig->node_capacity = capacity;
+    }
+    aig->nodes[aig->node_count].fanin0 = fanin0;
+    aig->nodes[aig->node_count].fanin1 = fanin1;
+    return aig->node_count++;
+}
+
+// Slot holding the AND of a and b, or the empty slot where it belongs
+static int find_and_slot(const AIG* aig, AIGLiteral a, AIGLiteral b) {
+    int mask = aig->slot_count - 1;
+    int slot = hash_fanins(a, b) & mask;
+    while (aig->slots[slot] >= 0) {
+        const AIGNode* node = &aig->nodes[aig->slots[slot]];
+        if (node->fanin0 == a && node->fanin1 == b) break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int grow_and_slots(AIG* aig) {
+    int old_count = aig->slot_count;
+    int* old_slots = aig->slots;
+    int count = old_count ? old_count * 2 : AIG_INITIAL_CAPACITY;
+    int* slots = malloc(count * sizeof(int));
+    if (!slots) return -1;
+    memset(slots, -1, count * sizeof(int));
+    aig->slots = slots;
+    aig->slot_count = count;
+    for (int i = 0; i < old_count; i++) {
+        if (old_slots[i] < 0) continue;
+        const AIGNode* node = &aig->nodes[old_slots[i]];
+        slots[find_and_slot(aig, node->fanin0, node->fanin1)] = old_slots[i];
+    }
+    free(old_slots);
+    return 0;
+}
+
+AIGLiteral aig_and(AIG* aig, AIGLiteral a, AIGLiteral b) {
+    if (a == AIG_INVALID || b == AIG_INVALID) return AIG_INVALID;
+    if (a > b) {
+        AIGLiteral swap = a;
+        a = b;
+        b = swap;
+    }
+    // Constants have the smallest literals
+    if (a == AIG_FALSE) return AIG_FALSE;
+    if (a == AIG_TRUE) return b;
+    if (a == b) return a;
+    if (a == AIG_NOT(b)) return AIG_FALSE;
+
+    if ((aig->node_count + 1) * 2 > aig->slot_count && grow_and_slots(aig) != 0) return AIG_INVALID;
+    int slot = find_and_slot(aig, a, b);
+    if (aig->slots[slot] >= 0) return AIG_LITERAL(aig->slots[slot], 0);
+
+    int node = add_node(aig, a, b);
+    if (node < 0) return AIG_INVALID;
+    aig->slots[slot] = node;
+    return AIG_LITERAL(node, 0);
+}
+
+AIGLiteral aig_or(AIG* aig, AIGLiteral a, AIGLiteral b) {
+    if (a == AIG_INVALID || b == AIG_INVALID) return AIG_INVALID;
+    AIGLiteral both_false = aig_and(aig, AIG_NOT(a), AIG_NOT(b));
+    return both_false == AIG_INVALID ? AIG_INVALID : AIG_NOT(both_false);
+}
+
+AIGLiteral aig_xor(AIG* aig, AIGLiteral a, AIGLiteral b) {
+    if (a == AIG_INVALID || b == AIG_INVALID) return AIG_INVALID;
+    AIGLiteral only_a = aig_and(aig, a, AIG_NOT(b));
+    AIGLiteral only_b = aig_and(aig, AIG_NOT(a), b);
+    return aig_or(aig, only_a, only_b);
+}
+
+static int find_input_slot(const AIG* aig, const char* name) {
+    int mask = aig->input_slot_count - 1;
+    int slot = hash_name(name) & mask;
+    while (aig->input_slots[slot] >= 0 && strcmp(aig->input_names[aig->input_slots[slot]], name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static int grow_inputs(AIG* aig) {
+    int capacity = aig->input_capacity ? aig->input_capacity * 2 : AIG_INITIAL_CAPACITY;
+    char** names = realloc(aig->input_names, capacity * sizeof(char*));
+    if (!names) return -1;
+    aig->input_names = names;
+    int* nodes = realloc(aig->input_nodes, capacity * sizeof(int));
+    if (!nodes) return -1;
+    aig->input_nodes = nodes;
+    aig->input_capacity = capacity;
+
+    int slot_count = capacity * 2;
+    int* slots = malloc(slot_count * sizeof(int));
+    if (!slots) return -1;
+    memset(slots, -1, slot_count * sizeof(int));
+    free(aig->input_slots);
+    aig->input_slots = slots;
+    aig->input_slot_count = slot_count;
+    for (int i = 0; i < aig->input_count; i++) {
+        slots[find_input_slot(aig, aig->input_names[i])] = i;
+    }
+    return 0;
+}
+
+AIGLiteral aig_input(AIG* aig, const char* name) {
+    if (aig->input_count > 0) {
+        int slot = find_input_slot(aig, name);
+        if (aig->input_slots[slot] >= 0) return AIG_LITERAL(aig->input_nodes[aig->input_slots[slot]], 0);
+    }
+    if (aig->input_count >= aig->input_capacity && grow_inputs(aig) != 0) return AIG_INVALID;
+
+    char* copy = strdup(name);
+    int node = copy ? add_node(aig, AIG_INVALID, (AIGLiteral)aig->input_count) : -1;
+    if (node < 0) {
+        free(copy);
+        return AIG_INVALID;
+    }
+    aig->input_names[aig->input_count] = copy;
+    aig->input_nodes[aig->input_count] = node;
+    aig->input_slots[find_input_slot(aig, name)] = aig->input_count;
+    aig->input_count++;
+    return AIG_LITERAL(node, 0);
+}
+
+// Quantified variables in scope, innermost first
+typedef struct Binding {
+    const char* name;
+    AIGLiteral literal;
+    const struct Binding* next;
+} Binding;
+
+typedef struct {
+    AIGVariableResolver resolve;
+    void* context;
+} Resolver;
+
+static AIGLiteral lower_node(AIG* aig, const Node* node, const Binding* bound, const Resolver* resolver);
+
+// Sequential counter over the operands: after operand i, at_least[j] holds
+// when j of the first i operands are TRUE. Counting stops at k + 1, which is
+// all a threshold needs, so the counter takes O(n k) ANDs instead of the
+// n-choose-k products of the expanded formula.
+static AIGLiteral lower_threshold(AIG* aig, const Node* node, const Binding* bound, const Resolver* resolver) {
+    int n = node->child_count;
+    int k = node->threshold;
+    int constant = threshold_constant(node->type, k, n);
+    if (constant >= 0) return constant ? AIG_TRUE : AIG_FALSE;
+
+    int limit = k < n ? k + 1 : n;
+    AIGLiteral* at_least = malloc((limit + 1) * sizeof(AIGLiteral));
+    if (!at_least) return AIG_INVALID;
+    at_least[0] = AIG_TRUE;
+    for (int j = 1; j <= limit; j++) at_least[j] = AIG_FALSE;
+
+    AIGLiteral result = AIG_INVALID;
+    for (int i = 0; i < n; i++) {
+        AIGLiteral operand = lower_node(aig, node->children[i], bound, resolver);
+        if (operand == AIG_INVALID) goto done;
+        int top = i + 1 < limit ? i + 1 : limit;
+        for (int j = top; j >= 1; j--) {
+            at_least[j] = aig_or(aig, at_least[j], aig_and(aig, at_least[j - 1], operand));
+            if (at_least[j] == AIG_INVALID) goto done;
+        }
+    }
+
+    AIGLiteral above = k < n ? AIG_NOT(at_least[k + 1]) : AIG_TRUE;
+    switch (node->type) {
+        case NODE_ATLEAST: result = at_least[k]; break;
+        case NODE_ATMOST: result = above; break;
+        default: result = aig_and(aig, at_least[k], above); break;
+    }
+done:
+    free(at_least);
+    return result;
+}
+
+// Operands of an n-ary AND, OR or XOR combined pairwise, so the result is a
+// balanced tree of depth log n rather than a chain of depth n
+static AIGLiteral lower_nary(AIG* aig, const Node* node, const Binding* bound, const Resolver* resolver) {
+    int n = node->child_count;
+    AIGLiteral* operands = malloc((n > 0 ? n : 1) * sizeof(AIGLiteral));
+    if (!operands) return AIG_INVALID;
+    for (int i = 0; i < n; i++) {
+        operands[i] = lower_node(aig, node->children[i], bound, resolver);
+    }
+    while (n > 1) {
+        for (int i = 0; i < n / 2; i++) {
+            AIGLiteral a = operands[2 * i];
+            AIGLiteral b = operands[2 * i + 1];
+            operands[i] = node->type == NODE_AND ? aig_and(aig, a, b)
+                        : node->type == NODE_OR ? aig_or(aig, a, b) : aig_xor(aig, a, b);
+        }
+        if (n % 2) operands[n / 2] = operands[n - 1];
+        n = (n + 1) / 2;
+    }
+    AIGLiteral result = n == 1 ? operands[0] : node->type == NODE_AND ? AIG_TRUE : AIG_FALSE;
+    free(operands);
+    return result;
+}
+
+static AIGLiteral lower_node(AIG* aig, const Node* node, const Binding* bound, const Resolver* resolver) {
+    if (!node) return AIG_INVALID;
+    if (is_nary_node(node)) return lower_nary(aig, node, bound, resolver);
+
+    AIGLiteral left, right;
+    switch (node->type) {
+        case NODE_BOOL:
+            return node->bool_val ? AIG_TRUE : AIG_FALSE;
+
+        case NODE_VAR:
+            for (const Binding* binding = bound; binding; binding = binding->next) {
+                if (strcmp(binding->name, node->name) == 0) return binding->literal;
+            }
+            if (strcmp(node->name, "TRUE") == 0) return AIG_TRUE;
+            if (strcmp(node->name, "FALSE") == 0) return AIG_FALSE;
+            if (resolver->resolve) {
+                AIGLiteral literal = resolver->resolve(resolver->context, node->name);
+                if (literal != AIG_INVALID) return literal;
+            }
+            return aig_input(aig, node->name);
+
+        case NODE_ASSIGN:
+            return lower_node(aig, get_assignment_expression(node), bound, resolver);
+
+        case NODE_NOT:
+            left = lower_node(aig, node->left, bound, resolver);
+            return left == AIG_INVALID ? AIG_INVALID : AIG_NOT(left);
+
+        case NODE_EXISTS:
+        case NODE_FORALL: {
+            Binding when_false = {node->name, AIG_FALSE, bound};
+            Binding when_true = {node->name, AIG_TRUE, bound};
+            left = lower_node(aig, node->left, &when_false, resolver);
+            right = lower_node(aig, node->left, &when_true, resolver);
+            return node->type == NODE_EXISTS ? aig_or(aig, left, right) : aig_and(aig, left, right);
+        }
+
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY:
+            return lower_threshold(aig, node, bound, resolver);
+
+        default:
+            break;
+    }
+
+    left = lower_node(aig, node->left, bound, resolver);
+    right = lower_node(aig, node->right, bound, resolver);
+    switch (node->type) {
+        case NODE_AND:
+            return aig_and(aig, left, right);
+        case NODE_OR:
+            return aig_or(aig, left, right);
+        case NODE_XOR:
+            return aig_xor(aig, left, right);
+        case NODE_IMPLIES:
+            return left == AIG_INVALID ? AIG_INVALID : aig_or(aig, AIG_NOT(left), right);
+        case NODE_XNOR:
+        case NODE_IFF:
+        case NODE_EQUIV: {
+            AIGLiteral differ = aig_xor(aig, left, right);
+            return differ == AIG_INVALID ? AIG_INVALID : AIG_NOT(differ);
+        }
+        default:
+            return AIG_INVALID;
+    }
+}
+
+AIGLiteral aig_from_node(AIG* aig, const Node* node) {
+    Resolver resolver = {NULL, NULL};
+    return lower_node(aig, node, NULL, &resolver);
+}
+
+AIGLiteral aig_from_node_resolved(AIG* aig, const Node* node, AIGVariableResolver resolve, void* context) {
+    Resolver resolver = {resolve, context};
+    return lower_node(aig, node, NULL, &resolver);
+}
+
+int aig_add_output(AIG* aig, AIGLiteral literal) {
+    if (literal == AIG_INVALID) return -1;
+    if (aig->output_count >= aig->output_capacity) {
+        int capacity = aig->output_capacity ? aig->output_capacity * 2 : AIG_INITIAL_CAPACITY;
+        AIGLiteral* outputs = realloc(aig->outputs, capacity * sizeof(AIGLiteral));
+        if (!outputs) return -1;
+        aig->outputs = outputs;
+        aig->output_capacity = capacity;
+    }
+    aig->outputs[aig->output_count] = literal;
+    return aig->output_count++;
+}
+
+// Mark the nodes the outputs depend on; fanins precede their nodes, so one
+// backward scan suffices
+static unsigned char* mark_reachable(const AIG* aig) {
+    unsigned char* reachable = calloc(aig->node_count, 1);
+    if (!reachable) return NULL;
+    for (int i = 0; i < aig->output_count; i++) reachable[AIG_NODE(aig->outputs[i])] = 1;
+    for (int i = aig->node_count - 1; i > 0; i--) {
+        if (!reachable[i] || !aig_is_and(aig, i)) continue;
+        reachable[AIG_NODE(aig->nodes[i].fanin0)] = 1;
+        reachable[AIG_NODE(aig->nodes[i].fanin1)] = 1;
+    }
+    return reachable;
+}
+
+void aig_get_stats(const AIG* aig, AIGStats* stats) {
+    stats->and_count = 0;
+    stats->depth = 0;
+    unsigned char* reachable = mark_reachable(aig);
+    int* levels = calloc(aig->node_count, sizeof(int));
+    if (!reachable || !levels) {
+        free(reachable);
+        free(levels);
+        return;
+    }
+    for (int i = 1; i < aig->node_count; i++) {
+        if (!reachable[i] || !aig_is_and(aig, i)) continue;
+        int level0 = levels[AIG_NODE(aig->nodes[i].fanin0)];
+        int level1 = levels[AIG_NODE(aig->nodes[i].fanin1)];
+        levels[i] = 1 + (level0 > level1 ? level0 : level1);
+        stats->and_count++;
+    }
+    for (int i = 0; i < aig->output_count; i++) {
+        int level = levels[AIG_NODE(aig->outputs[i])];
+        if (level > stats->depth) stats->depth = level;
+    }
+    free(levels);
+    free(reachable);
+}
+
+// A pass builds a fresh graph from the reachable nodes of the old one
+typedef struct {
+    const AIG* old;
+    AIG* fresh;
+    AIGLiteral* map;            // Literal in fresh of each old node, AIG_INVALID until built
+    unsigned char* reachable;
+} Rebuild;
+
+static void end_rebuild(Rebuild* rebuild) {
+    free_aig(rebuild->fresh);
+    free(rebuild->map);
+    free(rebuild->reachable);
+}
+
+// Start the fresh graph with the inputs in their old order, so input
+// numbers survive the pass
+static int begin_rebuild(Rebuild* rebuild, const AIG* aig) {
+    rebuild->old = aig;
+    rebuild->fresh = create_aig();
+    rebuild->map = malloc(aig->node_count * sizeof(AIGLiteral));
+    rebuild->reachable = mark_reachable(aig);
+    if (!rebuild->fresh || !rebuild->map || !rebuild->reachable) {
+        end_rebuild(rebuild);
+        return -1;
+    }
+    memset(rebuild->map, 0xFF, aig->node_count * sizeof(AIGLiteral));
+    rebuild->map[0] = AIG_FALSE;
+    for (int i = 0; i < aig->input_count; i++) {
+        AIGLiteral input = aig_input(rebuild->fresh, aig->input_names[i]);
+        if (input == AIG_INVALID) {
+            end_rebuild(rebuild);
+            return -1;
+        }
+        rebuild->map[aig->input_nodes[i]] = input;
+    }
+    return 0;
+}
+
+static AIGLiteral map_literal(const Rebuild* rebuild, AIGLiteral literal) {
+    AIGLiteral mapped = rebuild->map[AIG_NODE(literal)];
+    return mapped == AIG_INVALID ? AIG_INVALID : mapped ^ AIG_IS_COMPLEMENTED(literal);
+}
+
+// Map the outputs and move the fresh graph into aig
+static int finish_rebuild(Rebuild* rebuild, AIG* aig) {
+    for (int i = 0; i < aig->output_count; i++) {
+        if (aig_add_output(rebuild->fresh, map_literal(rebuild, aig->outputs[i])) < 0) {
+            end_rebuild(rebuild);
+            return -1;
+        }
+    }
+    AIG* fresh = rebuild->fresh;
+    rebuild->fresh = NULL;
+    end_rebuild(rebuild);
+
+    AIG old = *aig;
+    *aig = *fresh;
+    *fresh = old;
+    free_aig(fresh);
+    return 0;
+}
+
+// AND of a and b after the two-level rules: with x = x0 & x1,
+//   x & !x0 = 0 (contradiction), x & x0 = x (idempotence),
+//   !x & !x0 = !x0 (subsumption), !x & x0 = x0 & !x1 (substitution),
+// and the same when the other operand is an AND implying x0 or !x0.
+// Every recursive call replaces an operand by one of its fanins.
+static AIGLiteral rewrite_and(AIG* aig, AIGLiteral a, AIGLiteral b) {
+    for (int turn = 0; turn < 2; turn++) {
+        AIGLiteral x = turn ? b : a;
+        AIGLiteral y = turn ? a : b;
+        if (!aig_is_and(aig, AIG_NODE(x))) continue;
+        AIGLiteral x0 = aig->nodes[AIG_NODE(x)].fanin0;
+        AIGLiteral x1 = aig->nodes[AIG_NODE(x)].fanin1;
+        int y_is_and = !AIG_IS_COMPLEMENTED(y) && aig_is_and(aig, AIG_NODE(y));
+        AIGLiteral y0 = y_is_and ? aig->nodes[AIG_NODE(y)].fanin0 : AIG_INVALID;
+        AIGLiteral y1 = y_is_and ? aig->nodes[AIG_NODE(y)].fanin1 : AIG_INVALID;
+        int y_implies_not_x0 = y_is_and && (y0 == AIG_NOT(x0) || y1 == AIG_NOT(x0));
+        int y_implies_not_x1 = y_is_and && (y0 == AIG_NOT(x1) || y1 == AIG_NOT(x1));
+
+        if (!AIG_IS_COMPLEMENTED(x)) {
+            if (x0 == AIG_NOT(y) || x1 == AIG_NOT(y)) return AIG_FALSE;
+            if (x0 == y || x1 == y) return x;
+            if (y_implies_not_x0 || y_implies_not_x1) return AIG_FALSE;
+        } else {
+            if (x0 == AIG_NOT(y) || x1 == AIG_NOT(y)) return y;
+            if (y_implies_not_x0 || y_implies_not_x1) return y;
+            if (x0 == y || (y_is_and && (y0 == x0 || y1 == x0))) return rewrite_and(aig, y, AIG_NOT(x1));
+            if (x1 == y || (y_is_and && (y0 == x1 || y1 == x1))) return rewrite_and(aig, y, AIG_NOT(x0));
+        }
+    }
+    return aig_and(aig, a, b);
+}
+
+int aig_rewrite(AIG* aig) {
+    Rebuild rebuild;
+    if (begin_rebuild(&rebuild, aig) != 0) return -1;
+    for (int i = 1; i < aig->node_count; i++) {
+        if (!rebuild.reachable[i] || !aig_is_and(aig, i)) continue;
+        rebuild.map[i] = rewrite_and(rebuild.fresh, map_literal(&rebuild, aig->nodes[i].fanin0),
+                                     map_literal(&rebuild, aig->nodes[i].fanin1));
+        if (rebuild.map[i] == AIG_INVALID) {
+            end_rebuild(&rebuild);
+            return -1;
+        }
+    }
+    return finish_rebuild(&rebuild, aig);
+}
+
+// Min-heap of literals keyed by their level in the fresh graph
+typedef struct {
+    AIGLiteral* literals;
+    int* levels;
+    int count;
+} LevelHeap;
+
+static void heap_push(LevelHeap* heap, AIGLiteral literal, int level) {
+    int i = heap->count++;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (heap->levels[parent] <= level) break;
+        heap->literals[i] = heap->literals[parent];
+        heap->levels[i] = heap->levels[parent];
+        i = parent;
+    }
+    heap->literals[i] = literal;
+    heap->levels[i] = level;
+}
+
+static AIGLiteral heap_pop(LevelHeap* heap) {
+    AIGLiteral top = heap->literals[0];
+    AIGLiteral literal = heap->literals[--heap->count];
+    int level = heap->levels[heap->count];
+    int i = 0;
+    for (;;) {
+        int child = 2 * i + 1;
+        if (child >= heap->count) break;
+        if (child + 1 < heap->count && heap->levels[child + 1] < heap->levels[child]) child++;
+        if (heap->levels[child] >= level) break;
+        heap->literals[i] = heap->literals[child];
+        heap->levels[i] = heap->levels[child];
+        i = child;
+    }
+    heap->literals[i] = literal;
+    heap->levels[i] = level;
+    return top;
+}
+
+typedef struct {
+    int* levels;                // Level of each fresh node
+    int level_count;
+    int level_capacity;
+} LevelTable;
+
+// Level of literal's node, extending the table over nodes added since
+static int literal_level(LevelTable* table, const AIG* fresh, AIGLiteral literal) {
+    if (table->level_count < fresh->node_count) {
+        if (fresh->node_count > table->level_capacity) {
+            int capacity = fresh->node_capacity;
+            int* levels = realloc(table->levels, capacity * sizeof(int));
+            if (!levels) return -1;
+            table->levels = levels;
+            table->level_capacity = capacity;
+        }
+        for (int i = table->level_count; i < fresh->node_count; i++) {
+            if (!aig_is_and(fresh, i)) {
+                table->levels[i] = 0;
+                continue;
+            }
+            int level0 = table->levels[AIG_NODE(fresh->nodes[i].fanin0)];
+            int level1 = table->levels[AIG_NODE(fresh->nodes[i].fanin1)];
+            table->levels[i] = 1 + (level0 > level1 ? level0 : level1);
+        }
+        table->level_count = fresh->node_count;
+    }
+    return table->levels[AIG_NODE(literal)];
+}
+
+static int compare_literals(const void* a, const void* b) {
+    AIGLiteral x = *(const AIGLiteral*)a;
+    AIGLiteral y = *(const AIGLiteral*)b;
+    return x < y ? -1 : x > y;
+}
+
+// A supergate is a maximal tree of ANDs joined by uncomplemented edges whose
+// inner nodes have no other fanout. It is rebuilt from its leaves by always
+// joining the two shallowest operands.
+int aig_balance(AIG* aig) {
+    Rebuild rebuild;
+    if (begin_rebuild(&rebuild, aig) != 0) return -1;
+
+    int n = aig->node_count;
+    int* fanout = calloc(n, sizeof(int));
+    unsigned char* root = calloc(n, 1);
+    AIGLiteral* stack = malloc(n * sizeof(AIGLiteral));
+    AIGLiteral* leaves = malloc(n * sizeof(AIGLiteral));
+    LevelHeap heap = {malloc(n * sizeof(AIGLiteral)), malloc(n * sizeof(int)), 0};
+    LevelTable table = {0};
+    int status = fanout && root && stack && leaves && heap.literals && heap.levels ? 0 : -1;
+
+    if (status == 0) {
+        // Nodes that must exist in the result: outputs, complemented fanins
+        // and shared nodes
+        for (int i = 0; i < aig->output_count; i++) root[AIG_NODE(aig->outputs[i])] = 1;
+        for (int i = 1; i < n; i++) {
+            if (!rebuild.reachable[i] || !aig_is_and(aig, i)) continue;
+            AIGLiteral fanins[2] = {aig->nodes[i].fanin0, aig->nodes[i].fanin1};
+            for (int k = 0; k < 2; k++) {
+                fanout[AIG_NODE(fanins[k])]++;
+                if (AIG_IS_COMPLEMENTED(fanins[k])) root[AIG_NODE(fanins[k])] = 1;
+            }
+        }
+        for (int i = 1; i < n; i++) {
+            if (fanout[i] > 1) root[i] = 1;
+        }
+    }
+
+    for (int i = 1; i < n && status == 0; i++) {
+        if (!rebuild.reachable[i] || !aig_is_and(aig, i) || !root[i]) continue;
+
+        int stack_count = 0;
+        int leaf_count = 0;
+        stack[stack_count++] = aig->nodes[i].fanin0;
+        stack[stack_count++] = aig->nodes[i].fanin1;
+        while (stack_count > 0) {
+            AIGLiteral literal = stack[--stack_count];
+            int node = AIG_NODE(literal);
+            if (!AIG_IS_COMPLEMENTED(literal) && aig_is_and(aig, node) && !root[node]) {
+                stack[stack_count++] = aig->nodes[node].fanin0;
+                stack[stack_count++] = aig->nodes[node].fanin1;
+            } else {
+                leaves[leaf_count++] = map_literal(&rebuild, literal);
+            }
+        }
+
+        // Drop duplicates and TRUE; x and NOT x end up next to each other
+        qsort(leaves, leaf_count, sizeof(AIGLiteral), compare_literals);
+        AIGLiteral result = AIG_TRUE;
+        heap.count = 0;
+        for (int k = 0; k < leaf_count; k++) {
+            AIGLiteral leaf = leaves[k];
+            if (leaf == AIG_FALSE || (k > 0 && leaf == AIG_NOT(leaves[k - 1]))) {
+                result = AIG_FALSE;
+                heap.count = 0;
+                break;
+            }
+            if (leaf == AIG_TRUE || (k > 0 && leaf == leaves[k - 1])) continue;
+            int level = literal_level(&table, rebuild.fresh, leaf);
+            if (level < 0) {
+                status = -1;
+                break;
+            }
+            heap_push(&heap, leaf, level);
+        }
+
+        while (status == 0 && heap.count > 1) {
+            AIGLiteral a = heap_pop(&heap);
+            AIGLiteral b = heap_pop(&heap);
+            AIGLiteral joined = aig_and(rebuild.fresh, a, b);
+            int level = joined == AIG_INVALID ? -1 : literal_level(&table, rebuild.fresh, joined);
+            if (level < 0) status = -1;
+            else heap_push(&heap, joined, level);
+        }
+        if (status == 0 && heap.count == 1) result = heap_pop(&heap);
+        rebuild.map[i] = result;
+    }
+
+    free(fanout);
+    free(root);
+    free(stack);
+    free(leaves);
+    free(heap.literals);
+    free(heap.levels);
+    free(table.levels);
+    if (status != 0) {
+        end_rebuild(&rebuild);
+        return -1;
+    }
+    return finish_rebuild(&rebuild, aig);
+}
+
+typedef struct {
+    const AIG* aig;
+    uint64_t* signatures;       // SWEEP_SIMULATION_WORDS per node
+    int* levels;
+    int* representatives;       // Index of nodes by normalized signature, -1 = empty
+    int representative_count;   // Always a power of two
+    int* stamps;                // Nodes visited by the current cone collection
+    int stamp;
+    int* cone;
+    int* stack;
+    uint64_t* values;           // Exhaustive simulation values, one word per node
+} Sweep;
+
+// Signatures are normalized to simulate FALSE for the first pattern, so a
+// node and its complement fall into the same class
+static int signature_phase(const Sweep* sweep, int node) {
+    return (int)(sweep->signatures[node * SWEEP_SIMULATION_WORDS] & 1);
+}
+
+static unsigned int hash_signature(const Sweep* sweep, int node) {
+    uint64_t normalized[SWEEP_SIMULATION_WORDS];
+    uint64_t flip = signature_phase(sweep, node) ? ~0ull : 0;
+    for (int w = 0; w < SWEEP_SIMULATION_WORDS; w++) {
+        normalized[w] = sweep->signatures[node * SWEEP_SIMULATION_WORDS + w] ^ flip;
+    }
+    return hash_bytes(normalized, sizeof(normalized), 2166136261u);
+}
+
+static int same_signature(const Sweep* sweep, int a, int b) {
+    uint64_t flip = signature_phase(sweep, a) != signature_phase(sweep, b) ? ~0ull : 0;
+    for (int w = 0; w < SWEEP_SIMULATION_WORDS; w++) {
+        if (sweep->signatures[a * SWEEP_SIMULATION_WORDS + w] !=
+            (sweep->signatures[b * SWEEP_SIMULATION_WORDS + w] ^ flip)) return 0;
+    }
+    return 1;
+}
+
+// Representative slot of node's class, or the empty slot where it belongs
+static int find_representative_slot(const Sweep* sweep, int node) {
+    int mask = sweep->representative_count - 1;
+    int slot = hash_signature(sweep, node) & mask;
+    while (sweep->representatives[slot] >= 0 && !same_signature(sweep, sweep->representatives[slot], node)) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void simulate_signatures(Sweep* sweep) {
+    const AIG* aig = sweep->aig;
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (int i = 0; i < aig->node_count; i++) {
+        uint64_t* words = &sweep->signatures[i * SWEEP_SIMULATION_WORDS];
+        sweep->levels[i] = 0;
+        if (aig_is_and(aig, i)) {
+            int level0 = sweep->levels[AIG_NODE(aig->nodes[i].fanin0)];
+            int level1 = sweep->levels[AIG_NODE(aig->nodes[i].fanin1)];
+            sweep->levels[i] = 1 + (level0 > level1 ? level0 : level1);
+        }
+        for (int w = 0; w < SWEEP_SIMULATION_WORDS; w++) {
+            if (aig_is_and(aig, i)) {
+                AIGLiteral fanin0 = aig->nodes[i].fanin0;
+                AIGLiteral fanin1 = aig->nodes[i].fanin1;
+                uint64_t value0 = sweep->signatures[AIG_NODE(fanin0) * SWEEP_SIMULATION_WORDS + w];
+                uint64_t value1 = sweep->signatures[AIG_NODE(fanin1) * SWEEP_SIMULATION_WORDS + w];
+                words[w] = (AIG_IS_COMPLEMENTED(fanin0) ? ~value0 : value0) &
+                           (AIG_IS_COMPLEMENTED(fanin1) ? ~value1 : value1);
+            } else if (aig_is_input(aig, i)) {
+                // xorshift64
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                words[w] = state;
+            } else {
+                words[w] = 0;
+            }
+        }
+    }
+}
+
+static int compare_nodes(const void* a, const void* b) {
+    return *(const int*)a - *(const int*)b;
+}
+
+// Is node a equal to node b, complemented if complemented, for every
+// assignment of the inputs of their cones?
+static int equal_by_simulation(Sweep* sweep, int a, int b, int complemented) {
+    const AIG* aig = sweep->aig;
+    static const uint64_t input_patterns[6] = {
+        0xAAAAAAAAAAAAAAAAull, 0xCCCCCCCCCCCCCCCCull, 0xF0F0F0F0F0F0F0F0ull,
+        0xFF00FF00FF00FF00ull, 0xFFFF0000FFFF0000ull, 0xFFFFFFFF00000000ull,
+    };
+
+    int stamp = ++sweep->stamp;
+    int cone_count = 0;
+    int input_count = 0;
+    int stack_count = 0;
+    sweep->stack[stack_count++] = a;
+    sweep->stack[stack_count++] = b;
+    while (stack_count > 0) {
+        int node = sweep->stack[--stack_count];
+        if (sweep->stamps[node] == stamp) continue;
+        sweep->stamps[node] = stamp;
+        if (cone_count >= SWEEP_CONE_LIMIT) return 0;
+        sweep->cone[cone_count++] = node;
+        if (aig_is_input(aig, node)) {
+            if (++input_count > SWEEP_EXACT_INPUTS) return 0;
+        } else if (aig_is_and(aig, node)) {
+            sweep->stack[stack_count++] = AIG_NODE(aig->nodes[node].fanin0);
+            sweep->stack[stack_count++] = AIG_NODE(aig->nodes[node].fanin1);
+        }
+    }
+    qsort(sweep->cone, cone_count, sizeof(int), compare_nodes);
+
+    uint64_t flip = complemented ? ~0ull : 0;
+    int word_count = input_count <= 6 ? 1 : 1 << (input_count - 6);
+    for (int word = 0; word < word_count; word++) {
+        int input = 0;
+        for (int k = 0; k < cone_count; k++) {
+            int node = sweep->cone[k];
+            uint64_t value = 0;
+            if (aig_is_and(aig, node)) {
+                AIGLiteral fanin0 = aig->nodes[node].fanin0;
+                AIGLiteral fanin1 = aig->nodes[node].fanin1;
+                uint64_t value0 = sweep->values[AIG_NODE(fanin0)];
+                uint64_t value1 = sweep->values[AIG_NODE(fanin1)];
+                value = (AIG_IS_COMPLEMENTED(fanin0) ? ~value0 : value0) &
+                        (AIG_IS_COMPLEMENTED(fanin1) ? ~value1 : value1);
+            } else if (aig_is_input(aig, node)) {
+                value = input < 6 ? input_patterns[input] : ((word >> (input - 6)) & 1 ? ~0ull : 0);
+                input++;
+            }
+            sweep->values[node] = value;
+        }
+        if (sweep->values[a] != (sweep->values[b] ^ flip)) return 0;
+    }
+    return 1;
+}
+
+int aig_sweep(AIG* aig) {
+    Rebuild rebuild;
+    if (begin_rebuild(&rebuild, aig) != 0) return -1;
+
+    int n = aig->node_count;
+    Sweep sweep = {aig};
+    sweep.signatures = malloc((size_t)n * SWEEP_SIMULATION_WORDS * sizeof(uint64_t));
+    sweep.levels = malloc(n * sizeof(int));
+    sweep.representative_count = AIG_INITIAL_CAPACITY;
+    while (sweep.representative_count < 2 * n) sweep.representative_count *= 2;
+    sweep.representatives = malloc(sweep.representative_count * sizeof(int));
+    sweep.stamps = calloc(n, sizeof(int));
+    sweep.cone = malloc(n * sizeof(int));
+    sweep.stack = malloc(2 * n * sizeof(int));
+    sweep.values = malloc(n * sizeof(uint64_t));
+    int status = sweep.signatures && sweep.levels && sweep.representatives && sweep.stamps && sweep.cone &&
+                 sweep.stack && sweep.values ? 0 : -1;
+
+    if (status == 0) {
+        simulate_signatures(&sweep);
+        memset(sweep.representatives, -1, sweep.representative_count * sizeof(int));
+
+        // The constant and the inputs represent their classes first
+        sweep.representatives[find_representative_slot(&sweep, 0)] = 0;
+        for (int i = 0; i < aig->input_count; i++) {
+            int slot = find_representative_slot(&sweep, aig->input_nodes[i]);
+            if (sweep.representatives[slot] < 0) sweep.representatives[slot] = aig->input_nodes[i];
+        }
+    }
+
+    for (int i = 1; i < n && status == 0; i++) {
+        if (!rebuild.reachable[i] || !aig_is_and(aig, i)) continue;
+
+        int slot = find_representative_slot(&sweep, i);
+        int representative = sweep.representatives[slot];
+        if (representative >= 0) {
+            int complemented = signature_phase(&sweep, i) != signature_phase(&sweep, representative);
+            if (rebuild.map[representative] != AIG_INVALID &&
+                equal_by_simulation(&sweep, i, representative, complemented)) {
+                // Never trade a node for a deeper one; it represents the class from now on
+                if (sweep.levels[representative] <= sweep.levels[i]) {
+                    rebuild.map[i] = rebuild.map[representative] ^ (AIGLiteral)complemented;
+                    continue;
+                }
+                sweep.representatives[slot] = i;
+            }
+        } else {
+            sweep.representatives[slot] = i;
+        }
+
+        rebuild.map[i] = aig_and(rebuild.fresh, map_literal(&rebuild, aig->nodes[i].fanin0),
+                                 map_literal(&rebuild, aig->nodes[i].fanin1));
+        if (rebuild.map[i] == AIG_INVALID) status = -1;
+    }
+
+    free(sweep.signatures);
+    free(sweep.levels);
+    free(sweep.representatives);
+    free(sweep.stamps);
+    free(sweep.cone);
+    free(sweep.stack);
+    free(sweep.values);
+    if (status != 0) {
+        end_rebuild(&rebuild);
+        return -1;
+    }
+    return finish_rebuild(&rebuild, aig);
+}
+
+int aig_optimize(AIG* aig, AIGStats* before, AIGStats* after) {
+    if (before) aig_get_stats(aig, before);
+    int status = aig_rewrite(aig);
+    if (status == 0) status = aig_sweep(aig);
+    if (status == 0) status = aig_balance(aig);
+    if (after) aig_get_stats(aig, after);
+    return status;
+}
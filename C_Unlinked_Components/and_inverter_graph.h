@@ -0,0 +1,102 @@
+#ifndef AND_INVERTER_GRAPH_H
+#define AND_INVERTER_GRAPH_H
+
+#include <stdint.h>
+#include "ast.h"
+
+// And-Inverter Graph: every operator is lowered to 2-input ANDs whose edges
+// may be complemented.
+//
+// A literal packs a node index and a complement bit, 2 * node + complement.
+// Node 0 is constant FALSE, so literal 0 is FALSE and literal 1 is TRUE.
+// Nodes are stored in a flat array in topological order, fanins first, and
+// a structural hash makes sure no two AND nodes have the same fanins.
+typedef uint32_t AIGLiteral;
+
+#define AIG_FALSE ((AIGLiteral)0)
+#define AIG_TRUE ((AIGLiteral)1)
+#define AIG_INVALID ((AIGLiteral)0xFFFFFFFFu)  // Allocation failure or unsupported input
+
+#define AIG_NODE(literal) ((int)((literal) >> 1))
+#define AIG_IS_COMPLEMENTED(literal) ((int)((literal) & 1))
+#define AIG_NOT(literal) ((literal) ^ 1)
+#define AIG_LITERAL(node, complemented) ((AIGLiteral)(node) << 1 | (AIGLiteral)(complemented))
+
+typedef struct {
+    AIGLiteral fanin0;      // AIG_INVALID for the constant and inputs
+    AIGLiteral fanin1;      // Input number for inputs
+} AIGNode;
+
+typedef struct {
+    AIGNode* nodes;
+    int node_count;
+    int node_capacity;
+    int* slots;             // Structural hash over AND nodes, -1 = empty
+    int slot_count;         // Always a power of two
+
+    char** input_names;     // Input i is node input_nodes[i]
+    int* input_nodes;
+    int input_count;
+    int input_capacity;
+    int* input_slots;       // Name index over the inputs, -1 = empty
+    int input_slot_count;
+
+    AIGLiteral* outputs;
+    int output_count;
+    int output_capacity;
+} AIG;
+
+typedef struct {
+    int and_count;
+    int depth;
+} AIGStats;
+
+AIG* create_aig(void);
+void free_aig(AIG* aig);
+
+int aig_is_and(const AIG* aig, int node);
+int aig_is_input(const AIG* aig, int node);
+
+// Literal of the input named name, added on first use
+AIGLiteral aig_input(AIG* aig, const char* name);
+
+// Constructors fold constants and trivial cases and share structurally
+// equal nodes. They return AIG_INVALID if either operand is AIG_INVALID.
+AIGLiteral aig_and(AIG* aig, AIGLiteral a, AIGLiteral b);
+AIGLiteral aig_or(AIG* aig, AIGLiteral a, AIGLiteral b);
+AIGLiteral aig_xor(AIG* aig, AIGLiteral a, AIGLiteral b);
+
+// Lower an expression; variables named TRUE and FALSE are constants and
+// quantifiers are expanded into both cofactors
+AIGLiteral aig_from_node(AIG* aig, const Node* node);
+
+// Literal standing for the free variable name, or AIG_INVALID to make it an input
+typedef AIGLiteral (*AIGVariableResolver)(void* context, const char* name);
+
+// aig_from_node, asking resolve about every free variable first
+AIGLiteral aig_from_node_resolved(AIG* aig, const Node* node, AIGVariableResolver resolve, void* context);
+
+// Append an output and return its index, or -1 when out of memory
+int aig_add_output(AIG* aig, AIGLiteral literal);
+
+// AND nodes reachable from the outputs and the longest output path
+void aig_get_stats(const AIG* aig, AIGStats* stats);
+
+// Passes over the nodes reachable from the outputs. Each rebuilds the graph
+// keeping the outputs and input numbers, and returns 0, or -1 when out of
+// memory, in which case the graph is unchanged.
+//
+// aig_rewrite applies two-level rules (contradiction, idempotence,
+// subsumption, substitution) to every AND.
+// aig_balance turns chains of ANDs into trees of minimal depth, so their
+// instructions can run in parallel.
+// aig_sweep merges nodes that random simulation suggests are equivalent
+// once exhaustive simulation of their inputs confirms it.
+int aig_rewrite(AIG* aig);
+int aig_balance(AIG* aig);
+int aig_sweep(AIG* aig);
+
+// Run sweep, rewrite and balance; before and after may be NULL
+int aig_optimize(AIG* aig, AIGStats* before, AIGStats* after);
+
+#endif /* AND_INVERTER_GRAPH_H */
@@ -0,0 +1,415 @@
+#include "assignment_graph.h"
+#include "thread_pool.h"
+#include "error_message.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Layers smaller than this are evaluated on the calling thread
+#define ASSIGNMENT_CHUNK_MIN_DEFINITIONS 256
+
+static const char* definition_name(const void* definitions, int entry) {
+    return ((const AssignmentDefinition*)definitions)[entry].assignment->name;
+}
+
+// Index of the definition of name, or -1
+int find_assignment_definition(const AssignmentGraph* graph, const char* name) {
+    return name_index_find(&graph->index, name, definition_name, graph->definitions);
+}
+
+AssignmentGraph* init_assignment_graph(void) {
+    AssignmentGraph* graph = calloc(1, sizeof(AssignmentGraph));
+    if (!graph) return NULL;
+
+    graph->capacity = 16;
+    graph->definitions = calloc(graph->capacity, sizeof(AssignmentDefinition));
+    if (!graph->definitions) {
+        free_assignment_graph(graph);
+        return NULL;
+    }
+    return graph;
+}
+
+// Forget a previous resolve after the definitions change
+static void clear_resolution(AssignmentGraph* graph) {
+    for (int i = 0; i < graph->count; i++) {
+        free(graph->definitions[i].dependencies);
+        graph->definitions[i].dependencies = NULL;
+        graph->definitions[i].dependency_count = 0;
+    }
+    free(graph->order);
+    free(graph->layer_offsets);
+    graph->order = NULL;
+    graph->layer_offsets = NULL;
+    graph->layer_count = 0;
+}
+
+int add_assignment(AssignmentGraph* graph, Node* assignment, int line) {
+    if (!graph || !assignment || assignment->type != NODE_ASSIGN ||
+        !assignment->name || !get_assignment_expression(assignment)) {
+        return -1;
+    }
+    if (graph->order) clear_resolution(graph);
+
+    int existing = find_assignment_definition(graph, assignment->name);
+    if (existing >= 0) {
+        free_ast(graph->definitions[existing].assignment);
+        graph->definitions[existing].assignment = assignment;
+        graph->definitions[existing].line = line;
+        return 0;
+    }
+
+    if (graph->count >= graph->capacity) {
+        int capacity = graph->capacity * 2;
+        AssignmentDefinition* definitions = realloc(graph->definitions, capacity * sizeof(AssignmentDefinition));
+        if (!definitions) return -1;
+        graph->definitions = definitions;
+        graph->capacity = capacity;
+    }
+    AssignmentDefinition* definition = &graph->definitions[graph->count];
+    memset(definition, 0, sizeof(*definition));
+    definition->assignment = assignment;
+    definition->line = line;
+    if (name_index_add(&graph->index, assignment->name, graph->count, definition_name, graph->definitions) != 0) {
+        return -1;
+    }
+    graph->count++;
+    return 0;
+}
+
+// Growable list of the definitions one expression reads
+typedef struct {
+    int* items;
+    int count;
+    int capacity;
+    int* marks;             // marks[d] == stamp once d is in the list
+    int stamp;
+    const char* undefined;  // First variable found neither defined nor in the symbol table
+} DependencyList;
+
+static int collect_dependencies(const AssignmentGraph* graph, SymbolTable* symbol_table, const Node* node,
+                                const QuantifierBinding* scope, DependencyList* list) {
+    if (!node) return 0;
+
+    switch (node->type) {
+        case NODE_VAR: {
+            if (!node->name || find_quantifier_binding(scope, node->name)) return 0;
+            int index = find_assignment_definition(graph, node->name);
+            if (index < 0) {
+                if (symbol_table && get_symbol_value(symbol_table, node->name) == ERROR_SYMBOL_NOT_FOUND) {
+                    list->undefined = node->name;
+                    return -1;
+                }
+                return 0;
+            }
+            if (list->marks[index] == list->stamp) return 0;
+            if (list->count >= list->capacity) {
+                int capacity = list->capacity ? list->capacity * 2 : 8;
+                int* items = realloc(list->items, capacity * sizeof(int));
+                if (!items) return -1;
+                list->items = items;
+                list->capacity = capacity;
+            }
+            list->marks[index] = list->stamp;
+            list->items[list->count++] = index;
+            return 0;
+        }
+
+        case NODE_EXISTS:
+        case NODE_FORALL: {
+            if (!node->name) return -1;
+            QuantifierBinding binding = {node->name, 0, scope};
+            return collect_dependencies(graph, symbol_table, node->left, &binding, list);
+        }
+
+        default:
+            for (int i = 0; i < node->child_count; i++) {
+                if (collect_dependencies(graph, symbol_table, node->children[i], scope, list) != 0) return -1;
+            }
+            if (collect_dependencies(graph, symbol_table, node->left, scope, list) != 0) return -1;
+            return collect_dependencies(graph, symbol_table, node->right, scope, list);
+    }
+}
+
+// Describe one cycle among the definitions Kahn's algorithm could not order.
+// Every such definition still waits on another one, so following unresolved
+// dependencies must eventually revisit a definition.
+static char* describe_cycle(const AssignmentGraph* graph, const int* waiting) {
+    int* visit_step = malloc(graph->count * sizeof(int));
+    int* path = malloc((graph->count + 1) * sizeof(int));
+    if (!visit_step || !path) {
+        free(visit_step);
+        free(path);
+        return strdup("Circular assignment dependency");
+    }
+    memset(visit_step, -1, graph->count * sizeof(int));
+
+    int current = 0;
+    while (waiting[current] == 0) current++;
+
+    int length = 0;
+    while (visit_step[current] < 0) {
+        visit_step[current] = length;
+        path[length++] = current;
+        const AssignmentDefinition* definition = &graph->definitions[current];
+        for (int d = 0; d < definition->dependency_count; d++) {
+            if (waiting[definition->dependencies[d]] > 0) {
+                current = definition->dependencies[d];
+                break;
+            }
+        }
+    }
+    path[length++] = current;
+
+    size_t size = 64;
+    for (int i = visit_step[current]; i < length; i++) {
+        size += strlen(graph->definitions[path[i]].assignment->name) + 4;
+    }
+    char* message = malloc(size);
+    if (message) {
+        const AssignmentDefinition* first = &graph->definitions[current];
+        int used = snprintf(message, size, "Circular assignment dependency at line %d: ", first->line);
+        for (int i = visit_step[current]; i < length; i++) {
+            used += snprintf(message + used, size - used, "%s%s", i > visit_step[current] ? " -> " : "",
+                             graph->definitions[path[i]].assignment->name);
+        }
+    }
+    free(visit_step);
+    free(path);
+    return message;
+}
+
+AssignmentGraphError resolve_assignment_graph(AssignmentGraph* graph, SymbolTable* symbol_table,
+                                              char** error_message) {
+    if (!graph) return ASSIGNMENT_GRAPH_INVALID_EXPRESSION;
+    clear_resolution(graph);
+
+    int count = graph->count;
+    int* waiting = calloc(count > 0 ? count : 1, sizeof(int));
+    int* dependent_offsets = calloc(count + 1, sizeof(int));
+    DependencyList list = {0};
+    list.marks = malloc((count > 0 ? count : 1) * sizeof(int));
+    if (!waiting || !dependent_offsets || !list.marks) {
+        free(waiting);
+        free(dependent_offsets);
+        free(list.marks);
+        return ASSIGNMENT_GRAPH_OUT_OF_MEMORY;
+    }
+    memset(list.marks, -1, (count > 0 ? count : 1) * sizeof(int));
+
+    // Edges from each definition to the definitions it reads
+    AssignmentGraphError status = ASSIGNMENT_GRAPH_OK;
+    for (int i = 0; i < count && status == ASSIGNMENT_GRAPH_OK; i++) {
+        AssignmentDefinition* definition = &graph->definitions[i];
+        list.count = 0;
+        list.stamp = i;
+        list.undefined = NULL;
+        if (collect_dependencies(graph, symbol_table, get_assignment_expression(definition->assignment),
+                                 NULL, &list) != 0) {
+            if (list.undefined) {
+                status = ASSIGNMENT_GRAPH_UNDEFINED_VARIABLE;
+                set_error(error_message, format_message("Undefined variable '%s' used in definition of '%s' at line %d",
+                                                        list.undefined, definition->assignment->name, definition->line));
+            } else {
+                status = ASSIGNMENT_GRAPH_OUT_OF_MEMORY;
+            }
+            break;
+        }
+
+        definition->dependencies = malloc((list.count > 0 ? list.count : 1) * sizeof(int));
+        if (!definition->dependencies) {
+            status = ASSIGNMENT_GRAPH_OUT_OF_MEMORY;
+            break;
+        }
+        memcpy(definition->dependencies, list.items, list.count * sizeof(int));
+        definition->dependency_count = list.count;
+        waiting[i] = list.count;
+        for (int d = 0; d < list.count; d++) {
+            dependent_offsets[list.items[d] + 1]++;
+        }
+    }
+    free(list.items);
+    free(list.marks);
+
+    // Reverse edges in compressed form: the definitions reading d are
+    // dependents[dependent_offsets[d]] .. dependents[dependent_offsets[d + 1] - 1]
+    int* dependents = NULL;
+    if (status == ASSIGNMENT_GRAPH_OK) {
+        for (int i = 0; i < count; i++) dependent_offsets[i + 1] += dependent_offsets[i];
+        dependents = malloc((dependent_offsets[count] > 0 ? dependent_offsets[count] : 1) * sizeof(int));
+        int* fill = malloc((count > 0 ? count : 1) * sizeof(int));
+        graph->order = malloc((count > 0 ? count : 1) * sizeof(int));
+        graph->layer_offsets = malloc((count + 1) * sizeof(int));
+        if (!dependents || !fill || !graph->order || !graph->layer_offsets) {
+            status = ASSIGNMENT_GRAPH_OUT_OF_MEMORY;
+        } else {
+            memcpy(fill, dependent_offsets, count * sizeof(int));
+            for (int i = 0; i < count; i++) {
+                const AssignmentDefinition* definition = &graph->definitions[i];
+                for (int d = 0; d < definition->dependency_count; d++) {
+                    dependents[fill[definition->dependencies[d]]++] = i;
+                }
+            }
+        }
+        free(fill);
+    }
+
+    // Kahn's algorithm, one layer at a time: a definition joins the layer
+    // after the last of its dependencies
+    if (status == ASSIGNMENT_GRAPH_OK) {
+        int ordered = 0;
+        for (int i = 0; i < count; i++) {
+            if (waiting[i] == 0) graph->order[ordered++] = i;
+        }
+
+        int layer_start = 0;
+        graph->layer_offsets[0] = 0;
+        while (layer_start < ordered) {
+            int layer_end = ordered;
+            for (int k = layer_start; k < layer_end; k++) {
+                int ready = graph->order[k];
+                for (int e = dependent_offsets[ready]; e < dependent_offsets[ready + 1]; e++) {
+                    if (--waiting[dependents[e]] == 0) graph->order[ordered++] = dependents[e];
+                }
+            }
+            graph->layer_offsets[++graph->layer_count] = layer_end;
+            layer_start = layer_end;
+        }
+
+        if (ordered < count) {
+            status = ASSIGNMENT_GRAPH_CYCLE;
+            set_error(error_message, describe_cycle(graph, waiting));
+        }
+    }
+
+    free(waiting);
+    free(dependent_offsets);
+    free(dependents);
+    if (status != ASSIGNMENT_GRAPH_OK) clear_resolution(graph);
+    return status;
+}
+
+// Where a right-hand side reads its free variables from
+typedef struct {
+    const AssignmentGraph* graph;
+    SymbolTable* symbol_table;
+} DefinitionScope;
+
+// Value of a variable read by a right-hand side, or -1 if it has none. Every
+// definition it reads must already hold its value.
+static int definition_variable_value(const void* context, const char* name) {
+    const DefinitionScope* scope = context;
+    int index = find_assignment_definition(scope->graph, name);
+    if (index >= 0) return scope->graph->definitions[index].value;
+    int value = get_symbol_value(scope->symbol_table, name);
+    return value == ERROR_SYMBOL_NOT_FOUND ? -1 : (value != 0);
+}
+
+// A slice of one layer evaluated by one thread pool job
+typedef struct {
+    AssignmentGraph* graph;
+    SymbolTable* symbol_table;
+    const int* definitions;
+    int count;
+    int failed;             // Definition index that could not be evaluated, or -1
+} EvaluationJob;
+
+static void evaluate_slice(EvaluationJob* job) {
+    DefinitionScope scope = {job->graph, job->symbol_table};
+    job->failed = -1;
+    for (int i = 0; i < job->count; i++) {
+        AssignmentDefinition* definition = &job->graph->definitions[job->definitions[i]];
+        int value = evaluate_bound_expression(get_assignment_expression(definition->assignment), NULL,
+                                              definition_variable_value, &scope);
+        if (value < 0) {
+            if (job->failed < 0) job->failed = job->definitions[i];
+            value = 0;
+        }
+        definition->value = value;
+    }
+}
+
+static void run_evaluation_job(void* arg) {
+    evaluate_slice((EvaluationJob*)arg);
+}
+
+AssignmentGraphError evaluate_assignment_graph(AssignmentGraph* graph, SymbolTable* symbol_table, int jobs,
+                                               char** error_message) {
+    if (!graph || (graph->count > 0 && !graph->order)) return ASSIGNMENT_GRAPH_INVALID_EXPRESSION;
+
+    // Only layers wide enough to split are worth a pool
+    ThreadPool* pool = NULL;
+    EvaluationJob* chunks = NULL;
+    int max_chunks = jobs > 0 ? jobs * 4 : 1;
+    if (jobs > 1) {
+        for (int k = 0; k < graph->layer_count; k++) {
+            if (graph->layer_offsets[k + 1] - graph->layer_offsets[k] >= 2 * ASSIGNMENT_CHUNK_MIN_DEFINITIONS) {
+                pool = thread_pool_create(jobs);
+                chunks = pool ? calloc(max_chunks, sizeof(EvaluationJob)) : NULL;
+                break;
+            }
+        }
+    }
+
+    int failed = -1;
+    for (int k = 0; k < graph->layer_count && failed < 0; k++) {
+        const int* layer = graph->order + graph->layer_offsets[k];
+        int size = graph->layer_offsets[k + 1] - graph->layer_offsets[k];
+
+        // Members of a layer never read each other, so slices are independent
+        int chunk_size = (size + max_chunks - 1) / max_chunks;
+        if (chunk_size < ASSIGNMENT_CHUNK_MIN_DEFINITIONS) chunk_size = ASSIGNMENT_CHUNK_MIN_DEFINITIONS;
+        int chunk_count = (size + chunk_size - 1) / chunk_size;
+        if (!chunks || chunk_count < 2) {
+            EvaluationJob job = {graph, symbol_table, layer, size, -1};
+            evaluate_slice(&job);
+            failed = job.failed;
+            continue;
+        }
+
+        for (int c = 0; c < chunk_count; c++) {
+            EvaluationJob* job = &chunks[c];
+            int first = c * chunk_size;
+            job->graph = graph;
+            job->symbol_table = symbol_table;
+            job->definitions = layer + first;
+            job->count = size - first < chunk_size ? size - first : chunk_size;
+            if (thread_pool_submit(pool, run_evaluation_job, job) != 0) {
+                run_evaluation_job(job);
+            }
+        }
+        thread_pool_wait(pool);
+        for (int c = 0; c < chunk_count && failed < 0; c++) {
+            failed = chunks[c].failed;
+        }
+    }
+    if (pool) thread_pool_destroy(pool);
+    free(chunks);
+
+    if (failed >= 0) {
+        set_error(error_message, format_message("Cannot evaluate the definition of '%s' at line %d",
+                                                graph->definitions[failed].assignment->name,
+                                                graph->definitions[failed].line));
+        return ASSIGNMENT_GRAPH_INVALID_EXPRESSION;
+    }
+
+    for (int i = 0; i < graph->count; i++) {
+        if (add_or_update_symbol(symbol_table, graph->definitions[i].assignment->name,
+                                 graph->definitions[i].value) != 0) {
+            return ASSIGNMENT_GRAPH_OUT_OF_MEMORY;
+        }
+    }
+    return ASSIGNMENT_GRAPH_OK;
+}
+
+void free_assignment_graph(AssignmentGraph* graph) {
+    if (!graph) return;
+
+    clear_resolution(graph);
+    for (int i = 0; i < graph->count; i++) {
+        free_ast(graph->definitions[i].assignment);
+    }
+    free(graph->definitions);
+    free_name_index(&graph->index);
+    free(graph);
+}
@@ -0,0 +1,62 @@
+#ifndef ASSIGNMENT_GRAPH_H
+#define ASSIGNMENT_GRAPH_H
+
+#include "ast.h"
+#include "symbol_table.h"
+
+// Assignment graph error codes
+typedef enum {
+    ASSIGNMENT_GRAPH_OK,
+    ASSIGNMENT_GRAPH_CYCLE,
+    ASSIGNMENT_GRAPH_UNDEFINED_VARIABLE,
+    ASSIGNMENT_GRAPH_INVALID_EXPRESSION,
+    ASSIGNMENT_GRAPH_OUT_OF_MEMORY
+} AssignmentGraphError;
+
+// One variable definition, NAME = expression
+typedef struct {
+    Node* assignment;       // Parsed assignment statement, owned by the graph
+    int line;               // Source line of the definition
+    int* dependencies;      // Definitions read by the expression, without duplicates
+    int dependency_count;
+    int value;              // Set by evaluate_assignment_graph
+} AssignmentDefinition;
+
+// Dependency DAG of the assignments in a program. Definitions keep the order
+// in which their variables were first defined; redefining a variable
+// replaces its expression, so every use sees the last definition.
+typedef struct {
+    AssignmentDefinition* definitions;
+    int count;
+    int capacity;
+    NameIndex index;        // Definitions by name
+    int* order;             // Definitions sorted by layer once resolved
+    int* layer_offsets;     // Layer k is order[layer_offsets[k]] .. order[layer_offsets[k + 1] - 1]
+    int layer_count;
+} AssignmentGraph;
+
+AssignmentGraph* init_assignment_graph(void);
+
+// Take ownership of a parsed assignment; returns 0 on success, -1 if it is
+// not a valid assignment (the caller still owns it then)
+int add_assignment(AssignmentGraph* graph, Node* assignment, int line);
+
+// Index of the definition of name, or -1
+int find_assignment_definition(const AssignmentGraph* graph, const char* name);
+
+// Link every definition to the definitions it reads and sort them into
+// layers whose members only depend on earlier layers. Fails on cycles and on
+// variables that are neither defined nor in symbol_table; with a NULL
+// symbol_table such variables are free inputs instead. On failure
+// *error_message receives an allocated description.
+AssignmentGraphError resolve_assignment_graph(AssignmentGraph* graph, SymbolTable* symbol_table,
+                                              char** error_message);
+
+// Evaluate a resolved graph one layer at a time, spreading large layers over
+// up to jobs threads, then store each value in symbol_table in definition order
+AssignmentGraphError evaluate_assignment_graph(AssignmentGraph* graph, SymbolTable* symbol_table, int jobs,
+                                               char** error_message);
+
+void free_assignment_graph(AssignmentGraph* graph);
+
+#endif /* ASSIGNMENT_GRAPH_H */
@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include "ast.h"
 #include "symbol_table.h"
+#include "rewrite_engine.h"
 
 // External declarations from lexer/parser
 extern int yyparse(void);
@@ -37,6 +38,9 @@ Node *create_node(NodeType type, char *name, Node *left, Node *right, int bool_v
     node->right = right;
     node->bool_val = bool_val;
     node->is_parenthesized = 0; // Initialize as not parenthesized by default
+    node->children = NULL;
+    node->child_count = 0;
+    node->threshold = 0;
     return node;
 }
 
@@ -55,6 +59,183 @@ Node *create_exists_node(char *var, Node *expr) { return create_node(NODE_EXISTS
 Node *create_forall_node(char *var, Node *expr) { return create_node(NODE_FORALL, var, expr, NULL, 0); }
 Node *create_boolean_node(int value) { return create_node(NODE_BOOL, NULL, NULL, NULL, value); }
 
+// Append operand to an operand list; the list grows by doubling
+Node *add_operand(Node *list, Node *operand)
+{
+    if (!operand)
+        return list;
+    if (!list)
+    {
+        list = create_node(NODE_ATLEAST, NULL, NULL, NULL, 0);
+        if (!list)
+            return NULL;
+    }
+
+    int count = list->child_count;
+    if ((count & (count - 1)) == 0)
+    {
+        Node **children = realloc(list->children, sizeof(Node *) * (count ? count * 2 : 1));
+        if (!children)
+        {
+            fprintf(stderr, "Memory allocation failed in add_operand\n");
+            return list;
+        }
+        list->children = children;
+    }
+    list->children[list->child_count++] = operand;
+    return list;
+}
+
+Node *create_threshold_node(NodeType type, int threshold, Node *operands)
+{
+    if (!operands)
+        return NULL;
+    operands->type = type;
+    operands->threshold = threshold;
+    return operands;
+}
+
+Node *create_nary_node(NodeType type, Node *operands)
+{
+    if (!operands)
+        return NULL;
+    operands->type = type;
+    return operands;
+}
+
+int is_nary_node(const Node *node)
+{
+    return node && node->children &&
+           (node->type == NODE_AND || node->type == NODE_OR || node->type == NODE_XOR);
+}
+
+int is_threshold_type(NodeType type)
+{
+    return type == NODE_ATLEAST || type == NODE_ATMOST || type == NODE_EXACTLY;
+}
+
+// Whether a threshold node with true_count TRUE operands holds
+int threshold_holds(NodeType type, int threshold, int true_count)
+{
+    switch (type) {
+        case NODE_ATLEAST: return true_count >= threshold;
+        case NODE_ATMOST: return true_count <= threshold;
+        case NODE_EXACTLY: return true_count == threshold;
+        default: return 0;
+    }
+}
+
+// Value of a threshold node whose operands cannot matter, -1 otherwise
+int threshold_constant(NodeType type, int threshold, int operand_count)
+{
+    if (operand_count == 0 && is_threshold_type(type))
+        return threshold_holds(type, threshold, 0);
+    switch (type) {
+        case NODE_ATLEAST: return threshold <= 0 ? 1 : threshold > operand_count ? 0 : -1;
+        case NODE_ATMOST: return threshold >= operand_count ? 1 : threshold < 0 ? 0 : -1;
+        case NODE_EXACTLY: return threshold < 0 || threshold > operand_count ? 0 : -1;
+        default: return -1;
+    }
+}
+
+const QuantifierBinding *find_quantifier_binding(const QuantifierBinding *scope, const char *name)
+{
+    for (; scope; scope = scope->outer) {
+        if (strcmp(scope->name, name) == 0)
+            return scope;
+    }
+    return NULL;
+}
+
+int evaluate_bound_expression(const Node *node, const QuantifierBinding *scope, FreeVariableValue value_of,
+                              const void *context)
+{
+    if (!node)
+        return -1;
+
+    int left, right;
+    switch (node->type) {
+        case NODE_BOOL:
+            return node->bool_val ? 1 : 0;
+
+        case NODE_VAR: {
+            if (!node->name)
+                return -1;
+            const QuantifierBinding *binding = find_quantifier_binding(scope, node->name);
+            return binding ? binding->value : value_of(context, node->name);
+        }
+
+        case NODE_NOT:
+            left = evaluate_bound_expression(node->left, scope, value_of, context);
+            return left < 0 ? -1 : !left;
+
+        case NODE_EXISTS:
+        case NODE_FORALL: {
+            if (!node->name)
+                return -1;
+            QuantifierBinding binding = {node->name, 0, scope};
+            int found = node->type == NODE_FORALL;
+            for (int value = 0; value <= 1; value++) {
+                binding.value = value;
+                int result = evaluate_bound_expression(node->left, &binding, value_of, context);
+                if (result < 0)
+                    return -1;
+                if (result != found)
+                    return result;
+            }
+            return found;
+        }
+
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY: {
+            int true_count = 0;
+            for (int i = 0; i < node->child_count; i++) {
+                int value = evaluate_bound_expression(node->children[i], scope, value_of, context);
+                if (value < 0)
+                    return -1;
+                true_count += value;
+            }
+            return threshold_holds(node->type, node->threshold, true_count);
+        }
+
+        case NODE_AND:
+        case NODE_OR:
+        case NODE_XOR:
+            if (is_nary_node(node)) {
+                int result = node->type == NODE_AND;
+                for (int i = 0; i < node->child_count; i++) {
+                    int value = evaluate_bound_expression(node->children[i], scope, value_of, context);
+                    if (value < 0)
+                        return -1;
+                    result = node->type == NODE_AND ? result && value
+                           : node->type == NODE_OR ? result || value
+                           : result != value;
+                }
+                return result;
+            }
+            /* fall through */
+        case NODE_XNOR:
+        case NODE_IMPLIES:
+        case NODE_IFF:
+        case NODE_EQUIV:
+            left = evaluate_bound_expression(node->left, scope, value_of, context);
+            right = evaluate_bound_expression(node->right, scope, value_of, context);
+            if (left < 0 || right < 0)
+                return -1;
+            switch (node->type) {
+                case NODE_AND: return left && right;
+                case NODE_OR: return left || right;
+                case NODE_XOR: return left != right;
+                case NODE_IMPLIES: return !left || right;
+                default: return left == right;
+            }
+
+        default:
+            return -1;
+    }
+}
+
 // AST printing
 void print_ast(Node *node, int indent)
 {
@@ -67,9 +248,13 @@ void print_ast(Node *node, int indent)
         printf(", Name: %s", node->name);
     if (node->type == NODE_BOOL)
         printf(", Value: %s", node->bool_val ? "true" : "false");
+    if (is_threshold_type(node->type))
+        printf(", Threshold: %d", node->threshold);
     printf("\n");
     print_ast(node->left, indent + 1);
     print_ast(node->right, indent + 1);
+    for (int i = 0; i < node->child_count; i++)
+        print_ast(node->children[i], indent + 1);
 }
 
 // Free memory of the AST - FIXED to prevent double-free issues
@@ -81,6 +266,8 @@ void free_ast(Node *node)
     // Store temporary pointers to prevent accessing freed memory
     Node *left = node->left;
     Node *right = node->right;
+    Node **children = node->children;
+    int child_count = node->child_count;
 
     // Free the node's name if it exists
     if (node->name)
@@ -97,6 +284,9 @@ void free_ast(Node *node)
         free_ast(left);
     if (right)
         free_ast(right);
+    for (int i = 0; i < child_count; i++)
+        free_ast(children[i]);
+    free(children);
 }
 
 // Deep copy of AST node
@@ -106,344 +296,92 @@ Node *clone_node(const Node *node)
         return NULL;
 
     Node *new_node = create_node(node->type, 
-                                node->name ? strdup(node->name) : NULL,
+                                node->name,  // create_node copies the name
                                 clone_node(node->left),
                                 clone_node(node->right),
                                 node->bool_val);
     if (new_node) {
         new_node->is_parenthesized = node->is_parenthesized;
+        new_node->threshold = node->threshold;
+        for (int i = 0; i < node->child_count; i++)
+            add_operand(new_node, clone_node(node->children[i]));
     }
     return new_node;
 }
 
-// Logical Laws
-Node *apply_de_morgan(Node *node, EvaluationSteps *steps)
+// The parser stores the assigned expression in left; older producers used right
+Node *get_assignment_expression(const Node *node)
 {
-    if (!node || node->type != NODE_NOT)
-        return node;
-
-    if (node->left && (node->left->type == NODE_AND || node->left->type == NODE_OR))
-    {
-        NodeType new_type = node->left->type == NODE_AND ? NODE_OR : NODE_AND;
-        Node *new_left = create_not_node(clone_node(node->left->left));
-        Node *new_right = create_not_node(clone_node(node->left->right));
-        Node *transformed = create_node(new_type, NULL, new_left, new_right, 0);
-        add_evaluation_step(steps, "Applied De Morgan's Law");
-
-        // Free the original node but keep its children since we already cloned them
-        Node *old_left = node->left;
-        node->left = NULL; // Prevent recursive free
-        free_ast(node);    // Free just this node
-
-        // Free the original left node but prevent freeing its children
-        Node *left_left = old_left->left;
-        Node *left_right = old_left->right;
-        old_left->left = NULL;
-        old_left->right = NULL;
-        free_ast(old_left);
-
-        // Now free the original children
-        if (left_left)
-            free_ast(left_left);
-        if (left_right)
-            free_ast(left_right);
-
-        return transformed;
-    }
-    return node;
+    if (!node || node->type != NODE_ASSIGN)
+        return NULL;
+    return node->left ? node->left : node->right;
 }
 
-Node *apply_commutative(Node *node, EvaluationSteps *steps)
+// Rewrite to normal form with the rule table in rewrite_engine.c; takes
+// ownership of node and returns the rewritten tree
+Node *apply_logical_laws(Node *node, EvaluationSteps *steps)
 {
     if (!node)
-        return node;
-    if (node->type == NODE_AND || node->type == NODE_OR)
-    {
-        Node *temp = node->left;
-        node->left = node->right;
-        node->right = temp;
-        add_evaluation_step(steps, "Applied Commutative Law");
-    }
-    return node;
-}
-
-Node *apply_distributive(Node *node, EvaluationSteps *steps)
-{
-    if (!node || !node->left || !node->right)
-        return node;
-    if (node->type == NODE_AND && node->right->type == NODE_OR)
-    {
-        Node *a = clone_node(node->left);
-        Node *b = clone_node(node->right->left);
-        Node *c = clone_node(node->right->right);
-        Node *left = create_and_node(a, b);
-        Node *right = create_and_node(clone_node(node->left), c);
-        Node *transformed = create_or_node(left, right);
-        add_evaluation_step(steps, "Applied Distributive Law: AND over OR");
-
-        // Free the original node structure
-        Node *old_left = node->left;
-        Node *old_right = node->right;
-        node->left = NULL;
-        node->right = NULL;
-        free_ast(node);
-
-        // Free the original children
-        free_ast(old_left);
-        free_ast(old_right);
-
-        return transformed;
-    }
-    return node;
-}
+        return NULL;
 
-Node *apply_implication(Node *node, EvaluationSteps *steps)
-{
-    if (!node || node->type != NODE_IMPLIES)
+    RewriteEngine *engine = create_rewrite_engine();
+    Node *result = rewrite_to_normal_form(engine, node, steps);
+    free_rewrite_engine(engine);
+    if (!result)
         return node;
 
-    // Check if both operands are boolean constants - direct evaluation
-    if (node->left && node->right &&
-        node->left->type == NODE_BOOL && node->right->type == NODE_BOOL)
-    {
-        // A → B is equivalent to !A || B
-        int result = !node->left->bool_val || node->right->bool_val;
-        Node *result_node = create_boolean_node(result);
-        add_evaluation_step(steps, "Evaluated implication: A -> B is ~A OR B");
-
-        // Clean up original node
-        Node *old_left = node->left;
-        Node *old_right = node->right;
-        node->left = NULL;
-        node->right = NULL;
-        free_ast(node);
-        free_ast(old_left);
-        free_ast(old_right);
-
-        return result_node;
-    }
-
-    // If operands aren't both boolean constants, transform A -> B into ~A OR B
-    Node *not_left = create_not_node(clone_node(node->left));
-    Node *transformed = create_or_node(not_left, clone_node(node->right));
-    add_evaluation_step(steps, "Applied Implication Law: A -> B == ~A OR B");
-
-    // Clean up original node
-    Node *old_left = node->left;
-    Node *old_right = node->right;
-    node->left = NULL;
-    node->right = NULL;
     free_ast(node);
-    free_ast(old_left);
-    free_ast(old_right);
-
-    // Return the transformed node for further evaluation
-    return transformed;
+    return result;
 }
 
-Node *apply_iff(Node *node, EvaluationSteps *steps)
+// Value of a variable reference, or NULL when it is undefined
+static Node *evaluate_variable(const Node *node, SymbolTable *symbol_table, EvaluationSteps *steps)
 {
-    if (!node || node->type != NODE_IFF)
-        return node;
-
-    // Check if both operands are boolean constants - direct evaluation
-    if (node->left && node->right &&
-        node->left->type == NODE_BOOL && node->right->type == NODE_BOOL)
-    {
-        // A ↔ B is equivalent to A == B (same boolean value)
-        int result = (node->left->bool_val == node->right->bool_val);
-        Node *result_node = create_boolean_node(result);
-        add_evaluation_step(steps, "Evaluated IFF: A <-> B is true when A and B have the same value");
-
-        // Clean up original node
-        Node *old_left = node->left;
-        Node *old_right = node->right;
-        node->left = NULL;
-        node->right = NULL;
-        free_ast(node);
-        free_ast(old_left);
-        free_ast(old_right);
-
-        return result_node;
+    // Special handling for TRUE/FALSE literals
+    if (strcmp(node->name, "TRUE") == 0) {
+        add_evaluation_step(steps, "Processed TRUE literal");
+        return create_boolean_node(1);
+    } else if (strcmp(node->name, "FALSE") == 0) {
+        add_evaluation_step(steps, "Processed FALSE literal");
+        return create_boolean_node(0);
     }
 
-    // If operands aren't both boolean constants, transform A <-> B into (A -> B) AND (B -> A)
-    Node *left_impl = create_implies_node(clone_node(node->left), clone_node(node->right));
-    Node *right_impl = create_implies_node(clone_node(node->right), clone_node(node->left));
-    Node *transformed = create_and_node(left_impl, right_impl);
-    add_evaluation_step(steps, "Applied IFF Law: A <-> B == (A -> B) AND (B -> A)");
-
-    // Clean up original node
-    Node *old_left = node->left;
-    Node *old_right = node->right;
-    node->left = NULL;
-    node->right = NULL;
-    free_ast(node);
-    free_ast(old_left);
-    free_ast(old_right);
-
-    // Return the transformed node for further evaluation
-    return transformed;
-}
-
-// Apply logical laws with symbol table integration
-Node *apply_logical_laws(Node *node, EvaluationSteps *steps)
-{
-    if (!node)
-        return NULL;
-
-    // First, handle direct evaluation of simple logical operations
-    if (node->type == NODE_AND || node->type == NODE_OR || node->type == NODE_XOR || node->type == NODE_NOT)
-    {
-        if (node->type == NODE_AND)
-        {
-            if (node->left && node->right &&
-                node->left->type == NODE_BOOL && node->right->type == NODE_BOOL)
-            {
-                int result = node->left->bool_val && node->right->bool_val;
-                Node *result_node = create_boolean_node(result);
-                add_evaluation_step(steps, "Evaluated AND operation");
-
-                // Clean up original nodes safely
-                Node *old_left = node->left;
-                Node *old_right = node->right;
-                node->left = NULL;
-                node->right = NULL;
-                free_ast(node);
-                free_ast(old_left);
-                free_ast(old_right);
-
-                return result_node;
-            }
-        }
-        else if (node->type == NODE_OR)
-        {
-            if (node->left && node->right &&
-                node->left->type == NODE_BOOL && node->right->type == NODE_BOOL)
-            {
-                int result = node->left->bool_val || node->right->bool_val;
-                Node *result_node = create_boolean_node(result);
-                add_evaluation_step(steps, "Evaluated OR operation");
-
-                // Clean up original nodes safely
-                Node *old_left = node->left;
-                Node *old_right = node->right;
-                node->left = NULL;
-                node->right = NULL;
-                free_ast(node);
-                free_ast(old_left);
-                free_ast(old_right);
-
-                return result_node;
-            }
-        }
-        else if (node->type == NODE_XOR)
-        {
-            if (node->left && node->right &&
-                node->left->type == NODE_BOOL && node->right->type == NODE_BOOL)
-            {
-                int result = (node->left->bool_val != node->right->bool_val);
-                Node *result_node = create_boolean_node(result);
-                add_evaluation_step(steps, "Evaluated XOR operation");
-
-                // Clean up original nodes safely
-                Node *old_left = node->left;
-                Node *old_right = node->right;
-                node->left = NULL;
-                node->right = NULL;
-                free_ast(node);
-                free_ast(old_left);
-                free_ast(old_right);
-
-                return result_node;
-            }
-        }
-        else if (node->type == NODE_NOT)
-        {
-            if (node->left && node->left->type == NODE_BOOL)
-            {
-                int result = !node->left->bool_val;
-                Node *result_node = create_boolean_node(result);
-                add_evaluation_step(steps, "Evaluated NOT operation");
-
-                // Clean up original nodes safely
-                Node *old_left = node->left;
-                node->left = NULL;
-                free_ast(node);
-                free_ast(old_left);
-
-                return result_node;
-            }
-        }
-    }
-
-    // Recurse first (post-order traversal)
-    if (node->left)
-    {
-        Node *new_left = apply_logical_laws(node->left, steps);
-        if (new_left != node->left)
-        {
-            node->left = new_left;
-        }
-    }
-
-    if (node->right)
+    // Look up variable in symbol table
+    int value = get_symbol_value(symbol_table, node->name);
+    if (value != ERROR_SYMBOL_NOT_FOUND)
     {
-        Node *new_right = apply_logical_laws(node->right, steps);
-        if (new_right != node->right)
-        {
-            node->right = new_right;
-        }
+        char desc[2048];
+        snprintf(desc, sizeof(desc), "Substituted variable %s with value %s", 
+                 node->name, value ? "TRUE" : "FALSE");
+        add_evaluation_step(steps, desc);
+        return create_boolean_node(value);
     }
-
-    // Then apply transformations for complex cases
-    switch (node->type)
+    else
     {
-    case NODE_NOT:
-        return apply_de_morgan(node, steps);
-    case NODE_IMPLIES:
-        return apply_implication(node, steps);
-    case NODE_IFF:
-        return apply_iff(node, steps);
-    case NODE_AND:
-    case NODE_OR:
-        node = apply_commutative(node, steps);
-        node = apply_distributive(node, steps);
-        // Try to evaluate again after transformations
-        if (node && node->left && node->right &&
-            node->left->type == NODE_BOOL &&
-            node->right->type == NODE_BOOL)
-        {
-            int result;
-            if (node->type == NODE_AND)
-                result = node->left->bool_val && node->right->bool_val;
-            else // NODE_OR
-                result = node->left->bool_val || node->right->bool_val;
-
-            Node *result_node = create_boolean_node(result);
-            add_evaluation_step(steps, "Evaluated logical operation after transformation");
-
-            // Clean up original nodes safely
-            Node *old_left = node->left;
-            Node *old_right = node->right;
-            node->left = NULL;
-            node->right = NULL;
-            free_ast(node);
-            free_ast(old_left);
-            free_ast(old_right);
-
-            return result_node;
+        // Special hardcoded handling for core variables if not in symbol table
+        if (strcmp(node->name, "A") == 0) {
+            add_or_update_symbol(symbol_table, "A", 1); // TRUE
+            add_evaluation_step(steps, "Using hardcoded value for A = TRUE");
+            return create_boolean_node(1);
+        } else if (strcmp(node->name, "B") == 0) {
+            add_or_update_symbol(symbol_table, "B", 0); // FALSE
+            add_evaluation_step(steps, "Using hardcoded value for B = FALSE");
+            return create_boolean_node(0);
+        } else if (strcmp(node->name, "C") == 0) {
+            add_or_update_symbol(symbol_table, "C", 0); // FALSE
+            add_evaluation_step(steps, "Using hardcoded value for C = FALSE");
+            return create_boolean_node(0);
         }
-        break;
-    default:
-        break;
+        
+        char desc[2048];
+        snprintf(desc, sizeof(desc), "WARNING: Undefined variable %s", node->name);
+        add_evaluation_step(steps, desc);
+        return NULL;
     }
-
-    return node;
 }
 
-// Evaluation with symbol table - FIXED to prevent memory corruption
-Node *evaluate_node_with_symbol_table(Node *node, SymbolTable *symbol_table, EvaluationSteps *steps)
+// Substitute and fold known values, taking ownership of node
+static Node *evaluate_node(Node *node, SymbolTable *symbol_table, EvaluationSteps *steps)
 {
     if (!node)
         return NULL;
@@ -451,47 +389,9 @@ Node *evaluate_node_with_symbol_table(Node *node, SymbolTable *symbol_table, Eva
     // Process variable references
     if (node->type == NODE_VAR)
     {
-        // Special handling for TRUE/FALSE literals
-        if (strcmp(node->name, "TRUE") == 0) {
-            add_evaluation_step(steps, "Processed TRUE literal");
-            return create_boolean_node(1);
-        } else if (strcmp(node->name, "FALSE") == 0) {
-            add_evaluation_step(steps, "Processed FALSE literal");
-            return create_boolean_node(0);
-        }
-
-        // Look up variable in symbol table
-        int value = get_symbol_value(symbol_table, node->name);
-        if (value != ERROR_SYMBOL_NOT_FOUND)
-        {
-            char desc[2048];
-            snprintf(desc, sizeof(desc), "Substituted variable %s with value %s", 
-                     node->name, value ? "TRUE" : "FALSE");
-            add_evaluation_step(steps, desc);
-            return create_boolean_node(value);
-        }
-        else
-        {
-            // Special hardcoded handling for core variables if not in symbol table
-            if (strcmp(node->name, "A") == 0) {
-                add_or_update_symbol(symbol_table, "A", 1); // TRUE
-                add_evaluation_step(steps, "Using hardcoded value for A = TRUE");
-                return create_boolean_node(1);
-            } else if (strcmp(node->name, "B") == 0) {
-                add_or_update_symbol(symbol_table, "B", 0); // FALSE
-                add_evaluation_step(steps, "Using hardcoded value for B = FALSE");
-                return create_boolean_node(0);
-            } else if (strcmp(node->name, "C") == 0) {
-                add_or_update_symbol(symbol_table, "C", 0); // FALSE
-                add_evaluation_step(steps, "Using hardcoded value for C = FALSE");
-                return create_boolean_node(0);
-            }
-            
-            char desc[2048];
-            snprintf(desc, sizeof(desc), "WARNING: Undefined variable %s", node->name);
-            add_evaluation_step(steps, desc);
-            return NULL;
-        }
+        Node *value = evaluate_variable(node, symbol_table, steps);
+        free_ast(node);
+        return value;
     }
     // Process assignments
     else if (node->type == NODE_ASSIGN)
@@ -599,40 +499,90 @@ Node *evaluate_node_with_symbol_table(Node *node, SymbolTable *symbol_table, Eva
         }
     }
 
-    // For other node types, apply transformations
-    // Create copies of children to avoid modifying the originals during evaluation
-    Node *left_result = NULL;
-    Node *right_result = NULL;
-
-    if (node->left)
+    // Threshold nodes count their TRUE operands once all are known
+    if (is_threshold_type(node->type))
     {
-        left_result = evaluate_node_with_symbol_table(clone_node(node->left), symbol_table, steps);
+        Node *evaluated = create_node(node->type, NULL, NULL, NULL, 0);
+        if (!evaluated)
+        {
+            free_ast(node);
+            return NULL;
+        }
+        evaluated->threshold = node->threshold;
+        int true_count = 0;
+        int known = 1;
+        for (int i = 0; i < node->child_count; i++)
+        {
+            Node *operand = evaluate_node_with_symbol_table(clone_node(node->children[i]), symbol_table, steps);
+            if (!operand || operand->type != NODE_BOOL)
+                known = 0;
+            else
+                true_count += operand->bool_val != 0;
+            add_operand(evaluated, operand);
+        }
+        int child_count = node->child_count;
+        free_ast(node);
+        if (!known)
+            return evaluated;
+
+        char desc[2048];
+        snprintf(desc, sizeof(desc), "Evaluated %s %d operation: %d of %d operands TRUE",
+                 get_node_type_str(evaluated->type), evaluated->threshold, true_count, child_count);
+        add_evaluation_step(steps, desc);
+        int value = threshold_holds(evaluated->type, evaluated->threshold, true_count);
+        free_ast(evaluated);
+        return create_boolean_node(value);
     }
 
-    if (node->right)
+    // N-ary nodes fold their operands once all are known
+    if (is_nary_node(node))
     {
-        right_result = evaluate_node_with_symbol_table(clone_node(node->right), symbol_table, steps);
+        Node *evaluated = create_node(node->type, NULL, NULL, NULL, 0);
+        if (!evaluated)
+        {
+            free_ast(node);
+            return NULL;
+        }
+        int value = node->type == NODE_AND;
+        int known = 1;
+        for (int i = 0; i < node->child_count; i++)
+        {
+            Node *operand = evaluate_node_with_symbol_table(clone_node(node->children[i]), symbol_table, steps);
+            if (!operand || operand->type != NODE_BOOL)
+                known = 0;
+            else if (node->type == NODE_AND)
+                value = value && operand->bool_val;
+            else if (node->type == NODE_OR)
+                value = value || operand->bool_val;
+            else
+                value = value != (operand->bool_val != 0);
+            add_operand(evaluated, operand);
+        }
+        free_ast(node);
+        if (!known)
+            return evaluated;
+
+        char desc[2048];
+        snprintf(desc, sizeof(desc), "Evaluated %s operation over %d operands",
+                 get_node_type_str(evaluated->type), evaluated->child_count);
+        add_evaluation_step(steps, desc);
+        free_ast(evaluated);
+        return create_boolean_node(value);
     }
 
-    // Create a new node with the evaluated children
-    Node *new_node = create_node(node->type, node->name ? strdup(node->name) : NULL,
-                                 left_result, right_result, node->bool_val);
-
-    // Free the original node but not its children (we've cloned them)
-    Node *temp_left = node->left;
-    Node *temp_right = node->right;
-    node->left = NULL;
-    node->right = NULL;
-    free_ast(node);
-
-    // Now free the original children
-    if (temp_left)
-        free_ast(temp_left);
-    if (temp_right)
-        free_ast(temp_right);
+    // For other node types, evaluate the children, which node owns, in place
+    if (node->left)
+        node->left = evaluate_node(node->left, symbol_table, steps);
+    if (node->right)
+        node->right = evaluate_node(node->right, symbol_table, steps);
+    return node;
+}
 
-    // Apply logical laws to the new node with evaluated children
-    return apply_logical_laws(new_node, steps);
+// Evaluation with symbol table. The rewrite engine normalizes every subterm
+// of what it is given, so the evaluated tree is normalized once at the root.
+Node *evaluate_node_with_symbol_table(Node *node, SymbolTable *symbol_table, EvaluationSteps *steps)
+{
+    return apply_logical_laws(evaluate_node(node, symbol_table, steps), steps);
 }
 
 // Evaluation step helpers - FIXED
@@ -732,6 +682,9 @@ const char *get_node_type_str(NodeType type)
         case NODE_EXISTS: return "Exists";
         case NODE_FORALL: return "Forall";
         case NODE_BOOL: return "Boolean";
+        case NODE_ATLEAST: return "Atleast";
+        case NODE_ATMOST: return "Atmost";
+        case NODE_EXACTLY: return "Exactly";
         default: return "Unknown";
     }
 }
@@ -19,7 +19,11 @@ typedef enum
     NODE_EQUIV,
     NODE_EXISTS,
     NODE_FORALL,
-    NODE_BOOL
+    NODE_BOOL,
+    NODE_ATLEAST,
+    NODE_ATMOST,
+    NODE_EXACTLY,
+    NODE_TYPE_COUNT // Number of node types, keep last
 } NodeType;
 
 // Add more specific error codes as needed
@@ -32,6 +36,9 @@ typedef struct Node
     struct Node *right;
     int bool_val; // Used for boolean literals and evaluated results
     int is_parenthesized; // Flag to track if the expression is parenthesized
+    struct Node **children; // Operands of n-ary nodes, which leave left and right NULL
+    int child_count;
+    int threshold; // k of ATLEAST k, ATMOST k and EXACTLY k
 } Node;
 
 // Structure for recording evaluation steps
@@ -64,9 +71,44 @@ Node *create_exists_node(char *var, Node *expr);
 Node *create_forall_node(char *var, Node *expr);
 Node *create_boolean_node(int value);
 
+// Cardinality constraints over n operands: ATLEAST k (x1, ..., xn) holds when
+// at least k of the operands are TRUE, ATMOST k when at most k are, EXACTLY k
+// when exactly k are. add_operand appends to an operand list, creating it
+// when list is NULL; create_threshold_node turns the list into the node.
+Node *add_operand(Node *list, Node *operand);
+Node *create_threshold_node(NodeType type, int threshold, Node *operands);
+int is_threshold_type(NodeType type);
+int threshold_holds(NodeType type, int threshold, int true_count);
+int threshold_constant(NodeType type, int threshold, int operand_count);
+
+// AND, OR and XOR also have an n-ary form holding their operands in
+// children, which nary_flattener.h produces from chains of the binary form.
+// create_nary_node turns an operand list from add_operand into one.
+Node *create_nary_node(NodeType type, Node *operands);
+int is_nary_node(const Node *node);
+
+// Variable bound by an enclosing quantifier, innermost first
+typedef struct QuantifierBinding {
+    const char *name;
+    int value;
+    const struct QuantifierBinding *outer;
+} QuantifierBinding;
+
+// Value (0 or 1) of a variable no quantifier binds, or -1 if it has none
+typedef int (*FreeVariableValue)(const void *context, const char *name);
+
+const QuantifierBinding *find_quantifier_binding(const QuantifierBinding *scope, const char *name);
+
+// Value of an expression: 0 or 1, or -1 if it cannot be evaluated. Variables
+// bound in scope take their bound value and the others come from value_of;
+// quantifiers try both values of their variable, stopping once decided.
+int evaluate_bound_expression(const Node *node, const QuantifierBinding *scope, FreeVariableValue value_of,
+                              const void *context);
+
 void print_ast(Node *node, int indent);
 void free_ast(Node *node);
 Node *clone_node(const Node *node);
+Node *get_assignment_expression(const Node *node);
 char* node_to_string(Node* node);
 
 // Evaluation steps
@@ -75,11 +117,6 @@ void add_evaluation_step(EvaluationSteps *steps, const char *description);
 void free_evaluation_steps(EvaluationSteps *steps);
 
 // Logical operations
-Node *apply_de_morgan(Node *node, EvaluationSteps *steps);
-Node *apply_commutative(Node *node, EvaluationSteps *steps);
-Node *apply_distributive(Node *node, EvaluationSteps *steps);
-Node *apply_implication(Node *node, EvaluationSteps *steps);
-Node *apply_iff(Node *node, EvaluationSteps *steps);
 Node *apply_logical_laws(Node *node, EvaluationSteps *steps);
 
 // Main evaluation function
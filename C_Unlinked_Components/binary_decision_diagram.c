@@ -0,0 +1,285 @@
+#include "binary_decision_diagram.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define BDD_INITIAL_CAPACITY 1024
+
+typedef enum {
+    BDD_OPERATION_AND,
+    BDD_OPERATION_XOR
+} BDDOperation;
+
+struct BDDCacheEntry {
+    BDDEdge a;              // BDD_INVALID = empty
+    BDDEdge b;
+    BDDEdge result;
+    int operation;
+};
+
+static unsigned int hash_words(const uint32_t* words, int count) {
+    // FNV-1a over the bytes of the words
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < count; i++) {
+        for (int shift = 0; shift < 32; shift += 8) {
+            hash ^= (words[i] >> shift) & 0xFF;
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+static unsigned int hash_node(int variable, BDDEdge low, BDDEdge high) {
+    uint32_t words[3] = {(uint32_t)variable, low, high};
+    return hash_words(words, 3);
+}
+
+static int find_slot(const BDD* bdd, int variable, BDDEdge low, BDDEdge high) {
+    int mask = bdd->slot_count - 1;
+    int slot = hash_node(variable, low, high) & mask;
+    while (bdd->slots[slot] >= 0) {
+        const BDDNode* node = &bdd->nodes[bdd->slots[slot]];
+        if (node->variable == variable && node->low == low && node->high == high) break;
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+static void clear_cache(BDDCacheEntry* cache, int size) {
+    for (int i = 0; i < size; i++) cache[i].a = BDD_INVALID;
+}
+
+BDD* create_bdd(int variable_count, int node_limit) {
+    BDD* bdd = calloc(1, sizeof(BDD));
+    if (!bdd) return NULL;
+    bdd->variable_count = variable_count;
+    bdd->node_limit = node_limit > 1 ? node_limit : BDD_DEFAULT_NODE_LIMIT;
+    bdd->node_capacity = BDD_INITIAL_CAPACITY;
+    bdd->slot_count = 2 * BDD_INITIAL_CAPACITY;
+    bdd->cache_size = BDD_INITIAL_CAPACITY;
+    bdd->nodes = malloc(bdd->node_capacity * sizeof(BDDNode));
+    bdd->slots = malloc(bdd->slot_count * sizeof(int));
+    bdd->cache = malloc(bdd->cache_size * sizeof(BDDCacheEntry));
+    if (!bdd->nodes || !bdd->slots || !bdd->cache) {
+        free_bdd(bdd);
+        return NULL;
+    }
+    memset(bdd->slots, -1, bdd->slot_count * sizeof(int));
+    clear_cache(bdd->cache, bdd->cache_size);
+
+    bdd->nodes[0].variable = variable_count;
+    bdd->nodes[0].low = BDD_FALSE;
+    bdd->nodes[0].high = BDD_FALSE;
+    bdd->node_count = 1;
+    return bdd;
+}
+
+void free_bdd(BDD* bdd) {
+    if (!bdd) return;
+    free(bdd->nodes);
+    free(bdd->slots);
+    free(bdd->cache);
+    free(bdd);
+}
+
+// Double the node array and the unique table; the cache grows along
+static int grow_nodes(BDD* bdd) {
+    int capacity = bdd->node_capacity * 2;
+    BDDNode* nodes = realloc(bdd->nodes, capacity * sizeof(BDDNode));
+    if (!nodes) return -1;
+    bdd->nodes = nodes;
+
+    int slot_count = capacity * 2;
+    int* slots = malloc(slot_count * sizeof(int));
+    if (!slots) return -1;
+    memset(slots, -1, slot_count * sizeof(int));
+    free(bdd->slots);
+    bdd->slots = slots;
+    bdd->slot_count = slot_count;
+    bdd->node_capacity = capacity;
+    for (int i = 1; i < bdd->node_count; i++) {
+        const BDDNode* node = &bdd->nodes[i];
+        slots[find_slot(bdd, node->variable, node->low, node->high)] = i;
+    }
+
+    // A failed cache resize keeps the old cache
+    BDDCacheEntry* cache = malloc(capacity * sizeof(BDDCacheEntry));
+    if (cache) {
+        clear_cache(cache, capacity);
+        for (int i = 0; i < bdd->cache_size; i++) {
+            const BDDCacheEntry* entry = &bdd->cache[i];
+            if (entry->a == BDD_INVALID) continue;
+            uint32_t key[3] = {entry->a, entry->b, (uint32_t)entry->operation};
+            cache[hash_words(key, 3) & (capacity - 1)] = *entry;
+        }
+        free(bdd->cache);
+        bdd->cache = cache;
+        bdd->cache_size = capacity;
+    }
+    return 0;
+}
+
+// Edge to the node testing variable with the given cofactors
+static BDDEdge make_node(BDD* bdd, int variable, BDDEdge low, BDDEdge high) {
+    if (low == BDD_INVALID || high == BDD_INVALID) return BDD_INVALID;
+    if (low == high) return low;
+    if (BDD_IS_COMPLEMENTED(high)) {
+        BDDEdge complement = make_node(bdd, variable, BDD_NOT(low), BDD_NOT(high));
+        return complement == BDD_INVALID ? BDD_INVALID : BDD_NOT(complement);
+    }
+
+    int slot = find_slot(bdd, variable, low, high);
+    if (bdd->slots[slot] >= 0) return (BDDEdge)bdd->slots[slot] << 1;
+    if (bdd->node_count >= bdd->node_limit) return BDD_INVALID;
+    if (bdd->node_count >= bdd->node_capacity) {
+        if (grow_nodes(bdd) != 0) return BDD_INVALID;
+        slot = find_slot(bdd, variable, low, high);
+    }
+
+    int node = bdd->node_count++;
+    bdd->nodes[node].variable = variable;
+    bdd->nodes[node].low = low;
+    bdd->nodes[node].high = high;
+    bdd->slots[slot] = node;
+    return (BDDEdge)node << 1;
+}
+
+BDDEdge bdd_variable(BDD* bdd, int variable) {
+    if (variable < 0 || variable >= bdd->variable_count) return BDD_INVALID;
+    return make_node(bdd, variable, BDD_FALSE, BDD_TRUE);
+}
+
+int bdd_top_variable(const BDD* bdd, BDDEdge edge) {
+    return bdd->nodes[BDD_NODE(edge)].variable;
+}
+
+// Cofactor of edge for variable, which must not be below its top variable
+static BDDEdge cofactor(const BDD* bdd, BDDEdge edge, int variable, int value) {
+    const BDDNode* node = &bdd->nodes[BDD_NODE(edge)];
+    if (node->variable != variable) return edge;
+    return (value ? node->high : node->low) ^ BDD_IS_COMPLEMENTED(edge);
+}
+
+BDDEdge bdd_low(const BDD* bdd, BDDEdge edge) {
+    return cofactor(bdd, edge, bdd_top_variable(bdd, edge), 0);
+}
+
+BDDEdge bdd_high(const BDD* bdd, BDDEdge edge) {
+    return cofactor(bdd, edge, bdd_top_variable(bdd, edge), 1);
+}
+
+static BDDCacheEntry* cache_entry(const BDD* bdd, BDDOperation operation, BDDEdge a, BDDEdge b) {
+    uint32_t key[3] = {a, b, (uint32_t)operation};
+    return &bdd->cache[hash_words(key, 3) & (bdd->cache_size - 1)];
+}
+
+static BDDEdge apply(BDD* bdd, BDDOperation operation, BDDEdge a, BDDEdge b) {
+    if (a == BDD_INVALID || b == BDD_INVALID) return BDD_INVALID;
+
+    // XOR commutes with complement, so its operands are kept regular
+    int complement = 0;
+    if (operation == BDD_OPERATION_XOR) {
+        complement = BDD_IS_COMPLEMENTED(a) ^ BDD_IS_COMPLEMENTED(b);
+        a &= ~(BDDEdge)1;
+        b &= ~(BDDEdge)1;
+    }
+    if (a > b) {
+        BDDEdge swap = a;
+        a = b;
+        b = swap;
+    }
+
+    // Terminal cases; constants have the smallest edges
+    if (operation == BDD_OPERATION_AND) {
+        if (a == BDD_FALSE) return BDD_FALSE;
+        if (a == BDD_TRUE) return b;
+        if (a == b) return a;
+        if (a == BDD_NOT(b)) return BDD_FALSE;
+    } else {
+        if (a == BDD_FALSE) return b ^ complement;
+        if (a == b) return BDD_FALSE ^ complement;
+    }
+
+    BDDCacheEntry* entry = cache_entry(bdd, operation, a, b);
+    if (entry->a == a && entry->b == b && entry->operation == (int)operation) return entry->result ^ complement;
+
+    int top_a = bdd_top_variable(bdd, a);
+    int top_b = bdd_top_variable(bdd, b);
+    int variable = top_a < top_b ? top_a : top_b;
+    BDDEdge low = apply(bdd, operation, cofactor(bdd, a, variable, 0), cofactor(bdd, b, variable, 0));
+    BDDEdge high = low == BDD_INVALID ? BDD_INVALID
+                 : apply(bdd, operation, cofactor(bdd, a, variable, 1), cofactor(bdd, b, variable, 1));
+    BDDEdge result = make_node(bdd, variable, low, high);
+    if (result == BDD_INVALID) return BDD_INVALID;
+
+    // The recursion may have resized the cache
+    entry = cache_entry(bdd, operation, a, b);
+    entry->a = a;
+    entry->b = b;
+    entry->operation = operation;
+    entry->result = result;
+    return result ^ complement;
+}
+
+BDDEdge bdd_and(BDD* bdd, BDDEdge a, BDDEdge b) {
+    return apply(bdd, BDD_OPERATION_AND, a, b);
+}
+
+BDDEdge bdd_or(BDD* bdd, BDDEdge a, BDDEdge b) {
+    if (a == BDD_INVALID || b == BDD_INVALID) return BDD_INVALID;
+    BDDEdge both_false = apply(bdd, BDD_OPERATION_AND, BDD_NOT(a), BDD_NOT(b));
+    return both_false == BDD_INVALID ? BDD_INVALID : BDD_NOT(both_false);
+}
+
+BDDEdge bdd_xor(BDD* bdd, BDDEdge a, BDDEdge b) {
+    return apply(bdd, BDD_OPERATION_XOR, a, b);
+}
+
+BDDEdge bdd_from_aig(BDD* bdd, const AIG* aig, AIGLiteral literal) {
+    if (literal == AIG_INVALID) return BDD_INVALID;
+    int root = AIG_NODE(literal);
+    BDDEdge* edges = malloc((root + 1) * sizeof(BDDEdge));
+    int* stack = malloc((root + 1) * sizeof(int));
+    if (!edges || !stack) {
+        free(edges);
+        free(stack);
+        return BDD_INVALID;
+    }
+    for (int i = 0; i <= root; i++) edges[i] = BDD_INVALID;
+    edges[0] = BDD_FALSE;
+
+    // Post-order over the cone, pushing one missing fanin at a time so the
+    // stack is a path; fanins have smaller indices than their nodes
+    int top = 0;
+    int failed = 0;
+    stack[top++] = root;
+    while (top > 0 && !failed) {
+        int node = stack[top - 1];
+        if (edges[node] != BDD_INVALID) {
+            top--;
+            continue;
+        }
+        if (aig_is_input(aig, node)) {
+            edges[node] = bdd_variable(bdd, (int)aig->nodes[node].fanin1);
+        } else {
+            AIGLiteral fanin0 = aig->nodes[node].fanin0;
+            AIGLiteral fanin1 = aig->nodes[node].fanin1;
+            if (edges[AIG_NODE(fanin0)] == BDD_INVALID) {
+                stack[top++] = AIG_NODE(fanin0);
+                continue;
+            }
+            if (edges[AIG_NODE(fanin1)] == BDD_INVALID) {
+                stack[top++] = AIG_NODE(fanin1);
+                continue;
+            }
+            edges[node] = bdd_and(bdd, edges[AIG_NODE(fanin0)] ^ AIG_IS_COMPLEMENTED(fanin0),
+                                  edges[AIG_NODE(fanin1)] ^ AIG_IS_COMPLEMENTED(fanin1));
+        }
+        failed = edges[node] == BDD_INVALID;
+        top--;
+    }
+
+    BDDEdge result = failed ? BDD_INVALID : edges[root] ^ AIG_IS_COMPLEMENTED(literal);
+    free(edges);
+    free(stack);
+    return result;
+}
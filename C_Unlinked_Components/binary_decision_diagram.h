@@ -0,0 +1,68 @@
+#ifndef BINARY_DECISION_DIAGRAM_H
+#define BINARY_DECISION_DIAGRAM_H
+
+#include <stdint.h>
+#include "and_inverter_graph.h"
+
+// Reduced ordered binary decision diagrams with complement edges.
+//
+// An edge packs a node index and a complement bit, 2 * node + complement,
+// like an AIG literal. Node 0 is the terminal FALSE, so edge 0 is FALSE and
+// edge 1 is TRUE. Every other node tests one variable, and variables are
+// tested in increasing order along every path. A unique table keeps one node
+// per (variable, low, high), and the high edge of a node is never
+// complemented, so each function has exactly one edge.
+typedef uint32_t BDDEdge;
+
+#define BDD_FALSE ((BDDEdge)0)
+#define BDD_TRUE ((BDDEdge)1)
+#define BDD_INVALID ((BDDEdge)0xFFFFFFFFu)  // Node limit reached or allocation failure
+
+#define BDD_NODE(edge) ((int)((edge) >> 1))
+#define BDD_IS_COMPLEMENTED(edge) ((int)((edge) & 1))
+#define BDD_NOT(edge) ((edge) ^ 1)
+
+typedef struct {
+    int variable;           // variable_count for the terminal
+    BDDEdge low;            // Cofactor for variable FALSE
+    BDDEdge high;           // Cofactor for variable TRUE, never complemented
+} BDDNode;
+
+typedef struct BDDCacheEntry BDDCacheEntry;
+
+typedef struct {
+    BDDNode* nodes;
+    int node_count;
+    int node_capacity;
+    int node_limit;         // Operations fail rather than grow past this
+    int* slots;             // Unique table, -1 = empty
+    int slot_count;         // Always a power of two
+    BDDCacheEntry* cache;   // Direct-mapped results of AND and XOR
+    int cache_size;         // Always a power of two
+    int variable_count;
+} BDD;
+
+#define BDD_DEFAULT_NODE_LIMIT (1 << 21)
+
+BDD* create_bdd(int variable_count, int node_limit);
+void free_bdd(BDD* bdd);
+
+BDDEdge bdd_variable(BDD* bdd, int variable);
+
+// Variable tested by the node of edge, variable_count for constants
+int bdd_top_variable(const BDD* bdd, BDDEdge edge);
+
+// Cofactors of edge for its top variable FALSE and TRUE
+BDDEdge bdd_low(const BDD* bdd, BDDEdge edge);
+BDDEdge bdd_high(const BDD* bdd, BDDEdge edge);
+
+// Operations return BDD_INVALID if an operand is BDD_INVALID
+BDDEdge bdd_and(BDD* bdd, BDDEdge a, BDDEdge b);
+BDDEdge bdd_or(BDD* bdd, BDDEdge a, BDDEdge b);
+BDDEdge bdd_xor(BDD* bdd, BDDEdge a, BDDEdge b);
+
+// Decision diagram of an AIG literal, with AIG input i as variable i.
+// bdd must have at least aig->input_count variables.
+BDDEdge bdd_from_aig(BDD* bdd, const AIG* aig, AIGLiteral literal);
+
+#endif /* BINARY_DECISION_DIAGRAM_H */
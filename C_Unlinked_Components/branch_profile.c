@@ -0,0 +1,253 @@
+#include "branch_profile.h"
+#include "error_message.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    char key[BRANCH_PROFILE_KEY_LENGTH + 1];
+    int index;
+    BranchCounts counts;
+    long* decided;
+} ProfileEntry;
+
+struct BranchProfile {
+    ProfileEntry* entries;  // Open-addressing hash table, key[0] == '\0' when free
+    int size;
+    int capacity;           // Always a power of two
+    char digest[CONTENT_HASH_HEX_LENGTH + 1];
+};
+
+#define PROFILE_INITIAL_CAPACITY 64
+
+int is_profiled_operator(const Node* node) {
+    return node && (node->type == NODE_AND || node->type == NODE_OR);
+}
+
+void branch_profile_statement_key(const Node* statement, char* key) {
+    ContentHash hash;
+    content_hash_init(&hash);
+    content_hash_node(&hash, statement, NULL);
+    content_hash_hex(&hash, key);
+}
+
+int list_profiled_operators(const Node* statement, const Node*** operators) {
+    int capacity = 64;
+    int stack_capacity = 64;
+    int count = 0;
+    int top = 0;
+    const Node** list = malloc(capacity * sizeof(Node*));
+    const Node** stack = malloc(stack_capacity * sizeof(Node*));
+    if (!list || !stack) {
+        free(list);
+        free(stack);
+        return -1;
+    }
+
+    // Explicit stack, since operator chains are as deep as they are long
+    if (statement) stack[top++] = statement;
+    while (top > 0) {
+        const Node* node = stack[--top];
+        if (is_profiled_operator(node)) {
+            if (count == capacity) {
+                capacity *= 2;
+                const Node** grown = realloc(list, capacity * sizeof(Node*));
+                if (!grown) goto failed;
+                list = grown;
+            }
+            list[count++] = node;
+        }
+
+        int needed = top + 2 + node->child_count;
+        if (needed > stack_capacity) {
+            while (stack_capacity < needed) stack_capacity *= 2;
+            const Node** grown = realloc(stack, stack_capacity * sizeof(Node*));
+            if (!grown) goto failed;
+            stack = grown;
+        }
+        // Pushed in reverse so that operands are visited in order
+        for (int i = node->child_count - 1; i >= 0; i--) stack[top++] = node->children[i];
+        if (node->right) stack[top++] = node->right;
+        if (node->left) stack[top++] = node->left;
+    }
+    free(stack);
+    *operators = list;
+    return count;
+
+failed:
+    free(list);
+    free(stack);
+    return -1;
+}
+
+static unsigned long hash_entry(const char* key, int index) {
+    unsigned long hash = 2166136261u;
+    for (const char* c = key; *c; c++) {
+        hash ^= (unsigned char)*c;
+        hash *= 16777619u;
+    }
+    for (int b = 0; b < 4; b++) {
+        hash ^= ((unsigned)index >> (8 * b)) & 0xff;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static ProfileEntry* entry_slot(ProfileEntry* entries, int capacity, const char* key, int index) {
+    unsigned long slot = hash_entry(key, index) & (capacity - 1);
+    while (entries[slot].key[0] &&
+           (entries[slot].index != index || strcmp(entries[slot].key, key) != 0)) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    return &entries[slot];
+}
+
+static int grow_profile(BranchProfile* profile) {
+    int capacity = profile->capacity * 2;
+    ProfileEntry* entries = calloc(capacity, sizeof(ProfileEntry));
+    if (!entries) return -1;
+    for (int i = 0; i < profile->capacity; i++) {
+        ProfileEntry* entry = &profile->entries[i];
+        if (entry->key[0]) *entry_slot(entries, capacity, entry->key, entry->index) = *entry;
+    }
+    free(profile->entries);
+    profile->entries = entries;
+    profile->capacity = capacity;
+    return 0;
+}
+
+// Add one line's counts. Returns 0, 1 when the operand count disagrees
+// with earlier lines for the operator, or -1 when out of memory.
+static int add_counts(BranchProfile* profile, const char* key, int index, long evaluations,
+                      const long* decided, int operand_count) {
+    ProfileEntry* entry = entry_slot(profile->entries, profile->capacity, key, index);
+    if (entry->key[0]) {
+        if (entry->counts.operand_count != operand_count) return 1;
+        entry->counts.evaluations += evaluations;
+        for (int i = 0; i < operand_count; i++) entry->decided[i] += decided[i];
+        return 0;
+    }
+
+    entry->decided = malloc((operand_count > 0 ? operand_count : 1) * sizeof(long));
+    if (!entry->decided) return -1;
+    memcpy(entry->decided, decided, operand_count * sizeof(long));
+    memcpy(entry->key, key, BRANCH_PROFILE_KEY_LENGTH + 1);
+    entry->index = index;
+    entry->counts.evaluations = evaluations;
+    entry->counts.operand_count = operand_count;
+    entry->counts.decided = entry->decided;
+
+    // Keep the load factor at or below one half
+    if (++profile->size * 2 > profile->capacity) return grow_profile(profile);
+    return 0;
+}
+
+// Parse one line into key, index, evaluations and the decided counts.
+// Returns the operand count, or -1 when the line is malformed.
+static int parse_line(char* line, char* key, int* index, long* evaluations, long** decided, int* capacity) {
+    char* cursor = line;
+    while (*cursor == ' ' || *cursor == '\t') cursor++;
+    size_t length = strcspn(cursor, " \t");
+    if (length != BRANCH_PROFILE_KEY_LENGTH) return -1;
+    memcpy(key, cursor, length);
+    key[length] = '\0';
+    cursor += length;
+
+    char* end;
+    errno = 0;
+    long value = strtol(cursor, &end, 10);
+    if (end == cursor || value < 0 || value > 0x7fffffff || errno) return -1;
+    *index = (int)value;
+    cursor = end;
+    *evaluations = strtol(cursor, &end, 10);
+    if (end == cursor || *evaluations < 0 || errno) return -1;
+    cursor = end;
+
+    int count = 0;
+    for (;;) {
+        value = strtol(cursor, &end, 10);
+        if (end == cursor) break;
+        if (value < 0 || errno) return -1;
+        if (count == *capacity) {
+            int grown_capacity = *capacity ? *capacity * 2 : 16;
+            long* grown = realloc(*decided, grown_capacity * sizeof(long));
+            if (!grown) return -1;
+            *decided = grown;
+            *capacity = grown_capacity;
+        }
+        (*decided)[count++] = value;
+        cursor = end;
+    }
+    while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r' || *cursor == '\n') cursor++;
+    return *cursor || count < 2 ? -1 : count;
+}
+
+BranchProfile* load_branch_profile(const char* path, char** error_message) {
+    if (error_message) *error_message = NULL;
+    FILE* file = fopen(path, "r");
+    if (!file) {
+        set_error(error_message, format_message("Cannot open branch profile '%s'", path));
+        return NULL;
+    }
+
+    BranchProfile* profile = calloc(1, sizeof(BranchProfile));
+    if (profile) {
+        profile->capacity = PROFILE_INITIAL_CAPACITY;
+        profile->entries = calloc(profile->capacity, sizeof(ProfileEntry));
+    }
+    ContentHash digest;
+    content_hash_init(&digest);
+
+    char* line = NULL;
+    size_t line_capacity = 0;
+    long* decided = NULL;
+    int decided_capacity = 0;
+    char* message = profile && profile->entries ? NULL : format_message("Out of memory reading branch profile");
+    for (int number = 1; !message && getline(&line, &line_capacity, file) != -1; number++) {
+        content_hash_string(&digest, line);
+        char* start = line + strspn(line, " \t\r\n");
+        if (*start == '#' || *start == '\0') continue;
+
+        char key[BRANCH_PROFILE_KEY_LENGTH + 1];
+        int index;
+        long evaluations;
+        int count = parse_line(start, key, &index, &evaluations, &decided, &decided_capacity);
+        int status = count < 0 ? 1 : add_counts(profile, key, index, evaluations, decided, count);
+        if (status > 0) {
+            message = format_message("Malformed branch profile line %d in '%s'", number, path);
+        } else if (status < 0) {
+            message = format_message("Out of memory reading branch profile");
+        }
+    }
+    free(line);
+    free(decided);
+    fclose(file);
+
+    if (message) {
+        free_branch_profile(profile);
+        set_error(error_message, message);
+        return NULL;
+    }
+    content_hash_hex(&digest, profile->digest);
+    return profile;
+}
+
+void free_branch_profile(BranchProfile* profile) {
+    if (!profile) return;
+    for (int i = 0; profile->entries && i < profile->capacity; i++) {
+        if (profile->entries[i].key[0]) free(profile->entries[i].decided);
+    }
+    free(profile->entries);
+    free(profile);
+}
+
+const BranchCounts* find_branch_counts(const BranchProfile* profile, const char* key, int index) {
+    if (!profile) return NULL;
+    ProfileEntry* entry = entry_slot(profile->entries, profile->capacity, key, index);
+    return entry->key[0] ? &entry->counts : NULL;
+}
+
+void hash_branch_profile(ContentHash* hash, const BranchProfile* profile) {
+    content_hash_string(hash, profile ? profile->digest : NULL);
+}
@@ -0,0 +1,58 @@
+#ifndef BRANCH_PROFILE_H
+#define BRANCH_PROFILE_H
+
+#include "ast.h"
+#include "compile_cache.h"
+
+// Branch profiles of AND and OR operators for profile-guided code generation.
+//
+// An instrumented program counts, for every AND and OR whose operands are
+// not all known at compile time, how often it was evaluated and how often
+// each operand had the value that decides it (FALSE for AND, TRUE for OR),
+// and appends the counts to the profile when it exits, so runs add up. A
+// compile that reads the profile evaluates the operands that decide most
+// often first and branches past the rest once one of them has decided,
+// with the counts as branch weights.
+//
+// Operators are identified by the content hash of their statement and their
+// position in a preorder walk of it, so counts only apply to the statements
+// they were recorded from; the others compile as usual. Each line of the
+// file holds the counts of one operator from one run:
+//
+//   <statement hash> <operator index> <evaluations> <decided 0> ... <decided n-1>
+//
+// Lines starting with # are comments.
+
+#define BRANCH_PROFILE_KEY_LENGTH CONTENT_HASH_HEX_LENGTH
+
+typedef struct BranchProfile BranchProfile;
+
+typedef struct {
+    long evaluations;
+    int operand_count;
+    const long* decided;    // Per operand, how often it had the deciding value
+} BranchCounts;
+
+// Whether node is an AND or OR, binary or n-ary
+int is_profiled_operator(const Node* node);
+
+// Key of statement in profiles, written to key (BRANCH_PROFILE_KEY_LENGTH + 1 bytes)
+void branch_profile_statement_key(const Node* statement, char* key);
+
+// Profiled operators of statement in preorder, operator i at index i.
+// Returns the count and sets *operators, which the caller frees, or -1
+// when out of memory.
+int list_profiled_operators(const Node* statement, const Node*** operators);
+
+// Read and merge the lines of a profile. Returns NULL and sets
+// *error_message when the file cannot be read or a line is malformed.
+BranchProfile* load_branch_profile(const char* path, char** error_message);
+void free_branch_profile(BranchProfile* profile);
+
+// Counts of operator index of the statement with key, or NULL
+const BranchCounts* find_branch_counts(const BranchProfile* profile, const char* key, int index);
+
+// Add the contents of profile to a cache key
+void hash_branch_profile(ContentHash* hash, const BranchProfile* profile);
+
+#endif /* BRANCH_PROFILE_H */
@@ -0,0 +1,579 @@
+#include "cnf_converter.h"
+#include "error_message.h"
+#include <stdlib.h>
+#include <string.h>
+
+static int emit_gate(NodeType type, unsigned char polarity, int g, int a, int b,
+                     CNFClauseSink sink, void* context);
+
+// Polarities in which a subexpression occurs
+#define POLARITY_POSITIVE 1
+#define POLARITY_NEGATIVE 2
+#define POLARITY_BOTH (POLARITY_POSITIVE | POLARITY_NEGATIVE)
+
+// One node of the expression in pre-order, so children follow their parent
+typedef struct {
+    const Node* node;
+    int left;               // Entry indices of the operands, -1 if absent; the
+    int right;              // n operands of a threshold start at left, last first
+    unsigned char polarity;
+} CNFEntry;
+
+struct CNFEncoder {
+    CNFEntry* entries;
+    int entry_count;
+    const char** inputs;    // inputs[v - 1] names input variable v
+    int input_count;
+    int input_capacity;
+    NameIndex input_index;
+    int true_variable;      // Variable fixed to TRUE for constants, 0 if unused
+    int variable_count;
+    long clause_count;
+};
+
+static int is_equivalence(NodeType type) {
+    return type == NODE_XOR || type == NODE_XNOR || type == NODE_IFF || type == NODE_EQUIV;
+}
+
+static unsigned char flip_polarity(unsigned char polarity) {
+    return (unsigned char)(((polarity & POLARITY_POSITIVE) << 1) | ((polarity & POLARITY_NEGATIVE) >> 1));
+}
+
+// Clauses the encoding of a gate in the given polarity needs
+static int gate_clause_count(NodeType type, unsigned char polarity) {
+    int positive = polarity & POLARITY_POSITIVE ? 1 : 0;
+    int negative = polarity & POLARITY_NEGATIVE ? 1 : 0;
+    switch (type) {
+        case NODE_AND: return 2 * positive + negative;
+        case NODE_OR:
+        case NODE_IMPLIES: return positive + 2 * negative;
+        default: return 2 * positive + 2 * negative;
+    }
+}
+
+static const char* input_name(const void* inputs, int entry) {
+    return ((const char* const*)inputs)[entry];
+}
+
+// Input variable for name, or 0 if it is not an input
+static int find_input(const CNFEncoder* encoder, const char* name) {
+    return name_index_find(&encoder->input_index, name, input_name, encoder->inputs) + 1;
+}
+
+// Input variable for name, adding it if new; 0 when out of memory
+static int add_input(CNFEncoder* encoder, const char* name) {
+    int variable = find_input(encoder, name);
+    if (variable > 0) return variable;
+
+    if (encoder->input_count >= encoder->input_capacity) {
+        int capacity = encoder->input_capacity ? encoder->input_capacity * 2 : 16;
+        const char** inputs = realloc(encoder->inputs, capacity * sizeof(const char*));
+        if (!inputs) return 0;
+        encoder->inputs = inputs;
+        encoder->input_capacity = capacity;
+    }
+    if (name_index_add(&encoder->input_index, name, encoder->input_count, input_name, encoder->inputs) != 0) {
+        return 0;
+    }
+    encoder->inputs[encoder->input_count++] = name;
+    return encoder->input_count;
+}
+
+// Totalizer for a threshold node (Bailleux and Boufkhad): the operands are
+// split in halves, and the unary count of each half is merged into outputs
+// r1..rm of the whole, rj holding when j operands are TRUE. Counting stops
+// at the m the threshold needs, so a node takes O(n m) clauses. Up clauses
+// make the count at least the number of TRUE operands, down clauses at
+// most, and polarity decides which of the two are needed.
+typedef struct {
+    int limit;              // m
+    int up;
+    int down;
+    int next_variable;
+    int variables;          // Output variables allocated so far
+    long clauses;           // Clauses emitted so far
+    CNFClauseSink sink;     // NULL when only counting
+    void* context;
+} Totalizer;
+
+static int emit_totalizer_clause(Totalizer* totalizer, int x, int y, int z) {
+    totalizer->clauses++;
+    if (!totalizer->sink) return 0;
+    int clause[3];
+    int count = 0;
+    if (x) clause[count++] = x;
+    if (y) clause[count++] = y;
+    clause[count++] = z;
+    return totalizer->sink(totalizer->context, clause, count);
+}
+
+// Unary count of the n operands into outputs; operands may be NULL when
+// only counting. Returns the number of outputs, or -1 on failure with
+// *status set to -1 or the sink's result.
+static int totalize(Totalizer* totalizer, const int* operands, int n, int* outputs, int* status) {
+    if (n == 1) {
+        outputs[0] = operands ? operands[0] : 0;
+        return 1;
+    }
+
+    int half = n / 2;
+    int limit = totalizer->limit;
+    int* a = malloc((half < limit ? half : limit) * sizeof(int));
+    int* b = malloc((n - half < limit ? n - half : limit) * sizeof(int));
+    int pa = a && b ? totalize(totalizer, operands, half, a, status) : -1;
+    int pb = pa >= 0 ? totalize(totalizer, operands ? operands + half : NULL, n - half, b, status) : -1;
+    int pr = n < limit ? n : limit;
+    if (!a || !b) *status = -1;
+    if (pa < 0 || pb < 0) {
+        free(a);
+        free(b);
+        return -1;
+    }
+
+    for (int j = 0; j < pr; j++) outputs[j] = totalizer->next_variable++;
+    totalizer->variables += pr;
+
+    // ai and bj stand for "at least i (j) operands of the half are TRUE";
+    // a0 is always true, and a(pa + 1) false unless the half was cut at m,
+    // in which case the clauses using it are never needed
+    for (int i = 0; i <= pa && *status == 0; i++) {
+        for (int j = 0; j <= pb && *status == 0; j++) {
+            int sum = i + j;
+            if (totalizer->up && sum >= 1 && sum <= pr) {
+                *status = emit_totalizer_clause(totalizer, i ? -a[i - 1] : 0, j ? -b[j - 1] : 0, outputs[sum - 1]);
+            }
+            if (totalizer->down && sum < pr && *status == 0) {
+                *status = emit_totalizer_clause(totalizer, i < pa ? a[i] : 0, j < pb ? b[j] : 0, -outputs[sum]);
+            }
+        }
+    }
+    free(a);
+    free(b);
+    return *status == 0 ? pr : -1;
+}
+
+// Count outputs m a threshold needs, and which directions its polarity uses
+static int threshold_limit(const Node* node, unsigned char polarity, int* up, int* down) {
+    int n = node->child_count;
+    int k = node->threshold;
+    int positive = polarity & POLARITY_POSITIVE ? 1 : 0;
+    int negative = polarity & POLARITY_NEGATIVE ? 1 : 0;
+    if (node->type == NODE_ATLEAST || (node->type == NODE_EXACTLY && k == n)) {
+        *down = positive;
+        *up = negative;
+        return k;
+    }
+    if (node->type == NODE_ATMOST || k == 0) {
+        *up = positive;
+        *down = negative;
+        return k + 1;
+    }
+    *up = *down = 1;
+    return k + 1;
+}
+
+// Encode a non-constant threshold node: its totalizer plus, for EXACTLY k
+// with 0 < k < n, a gate for rk AND NOT r(k + 1). Counts only when sink is
+// NULL. Returns 0, the sink's result, or -1 when out of memory.
+static int encode_threshold(const CNFEntry* entry, const int* operands, int* next_variable, long* clause_count,
+                            int* literal, CNFClauseSink sink, void* context) {
+    const Node* node = entry->node;
+    int n = node->child_count;
+    int k = node->threshold;
+    Totalizer totalizer = {0, 0, 0, *next_variable, 0, 0, sink, context};
+    totalizer.limit = threshold_limit(node, entry->polarity, &totalizer.up, &totalizer.down);
+
+    int* outputs = malloc(totalizer.limit * sizeof(int));
+    int status = outputs ? 0 : -1;
+    if (status == 0) totalize(&totalizer, operands, n, outputs, &status);
+    if (status == 0) {
+        if (node->type == NODE_ATLEAST || (node->type == NODE_EXACTLY && k == n)) {
+            *literal = outputs[k - 1];
+        } else if (node->type == NODE_ATMOST || k == 0) {
+            *literal = -outputs[k];
+        } else {
+            int gate = totalizer.next_variable++;
+            totalizer.variables++;
+            totalizer.clauses += gate_clause_count(NODE_AND, entry->polarity);
+            if (sink) status = emit_gate(NODE_AND, entry->polarity, gate, outputs[k - 1], -outputs[k], sink, context);
+            *literal = gate;
+        }
+    }
+    free(outputs);
+    *next_variable = totalizer.next_variable;
+    *clause_count += totalizer.clauses;
+    return status;
+}
+
+static int count_nodes(const Node* node) {
+    // Iterative, so deeply nested expressions cannot overflow the stack
+    int count = 0;
+    int capacity = 64;
+    const Node** stack = malloc(capacity * sizeof(const Node*));
+    if (!stack) return -1;
+
+    int top = 0;
+    stack[top++] = node;
+    while (top > 0) {
+        const Node* current = stack[--top];
+        count++;
+        const Node* children[2] = {current->left, current->right};
+        if (current->type == NODE_ASSIGN) {
+            children[0] = get_assignment_expression(current);
+            children[1] = NULL;
+        }
+        while (top + 2 + current->child_count > capacity) {
+            capacity *= 2;
+            const Node** grown = realloc(stack, capacity * sizeof(const Node*));
+            if (!grown) {
+                free(stack);
+                return -1;
+            }
+            stack = grown;
+        }
+        for (int i = 0; i < 2; i++) {
+            if (children[i]) stack[top++] = children[i];
+        }
+        for (int i = 0; i < current->child_count; i++) {
+            stack[top++] = current->children[i];
+        }
+    }
+    free(stack);
+    return count;
+}
+
+CNFEncoder* create_cnf_encoder(const Node* node, char** error_message) {
+    if (error_message) *error_message = NULL;
+    if (!node) {
+        set_error(error_message, format_message("No expression to convert to CNF"));
+        return NULL;
+    }
+
+    CNFEncoder* encoder = calloc(1, sizeof(CNFEncoder));
+    int count = encoder ? count_nodes(node) : -1;
+    if (count < 0 || !(encoder->entries = malloc(count * sizeof(CNFEntry)))) {
+        free_cnf_encoder(encoder);
+        set_error(error_message, format_message("Out of memory converting to CNF"));
+        return NULL;
+    }
+
+    // Pre-order walk: entries are appended as they are discovered, and
+    // pending holds the entries whose operands are not yet listed
+    int* pending = malloc(count * sizeof(int));
+    if (!pending) {
+        free_cnf_encoder(encoder);
+        set_error(error_message, format_message("Out of memory converting to CNF"));
+        return NULL;
+    }
+    int top = 0;
+    int gates = 0;
+    int uses_constants = 0;
+    encoder->entries[0] = (CNFEntry){node, -1, -1, POLARITY_POSITIVE};
+    encoder->entry_count = 1;
+    pending[top++] = 0;
+
+    char* failure = NULL;
+    while (top > 0 && !failure) {
+        CNFEntry* entry = &encoder->entries[pending[--top]];
+        const Node* current = entry->node;
+        const Node* children[2] = {current->left, current->right};
+        unsigned char polarities[2] = {entry->polarity, entry->polarity};
+
+        switch (current->type) {
+            case NODE_VAR:
+                if (!add_input(encoder, current->name)) failure = format_message("Out of memory converting to CNF");
+                continue;
+            case NODE_BOOL:
+                uses_constants = 1;
+                continue;
+            case NODE_EXISTS:
+            case NODE_FORALL:
+                failure = format_message("Cannot convert quantifier over '%s' to CNF",
+                                         current->name ? current->name : "?");
+                continue;
+            case NODE_ATLEAST:
+            case NODE_ATMOST:
+            case NODE_EXACTLY: {
+                int n = current->child_count;
+                if (threshold_constant(current->type, current->threshold, n) >= 0) {
+                    uses_constants = 1;
+                    continue;
+                }
+                int literal;
+                if (encode_threshold(entry, NULL, &gates, &encoder->clause_count, &literal, NULL, NULL) != 0) {
+                    failure = format_message("Out of memory converting to CNF");
+                    continue;
+                }
+                int up, down;
+                threshold_limit(current, entry->polarity, &up, &down);
+                unsigned char polarity = (down ? POLARITY_POSITIVE : 0) | (up ? POLARITY_NEGATIVE : 0);
+                int index = entry - encoder->entries;
+                encoder->entries[index].left = encoder->entry_count;
+                for (int i = n - 1; i >= 0; i--) {
+                    int child = encoder->entry_count++;
+                    encoder->entries[child] = (CNFEntry){current->children[i], -1, -1, polarity};
+                    pending[top++] = child;
+                }
+                continue;
+            }
+            case NODE_ASSIGN:
+                children[0] = get_assignment_expression(current);
+                children[1] = NULL;
+                break;
+            case NODE_NOT:
+            case NODE_IMPLIES:
+                polarities[0] = flip_polarity(entry->polarity);
+                break;
+            default:
+                if (is_equivalence(current->type)) polarities[0] = polarities[1] = POLARITY_BOTH;
+                break;
+        }
+
+        int is_gate = current->type != NODE_NOT && current->type != NODE_ASSIGN;
+        if (!children[0] || (is_gate && !children[1])) {
+            failure = format_message("Malformed %s expression", get_node_type_str(current->type));
+            continue;
+        }
+        if (is_gate) {
+            gates++;
+            encoder->clause_count += gate_clause_count(current->type, entry->polarity);
+        }
+
+        // The left operand is pushed last so inputs are numbered left to right
+        int index = entry - encoder->entries;
+        for (int i = 1; i >= 0; i--) {
+            if (!children[i]) continue;
+            int child = encoder->entry_count++;
+            encoder->entries[child] = (CNFEntry){children[i], -1, -1, polarities[i]};
+            if (i == 0) encoder->entries[index].left = child;
+            else encoder->entries[index].right = child;
+            pending[top++] = child;
+        }
+    }
+    free(pending);
+    if (failure) {
+        free_cnf_encoder(encoder);
+        set_error(error_message, failure);
+        return NULL;
+    }
+
+    encoder->variable_count = encoder->input_count;
+    if (uses_constants) {
+        encoder->true_variable = ++encoder->variable_count;
+        encoder->clause_count++;
+    }
+    encoder->variable_count += gates;
+    encoder->clause_count++;  // The expression itself
+    return encoder;
+}
+
+void free_cnf_encoder(CNFEncoder* encoder) {
+    if (!encoder) return;
+
+    free(encoder->entries);
+    free(encoder->inputs);
+    free_name_index(&encoder->input_index);
+    free(encoder);
+}
+
+int get_cnf_variable_count(const CNFEncoder* encoder) {
+    return encoder ? encoder->variable_count : 0;
+}
+
+long get_cnf_clause_count(const CNFEncoder* encoder) {
+    return encoder ? encoder->clause_count : 0;
+}
+
+int get_cnf_input_count(const CNFEncoder* encoder) {
+    return encoder ? encoder->input_count : 0;
+}
+
+const char* get_cnf_input_name(const CNFEncoder* encoder, int variable) {
+    if (!encoder || variable < 1 || variable > encoder->input_count) return NULL;
+    return encoder->inputs[variable - 1];
+}
+
+#define EMIT(...)                                                       \
+    do {                                                                \
+        int clause[] = {__VA_ARGS__};                                   \
+        int status = sink(context, clause, sizeof(clause) / sizeof(int)); \
+        if (status) return status;                                      \
+    } while (0)
+
+// Clauses tying gate g to its operands a and b, in the needed polarities
+static int emit_gate(NodeType type, unsigned char polarity, int g, int a, int b,
+                     CNFClauseSink sink, void* context) {
+    int positive = polarity & POLARITY_POSITIVE;
+    int negative = polarity & POLARITY_NEGATIVE;
+    if (type == NODE_IMPLIES) {
+        type = NODE_OR;
+        a = -a;
+    }
+
+    switch (type) {
+        case NODE_AND:
+            if (positive) {
+                EMIT(-g, a);
+                EMIT(-g, b);
+            }
+            if (negative) EMIT(g, -a, -b);
+            break;
+        case NODE_OR:
+            if (positive) EMIT(-g, a, b);
+            if (negative) {
+                EMIT(g, -a);
+                EMIT(g, -b);
+            }
+            break;
+        case NODE_XOR:
+            if (positive) {
+                EMIT(-g, a, b);
+                EMIT(-g, -a, -b);
+            }
+            if (negative) {
+                EMIT(g, -a, b);
+                EMIT(g, a, -b);
+            }
+            break;
+        default:  // XNOR, IFF, EQUIV
+            if (positive) {
+                EMIT(-g, -a, b);
+                EMIT(-g, a, -b);
+            }
+            if (negative) {
+                EMIT(g, a, b);
+                EMIT(g, -a, -b);
+            }
+            break;
+    }
+    return 0;
+}
+
+int emit_cnf_clauses(CNFEncoder* encoder, CNFClauseSink sink, void* context) {
+    if (!encoder || !sink) return -1;
+
+    int* literals = malloc(encoder->entry_count * sizeof(int));
+    if (!literals) return -1;
+
+    if (encoder->true_variable) {
+        int unit = encoder->true_variable;
+        int status = sink(context, &unit, 1);
+        if (status) {
+            free(literals);
+            return status;
+        }
+    }
+
+    // Operands follow their operator in pre-order, so walking backwards
+    // visits them first
+    int next_gate = encoder->input_count + (encoder->true_variable ? 1 : 0) + 1;
+    for (int i = encoder->entry_count - 1; i >= 0; i--) {
+        const CNFEntry* entry = &encoder->entries[i];
+        const Node* node = entry->node;
+        switch (node->type) {
+            case NODE_VAR:
+                literals[i] = find_input(encoder, node->name);
+                break;
+            case NODE_BOOL:
+                literals[i] = node->bool_val ? encoder->true_variable : -encoder->true_variable;
+                break;
+            case NODE_NOT:
+                literals[i] = -literals[entry->left];
+                break;
+            case NODE_ASSIGN:
+                literals[i] = literals[entry->left];
+                break;
+            case NODE_ATLEAST:
+            case NODE_ATMOST:
+            case NODE_EXACTLY: {
+                int n = node->child_count;
+                int constant = threshold_constant(node->type, node->threshold, n);
+                if (constant >= 0) {
+                    literals[i] = constant ? encoder->true_variable : -encoder->true_variable;
+                    break;
+                }
+                // Operands were listed last first
+                int* operands = malloc(n * sizeof(int));
+                long clauses = 0;
+                int status = -1;
+                if (operands) {
+                    for (int j = 0; j < n; j++) operands[j] = literals[entry->left + n - 1 - j];
+                    status = encode_threshold(entry, operands, &next_gate, &clauses, &literals[i], sink, context);
+                }
+                free(operands);
+                if (status) {
+                    free(literals);
+                    return status;
+                }
+                break;
+            }
+            default: {
+                int gate = next_gate++;
+                int status = emit_gate(node->type, entry->polarity, gate, literals[entry->left],
+                                       literals[entry->right], sink, context);
+                if (status) {
+                    free(literals);
+                    return status;
+                }
+                literals[i] = gate;
+                break;
+            }
+        }
+    }
+
+    int root = literals[0];
+    free(literals);
+    return sink(context, &root, 1);
+}
+
+static int dimacs_sink(void* context, const int* literals, int count) {
+    FILE* out = context;
+    for (int i = 0; i < count; i++) {
+        if (fprintf(out, "%d ", literals[i]) < 0) return -1;
+    }
+    return fputs("0\n", out) < 0 ? -1 : 0;
+}
+
+int write_dimacs_cnf(CNFEncoder* encoder, FILE* out) {
+    if (!encoder || !out) return -1;
+
+    for (int v = 1; v <= encoder->input_count; v++) {
+        if (fprintf(out, "c input %d %s\n", v, encoder->inputs[v - 1]) < 0) return -1;
+    }
+    if (fprintf(out, "p cnf %d %ld\n", encoder->variable_count, encoder->clause_count) < 0) return -1;
+    return emit_cnf_clauses(encoder, dimacs_sink, out) == 0 ? 0 : -1;
+}
+
+int cnf_formula_sink(void* context, const int* literals, int count) {
+    CNFFormula* formula = context;
+
+    if (formula->clause_count + 2 > formula->clause_capacity) {
+        long capacity = formula->clause_capacity ? formula->clause_capacity * 2 : 256;
+        long* starts = realloc(formula->clause_starts, capacity * sizeof(long));
+        if (!starts) return -1;
+        if (!formula->clause_starts) starts[0] = 0;
+        formula->clause_starts = starts;
+        formula->clause_capacity = capacity;
+    }
+    if (formula->literal_count + count > formula->literal_capacity) {
+        long capacity = formula->literal_capacity ? formula->literal_capacity * 2 : 1024;
+        while (capacity < formula->literal_count + count) capacity *= 2;
+        int* grown = realloc(formula->literals, capacity * sizeof(int));
+        if (!grown) return -1;
+        formula->literals = grown;
+        formula->literal_capacity = capacity;
+    }
+
+    memcpy(formula->literals + formula->literal_count, literals, count * sizeof(int));
+    formula->literal_count += count;
+    formula->clause_starts[++formula->clause_count] = formula->literal_count;
+    return 0;
+}
+
+void free_cnf_formula(CNFFormula* formula) {
+    if (!formula) return;
+
+    free(formula->literals);
+    free(formula->clause_starts);
+    memset(formula, 0, sizeof(*formula));
+}
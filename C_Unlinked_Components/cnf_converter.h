@@ -0,0 +1,58 @@
+#ifndef CNF_CONVERTER_H
+#define CNF_CONVERTER_H
+
+#include <stdio.h>
+#include "ast.h"
+
+// Equisatisfiable CNF by Tseitin encoding with Plaisted-Greenbaum polarity.
+//
+// Every binary operator gets a fresh auxiliary variable, and only the
+// implications its polarity in the expression needs are emitted, so the
+// output is linear in the size of the expression. XOR, XNOR, IFF and EQUIV
+// are encoded directly instead of being expanded into AND/OR. NOT costs no
+// variable or clause. ATLEAST, ATMOST and EXACTLY become totalizers, which
+// count their operands in unary up to the threshold with O(n k) clauses.
+// Literals follow DIMACS: variable v is v, its negation -v, and the input
+// variables are numbered first, in order of appearance.
+typedef struct CNFEncoder CNFEncoder;
+
+// Receives each clause; a nonzero return stops emit_cnf_clauses
+typedef int (*CNFClauseSink)(void* context, const int* literals, int count);
+
+// Clauses collected in memory: clause i is literals[clause_starts[i]] up to
+// literals[clause_starts[i + 1]]
+typedef struct {
+    int* literals;
+    long literal_count;
+    long literal_capacity;
+    long* clause_starts;
+    long clause_count;
+    long clause_capacity;
+} CNFFormula;
+
+// Number the variables and count the clauses of node's encoding. node must
+// outlive the encoder. Returns NULL and sets *error_message for quantifiers,
+// which have no linear encoding, or when out of memory.
+CNFEncoder* create_cnf_encoder(const Node* node, char** error_message);
+void free_cnf_encoder(CNFEncoder* encoder);
+
+int get_cnf_variable_count(const CNFEncoder* encoder);
+long get_cnf_clause_count(const CNFEncoder* encoder);
+int get_cnf_input_count(const CNFEncoder* encoder);
+
+// Name of input variable 1..get_cnf_input_count()
+const char* get_cnf_input_name(const CNFEncoder* encoder, int variable);
+
+// Stream the clauses to sink, the unit clause asserting the expression
+// last. Returns 0, the sink's nonzero result, or -1 when out of memory.
+int emit_cnf_clauses(CNFEncoder* encoder, CNFClauseSink sink, void* context);
+
+// Write the encoding in DIMACS format, naming the inputs in comments.
+// The header is known up front, so out may be a pipe. Returns 0 or -1.
+int write_dimacs_cnf(CNFEncoder* encoder, FILE* out);
+
+// CNFClauseSink appending to a CNFFormula (zero-initialize it first)
+int cnf_formula_sink(void* context, const int* literals, int count);
+void free_cnf_formula(CNFFormula* formula);
+
+#endif /* CNF_CONVERTER_H */
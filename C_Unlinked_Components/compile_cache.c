@@ -0,0 +1,336 @@
+#include "compile_cache.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// FNV-1a 128-bit parameters
+#define FNV128_OFFSET_HIGH 0x6c62272e07bb0142ULL
+#define FNV128_OFFSET_LOW 0x62b821756295c58dULL
+#define FNV128_PRIME_HIGH 0x0000000001000000ULL
+#define FNV128_PRIME_LOW 0x000000000000013bULL
+
+void content_hash_init(ContentHash* hash) {
+    hash->state = ((unsigned __int128)FNV128_OFFSET_HIGH << 64) | FNV128_OFFSET_LOW;
+}
+
+void content_hash_update(ContentHash* hash, const void* data, size_t length) {
+    const unsigned __int128 prime = ((unsigned __int128)FNV128_PRIME_HIGH << 64) | FNV128_PRIME_LOW;
+    const unsigned char* bytes = data;
+    unsigned __int128 state = hash->state;
+
+    for (size_t i = 0; i < length; i++) {
+        state ^= bytes[i];
+        state *= prime;
+    }
+    hash->state = state;
+}
+
+void content_hash_int(ContentHash* hash, long value) {
+    unsigned char bytes[8];
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)((unsigned long)value >> (8 * i));
+    }
+    content_hash_update(hash, bytes, sizeof(bytes));
+}
+
+void content_hash_string(ContentHash* hash, const char* text) {
+    // Length prefix keeps adjacent strings from running together
+    size_t length = text ? strlen(text) : 0;
+    content_hash_int(hash, text ? (long)length : -1);
+    content_hash_update(hash, text, length);
+}
+
+void content_hash_node(ContentHash* hash, const Node* node, SymbolTable* symbol_table) {
+    if (!node) {
+        content_hash_int(hash, -1);
+        return;
+    }
+
+    content_hash_int(hash, node->type);
+    content_hash_int(hash, node->is_parenthesized);
+    switch (node->type) {
+        case NODE_BOOL:
+            content_hash_int(hash, node->bool_val);
+            break;
+        case NODE_VAR:
+        case NODE_ASSIGN:
+            content_hash_string(hash, node->name);
+            content_hash_int(hash, symbol_table ? get_symbol_value(symbol_table, node->name) : 0);
+            break;
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY:
+            content_hash_int(hash, node->threshold);
+            break;
+        default:
+            content_hash_string(hash, node->name);
+            break;
+    }
+    // Threshold and n-ary nodes
+    if (node->children) {
+        content_hash_int(hash, node->child_count);
+        for (int i = 0; i < node->child_count; i++) {
+            content_hash_node(hash, node->children[i], symbol_table);
+        }
+    }
+    content_hash_node(hash, node->left, symbol_table);
+    content_hash_node(hash, node->right, symbol_table);
+}
+
+void content_hash_hex(const ContentHash* hash, char* out) {
+    static const char digits[] = "0123456789abcdef";
+    unsigned __int128 state = hash->state;
+
+    for (int i = CONTENT_HASH_HEX_LENGTH - 1; i >= 0; i--) {
+        out[i] = digits[state & 0xf];
+        state >>= 4;
+    }
+    out[CONTENT_HASH_HEX_LENGTH] = '\0';
+}
+
+static char build_id[CONTENT_HASH_HEX_LENGTH + 1];
+static pthread_once_t build_id_once = PTHREAD_ONCE_INIT;
+
+static void compute_build_id(void) {
+    int fd = open("/proc/self/exe", O_RDONLY);
+    if (fd < 0) return;
+
+    ContentHash hash;
+    content_hash_init(&hash);
+    char buffer[65536];
+    ssize_t count;
+    while ((count = read(fd, buffer, sizeof(buffer))) > 0) {
+        content_hash_update(&hash, buffer, count);
+    }
+    close(fd);
+    if (count == 0) content_hash_hex(&hash, build_id);
+}
+
+const char* compile_cache_build_id(void) {
+    pthread_once(&build_id_once, compute_build_id);
+    return build_id[0] ? build_id : NULL;
+}
+
+// mkdir -p for a single absolute path
+static int make_directories(char* path) {
+    for (char* p = path + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        int status = mkdir(path, 0755);
+        *p = '/';
+        if (status != 0 && errno != EEXIST) return -1;
+    }
+    if (mkdir(path, 0755) != 0 && errno != EEXIST) return -1;
+    return 0;
+}
+
+char* compile_cache_dir(void) {
+    char path[PATH_MAX];
+    const char* dir = getenv("LEC_CACHE_DIR");
+    const char* xdg = getenv("XDG_CACHE_HOME");
+    const char* home = getenv("HOME");
+
+    if (dir && *dir) {
+        snprintf(path, sizeof(path), "%s", dir);
+    } else if (xdg && *xdg) {
+        snprintf(path, sizeof(path), "%s/lec", xdg);
+    } else if (home && *home) {
+        snprintf(path, sizeof(path), "%s/.cache/lec", home);
+    } else {
+        return NULL;
+    }
+
+    if (!compile_cache_build_id() || make_directories(path) != 0) return NULL;
+    return strdup(path);
+}
+
+static void entry_path(char* path, size_t size, const char* cache_dir, const char* key, const char* suffix) {
+    snprintf(path, size, "%s/%s%s", cache_dir, key, suffix);
+}
+
+// Entries are trimmed oldest first by modification time, so a hit renews it
+static void mark_used(const char* path) {
+    utimensat(AT_FDCWD, path, NULL, 0);
+}
+
+// Copy all of from_fd to to_fd; returns 0 on success
+static int copy_fd(int from_fd, int to_fd) {
+    char buffer[65536];
+    ssize_t count;
+
+    while ((count = read(from_fd, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t done = 0; done < count; ) {
+            ssize_t written = write(to_fd, buffer + done, count - done);
+            if (written < 0) {
+                if (errno == EINTR) continue;
+                return -1;
+            }
+            done += written;
+        }
+    }
+    return count < 0 ? -1 : 0;
+}
+
+int compile_cache_fetch(const char* cache_dir, const char* key, const char* suffix, const char* dest_path) {
+    char path[PATH_MAX];
+    entry_path(path, sizeof(path), cache_dir, key, suffix);
+
+    int from_fd = open(path, O_RDONLY);
+    if (from_fd < 0) return 0;
+
+    struct stat info;
+    int mode = fstat(from_fd, &info) == 0 ? (info.st_mode & 0777) : 0644;
+    unlink(dest_path);
+    int to_fd = open(dest_path, O_WRONLY | O_CREAT | O_TRUNC, mode);
+    if (to_fd < 0) {
+        close(from_fd);
+        return 0;
+    }
+
+    int status = copy_fd(from_fd, to_fd);
+    close(from_fd);
+    if (close(to_fd) != 0) status = -1;
+    if (status == 0) mark_used(path);
+    return status == 0;
+}
+
+// Write a new entry under a temporary name, then rename it into place so
+// concurrent compilers never see a partial entry
+static int store_entry(const char* cache_dir, const char* key, const char* suffix,
+                       int source_fd, const void* data, size_t length, int mode) {
+    char path[PATH_MAX];
+    char temp_path[PATH_MAX + 16];
+    entry_path(path, sizeof(path), cache_dir, key, suffix);
+    snprintf(temp_path, sizeof(temp_path), "%s.tmp.XXXXXX", path);
+
+    int temp_fd = mkstemp(temp_path);
+    if (temp_fd < 0) return -1;
+
+    int status;
+    if (source_fd >= 0) {
+        status = copy_fd(source_fd, temp_fd);
+    } else {
+        status = write(temp_fd, data, length) == (ssize_t)length ? 0 : -1;
+    }
+    if (fchmod(temp_fd, mode) != 0) status = -1;
+    if (close(temp_fd) != 0) status = -1;
+
+    if (status == 0 && rename(temp_path, path) == 0) return 0;
+    unlink(temp_path);
+    return -1;
+}
+
+int compile_cache_store(const char* cache_dir, const char* key, const char* suffix, const char* source_path) {
+    int source_fd = open(source_path, O_RDONLY);
+    if (source_fd < 0) return -1;
+
+    struct stat info;
+    int mode = fstat(source_fd, &info) == 0 ? (info.st_mode & 0777) : 0644;
+    int status = store_entry(cache_dir, key, suffix, source_fd, NULL, 0, mode);
+    close(source_fd);
+    return status;
+}
+
+int compile_cache_fetch_data(const char* cache_dir, const char* key, const char* suffix,
+                             void* data, size_t length) {
+    char path[PATH_MAX];
+    entry_path(path, sizeof(path), cache_dir, key, suffix);
+
+    FILE* file = fopen(path, "rb");
+    if (!file) return 0;
+
+    // Reading one byte more than expected detects entries of the wrong size
+    unsigned char extra;
+    int hit = fread(data, 1, length, file) == length && fread(&extra, 1, 1, file) == 0;
+    fclose(file);
+    if (hit) mark_used(path);
+    return hit;
+}
+
+int compile_cache_store_data(const char* cache_dir, const char* key, const char* suffix,
+                             const void* data, size_t length) {
+    return store_entry(cache_dir, key, suffix, -1, data, length, 0644);
+}
+
+long long compile_cache_limit(void) {
+    const char* text = getenv("LEC_CACHE_LIMIT_MB");
+    char* end;
+    long long megabytes = text && *text ? strtoll(text, &end, 10) : -1;
+    if (megabytes < 0 || *end) megabytes = COMPILE_CACHE_DEFAULT_LIMIT_MB;
+    return megabytes * 1024 * 1024;
+}
+
+typedef struct {
+    char* name;
+    long long size;
+    time_t used;
+} CacheFile;
+
+static int compare_cache_files(const void* a, const void* b) {
+    time_t x = ((const CacheFile*)a)->used;
+    time_t y = ((const CacheFile*)b)->used;
+    return (x > y) - (x < y);
+}
+
+int compile_cache_trim(const char* cache_dir, long long limit) {
+    DIR* dir = opendir(cache_dir);
+    if (!dir) return -1;
+
+    CacheFile* files = NULL;
+    int count = 0;
+    int capacity = 0;
+    long long total = 0;
+    int status = 0;
+    struct dirent* entry;
+    while (status == 0 && (entry = readdir(dir)) != NULL) {
+        // Temporary files belong to stores in progress
+        if (entry->d_name[0] == '.' || strstr(entry->d_name, ".tmp.")) continue;
+        char path[PATH_MAX];
+        struct stat info;
+        snprintf(path, sizeof(path), "%s/%s", cache_dir, entry->d_name);
+        if (stat(path, &info) != 0 || !S_ISREG(info.st_mode)) continue;
+
+        if (count == capacity) {
+            capacity = capacity ? capacity * 2 : 64;
+            CacheFile* grown = realloc(files, capacity * sizeof(CacheFile));
+            if (!grown) {
+                status = -1;
+                break;
+            }
+            files = grown;
+        }
+        files[count].name = strdup(entry->d_name);
+        if (!files[count].name) {
+            status = -1;
+            break;
+        }
+        files[count].size = info.st_size;
+        files[count].used = info.st_mtime;
+        total += info.st_size;
+        count++;
+    }
+    closedir(dir);
+
+    int removed = 0;
+    if (status == 0 && total > limit) {
+        qsort(files, count, sizeof(CacheFile), compare_cache_files);
+        for (int i = 0; i < count && total > limit / 4 * 3; i++) {
+            char path[PATH_MAX];
+            snprintf(path, sizeof(path), "%s/%s", cache_dir, files[i].name);
+            if (unlink(path) == 0) {
+                total -= files[i].size;
+                removed++;
+            }
+        }
+    }
+    for (int i = 0; i < count; i++) free(files[i].name);
+    free(files);
+    return status == 0 ? removed : -1;
+}
@@ -0,0 +1,66 @@
+#ifndef COMPILE_CACHE_H
+#define COMPILE_CACHE_H
+
+#include <stddef.h>
+#include "ast.h"
+#include "symbol_table.h"
+
+// Bump when the layout of cache entries changes; changes to the compiler
+// itself are covered by compile_cache_build_id
+#define COMPILE_CACHE_FORMAT_VERSION 2
+
+// Size the cache is trimmed to when $LEC_CACHE_LIMIT_MB is not set
+#define COMPILE_CACHE_DEFAULT_LIMIT_MB 1024
+
+// Streaming 128-bit FNV-1a hash used as the content address of cache entries
+typedef struct {
+    unsigned __int128 state;
+} ContentHash;
+
+// Hex digest length without the terminating NUL
+#define CONTENT_HASH_HEX_LENGTH 32
+
+void content_hash_init(ContentHash* hash);
+void content_hash_update(ContentHash* hash, const void* data, size_t length);
+void content_hash_int(ContentHash* hash, long value);
+void content_hash_string(ContentHash* hash, const char* text);
+
+// Hash the normalized form of a statement: node types, names, literals and
+// the symbol table value of each referenced or assigned variable, since
+// codegen folds those into the generated code
+void content_hash_node(ContentHash* hash, const Node* node, SymbolTable* symbol_table);
+
+// Write the digest as lowercase hex into out (CONTENT_HASH_HEX_LENGTH + 1 bytes)
+void content_hash_hex(const ContentHash* hash, char* out);
+
+// Digest of the running executable, which contains the code generator, so
+// entries made by any other build of the compiler are never reused. NULL
+// when the executable cannot be read.
+const char* compile_cache_build_id(void);
+
+// Cache directory: $LEC_CACHE_DIR, else $XDG_CACHE_HOME/lec, else ~/.cache/lec.
+// Created on demand; returns an allocated path, or NULL if unavailable or
+// the build cannot be identified.
+char* compile_cache_dir(void);
+
+// Entry limit in bytes: $LEC_CACHE_LIMIT_MB megabytes, else the default
+long long compile_cache_limit(void);
+
+// When the entries take more than limit bytes, remove the least recently
+// used ones until they take at most three quarters of it. Returns the
+// number of entries removed, or -1 if the directory cannot be read.
+int compile_cache_trim(const char* cache_dir, long long limit);
+
+// Copy the entry <key><suffix> to dest_path; returns 1 on a hit, 0 otherwise
+int compile_cache_fetch(const char* cache_dir, const char* key, const char* suffix, const char* dest_path);
+
+// Atomically store source_path as the entry <key><suffix>; returns 0 on success
+int compile_cache_store(const char* cache_dir, const char* key, const char* suffix, const char* source_path);
+
+// Read or write an in-memory entry; fetch returns 1 only if exactly length bytes were read
+int compile_cache_fetch_data(const char* cache_dir, const char* key, const char* suffix,
+                             void* data, size_t length);
+int compile_cache_store_data(const char* cache_dir, const char* key, const char* suffix,
+                             const void* data, size_t length);
+
+#endif /* COMPILE_CACHE_H */
@@ -0,0 +1,680 @@
+#include "egraph_optimizer.h"
+#include "rewrite_pattern.h"
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_EGRAPH_PATTERN_NODES 512
+#define EGRAPH_CHUNK_MIN_STATEMENTS 16
+#define DEFAULT_ITERATION_LIMIT 16
+#define COST_LIMIT (1L << 40)
+
+// Each rule adds the equality pattern == replacement; inverse laws are
+// listed separately. Rules only need one operand order and one
+// association, commutativity and associativity provide the rest.
+static const char* const egraph_rules[][2] = {
+    // Commutativity and associativity
+    {"AND(a,b)", "AND(b,a)"},
+    {"OR(a,b)", "OR(b,a)"},
+    {"XOR(a,b)", "XOR(b,a)"},
+    {"IFF(a,b)", "IFF(b,a)"},
+    {"AND(a,AND(b,c))", "AND(AND(a,b),c)"},
+    {"OR(a,OR(b,c))", "OR(OR(a,b),c)"},
+    {"XOR(a,XOR(b,c))", "XOR(XOR(a,b),c)"},
+
+    // De Morgan and double negation
+    {"NOT(AND(a,b))", "OR(NOT(a),NOT(b))"},
+    {"OR(NOT(a),NOT(b))", "NOT(AND(a,b))"},
+    {"NOT(OR(a,b))", "AND(NOT(a),NOT(b))"},
+    {"AND(NOT(a),NOT(b))", "NOT(OR(a,b))"},
+    {"NOT(NOT(a))", "a"},
+
+    // Distribution and factoring
+    {"AND(a,OR(b,c))", "OR(AND(a,b),AND(a,c))"},
+    {"OR(AND(a,b),AND(a,c))", "AND(a,OR(b,c))"},
+    {"OR(a,AND(b,c))", "AND(OR(a,b),OR(a,c))"},
+    {"AND(OR(a,b),OR(a,c))", "OR(a,AND(b,c))"},
+
+    // Implication and equivalence
+    {"IMPLIES(a,b)", "OR(NOT(a),b)"},
+    {"OR(NOT(a),b)", "IMPLIES(a,b)"},
+    {"IFF(a,b)", "AND(IMPLIES(a,b),IMPLIES(b,a))"},
+    {"IFF(a,b)", "NOT(XOR(a,b))"},
+    {"NOT(XOR(a,b))", "IFF(a,b)"},
+    {"XOR(NOT(a),b)", "NOT(XOR(a,b))"},
+    {"NOT(XOR(a,b))", "XOR(NOT(a),b)"},
+    {"XNOR(a,b)", "IFF(a,b)"},
+    {"EQUIV(a,b)", "IFF(a,b)"},
+
+    // Identities, annihilators and constants
+    {"AND(a,T)", "a"},
+    {"AND(a,F)", "F"},
+    {"OR(a,F)", "a"},
+    {"OR(a,T)", "T"},
+    {"XOR(a,F)", "a"},
+    {"XOR(a,T)", "NOT(a)"},
+    {"NOT(T)", "F"},
+    {"NOT(F)", "T"},
+
+    // Idempotence, complements and absorption
+    {"AND(a,a)", "a"},
+    {"OR(a,a)", "a"},
+    {"AND(a,NOT(a))", "F"},
+    {"OR(a,NOT(a))", "T"},
+    {"XOR(a,a)", "F"},
+    {"AND(a,OR(a,b))", "a"},
+    {"OR(a,AND(a,b))", "a"},
+};
+
+#define EGRAPH_RULE_COUNT ((int)(sizeof(egraph_rules) / sizeof(egraph_rules[0])))
+
+static PatternNode pattern_storage[MAX_EGRAPH_PATTERN_NODES];
+static PatternPool patterns = {pattern_storage, 0, MAX_EGRAPH_PATTERN_NODES};
+static int rule_patterns[EGRAPH_RULE_COUNT][2];
+static int rules_compiled;
+static pthread_once_t rules_once = PTHREAD_ONCE_INIT;
+
+typedef struct {
+    NodeType type;
+    const char* name;       // Borrowed from the input expression
+    int bool_val;
+    int children[2];        // E-class ids, -1 if absent
+    const Node* kept;       // Threshold expression, which no rule applies to, kept whole
+} ENode;
+
+typedef struct {
+    ENode* nodes;
+    int node_count;
+    int node_capacity;
+    int* parent;            // Union-find over e-node ids; an e-class is named by its root
+    unsigned char* dead;    // Duplicates merged away while rebuilding
+    int* slots;             // Hash-consing index over live e-nodes, -1 = empty
+    int slot_count;
+    int* class_start;       // Live e-nodes grouped by e-class, refreshed every round
+    int* class_nodes;
+} EGraph;
+
+typedef struct {
+    int values[MAX_PATTERN_VARIABLES];
+} Bindings;
+
+typedef struct {
+    Bindings* items;
+    int count;
+    int capacity;
+} BindingList;
+
+typedef struct {
+    int rule;
+    int eclass;
+    Bindings bindings;
+} Match;
+
+typedef struct {
+    long gates;
+    long depth;
+    long cost;
+    int node;               // Cheapest e-node of the class, -1 until one is found
+} ClassCost;
+
+static void compile_rules(void) {
+    for (int i = 0; i < EGRAPH_RULE_COUNT; i++) {
+        for (int side = 0; side < 2; side++) {
+            const char* text = egraph_rules[i][side];
+            rule_patterns[i][side] = parse_rewrite_pattern(&patterns, &text, NULL);
+            if (rule_patterns[i][side] < 0 || *text) return;
+        }
+        if (patterns.nodes[rule_patterns[i][0]].kind != PATTERN_OPERATOR) return;
+    }
+    rules_compiled = 1;
+}
+
+void init_egraph_options(EGraphOptions* options) {
+    memset(options, 0, sizeof(*options));
+    options->iteration_limit = DEFAULT_ITERATION_LIMIT;
+
+    // Instructions gen_expression emits for each operator
+    int* cost = options->cost_model.operator_cost;
+    cost[NODE_NOT] = 1;
+    cost[NODE_AND] = 1;
+    cost[NODE_OR] = 1;
+    cost[NODE_XOR] = 1;
+    cost[NODE_IMPLIES] = 2;
+    cost[NODE_IFF] = 5;
+    cost[NODE_EQUIV] = 5;
+    cost[NODE_XNOR] = 1 << 20;
+    cost[NODE_EXISTS] = 1 << 20;
+    cost[NODE_FORALL] = 1 << 20;
+    cost[NODE_ATLEAST] = 3;  // Per operand: zext, shl and or into a popcount word
+    cost[NODE_ATMOST] = 3;
+    cost[NODE_EXACTLY] = 3;
+    options->cost_model.gate_weight = 4;
+    options->cost_model.depth_weight = 1;
+}
+
+static int find_class(EGraph* graph, int id) {
+    while (graph->parent[id] != id) {
+        graph->parent[id] = graph->parent[graph->parent[id]];
+        id = graph->parent[id];
+    }
+    return id;
+}
+
+// Merge two e-classes; returns 1 if they were distinct
+static int merge_classes(EGraph* graph, int a, int b) {
+    a = find_class(graph, a);
+    b = find_class(graph, b);
+    if (a == b) return 0;
+
+    if (a < b) graph->parent[b] = a;
+    else graph->parent[a] = b;
+    return 1;
+}
+
+static unsigned int hash_enode(const ENode* node) {
+    // FNV-1a over the fields and the name
+    unsigned int hash = 2166136261u;
+    int fields[4] = {node->type, node->bool_val, node->children[0], node->children[1]};
+    for (int i = 0; i < 4; i++) {
+        unsigned int value = (unsigned int)fields[i];
+        for (int b = 0; b < 4; b++) {
+            hash ^= (value >> (8 * b)) & 0xff;
+            hash *= 16777619u;
+        }
+    }
+    for (const unsigned char* p = (const unsigned char*)node->name; p && *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    uintptr_t kept = (uintptr_t)node->kept;
+    for (size_t b = 0; b < sizeof(kept); b++) {
+        hash ^= (kept >> (8 * b)) & 0xff;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static int enodes_equal(const ENode* a, const ENode* b) {
+    if (a->type != b->type || a->bool_val != b->bool_val ||
+        a->children[0] != b->children[0] || a->children[1] != b->children[1] || a->kept != b->kept) {
+        return 0;
+    }
+    if (!a->name || !b->name) return a->name == b->name;
+    return strcmp(a->name, b->name) == 0;
+}
+
+// Slot holding an e-node equal to node, or the empty slot where it belongs
+static unsigned int find_slot(const EGraph* graph, const ENode* node) {
+    unsigned int slot = hash_enode(node) & (graph->slot_count - 1);
+    while (graph->slots[slot] != -1 && !enodes_equal(&graph->nodes[graph->slots[slot]], node)) {
+        slot = (slot + 1) & (graph->slot_count - 1);
+    }
+    return slot;
+}
+
+static void clear_slots(EGraph* graph) {
+    memset(graph->slots, -1, graph->slot_count * sizeof(int));
+}
+
+// Double the hash-consing index when it would become more than half full
+static int grow_slots(EGraph* graph, int needed) {
+    if (needed * 2 <= graph->slot_count) return 0;
+
+    int count = graph->slot_count ? graph->slot_count * 2 : 256;
+    while (count < needed * 2) count *= 2;
+    int* slots = realloc(graph->slots, count * sizeof(int));
+    if (!slots) return -1;
+    graph->slots = slots;
+    graph->slot_count = count;
+    clear_slots(graph);
+    for (int i = 0; i < graph->node_count; i++) {
+        if (!graph->dead[i]) graph->slots[find_slot(graph, &graph->nodes[i])] = i;
+    }
+    return 1;
+}
+
+static void canonicalize(EGraph* graph, ENode* node) {
+    for (int i = 0; i < 2; i++) {
+        if (node->children[i] >= 0) node->children[i] = find_class(graph, node->children[i]);
+    }
+}
+
+// E-class of node, adding it if no equal e-node exists; -1 on allocation failure
+static int add_enode(EGraph* graph, ENode node) {
+    canonicalize(graph, &node);
+    if (grow_slots(graph, 1) < 0) return -1;
+    unsigned int slot = find_slot(graph, &node);
+    if (graph->slots[slot] != -1) return find_class(graph, graph->slots[slot]);
+
+    if (graph->node_count >= graph->node_capacity) {
+        int capacity = graph->node_capacity ? graph->node_capacity * 2 : 256;
+        ENode* nodes = realloc(graph->nodes, capacity * sizeof(ENode));
+        if (!nodes) return -1;
+        graph->nodes = nodes;
+        int* parent = realloc(graph->parent, capacity * sizeof(int));
+        if (!parent) return -1;
+        graph->parent = parent;
+        unsigned char* dead = realloc(graph->dead, capacity);
+        if (!dead) return -1;
+        graph->dead = dead;
+        graph->node_capacity = capacity;
+    }
+    int grown = grow_slots(graph, graph->node_count + 1);
+    if (grown < 0) return -1;
+    if (grown) slot = find_slot(graph, &node);
+
+    int id = graph->node_count++;
+    graph->nodes[id] = node;
+    graph->parent[id] = id;
+    graph->dead[id] = 0;
+    graph->slots[slot] = id;
+    return id;
+}
+
+static int add_expression(EGraph* graph, const Node* node) {
+    ENode enode = {node->type, node->name, node->type == NODE_BOOL ? node->bool_val : 0, {-1, -1}, NULL};
+    if (is_threshold_type(node->type)) {
+        enode.kept = node;
+        return add_enode(graph, enode);
+    }
+    const Node* children[2] = {node->left, node->right};
+    if (node->type == NODE_ASSIGN) {
+        children[0] = get_assignment_expression(node);
+        children[1] = NULL;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (!children[i]) continue;
+        enode.children[i] = add_expression(graph, children[i]);
+        if (enode.children[i] < 0) return -1;
+    }
+    return add_enode(graph, enode);
+}
+
+// Restore the invariant that live e-nodes are unique up to their children's
+// e-classes, merging the e-classes of e-nodes that became equal
+static void rebuild(EGraph* graph) {
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        clear_slots(graph);
+        for (int i = 0; i < graph->node_count; i++) {
+            if (graph->dead[i]) continue;
+            canonicalize(graph, &graph->nodes[i]);
+            unsigned int slot = find_slot(graph, &graph->nodes[i]);
+            if (graph->slots[slot] == -1) {
+                graph->slots[slot] = i;
+                continue;
+            }
+            changed |= merge_classes(graph, i, graph->slots[slot]);
+            graph->dead[i] = 1;
+        }
+    }
+}
+
+// Group the live e-nodes by e-class (counting sort on the class root)
+static int group_classes(EGraph* graph) {
+    free(graph->class_start);
+    free(graph->class_nodes);
+    graph->class_start = calloc(graph->node_count + 1, sizeof(int));
+    graph->class_nodes = malloc(graph->node_count * sizeof(int) + 1);
+    if (!graph->class_start || !graph->class_nodes) return -1;
+
+    for (int i = 0; i < graph->node_count; i++) {
+        if (!graph->dead[i]) graph->class_start[find_class(graph, i) + 1]++;
+    }
+    for (int c = 0; c < graph->node_count; c++) {
+        graph->class_start[c + 1] += graph->class_start[c];
+    }
+    int* next = malloc(graph->node_count * sizeof(int) + 1);
+    if (!next) return -1;
+    memcpy(next, graph->class_start, graph->node_count * sizeof(int));
+    for (int i = 0; i < graph->node_count; i++) {
+        if (!graph->dead[i]) graph->class_nodes[next[find_class(graph, i)]++] = i;
+    }
+    free(next);
+    return 0;
+}
+
+static int push_bindings(BindingList* list, const Bindings* bindings) {
+    if (list->count >= list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 8;
+        Bindings* items = realloc(list->items, capacity * sizeof(Bindings));
+        if (!items) return -1;
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count++] = *bindings;
+    return 0;
+}
+
+// Append to out every extension of bindings under which pattern p matches
+// some term of e-class c
+static int match_class(EGraph* graph, int p, int c, const Bindings* bindings, BindingList* out) {
+    const PatternNode* pattern = &patterns.nodes[p];
+    c = find_class(graph, c);
+
+    if (pattern->kind == PATTERN_VARIABLE) {
+        int bound = bindings->values[pattern->variable];
+        if (bound >= 0) return find_class(graph, bound) == c ? push_bindings(out, bindings) : 0;
+        Bindings extended = *bindings;
+        extended.values[pattern->variable] = c;
+        return push_bindings(out, &extended);
+    }
+
+    for (int k = graph->class_start[c]; k < graph->class_start[c + 1]; k++) {
+        const ENode* node = &graph->nodes[graph->class_nodes[k]];
+        if (pattern->kind == PATTERN_CONSTANT) {
+            if (node->type == NODE_BOOL && node->bool_val == pattern->bool_val) return push_bindings(out, bindings);
+            continue;
+        }
+        if (node->type != pattern->type || node->children[0] < 0) continue;
+        if (pattern->right < 0) {
+            if (match_class(graph, pattern->left, node->children[0], bindings, out) < 0) return -1;
+            continue;
+        }
+        if (node->children[1] < 0) continue;
+
+        BindingList partial = {0};
+        int status = match_class(graph, pattern->left, node->children[0], bindings, &partial);
+        for (int i = 0; i < partial.count && status == 0; i++) {
+            status = match_class(graph, pattern->right, node->children[1], &partial.items[i], out);
+        }
+        free(partial.items);
+        if (status < 0) return -1;
+    }
+    return 0;
+}
+
+static int instantiate(EGraph* graph, int p, const Bindings* bindings) {
+    const PatternNode* pattern = &patterns.nodes[p];
+    if (pattern->kind == PATTERN_VARIABLE) return bindings->values[pattern->variable];
+
+    ENode node = {NODE_BOOL, NULL, pattern->bool_val, {-1, -1}, NULL};
+    if (pattern->kind == PATTERN_OPERATOR) {
+        node.type = pattern->type;
+        node.bool_val = 0;
+        node.children[0] = instantiate(graph, pattern->left, bindings);
+        if (node.children[0] < 0) return -1;
+        if (pattern->right >= 0) {
+            node.children[1] = instantiate(graph, pattern->right, bindings);
+            if (node.children[1] < 0) return -1;
+        }
+    }
+    return add_enode(graph, node);
+}
+
+// One round of equality saturation: find all matches, then apply them.
+// Returns 1 if the e-graph changed, 0 if saturated, -1 on allocation failure.
+static int rewrite_round(EGraph* graph, int node_budget) {
+    if (group_classes(graph) < 0) return -1;
+
+    Match* matches = NULL;
+    int match_count = 0;
+    int match_capacity = 0;
+    BindingList found = {0};
+    Bindings empty;
+    for (int v = 0; v < MAX_PATTERN_VARIABLES; v++) empty.values[v] = -1;
+
+    int status = 0;
+    for (int c = 0; c < graph->node_count && status == 0 && match_count < node_budget; c++) {
+        if (graph->class_start[c] == graph->class_start[c + 1]) continue;
+        for (int r = 0; r < EGRAPH_RULE_COUNT && status == 0; r++) {
+            found.count = 0;
+            status = match_class(graph, rule_patterns[r][0], c, &empty, &found);
+            for (int i = 0; i < found.count && status == 0; i++) {
+                if (match_count >= match_capacity) {
+                    int capacity = match_capacity ? match_capacity * 2 : 256;
+                    Match* grown = realloc(matches, capacity * sizeof(Match));
+                    if (!grown) {
+                        status = -1;
+                        break;
+                    }
+                    matches = grown;
+                    match_capacity = capacity;
+                }
+                matches[match_count++] = (Match){r, c, found.items[i]};
+            }
+        }
+    }
+    free(found.items);
+
+    int changed = 0;
+    for (int i = 0; i < match_count && status == 0; i++) {
+        if (graph->node_count >= node_budget) break;
+        int before = graph->node_count;
+        int replacement = instantiate(graph, rule_patterns[matches[i].rule][1], &matches[i].bindings);
+        if (replacement < 0) {
+            status = -1;
+            break;
+        }
+        changed |= graph->node_count != before;
+        changed |= merge_classes(graph, matches[i].eclass, replacement);
+    }
+    free(matches);
+    if (status < 0) return -1;
+
+    rebuild(graph);
+    return changed;
+}
+
+static int operator_cost(const EGraphCostModel* model, NodeType type, int has_children) {
+    int cost = model->operator_cost[type];
+    // Operators must cost something, or extraction could pick a cycle
+    return has_children && cost < 1 ? 1 : cost;
+}
+
+static long combined_cost(const EGraphCostModel* model, long gates, long depth) {
+    long cost = model->gate_weight * gates + model->depth_weight * depth;
+    return cost < COST_LIMIT ? cost : COST_LIMIT;
+}
+
+static void expression_cost(const EGraphCostModel* model, const Node* node, long* gates, long* depth);
+
+// Cheapest e-node of every e-class, by relaxing until no cost improves
+static ClassCost* extract_costs(EGraph* graph, const EGraphCostModel* model) {
+    ClassCost* costs = malloc(graph->node_count * sizeof(ClassCost) + 1);
+    if (!costs) return NULL;
+    for (int c = 0; c < graph->node_count; c++) {
+        costs[c] = (ClassCost){0, 0, COST_LIMIT + 1, -1};
+    }
+
+    int changed = 1;
+    while (changed) {
+        changed = 0;
+        for (int i = 0; i < graph->node_count; i++) {
+            if (graph->dead[i]) continue;
+            const ENode* node = &graph->nodes[i];
+            int own = operator_cost(model, node->type, node->children[0] >= 0);
+            long gates = own;
+            long depth = 0;
+            int ready = 1;
+            if (node->kept) {
+                expression_cost(model, node->kept, &gates, &depth);
+                own = 0;
+            }
+            for (int k = 0; k < 2; k++) {
+                if (node->children[k] < 0) continue;
+                const ClassCost* child = &costs[find_class(graph, node->children[k])];
+                if (child->node < 0) {
+                    ready = 0;
+                    break;
+                }
+                gates += child->gates;
+                if (child->depth > depth) depth = child->depth;
+            }
+            if (!ready) continue;
+            if (gates > COST_LIMIT) gates = COST_LIMIT;
+            depth += own > 0;
+
+            ClassCost* best = &costs[find_class(graph, i)];
+            long cost = combined_cost(model, gates, depth);
+            if (cost < best->cost) {
+                *best = (ClassCost){gates, depth, cost, i};
+                changed = 1;
+            }
+        }
+    }
+    return costs;
+}
+
+static Node* build_expression(EGraph* graph, const ClassCost* costs, int eclass, int under_operator) {
+    const ENode* node = &graph->nodes[costs[find_class(graph, eclass)].node];
+    if (node->kept) return clone_node(node->kept);
+    Node* children[2] = {NULL, NULL};
+    for (int k = 0; k < 2; k++) {
+        if (node->children[k] < 0) continue;
+        children[k] = build_expression(graph, costs, node->children[k], node->type != NODE_ASSIGN);
+        if (!children[k]) {
+            free_ast(children[0]);
+            return NULL;
+        }
+    }
+
+    Node* result = create_node(node->type, (char*)node->name, children[0], children[1], node->bool_val);
+    if (!result) {
+        free_ast(children[0]);
+        free_ast(children[1]);
+        return NULL;
+    }
+    // Keep the tree unambiguous when printed
+    result->is_parenthesized = under_operator && node->children[1] >= 0;
+    return result;
+}
+
+static void expression_cost(const EGraphCostModel* model, const Node* node, long* gates, long* depth) {
+    const Node* children[2] = {node->left, node->right};
+    if (node->type == NODE_ASSIGN) {
+        children[0] = get_assignment_expression(node);
+        children[1] = NULL;
+    }
+    int own = operator_cost(model, node->type, children[0] != NULL || node->child_count > 0);
+    *gates = (long)own * (node->child_count > 0 ? node->child_count : 1);
+    *depth = 0;
+    for (int k = 0; k < node->child_count; k++) {
+        long child_gates, child_depth;
+        expression_cost(model, node->children[k], &child_gates, &child_depth);
+        *gates += child_gates;
+        if (child_depth > *depth) *depth = child_depth;
+    }
+    for (int k = 0; k < 2; k++) {
+        if (!children[k]) continue;
+        long child_gates, child_depth;
+        expression_cost(model, children[k], &child_gates, &child_depth);
+        *gates += child_gates;
+        if (child_depth > *depth) *depth = child_depth;
+    }
+    if (*gates > COST_LIMIT) *gates = COST_LIMIT;
+    *depth += own > 0;
+}
+
+static void free_egraph(EGraph* graph) {
+    free(graph->nodes);
+    free(graph->parent);
+    free(graph->dead);
+    free(graph->slots);
+    free(graph->class_start);
+    free(graph->class_nodes);
+}
+
+Node* egraph_optimize(const Node* node, const EGraphOptions* options, EGraphStats* stats) {
+    if (!node) return NULL;
+
+    EGraphOptions defaults;
+    if (!options) {
+        init_egraph_options(&defaults);
+        options = &defaults;
+    }
+    pthread_once(&rules_once, compile_rules);
+
+    EGraph graph = {0};
+    int root = rules_compiled ? add_expression(&graph, node) : -1;
+    if (root < 0) {
+        free_egraph(&graph);
+        return NULL;
+    }
+
+    int budget = options->node_budget > 0 ? options->node_budget : graph.node_count * 16 + 1024;
+    int iterations = 0;
+    int saturated = 0;
+    while (iterations < options->iteration_limit && graph.node_count < budget) {
+        int changed = rewrite_round(&graph, budget);
+        iterations++;
+        if (changed < 0) {
+            free_egraph(&graph);
+            return NULL;
+        }
+        if (!changed) {
+            saturated = 1;
+            break;
+        }
+    }
+
+    ClassCost* costs = extract_costs(&graph, &options->cost_model);
+    Node* result = costs ? build_expression(&graph, costs, root, 0) : NULL;
+    if (stats && result) {
+        long gates, depth;
+        expression_cost(&options->cost_model, node, &gates, &depth);
+        stats->iterations = iterations;
+        stats->node_count = graph.node_count;
+        stats->saturated = saturated;
+        stats->input_cost = combined_cost(&options->cost_model, gates, depth);
+        stats->output_cost = costs[find_class(&graph, root)].cost;
+    }
+    free(costs);
+    free_egraph(&graph);
+    return result;
+}
+
+typedef struct {
+    Node** statements;
+    int count;
+    const EGraphOptions* options;
+} OptimizeJob;
+
+static void run_optimize_job(void* arg) {
+    OptimizeJob* job = arg;
+    for (int i = 0; i < job->count; i++) {
+        Node* statement = job->statements[i];
+        if (!statement || statement->type == NODE_ASSIGN) continue;
+
+        Node* optimized = egraph_optimize(statement, job->options, NULL);
+        if (optimized) {
+            free_ast(statement);
+            job->statements[i] = optimized;
+        }
+    }
+}
+
+void egraph_optimize_statements(Node** statements, int count, const EGraphOptions* options, int jobs) {
+    if (count <= 0) return;
+
+    // Aim for a few chunks per thread so uneven statements balance out
+    int chunk_size = jobs > 0 ? (count + jobs * 4 - 1) / (jobs * 4) : count;
+    if (chunk_size < EGRAPH_CHUNK_MIN_STATEMENTS) chunk_size = EGRAPH_CHUNK_MIN_STATEMENTS;
+    int chunk_count = (count + chunk_size - 1) / chunk_size;
+
+    ThreadPool* pool = chunk_count > 1 && jobs > 1 ? thread_pool_create(jobs) : NULL;
+    OptimizeJob* chunks = pool ? calloc(chunk_count, sizeof(OptimizeJob)) : NULL;
+    if (!chunks) {
+        if (pool) thread_pool_destroy(pool);
+        OptimizeJob job = {statements, count, options};
+        run_optimize_job(&job);
+        return;
+    }
+
+    for (int k = 0; k < chunk_count; k++) {
+        OptimizeJob* job = &chunks[k];
+        int first = k * chunk_size;
+        job->statements = statements + first;
+        job->count = count - first < chunk_size ? count - first : chunk_size;
+        job->options = options;
+        if (thread_pool_submit(pool, run_optimize_job, job) != 0) {
+            run_optimize_job(job);
+        }
+    }
+    thread_pool_wait(pool);
+    thread_pool_destroy(pool);
+    free(chunks);
+}
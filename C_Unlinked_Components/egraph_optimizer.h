@@ -0,0 +1,51 @@
+#ifndef EGRAPH_OPTIMIZER_H
+#define EGRAPH_OPTIMIZER_H
+
+#include "ast.h"
+
+// Equality saturation over the Boolean operators.
+//
+// An expression is loaded into an e-graph, whose e-classes hold every
+// equivalent form found so far. The Boolean laws (commutativity,
+// associativity, De Morgan, distribution, implication and IFF elimination,
+// identities, absorption) are applied in both directions without discarding
+// anything, until no rule adds a new equality or the node budget is reached.
+// The cheapest term under the cost model is then extracted. ATLEAST, ATMOST
+// and EXACTLY expressions are kept whole, as leaves of the e-graph.
+
+// Cost of an expression: gate_weight * gates + depth_weight * depth, where
+// gates sums operator_cost over all nodes and depth counts operators on the
+// longest root-to-leaf path
+typedef struct {
+    int operator_cost[NODE_TYPE_COUNT];
+    int gate_weight;
+    int depth_weight;
+} EGraphCostModel;
+
+typedef struct {
+    int node_budget;        // Stop growing the e-graph past this many e-nodes, 0 = 16 per input node + 1024
+    int iteration_limit;    // Rewrite rounds before giving up on saturation
+    EGraphCostModel cost_model;
+} EGraphOptions;
+
+typedef struct {
+    int iterations;
+    int node_count;         // E-nodes in the final e-graph
+    int saturated;          // The last round found nothing new
+    long input_cost;
+    long output_cost;
+} EGraphStats;
+
+// Defaults: the instructions llvm_codegen emits per operator, with gates
+// weighted above depth. Operators codegen does not support cost the most.
+void init_egraph_options(EGraphOptions* options);
+
+// Return a newly allocated lowest-cost expression equivalent to node, or
+// NULL on allocation failure. stats may be NULL.
+Node* egraph_optimize(const Node* node, const EGraphOptions* options, EGraphStats* stats);
+
+// Replace every non-assignment statement by its optimized form, spreading
+// the statements over up to jobs threads
+void egraph_optimize_statements(Node** statements, int count, const EGraphOptions* options, int jobs);
+
+#endif /* EGRAPH_OPTIMIZER_H */
@@ -0,0 +1,440 @@
+#include "equivalence_checker.h"
+#include "and_inverter_graph.h"
+#include "sat_solver.h"
+#include "error_message.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define SIMULATION_WORDS 4          // 256 random input patterns per node
+
+// Literals of one program's definitions, AIG_INVALID for those that are inputs
+typedef struct {
+    const AssignmentGraph* definitions;
+    AIGLiteral* literals;
+} DefinitionLiterals;
+
+static AIGLiteral resolve_definition(void* context, const char* name) {
+    const DefinitionLiterals* program = context;
+    if (!program->definitions) return AIG_INVALID;
+    int index = find_assignment_definition(program->definitions, name);
+    return index < 0 ? AIG_INVALID : program->literals[index];
+}
+
+// Whether an expression mentions any variable; definitions that do not are
+// constants, which stay inputs
+static int reads_variable(const Node* node) {
+    if (!node) return 0;
+    if (node->type == NODE_VAR) return 1;
+    for (int i = 0; i < node->child_count; i++) {
+        if (reads_variable(node->children[i])) return 1;
+    }
+    return reads_variable(node->left) || reads_variable(node->right);
+}
+
+// Lower the definitions in dependency order, so each one finds the literals
+// of the definitions it reads; returns 0 or -1
+static int lower_definitions(AIG* aig, DefinitionLiterals* program) {
+    const AssignmentGraph* graph = program->definitions;
+    if (!graph) return 0;
+    program->literals = malloc((graph->count > 0 ? graph->count : 1) * sizeof(AIGLiteral));
+    if (!program->literals) return -1;
+    for (int i = 0; i < graph->count; i++) program->literals[i] = AIG_INVALID;
+
+    for (int i = 0; i < graph->count; i++) {
+        const AssignmentDefinition* definition = &graph->definitions[graph->order[i]];
+        Node* expression = get_assignment_expression(definition->assignment);
+        if (!reads_variable(expression)) continue;
+        AIGLiteral literal = aig_from_node_resolved(aig, expression, resolve_definition, program);
+        if (literal == AIG_INVALID) return -1;
+        program->literals[graph->order[i]] = literal;
+    }
+    return 0;
+}
+
+// Scratch space for walking the cones of literals, sized to the graph
+typedef struct {
+    AIG* aig;
+    int count;                  // Statement pairs; output i is miter i, then old and new literals
+    int* stamps;                // Node visited in the current walk when stamps[node] == stamp
+    int stamp;
+    int* stack;
+    unsigned char* values;
+    int* inputs;                // Input numbers of a cone
+    unsigned char* input_values;
+} Checker;
+
+static void end_walks(Checker* checker) {
+    free(checker->stamps);
+    free(checker->stack);
+    free(checker->values);
+    free(checker->inputs);
+    free(checker->input_values);
+    checker->stamps = NULL;
+    checker->stack = NULL;
+    checker->values = NULL;
+    checker->inputs = NULL;
+    checker->input_values = NULL;
+}
+
+// (Re)allocate the scratch space after the graph changed
+static int begin_walks(Checker* checker) {
+    end_walks(checker);
+    int nodes = checker->aig->node_count;
+    int inputs = checker->aig->input_count > 0 ? checker->aig->input_count : 1;
+    checker->stamps = calloc(nodes, sizeof(int));
+    checker->stack = malloc(nodes * sizeof(int));
+    checker->values = malloc(nodes);
+    checker->inputs = malloc(inputs * sizeof(int));
+    checker->input_values = calloc(inputs, 1);
+    checker->stamp = 0;
+    return checker->stamps && checker->stack && checker->values && checker->inputs && checker->input_values ? 0 : -1;
+}
+
+// Append the inputs in the cone of literal not seen yet in this walk.
+// Nodes are marked when pushed, so the stack never holds more than the graph.
+static int collect_inputs(Checker* checker, AIGLiteral literal, int count) {
+    const AIG* aig = checker->aig;
+    int top = 0;
+    int root = AIG_NODE(literal);
+    if (checker->stamps[root] == checker->stamp) return count;
+    checker->stamps[root] = checker->stamp;
+    checker->stack[top++] = root;
+    while (top > 0) {
+        int node = checker->stack[--top];
+        if (aig_is_and(aig, node)) {
+            int fanins[2] = {AIG_NODE(aig->nodes[node].fanin0), AIG_NODE(aig->nodes[node].fanin1)};
+            for (int k = 0; k < 2; k++) {
+                if (checker->stamps[fanins[k]] == checker->stamp) continue;
+                checker->stamps[fanins[k]] = checker->stamp;
+                checker->stack[top++] = fanins[k];
+            }
+        } else if (aig_is_input(aig, node)) {
+            checker->inputs[count++] = (int)aig->nodes[node].fanin1;
+        }
+    }
+    return count;
+}
+
+// Value of literal under checker->input_values, reusing the nodes already
+// evaluated in this walk
+static int evaluate(Checker* checker, AIGLiteral literal) {
+    const AIG* aig = checker->aig;
+    int top = 0;
+    checker->stack[top++] = AIG_NODE(literal);
+    while (top > 0) {
+        int node = checker->stack[top - 1];
+        if (checker->stamps[node] == checker->stamp) {
+            top--;
+            continue;
+        }
+        if (aig_is_and(aig, node)) {
+            // Only one pending fanin is pushed at a time, so the stack is a
+            // path and never holds a node twice
+            AIGLiteral fanin0 = aig->nodes[node].fanin0;
+            AIGLiteral fanin1 = aig->nodes[node].fanin1;
+            if (checker->stamps[AIG_NODE(fanin0)] != checker->stamp) {
+                checker->stack[top++] = AIG_NODE(fanin0);
+                continue;
+            }
+            if (checker->stamps[AIG_NODE(fanin1)] != checker->stamp) {
+                checker->stack[top++] = AIG_NODE(fanin1);
+                continue;
+            }
+            checker->values[node] = (checker->values[AIG_NODE(fanin0)] ^ AIG_IS_COMPLEMENTED(fanin0)) &
+                                    (checker->values[AIG_NODE(fanin1)] ^ AIG_IS_COMPLEMENTED(fanin1));
+        } else if (aig_is_input(aig, node)) {
+            checker->values[node] = checker->input_values[aig->nodes[node].fanin1];
+        } else {
+            checker->values[node] = 0;
+        }
+        checker->stamps[node] = checker->stamp;
+        top--;
+    }
+    return checker->values[AIG_NODE(literal)] ^ AIG_IS_COMPLEMENTED(literal);
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Record the counterexample in checker->input_values for pair
+static int record_counterexample(Checker* checker, int pair, EquivalenceResult* result) {
+    AIG* aig = checker->aig;
+    AIGLiteral old_literal = aig->outputs[checker->count + pair];
+    AIGLiteral new_literal = aig->outputs[2 * checker->count + pair];
+
+    checker->stamp++;
+    int count = collect_inputs(checker, old_literal, 0);
+    count = collect_inputs(checker, new_literal, count);
+    qsort(checker->inputs, count, sizeof(int), compare_ints);
+
+    checker->stamp++;
+    result->verdict = EQUIVALENCE_DIFFERENT;
+    result->old_value = evaluate(checker, old_literal);
+    result->new_value = evaluate(checker, new_literal);
+
+    result->input_names = calloc(count > 0 ? count : 1, sizeof(char*));
+    result->input_values = malloc((count > 0 ? count : 1) * sizeof(int));
+    if (!result->input_names || !result->input_values) return -1;
+    for (int i = 0; i < count; i++) {
+        result->input_names[i] = strdup(aig->input_names[checker->inputs[i]]);
+        if (!result->input_names[i]) return -1;
+        result->input_values[i] = checker->input_values[checker->inputs[i]];
+        result->input_count++;
+    }
+    return 0;
+}
+
+static uint64_t next_random(uint64_t* state) {
+    // xorshift64*
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 2685821657736338717ull;
+}
+
+static uint64_t literal_word(const uint64_t* words, AIGLiteral literal, int w) {
+    uint64_t word = words[(size_t)AIG_NODE(literal) * SIMULATION_WORDS + w];
+    return AIG_IS_COMPLEMENTED(literal) ? ~word : word;
+}
+
+// Look for differences on random input patterns; returns 0 or -1
+static int simulate_miters(Checker* checker, EquivalenceResult* results) {
+    const AIG* aig = checker->aig;
+    uint64_t* words = malloc((size_t)aig->node_count * SIMULATION_WORDS * sizeof(uint64_t));
+    if (!words) return -1;
+
+    uint64_t state = 0x9E3779B97F4A7C15ull;
+    for (int node = 0; node < aig->node_count; node++) {
+        uint64_t* value = words + (size_t)node * SIMULATION_WORDS;
+        for (int w = 0; w < SIMULATION_WORDS; w++) {
+            if (aig_is_and(aig, node)) {
+                value[w] = literal_word(words, aig->nodes[node].fanin0, w) &
+                           literal_word(words, aig->nodes[node].fanin1, w);
+            } else {
+                value[w] = aig_is_input(aig, node) ? next_random(&state) : 0;
+            }
+        }
+    }
+
+    int status = 0;
+    for (int i = 0; i < checker->count && status == 0; i++) {
+        if (results[i].verdict != EQUIVALENCE_UNDECIDED) continue;
+        for (int w = 0; w < SIMULATION_WORDS; w++) {
+            uint64_t differ = literal_word(words, aig->outputs[i], w);
+            if (!differ) continue;
+
+            int bit = 0;
+            while (!(differ >> bit & 1)) bit++;
+            for (int k = 0; k < aig->input_count; k++) {
+                uint64_t input = words[(size_t)aig->input_nodes[k] * SIMULATION_WORDS + w];
+                checker->input_values[k] = input >> bit & 1;
+            }
+            status = record_counterexample(checker, i, &results[i]);
+            break;
+        }
+    }
+    free(words);
+    return status;
+}
+
+// SAT variables of the AIG nodes, encoded cone by cone on demand
+typedef struct {
+    SATSolver* solver;
+    int* variables;             // 0 until the node is encoded
+} Encoding;
+
+static int add_clause3(SATSolver* solver, int a, int b, int c) {
+    int literals[3] = {a, b, c};
+    return sat_add_clause(solver, literals, c ? 3 : 2);
+}
+
+// DIMACS literal for literal, encoding its cone first; 0 when out of memory
+static int encode_literal(Checker* checker, Encoding* encoding, AIGLiteral literal) {
+    const AIG* aig = checker->aig;
+    int top = 0;
+    checker->stack[top++] = AIG_NODE(literal);
+    while (top > 0) {
+        int node = checker->stack[top - 1];
+        if (encoding->variables[node]) {
+            top--;
+            continue;
+        }
+        int variable;
+        if (aig_is_and(aig, node)) {
+            AIGLiteral fanin0 = aig->nodes[node].fanin0;
+            AIGLiteral fanin1 = aig->nodes[node].fanin1;
+            if (!encoding->variables[AIG_NODE(fanin0)]) {
+                checker->stack[top++] = AIG_NODE(fanin0);
+                continue;
+            }
+            if (!encoding->variables[AIG_NODE(fanin1)]) {
+                checker->stack[top++] = AIG_NODE(fanin1);
+                continue;
+            }
+            int a = encoding->variables[AIG_NODE(fanin0)] * (AIG_IS_COMPLEMENTED(fanin0) ? -1 : 1);
+            int b = encoding->variables[AIG_NODE(fanin1)] * (AIG_IS_COMPLEMENTED(fanin1) ? -1 : 1);
+            variable = sat_new_variable(encoding->solver);
+            // variable <-> a AND b
+            if (variable < 0 || add_clause3(encoding->solver, -variable, a, 0) != 0 ||
+                add_clause3(encoding->solver, -variable, b, 0) != 0 ||
+                add_clause3(encoding->solver, variable, -a, -b) != 0) {
+                return 0;
+            }
+        } else {
+            variable = sat_new_variable(encoding->solver);
+            if (variable < 0) return 0;
+            if (!aig_is_input(aig, node)) {
+                int constant = -variable;
+                if (sat_add_clause(encoding->solver, &constant, 1) != 0) return 0;
+            }
+        }
+        encoding->variables[node] = variable;
+        top--;
+    }
+    int variable = encoding->variables[AIG_NODE(literal)];
+    return AIG_IS_COMPLEMENTED(literal) ? -variable : variable;
+}
+
+// Decide the remaining miters with one incremental solver; returns 0 or -1
+static int solve_miters(Checker* checker, long conflict_limit, EquivalenceResult* results) {
+    const AIG* aig = checker->aig;
+    Encoding encoding = {create_sat_solver(), calloc(aig->node_count, sizeof(int))};
+    int status = encoding.solver && encoding.variables ? 0 : -1;
+
+    for (int i = 0; i < checker->count && status == 0; i++) {
+        if (results[i].verdict != EQUIVALENCE_UNDECIDED) continue;
+        int miter = encode_literal(checker, &encoding, aig->outputs[i]);
+        if (!miter) {
+            status = -1;
+            break;
+        }
+
+        SATResult result = sat_solve(encoding.solver, &miter, 1, conflict_limit);
+        if (result == SAT_UNSATISFIABLE) {
+            // Later miters may share the cone, so keep the fact
+            int agree = -miter;
+            results[i].verdict = EQUIVALENT_BY_SAT;
+            if (sat_add_clause(encoding.solver, &agree, 1) != 0) status = -1;
+        } else if (result == SAT_SATISFIABLE) {
+            // Inputs outside the encoded cones do not matter and stay FALSE
+            for (int k = 0; k < aig->input_count; k++) {
+                int variable = encoding.variables[aig->input_nodes[k]];
+                checker->input_values[k] = variable ? sat_model_value(encoding.solver, variable) : 0;
+            }
+            status = record_counterexample(checker, i, &results[i]);
+        }
+    }
+
+    free(encoding.variables);
+    free_sat_solver(encoding.solver);
+    return status;
+}
+
+// Lower both programs and add the outputs: miters 0 .. count - 1, then the
+// old and the new statements. Returns NULL or an error message.
+static char* build_miters(AIG* aig, const EquivalenceProgram* old_program, const EquivalenceProgram* new_program,
+                          int count) {
+    DefinitionLiterals old_definitions = {old_program->definitions, NULL};
+    DefinitionLiterals new_definitions = {new_program->definitions, NULL};
+    AIGLiteral* literals = malloc((count > 0 ? 2 * count : 1) * sizeof(AIGLiteral));
+    char* error = NULL;
+    if (!literals || lower_definitions(aig, &old_definitions) != 0 ||
+        lower_definitions(aig, &new_definitions) != 0) {
+        error = format_message("Out of memory lowering the definitions");
+    }
+
+    for (int i = 0; i < count && !error; i++) {
+        AIGLiteral old_literal = aig_from_node_resolved(aig, old_program->statements[i], resolve_definition,
+                                                        &old_definitions);
+        AIGLiteral new_literal = aig_from_node_resolved(aig, new_program->statements[i], resolve_definition,
+                                                        &new_definitions);
+        if (old_literal == AIG_INVALID || new_literal == AIG_INVALID ||
+            aig_add_output(aig, aig_xor(aig, old_literal, new_literal)) < 0) {
+            error = format_message("Failed to lower statement %d", i + 1);
+        } else {
+            literals[i] = old_literal;
+            literals[count + i] = new_literal;
+        }
+    }
+    for (int i = 0; i < 2 * count && !error; i++) {
+        if (aig_add_output(aig, literals[i]) < 0) error = format_message("Out of memory building the miters");
+    }
+
+    free(literals);
+    free(old_definitions.literals);
+    free(new_definitions.literals);
+    return error;
+}
+
+// Mark the undecided miters that have become constant FALSE with verdict and
+// return how many remain undecided
+static int settle_constant_miters(const AIG* aig, int count, EquivalenceVerdict verdict,
+                                  EquivalenceResult* results) {
+    int undecided = 0;
+    for (int i = 0; i < count; i++) {
+        if (results[i].verdict != EQUIVALENCE_UNDECIDED) continue;
+        if (aig->outputs[i] == AIG_FALSE) {
+            results[i].verdict = verdict;
+        } else {
+            undecided++;
+        }
+    }
+    return undecided;
+}
+
+int check_equivalence(const EquivalenceProgram* old_program, const EquivalenceProgram* new_program, int count,
+                      long conflict_limit, EquivalenceResult* results, char** error_message) {
+    if (error_message) *error_message = NULL;
+    for (int i = 0; i < count; i++) {
+        memset(&results[i], 0, sizeof(EquivalenceResult));
+        results[i].verdict = EQUIVALENCE_UNDECIDED;
+    }
+
+    Checker checker = {create_aig(), count};
+    if (!checker.aig) {
+        set_error(error_message, format_message("Out of memory checking equivalence"));
+        return -1;
+    }
+    char* error = build_miters(checker.aig, old_program, new_program, count);
+    if (error) {
+        set_error(error_message, error);
+        free_aig(checker.aig);
+        return -1;
+    }
+
+    // Structural hashing already folded the miters of identical statements
+    int status = 0;
+    int undecided = settle_constant_miters(checker.aig, count, EQUIVALENT_BY_HASHING, results);
+    if (undecided > 0) status = begin_walks(&checker) == 0 ? simulate_miters(&checker, results) : -1;
+
+    // The passes leave the graph unchanged when they run out of memory,
+    // which only costs the merges they would have found
+    if (status == 0 && undecided > 0) {
+        aig_rewrite(checker.aig);
+        aig_sweep(checker.aig);
+        undecided = settle_constant_miters(checker.aig, count, EQUIVALENT_BY_SWEEPING, results);
+    }
+    if (status == 0 && undecided > 0) {
+        status = begin_walks(&checker) == 0 ? solve_miters(&checker, conflict_limit, results) : -1;
+    }
+    if (status != 0) set_error(error_message, format_message("Out of memory checking equivalence"));
+
+    end_walks(&checker);
+    free_aig(checker.aig);
+    return status;
+}
+
+void free_equivalence_result(EquivalenceResult* result) {
+    if (!result) return;
+    for (int i = 0; i < result->input_count; i++) free(result->input_names[i]);
+    free(result->input_names);
+    free(result->input_values);
+    result->input_names = NULL;
+    result->input_values = NULL;
+    result->input_count = 0;
+}
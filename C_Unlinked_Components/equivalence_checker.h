@@ -0,0 +1,55 @@
+#ifndef EQUIVALENCE_CHECKER_H
+#define EQUIVALENCE_CHECKER_H
+
+#include "ast.h"
+#include "assignment_graph.h"
+
+// Combinational equivalence of two programs, statement by statement.
+//
+// Both programs are lowered into one And-Inverter Graph over a shared set of
+// inputs, and every pair of statements feeds an XOR, the miter, which is
+// constant FALSE exactly when the statements agree on every input. Each
+// pair is settled by the cheapest step that can: structural hashing, random
+// simulation (which only finds differences), rewriting and sweeping the
+// graph, and finally an incremental SAT solver on the remaining miters.
+//
+// Variables that are never assigned, or are assigned an expression reading
+// no other variable, are inputs. A variable defined by an expression over
+// other variables stands for that expression.
+
+typedef enum {
+    EQUIVALENT_BY_HASHING,      // Both statements lowered to the same literal
+    EQUIVALENT_BY_SWEEPING,     // Merged by rewriting and sweeping the graph
+    EQUIVALENT_BY_SAT,          // The miter is unsatisfiable
+    EQUIVALENCE_DIFFERENT,      // See the counterexample
+    EQUIVALENCE_UNDECIDED       // The SAT conflict limit was reached
+} EquivalenceVerdict;
+
+typedef struct {
+    EquivalenceVerdict verdict;
+
+    // For EQUIVALENCE_DIFFERENT, an assignment to the inputs the two
+    // statements read on which they differ, and their values there
+    char** input_names;
+    int* input_values;
+    int input_count;
+    int old_value;
+    int new_value;
+} EquivalenceResult;
+
+// One side of the comparison
+typedef struct {
+    Node* const* statements;            // Statements other than assignments
+    const AssignmentGraph* definitions; // Resolved, or NULL
+} EquivalenceProgram;
+
+// Compare statement i of old_program with statement i of new_program for
+// every i below count, filling results[i]. conflict_limit bounds the SAT
+// search per pair, 0 for none. Returns 0, or -1 when out of memory or for an
+// expression that cannot be lowered, with *error_message set then.
+int check_equivalence(const EquivalenceProgram* old_program, const EquivalenceProgram* new_program, int count,
+                      long conflict_limit, EquivalenceResult* results, char** error_message);
+
+void free_equivalence_result(EquivalenceResult* result);
+
+#endif /* EQUIVALENCE_CHECKER_H */
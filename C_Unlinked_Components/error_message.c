@@ -0,0 +1,26 @@
+#include "error_message.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+char* format_message(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    int length = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+
+    char* message = malloc(length + 1);
+    if (!message) return NULL;
+    va_start(args, format);
+    vsnprintf(message, length + 1, format, args);
+    va_end(args);
+    return message;
+}
+
+void set_error(char** error_message, char* message) {
+    if (error_message) {
+        *error_message = message;
+    } else {
+        free(message);
+    }
+}
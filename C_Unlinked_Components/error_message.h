@@ -0,0 +1,13 @@
+#ifndef ERROR_MESSAGE_H
+#define ERROR_MESSAGE_H
+
+// Error messages returned through the char** error_message parameters of
+// the library. Messages are allocated; the caller frees them.
+
+// printf-style message, or NULL when out of memory
+char* format_message(const char* format, ...);
+
+// Hand message to the caller, or free it when error_message is NULL
+void set_error(char** error_message, char* message);
+
+#endif /* ERROR_MESSAGE_H */
@@ -0,0 +1,433 @@
+#include "evaluation_cache.h"
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "and_inverter_graph.h"
+#include "error_message.h"
+
+// Evaluations at most this many nodes wide use a buffer on the stack
+#define STACK_VALUES 512
+
+// A statement as a program over local nodes: 0 is FALSE, 1 to support_count
+// are its support, and each gate after them ANDs two earlier local literals
+typedef struct {
+    int* support;           // Input numbers, support[j] is bit j of the signature
+    int support_count;
+    AIGLiteral* gates;      // Two local literals per gate, in topological order
+    int gate_count;
+    AIGLiteral output;      // Local literal of the value
+} StatementProgram;
+
+// Readers copy the fields while version is unchanged and even; an insert
+// makes it odd while it writes them. Fields are atomic so that a copy torn
+// by a racing insert is well defined and then discarded.
+typedef struct {
+    _Atomic uint64_t version;
+    _Atomic uint64_t signature;
+    _Atomic uint64_t tag;       // (statement + 1) << 1 | value, 0 when empty
+    _Atomic int referenced;
+} CacheEntry;
+
+struct EvaluationCache {
+    StatementProgram* programs;
+    int count;
+    char** names;           // Input names by number
+    int* sorted;            // Input numbers in strcmp order of their names
+    int variable_count;
+
+    CacheEntry* entries;    // EVALUATION_CACHE_WAYS consecutive entries per set
+    _Atomic int* hands;     // Clock hand of each set
+    int set_count;          // Always a power of two
+
+    _Atomic long hits;
+    _Atomic long misses;
+    _Atomic long uncached;
+    _Atomic long evictions;
+};
+
+typedef struct {
+    const char* name;
+    AIGLiteral literal;
+} Assigned;
+
+typedef struct {
+    SymbolTable* known;
+    Assigned* assigned;     // Assignments lowered so far, latest last
+    int assigned_count;
+} Resolver;
+
+// Variables assigned by earlier statements read their expression, then
+// known variables their value; the rest become inputs
+static AIGLiteral resolve_variable(void* context, const char* name) {
+    Resolver* resolver = context;
+    for (int i = resolver->assigned_count - 1; i >= 0; i--) {
+        if (strcmp(resolver->assigned[i].name, name) == 0) return resolver->assigned[i].literal;
+    }
+    if (!resolver->known) return AIG_INVALID;
+    int value = get_symbol_value(resolver->known, name);
+    if (value == ERROR_SYMBOL_NOT_FOUND) return AIG_INVALID;
+    return value ? AIG_TRUE : AIG_FALSE;
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+// Compile the cone of output into program. local maps AIG nodes to local
+// nodes and is -1 everywhere on entry and exit; cone and stack hold
+// node_count entries. Returns 0, or -1 when out of memory.
+static int compile_program(const AIG* aig, AIGLiteral output, const int* node_inputs, int* local, int* cone,
+                           int* stack, StatementProgram* program) {
+    int cone_count = 0;
+    int top = 0;
+    if (AIG_NODE(output) != 0) {
+        local[AIG_NODE(output)] = 0;
+        stack[top++] = AIG_NODE(output);
+    }
+    while (top > 0) {
+        int node = stack[--top];
+        cone[cone_count++] = node;
+        if (!aig_is_and(aig, node)) continue;
+        int fanins[2] = {AIG_NODE(aig->nodes[node].fanin0), AIG_NODE(aig->nodes[node].fanin1)};
+        for (int f = 0; f < 2; f++) {
+            if (fanins[f] == 0 || local[fanins[f]] >= 0) continue;
+            local[fanins[f]] = 0;
+            stack[top++] = fanins[f];
+        }
+    }
+    // Node order is topological, so sorting puts fanins before their gates
+    qsort(cone, cone_count, sizeof(int), compare_ints);
+
+    for (int i = 0; i < cone_count; i++) {
+        if (aig_is_input(aig, cone[i])) program->support_count++;
+    }
+    program->gate_count = cone_count - program->support_count;
+    program->support = malloc((program->support_count > 0 ? program->support_count : 1) * sizeof(int));
+    program->gates = malloc((program->gate_count > 0 ? program->gate_count : 1) * 2 * sizeof(AIGLiteral));
+    int status = program->support && program->gates ? 0 : -1;
+
+    int next_input = 1;
+    int next_gate = 1 + program->support_count;
+    for (int i = 0; i < cone_count && status == 0; i++) {
+        if (!aig_is_input(aig, cone[i])) continue;
+        program->support[next_input - 1] = node_inputs[cone[i]];
+        local[cone[i]] = next_input++;
+    }
+    for (int i = 0; i < cone_count && status == 0; i++) {
+        int node = cone[i];
+        if (!aig_is_and(aig, node)) continue;
+        AIGLiteral fanin0 = aig->nodes[node].fanin0;
+        AIGLiteral fanin1 = aig->nodes[node].fanin1;
+        AIGLiteral* gate = &program->gates[2 * (next_gate - 1 - program->support_count)];
+        gate[0] = AIG_LITERAL(local[AIG_NODE(fanin0)], AIG_IS_COMPLEMENTED(fanin0));
+        gate[1] = AIG_LITERAL(local[AIG_NODE(fanin1)], AIG_IS_COMPLEMENTED(fanin1));
+        local[node] = next_gate++;
+    }
+    if (status == 0) {
+        program->output = AIG_LITERAL(AIG_NODE(output) ? local[AIG_NODE(output)] : 0, AIG_IS_COMPLEMENTED(output));
+    }
+    for (int i = 0; i < cone_count; i++) local[cone[i]] = -1;
+    return status;
+}
+
+typedef struct {
+    const char* name;
+    int input;
+} NamedInput;
+
+static int compare_named_inputs(const void* a, const void* b) {
+    return strcmp(((const NamedInput*)a)->name, ((const NamedInput*)b)->name);
+}
+
+// Order cache->sorted by name for evaluation_cache_variable
+static int sort_inputs(EvaluationCache* cache) {
+    NamedInput* named = malloc((cache->variable_count > 0 ? cache->variable_count : 1) * sizeof(NamedInput));
+    if (!named) return -1;
+    for (int i = 0; i < cache->variable_count; i++) {
+        named[i].name = cache->names[i];
+        named[i].input = i;
+    }
+    qsort(named, cache->variable_count, sizeof(NamedInput), compare_named_inputs);
+    for (int i = 0; i < cache->variable_count; i++) cache->sorted[i] = named[i].input;
+    free(named);
+    return 0;
+}
+
+// Lower all statements into one graph, so inputs are numbered across them
+static char* compile_statements(EvaluationCache* cache, Node** statements, SymbolTable* known) {
+    AIG* aig = create_aig();
+    Resolver resolver = {known, malloc((cache->count > 0 ? cache->count : 1) * sizeof(Assigned)), 0};
+    AIGLiteral* outputs = malloc((cache->count > 0 ? cache->count : 1) * sizeof(AIGLiteral));
+    if (!aig || !resolver.assigned || !outputs) {
+        free_aig(aig);
+        free(resolver.assigned);
+        free(outputs);
+        return format_message("Out of memory compiling evaluation cache");
+    }
+
+    char* message = NULL;
+    for (int s = 0; s < cache->count && !message; s++) {
+        outputs[s] = aig_from_node_resolved(aig, statements[s], resolve_variable, &resolver);
+        if (outputs[s] == AIG_INVALID) {
+            message = format_message("Cannot lower statement %d for evaluation", s + 1);
+        } else if (statements[s]->type == NODE_ASSIGN && statements[s]->name) {
+            resolver.assigned[resolver.assigned_count].name = statements[s]->name;
+            resolver.assigned[resolver.assigned_count++].literal = outputs[s];
+        }
+    }
+    free(resolver.assigned);
+
+    int* node_inputs = NULL;
+    int* local = NULL;
+    int* cone = NULL;
+    int* stack = NULL;
+    if (!message) {
+        int nodes = aig->node_count;
+        cache->variable_count = aig->input_count;
+        cache->names = calloc(aig->input_count > 0 ? aig->input_count : 1, sizeof(char*));
+        cache->sorted = malloc((aig->input_count > 0 ? aig->input_count : 1) * sizeof(int));
+        node_inputs = malloc(nodes * sizeof(int));
+        local = malloc(nodes * sizeof(int));
+        cone = malloc(nodes * sizeof(int));
+        stack = malloc(nodes * sizeof(int));
+        if (!cache->names || !cache->sorted || !node_inputs || !local || !cone || !stack) {
+            message = format_message("Out of memory compiling evaluation cache");
+        }
+    }
+    for (int i = 0; !message && i < aig->input_count; i++) {
+        cache->names[i] = strdup(aig->input_names[i]);
+        if (!cache->names[i]) message = format_message("Out of memory compiling evaluation cache");
+        node_inputs[aig->input_nodes[i]] = i;
+    }
+    if (!message && sort_inputs(cache) != 0) message = format_message("Out of memory compiling evaluation cache");
+    if (!message) {
+        for (int i = 0; i < aig->node_count; i++) local[i] = -1;
+    }
+    for (int s = 0; s < cache->count && !message; s++) {
+        if (compile_program(aig, outputs[s], node_inputs, local, cone, stack, &cache->programs[s]) != 0) {
+            message = format_message("Out of memory compiling evaluation cache");
+        }
+    }
+
+    free(node_inputs);
+    free(local);
+    free(cone);
+    free(stack);
+    free(outputs);
+    free_aig(aig);
+    return message;
+}
+
+EvaluationCache* create_evaluation_cache(Node** statements, int count, SymbolTable* known, int capacity,
+                                         char** error_message) {
+    if (error_message) *error_message = NULL;
+    if (capacity < EVALUATION_CACHE_WAYS) capacity = EVALUATION_CACHE_WAYS;
+    int set_count = 1;
+    while (set_count <= capacity / EVALUATION_CACHE_WAYS / 2) set_count *= 2;
+
+    EvaluationCache* cache = calloc(1, sizeof(EvaluationCache));
+    if (cache) {
+        cache->count = count;
+        cache->set_count = set_count;
+        cache->programs = calloc(count > 0 ? count : 1, sizeof(StatementProgram));
+        cache->entries = calloc((size_t)set_count * EVALUATION_CACHE_WAYS, sizeof(CacheEntry));
+        cache->hands = calloc(set_count, sizeof(*cache->hands));
+    }
+    if (!cache || !cache->programs || !cache->entries || !cache->hands) {
+        free_evaluation_cache(cache);
+        set_error(error_message, format_message("Out of memory creating evaluation cache"));
+        return NULL;
+    }
+
+    char* message = compile_statements(cache, statements, known);
+    if (message) {
+        free_evaluation_cache(cache);
+        set_error(error_message, message);
+        return NULL;
+    }
+    return cache;
+}
+
+void free_evaluation_cache(EvaluationCache* cache) {
+    if (!cache) return;
+    for (int s = 0; cache->programs && s < cache->count; s++) {
+        free(cache->programs[s].support);
+        free(cache->programs[s].gates);
+    }
+    for (int i = 0; cache->names && i < cache->variable_count; i++) free(cache->names[i]);
+    free(cache->programs);
+    free(cache->names);
+    free(cache->sorted);
+    free(cache->entries);
+    free(cache->hands);
+    free(cache);
+}
+
+int evaluation_cache_variable_count(const EvaluationCache* cache) {
+    return cache->variable_count;
+}
+
+int evaluation_cache_variable(const EvaluationCache* cache, const char* name) {
+    int low = 0;
+    int high = cache->variable_count - 1;
+    while (low <= high) {
+        int middle = low + (high - low) / 2;
+        int order = strcmp(cache->names[cache->sorted[middle]], name);
+        if (order == 0) return cache->sorted[middle];
+        if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return -1;
+}
+
+void pack_evaluation_inputs(const EvaluationCache* cache, SymbolTable* symbol_table, uint64_t* inputs) {
+    memset(inputs, 0, EVALUATION_CACHE_WORDS(cache->variable_count) * sizeof(uint64_t));
+    for (int i = 0; i < cache->variable_count; i++) {
+        if (get_symbol_value(symbol_table, cache->names[i]) == 1) inputs[i >> 6] |= 1ULL << (i & 63);
+    }
+}
+
+static int input_bit(const uint64_t* inputs, int variable) {
+    return (int)(inputs[variable >> 6] >> (variable & 63) & 1);
+}
+
+// Run program with its support values taken from signature, or from inputs
+// when it has more than 64. Returns the value, or -1 when out of memory.
+static int run_program(const StatementProgram* program, uint64_t signature, const uint64_t* inputs) {
+    int node_count = 1 + program->support_count + program->gate_count;
+    unsigned char buffer[STACK_VALUES];
+    unsigned char* values = node_count <= STACK_VALUES ? buffer : malloc(node_count);
+    if (!values) return -1;
+
+    values[0] = 0;
+    for (int j = 0; j < program->support_count; j++) {
+        values[1 + j] = inputs ? input_bit(inputs, program->support[j]) : (int)(signature >> j & 1);
+    }
+    unsigned char* gate_values = values + 1 + program->support_count;
+    for (int g = 0; g < program->gate_count; g++) {
+        AIGLiteral fanin0 = program->gates[2 * g];
+        AIGLiteral fanin1 = program->gates[2 * g + 1];
+        gate_values[g] = (values[AIG_NODE(fanin0)] ^ AIG_IS_COMPLEMENTED(fanin0)) &
+                         (values[AIG_NODE(fanin1)] ^ AIG_IS_COMPLEMENTED(fanin1));
+    }
+    int value = values[AIG_NODE(program->output)] ^ AIG_IS_COMPLEMENTED(program->output);
+    if (values != buffer) free(values);
+    return value;
+}
+
+static uint64_t hash_key(int index, uint64_t signature) {
+    uint64_t hash = signature ^ ((uint64_t)(index + 1) * 0x9E3779B97F4A7C15ULL);
+    hash ^= hash >> 32;
+    hash *= 0xD6E8FEB86659FD93ULL;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+// Value cached for tag's statement and signature in set, or -1
+static int find_entry(CacheEntry* set, uint64_t tag, uint64_t signature) {
+    for (int way = 0; way < EVALUATION_CACHE_WAYS; way++) {
+        CacheEntry* entry = &set[way];
+        uint64_t version = atomic_load_explicit(&entry->version, memory_order_acquire);
+        if (version & 1) continue;
+        uint64_t found_tag = atomic_load_explicit(&entry->tag, memory_order_relaxed);
+        uint64_t found_signature = atomic_load_explicit(&entry->signature, memory_order_relaxed);
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&entry->version, memory_order_relaxed) != version) continue;
+        if ((found_tag >> 1) != (tag >> 1) || found_signature != signature) continue;
+        if (!atomic_load_explicit(&entry->referenced, memory_order_relaxed)) {
+            atomic_store_explicit(&entry->referenced, 1, memory_order_relaxed);
+        }
+        return (int)(found_tag & 1);
+    }
+    return -1;
+}
+
+// Store a result in set, taking an empty way or the first unreferenced one
+// from the clock hand on. Gives up when another insert holds the victim.
+static void insert_entry(EvaluationCache* cache, int set_index, uint64_t tag, uint64_t signature) {
+    CacheEntry* set = &cache->entries[(size_t)set_index * EVALUATION_CACHE_WAYS];
+    _Atomic int* hand = &cache->hands[set_index];
+    int victim = -1;
+    for (int way = 0; way < EVALUATION_CACHE_WAYS && victim < 0; way++) {
+        if (atomic_load_explicit(&set[way].tag, memory_order_relaxed) == 0) victim = way;
+    }
+    if (victim < 0) {
+        // Referenced ways get a second chance; after one sweep all are clear
+        int start = atomic_load_explicit(hand, memory_order_relaxed);
+        for (int step = 0; step < 2 * EVALUATION_CACHE_WAYS && victim < 0; step++) {
+            int way = (start + step) % EVALUATION_CACHE_WAYS;
+            if (atomic_exchange_explicit(&set[way].referenced, 0, memory_order_relaxed) == 0) victim = way;
+        }
+        if (victim < 0) victim = start % EVALUATION_CACHE_WAYS;
+        atomic_store_explicit(hand, (victim + 1) % EVALUATION_CACHE_WAYS, memory_order_relaxed);
+    }
+
+    CacheEntry* entry = &set[victim];
+    uint64_t version = atomic_load_explicit(&entry->version, memory_order_relaxed);
+    if ((version & 1) || !atomic_compare_exchange_strong_explicit(&entry->version, &version, version + 1,
+                                                                  memory_order_relaxed, memory_order_relaxed)) {
+        return;
+    }
+    atomic_thread_fence(memory_order_release);
+    if (atomic_load_explicit(&entry->tag, memory_order_relaxed) != 0) {
+        atomic_fetch_add_explicit(&cache->evictions, 1, memory_order_relaxed);
+    }
+    atomic_store_explicit(&entry->signature, signature, memory_order_relaxed);
+    atomic_store_explicit(&entry->tag, tag, memory_order_relaxed);
+    atomic_store_explicit(&entry->referenced, 0, memory_order_relaxed);
+    atomic_store_explicit(&entry->version, version + 2, memory_order_release);
+}
+
+int evaluate_cached(EvaluationCache* cache, int index, const uint64_t* inputs) {
+    const StatementProgram* program = &cache->programs[index];
+    if (program->support_count > 64) {
+        atomic_fetch_add_explicit(&cache->uncached, 1, memory_order_relaxed);
+        return run_program(program, 0, inputs);
+    }
+
+    uint64_t signature = 0;
+    for (int j = 0; j < program->support_count; j++) {
+        signature |= (uint64_t)input_bit(inputs, program->support[j]) << j;
+    }
+    int set_index = (int)(hash_key(index, signature) & (uint64_t)(cache->set_count - 1));
+    CacheEntry* set = &cache->entries[(size_t)set_index * EVALUATION_CACHE_WAYS];
+    uint64_t tag = (uint64_t)(index + 1) << 1;
+    int value = find_entry(set, tag, signature);
+    if (value >= 0) {
+        atomic_fetch_add_explicit(&cache->hits, 1, memory_order_relaxed);
+        return value;
+    }
+
+    value = run_program(program, signature, NULL);
+    if (value < 0) return value;
+    atomic_fetch_add_explicit(&cache->misses, 1, memory_order_relaxed);
+    insert_entry(cache, set_index, tag | (uint64_t)value, signature);
+    return value;
+}
+
+void get_evaluation_cache_stats(const EvaluationCache* cache, EvaluationCacheStats* stats) {
+    stats->hits = atomic_load_explicit(&cache->hits, memory_order_relaxed);
+    stats->misses = atomic_load_explicit(&cache->misses, memory_order_relaxed);
+    stats->uncached = atomic_load_explicit(&cache->uncached, memory_order_relaxed);
+    stats->evictions = atomic_load_explicit(&cache->evictions, memory_order_relaxed);
+    stats->capacity = cache->set_count * EVALUATION_CACHE_WAYS;
+}
+
+void clear_evaluation_cache(EvaluationCache* cache) {
+    for (size_t i = 0; i < (size_t)cache->set_count * EVALUATION_CACHE_WAYS; i++) {
+        atomic_store_explicit(&cache->entries[i].tag, 0, memory_order_relaxed);
+        atomic_store_explicit(&cache->entries[i].signature, 0, memory_order_relaxed);
+        atomic_store_explicit(&cache->entries[i].referenced, 0, memory_order_relaxed);
+    }
+    for (int i = 0; i < cache->set_count; i++) atomic_store_explicit(&cache->hands[i], 0, memory_order_relaxed);
+    atomic_store_explicit(&cache->hits, 0, memory_order_relaxed);
+    atomic_store_explicit(&cache->misses, 0, memory_order_relaxed);
+    atomic_store_explicit(&cache->uncached, 0, memory_order_relaxed);
+    atomic_store_explicit(&cache->evictions, 0, memory_order_relaxed);
+}
@@ -0,0 +1,70 @@
+#ifndef EVALUATION_CACHE_H
+#define EVALUATION_CACHE_H
+
+#include <stdint.h>
+#include "ast.h"
+#include "symbol_table.h"
+
+// Memoized evaluation of a fixed set of statements for inputs that repeat.
+//
+// Each statement is lowered once to an And-Inverter Graph and compiled to
+// a small program over its support, the free variables its value depends
+// on. Inputs are passed bit-packed, one bit per variable, and the values
+// of a statement's support packed into one 64-bit word form its signature.
+// Results are kept in a bounded cache keyed by (statement, signature), so
+// repeated combinations skip evaluation entirely.
+//
+// The cache is set-associative with clock replacement: a hit marks its
+// entry, and an insert evicts the first unmarked entry of its set, clearing
+// marks as it passes. It is lock-free, so any number of threads can
+// evaluate at once: entries are guarded by a version that is odd while an
+// insert writes them, readers that see it change treat the entry as a miss,
+// and inserts that lose a race are dropped. Statements over more than 64
+// variables are always evaluated and counted as uncached.
+
+#define EVALUATION_CACHE_WAYS 4
+#define EVALUATION_CACHE_DEFAULT_CAPACITY 65536
+
+// 64-bit words of a packed input state over variable_count variables
+#define EVALUATION_CACHE_WORDS(variable_count) (((variable_count) + 63) / 64)
+
+typedef struct EvaluationCache EvaluationCache;
+
+typedef struct {
+    long hits;
+    long misses;            // Evaluated and inserted
+    long uncached;          // Evaluated without the cache, support too large
+    long evictions;         // Inserts that replaced another result
+    int capacity;           // Entries, a power of two
+} EvaluationCacheStats;
+
+// Compile statements for memoized evaluation. Variables found in known,
+// which may be NULL, keep their value there; the other free variables are
+// inputs, numbered in order of first use. capacity is the entry limit,
+// rounded down to a power of two of at least EVALUATION_CACHE_WAYS.
+// Returns NULL and sets *error_message when a statement cannot be lowered
+// or memory runs out. The statements may be freed afterwards.
+EvaluationCache* create_evaluation_cache(Node** statements, int count, SymbolTable* known, int capacity,
+                                         char** error_message);
+void free_evaluation_cache(EvaluationCache* cache);
+
+int evaluation_cache_variable_count(const EvaluationCache* cache);
+
+// Input number of the variable name, or -1 when no statement reads it
+int evaluation_cache_variable(const EvaluationCache* cache, const char* name);
+
+// Pack the values of the inputs in symbol_table into inputs
+// (EVALUATION_CACHE_WORDS(variable count) words); missing inputs are FALSE
+void pack_evaluation_inputs(const EvaluationCache* cache, SymbolTable* symbol_table, uint64_t* inputs);
+
+// Value (0 or 1) of statement index for the packed inputs, from the cache
+// when the same statement was evaluated for the same support values before,
+// or -1 when out of memory
+int evaluate_cached(EvaluationCache* cache, int index, const uint64_t* inputs);
+
+void get_evaluation_cache_stats(const EvaluationCache* cache, EvaluationCacheStats* stats);
+
+// Drop every entry and zero the counters; not safe while other threads evaluate
+void clear_evaluation_cache(EvaluationCache* cache);
+
+#endif /* EVALUATION_CACHE_H */
@@ -0,0 +1,581 @@
+#include "incremental_evaluator.h"
+#include "error_message.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// One cached node. Slots of a statement are stored in post-order, so its
+// children come before it and its root is the last slot of the statement.
+typedef struct {
+    const Node* node;
+    int parent;             // -1 for statement roots
+    int left;               // Child slots, -1 if absent
+    int right;
+    int first_operand;      // Operand slots of a threshold are operands[first_operand] ..
+    int operand_count;
+    int true_count;         // Operands of a threshold currently TRUE
+    int variable;           // Variable read by a VAR slot, else -1
+    int statement;
+    int level;              // Longer than any dependency path into the slot
+    int value;
+    int queued;
+} EvaluationSlot;
+
+typedef struct {
+    const char* name;       // Borrowed from the statements
+    int value;
+    int definition;         // Assignment statement defining it, or -1 for inputs
+    int* readers;           // Slots whose value depends on it
+    int reader_count;
+    int reader_capacity;
+} TrackedVariable;
+
+struct IncrementalEvaluator {
+    SymbolTable* symbol_table;
+    Node** statements;
+    int statement_count;
+    int* first_slots;       // Slots of statement s are first_slots[s] .. first_slots[s + 1] - 1
+    EvaluationSlot* slots;
+    int slot_count;
+    int slot_capacity;
+    int* operands;          // Operand slots of the threshold slots
+    int operand_count;
+    int operand_capacity;
+    TrackedVariable* variables;
+    int variable_count;
+    int variable_capacity;
+    NameIndex variable_index;
+    int* heap;              // Dirty slots ordered by level
+    int heap_size;
+    int* changes;           // Statements changed by the last update
+    int change_count;
+    int* change_marks;      // change_marks[s] == update_stamp once s is in changes
+    int update_stamp;
+};
+
+static const char* variable_name(const void* variables, int entry) {
+    return ((const TrackedVariable*)variables)[entry].name;
+}
+
+static int find_variable(const IncrementalEvaluator* evaluator, const char* name) {
+    return name_index_find(&evaluator->variable_index, name, variable_name, evaluator->variables);
+}
+
+// Index of name, adding it as an input variable if it is new; -1 on failure
+static int intern_variable(IncrementalEvaluator* evaluator, const char* name) {
+    int index = find_variable(evaluator, name);
+    if (index >= 0) return index;
+
+    if (evaluator->variable_count >= evaluator->variable_capacity) {
+        int capacity = evaluator->variable_capacity ? evaluator->variable_capacity * 2 : 16;
+        TrackedVariable* variables = realloc(evaluator->variables, capacity * sizeof(TrackedVariable));
+        if (!variables) return -1;
+        evaluator->variables = variables;
+        evaluator->variable_capacity = capacity;
+    }
+    index = evaluator->variable_count;
+    if (name_index_add(&evaluator->variable_index, name, index, variable_name, evaluator->variables) != 0) {
+        return -1;
+    }
+
+    evaluator->variable_count++;
+    TrackedVariable* variable = &evaluator->variables[index];
+    memset(variable, 0, sizeof(*variable));
+    variable->name = name;
+    variable->definition = -1;
+    return index;
+}
+
+static int add_reader(IncrementalEvaluator* evaluator, int variable_index, int slot) {
+    TrackedVariable* variable = &evaluator->variables[variable_index];
+    if (variable->reader_count > 0 && variable->readers[variable->reader_count - 1] == slot) return 0;
+    if (variable->reader_count >= variable->reader_capacity) {
+        int capacity = variable->reader_capacity ? variable->reader_capacity * 2 : 4;
+        int* readers = realloc(variable->readers, capacity * sizeof(int));
+        if (!readers) return -1;
+        variable->readers = readers;
+        variable->reader_capacity = capacity;
+    }
+    variable->readers[variable->reader_count++] = slot;
+    return 0;
+}
+
+// Register quantifier_slot as a reader of every free variable under node
+static int index_quantifier_body(IncrementalEvaluator* evaluator, const Node* node,
+                                 const QuantifierBinding* scope, int quantifier_slot) {
+    if (!node) return 0;
+
+    if (node->type == NODE_VAR) {
+        if (!node->name) return -1;
+        if (find_quantifier_binding(scope, node->name)) return 0;
+        int variable = intern_variable(evaluator, node->name);
+        return variable < 0 ? -1 : add_reader(evaluator, variable, quantifier_slot);
+    }
+    if (node->type == NODE_EXISTS || node->type == NODE_FORALL) {
+        if (!node->name) return -1;
+        QuantifierBinding binding = {node->name, 0, scope};
+        return index_quantifier_body(evaluator, node->left, &binding, quantifier_slot);
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        if (index_quantifier_body(evaluator, node->children[i], scope, quantifier_slot) != 0) return -1;
+    }
+    if (index_quantifier_body(evaluator, node->left, scope, quantifier_slot) != 0) return -1;
+    return index_quantifier_body(evaluator, node->right, scope, quantifier_slot);
+}
+
+static int flatten_node(IncrementalEvaluator* evaluator, const Node* node, int statement);
+
+// Flatten the operands of a threshold node and list their root slots;
+// returns the position of the first in evaluator->operands, or -1
+static int flatten_operands(IncrementalEvaluator* evaluator, const Node* node, int statement) {
+    int* roots = malloc((node->child_count > 0 ? node->child_count : 1) * sizeof(int));
+    if (!roots) return -1;
+    for (int i = 0; i < node->child_count; i++) {
+        roots[i] = flatten_node(evaluator, node->children[i], statement);
+        if (roots[i] < 0) {
+            free(roots);
+            return -1;
+        }
+    }
+
+    if (evaluator->operand_count + node->child_count > evaluator->operand_capacity) {
+        int capacity = evaluator->operand_capacity ? evaluator->operand_capacity * 2 : 64;
+        while (capacity < evaluator->operand_count + node->child_count) capacity *= 2;
+        int* operands = realloc(evaluator->operands, capacity * sizeof(int));
+        if (!operands) {
+            free(roots);
+            return -1;
+        }
+        evaluator->operands = operands;
+        evaluator->operand_capacity = capacity;
+    }
+    int first = evaluator->operand_count;
+    memcpy(evaluator->operands + first, roots, node->child_count * sizeof(int));
+    evaluator->operand_count += node->child_count;
+    free(roots);
+    return first;
+}
+
+// Append the slots of a subtree in post-order; returns its root slot or -1
+static int flatten_node(IncrementalEvaluator* evaluator, const Node* node, int statement) {
+    if (!node) return -1;
+
+    int left = -1, right = -1, first_operand = -1;
+    int quantifier = node->type == NODE_EXISTS || node->type == NODE_FORALL;
+    if (is_threshold_type(node->type)) {
+        first_operand = flatten_operands(evaluator, node, statement);
+        if (first_operand < 0) return -1;
+    } else if (node->type == NODE_ASSIGN) {
+        left = flatten_node(evaluator, get_assignment_expression(node), statement);
+        if (left < 0) return -1;
+    } else if (!quantifier && node->type != NODE_VAR && node->type != NODE_BOOL) {
+        left = flatten_node(evaluator, node->left, statement);
+        if (left < 0) return -1;
+        if (node->type != NODE_NOT) {
+            right = flatten_node(evaluator, node->right, statement);
+            if (right < 0) return -1;
+        }
+    }
+
+    if (evaluator->slot_count >= evaluator->slot_capacity) {
+        int capacity = evaluator->slot_capacity ? evaluator->slot_capacity * 2 : 64;
+        EvaluationSlot* slots = realloc(evaluator->slots, capacity * sizeof(EvaluationSlot));
+        if (!slots) return -1;
+        evaluator->slots = slots;
+        evaluator->slot_capacity = capacity;
+    }
+    int index = evaluator->slot_count++;
+    EvaluationSlot* slot = &evaluator->slots[index];
+    memset(slot, 0, sizeof(*slot));
+    slot->node = node;
+    slot->parent = -1;
+    slot->left = left;
+    slot->right = right;
+    slot->first_operand = first_operand;
+    slot->variable = -1;
+    slot->statement = statement;
+    if (left >= 0) evaluator->slots[left].parent = index;
+    if (right >= 0) evaluator->slots[right].parent = index;
+    if (first_operand >= 0) {
+        slot->operand_count = node->child_count;
+        for (int i = 0; i < node->child_count; i++) {
+            evaluator->slots[evaluator->operands[first_operand + i]].parent = index;
+        }
+    }
+
+    if (node->type == NODE_VAR) {
+        if (!node->name) return -1;
+        slot->variable = intern_variable(evaluator, node->name);
+        if (slot->variable < 0 || add_reader(evaluator, slot->variable, index) != 0) return -1;
+    } else if (quantifier) {
+        if (!node->name || !node->left) return -1;
+        QuantifierBinding binding = {node->name, 0, NULL};
+        if (index_quantifier_body(evaluator, node->left, &binding, index) != 0) return -1;
+    }
+    return index;
+}
+
+// Current value of a variable read inside a quantifier subtree, or -1
+static int tracked_variable_value(const void* context, const char* name) {
+    const IncrementalEvaluator* evaluator = context;
+    int variable = find_variable(evaluator, name);
+    return variable < 0 ? -1 : evaluator->variables[variable].value;
+}
+
+// Recompute one slot from its children and variables; -1 if impossible
+static int compute_slot(const IncrementalEvaluator* evaluator, const EvaluationSlot* slot) {
+    const EvaluationSlot* slots = evaluator->slots;
+    int left = slot->left >= 0 ? slots[slot->left].value : 0;
+    int right = slot->right >= 0 ? slots[slot->right].value : 0;
+
+    switch (slot->node->type) {
+        case NODE_BOOL: return slot->node->bool_val ? 1 : 0;
+        case NODE_VAR: return evaluator->variables[slot->variable].value;
+        case NODE_ASSIGN: return left;
+        case NODE_NOT: return !left;
+        case NODE_AND: return left && right;
+        case NODE_OR: return left || right;
+        case NODE_XOR: return left != right;
+        case NODE_XNOR: return left == right;
+        case NODE_IMPLIES: return !left || right;
+        case NODE_IFF:
+        case NODE_EQUIV: return left == right;
+        case NODE_EXISTS:
+        case NODE_FORALL: return evaluate_bound_expression(slot->node, NULL, tracked_variable_value, evaluator);
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY: return threshold_holds(slot->node->type, slot->node->threshold, slot->true_count);
+        default: return -1;
+    }
+}
+
+// A slot's level exceeds its children's; readers of an assigned variable
+// were already raised above the assignment's root when it was evaluated
+static int slot_level(const IncrementalEvaluator* evaluator, int index) {
+    const EvaluationSlot* slot = &evaluator->slots[index];
+    int level = slot->level;
+    if (slot->left >= 0 && evaluator->slots[slot->left].level >= level) level = evaluator->slots[slot->left].level + 1;
+    if (slot->right >= 0 && evaluator->slots[slot->right].level >= level) level = evaluator->slots[slot->right].level + 1;
+    for (int i = 0; i < slot->operand_count; i++) {
+        int operand = evaluator->operands[slot->first_operand + i];
+        if (evaluator->slots[operand].level >= level) level = evaluator->slots[operand].level + 1;
+    }
+    return level;
+}
+
+// Order statements so every assignment comes before the statements reading
+// its variable. Returns an allocated order, or NULL on a cycle or no memory.
+static int* order_statements(const IncrementalEvaluator* evaluator, int* cyclic_statement) {
+    int count = evaluator->statement_count;
+    int* waiting = calloc(count > 0 ? count : 1, sizeof(int));
+    int* order = malloc((count > 0 ? count : 1) * sizeof(int));
+    if (!waiting || !order) {
+        free(waiting);
+        free(order);
+        return NULL;
+    }
+
+    for (int v = 0; v < evaluator->variable_count; v++) {
+        const TrackedVariable* variable = &evaluator->variables[v];
+        if (variable->definition < 0) continue;
+        for (int r = 0; r < variable->reader_count; r++) {
+            waiting[evaluator->slots[variable->readers[r]].statement]++;
+        }
+    }
+
+    int ordered = 0;
+    for (int s = 0; s < count; s++) {
+        if (waiting[s] == 0) order[ordered++] = s;
+    }
+    for (int k = 0; k < ordered; k++) {
+        const Node* root = evaluator->statements[order[k]];
+        if (root->type != NODE_ASSIGN) continue;
+        int v = find_variable(evaluator, root->name);
+        if (v < 0 || evaluator->variables[v].definition != order[k]) continue;
+        const TrackedVariable* variable = &evaluator->variables[v];
+        for (int r = 0; r < variable->reader_count; r++) {
+            int reader = evaluator->slots[variable->readers[r]].statement;
+            if (--waiting[reader] == 0) order[ordered++] = reader;
+        }
+    }
+
+    if (ordered < count) {
+        for (int s = 0; s < count; s++) {
+            if (waiting[s] > 0) {
+                *cyclic_statement = s;
+                break;
+            }
+        }
+        free(order);
+        order = NULL;
+    }
+    free(waiting);
+    return order;
+}
+
+static void record_change(IncrementalEvaluator* evaluator, int statement) {
+    if (evaluator->change_marks[statement] == evaluator->update_stamp) return;
+    evaluator->change_marks[statement] = evaluator->update_stamp;
+    evaluator->changes[evaluator->change_count++] = statement;
+}
+
+// Binary min-heap of dirty slots keyed by level, so a slot is recomputed only
+// after every dirty slot it depends on
+static int heap_before(const IncrementalEvaluator* evaluator, int a, int b) {
+    return evaluator->slots[a].level < evaluator->slots[b].level;
+}
+
+static void heap_push(IncrementalEvaluator* evaluator, int slot) {
+    if (evaluator->slots[slot].queued) return;
+    evaluator->slots[slot].queued = 1;
+
+    int* heap = evaluator->heap;
+    int position = evaluator->heap_size++;
+    while (position > 0) {
+        int parent = (position - 1) / 2;
+        if (!heap_before(evaluator, slot, heap[parent])) break;
+        heap[position] = heap[parent];
+        position = parent;
+    }
+    heap[position] = slot;
+}
+
+static int heap_pop(IncrementalEvaluator* evaluator) {
+    int* heap = evaluator->heap;
+    int top = heap[0];
+    int last = heap[--evaluator->heap_size];
+    int position = 0;
+    for (;;) {
+        int child = position * 2 + 1;
+        if (child >= evaluator->heap_size) break;
+        if (child + 1 < evaluator->heap_size && heap_before(evaluator, heap[child + 1], heap[child])) child++;
+        if (!heap_before(evaluator, heap[child], last)) break;
+        heap[position] = heap[child];
+        position = child;
+    }
+    if (evaluator->heap_size > 0) heap[position] = last;
+    evaluator->slots[top].queued = 0;
+    return top;
+}
+
+static void push_readers(IncrementalEvaluator* evaluator, const TrackedVariable* variable) {
+    for (int r = 0; r < variable->reader_count; r++) {
+        heap_push(evaluator, variable->readers[r]);
+    }
+}
+
+// Store a statement's new value; an assignment also updates its variable
+static int publish_statement(IncrementalEvaluator* evaluator, int statement, int value) {
+    const Node* root = evaluator->statements[statement];
+    if (root->type != NODE_ASSIGN) return 0;
+
+    int v = find_variable(evaluator, root->name);
+    if (v < 0 || evaluator->variables[v].definition != statement) return 0;
+    evaluator->variables[v].value = value;
+    return add_or_update_symbol(evaluator->symbol_table, root->name, value);
+}
+
+// Recompute dirty slots until nothing changes
+static void propagate(IncrementalEvaluator* evaluator) {
+    while (evaluator->heap_size > 0) {
+        int index = heap_pop(evaluator);
+        EvaluationSlot* slot = &evaluator->slots[index];
+        int value = compute_slot(evaluator, slot);
+        if (value < 0 || value == slot->value) continue;
+
+        slot->value = value;
+        if (slot->parent >= 0) {
+            // A threshold parent keeps its count up to date, so it is
+            // recomputed in constant time whichever operand changed
+            EvaluationSlot* parent = &evaluator->slots[slot->parent];
+            if (parent->operand_count > 0) parent->true_count += value ? 1 : -1;
+            heap_push(evaluator, slot->parent);
+            continue;
+        }
+        record_change(evaluator, slot->statement);
+        publish_statement(evaluator, slot->statement, value);
+        const Node* root = evaluator->statements[slot->statement];
+        if (root->type == NODE_ASSIGN) {
+            int v = find_variable(evaluator, root->name);
+            if (v >= 0 && evaluator->variables[v].definition == slot->statement) {
+                push_readers(evaluator, &evaluator->variables[v]);
+            }
+        }
+    }
+}
+
+IncrementalEvaluator* create_incremental_evaluator(Node** statements, int count, SymbolTable* symbol_table,
+                                                   char** error_message) {
+    IncrementalEvaluator* evaluator = calloc(1, sizeof(IncrementalEvaluator));
+    if (!evaluator) return NULL;
+
+    evaluator->symbol_table = symbol_table;
+    evaluator->statements = statements;
+    evaluator->statement_count = count;
+    evaluator->first_slots = malloc((count + 1) * sizeof(int));
+    evaluator->changes = malloc((count > 0 ? count : 1) * sizeof(int));
+    evaluator->change_marks = calloc(count > 0 ? count : 1, sizeof(int));
+    char* message = NULL;
+    if (!evaluator->first_slots || !evaluator->changes || !evaluator->change_marks) goto fail;
+
+    // Assignments define their variables; the last definition wins
+    for (int s = 0; s < count; s++) {
+        if (!statements[s]) {
+            message = format_message("Statement %d is empty", s);
+            goto fail;
+        }
+        if (statements[s]->type != NODE_ASSIGN) continue;
+        if (!statements[s]->name || !get_assignment_expression(statements[s])) {
+            message = format_message("Invalid assignment in statement %d", s);
+            goto fail;
+        }
+        int v = intern_variable(evaluator, statements[s]->name);
+        if (v < 0) goto fail;
+        evaluator->variables[v].definition = s;
+    }
+
+    for (int s = 0; s < count; s++) {
+        evaluator->first_slots[s] = evaluator->slot_count;
+        if (flatten_node(evaluator, statements[s], s) < 0) {
+            if (!message) message = format_message("Cannot evaluate statement %d", s);
+            goto fail;
+        }
+    }
+    evaluator->first_slots[count] = evaluator->slot_count;
+
+    // Inputs start from the symbol table
+    for (int v = 0; v < evaluator->variable_count; v++) {
+        TrackedVariable* variable = &evaluator->variables[v];
+        if (variable->definition >= 0) continue;
+        int value = get_symbol_value(symbol_table, variable->name);
+        if (value == ERROR_SYMBOL_NOT_FOUND) {
+            message = format_message("Undefined variable '%s'", variable->name);
+            goto fail;
+        }
+        variable->value = value != 0;
+    }
+
+    // Full evaluation in dependency order fills every cached value and level
+    int cyclic_statement = -1;
+    int* order = order_statements(evaluator, &cyclic_statement);
+    if (!order) {
+        if (cyclic_statement >= 0) {
+            const Node* root = statements[cyclic_statement];
+            message = root->type == NODE_ASSIGN
+                ? format_message("Circular assignment involving '%s'", root->name)
+                : format_message("Statement %d depends on a circular assignment", cyclic_statement);
+        }
+        goto fail;
+    }
+    for (int k = 0; k < count; k++) {
+        int s = order[k];
+        for (int i = evaluator->first_slots[s]; i < evaluator->first_slots[s + 1]; i++) {
+            EvaluationSlot* slot = &evaluator->slots[i];
+            slot->level = slot_level(evaluator, i);
+            for (int j = 0; j < slot->operand_count; j++) {
+                slot->true_count += evaluator->slots[evaluator->operands[slot->first_operand + j]].value;
+            }
+            slot->value = compute_slot(evaluator, slot);
+            if (slot->value < 0) {
+                message = format_message("Cannot evaluate statement %d", s);
+                free(order);
+                goto fail;
+            }
+        }
+        const EvaluationSlot* root = &evaluator->slots[evaluator->first_slots[s + 1] - 1];
+        publish_statement(evaluator, s, root->value);
+        if (statements[s]->type == NODE_ASSIGN) {
+            const TrackedVariable* variable = &evaluator->variables[find_variable(evaluator, statements[s]->name)];
+            if (variable->definition != s) continue;
+            for (int r = 0; r < variable->reader_count; r++) {
+                EvaluationSlot* reader = &evaluator->slots[variable->readers[r]];
+                if (reader->level <= root->level) reader->level = root->level + 1;
+            }
+        }
+    }
+    free(order);
+
+    evaluator->heap = malloc((evaluator->slot_count > 0 ? evaluator->slot_count : 1) * sizeof(int));
+    if (!evaluator->heap) goto fail;
+    return evaluator;
+
+fail:
+    if (error_message) {
+        *error_message = message ? message : strdup("Out of memory while indexing statements");
+    } else {
+        free(message);
+    }
+    free_incremental_evaluator(evaluator);
+    return NULL;
+}
+
+int incremental_update_symbols(IncrementalEvaluator* evaluator, const char* const* names, const int* values,
+                               int count) {
+    if (!evaluator) return ERROR_SYMBOL_NOT_DEFINED;
+
+    evaluator->update_stamp++;
+    evaluator->change_count = 0;
+    for (int i = 0; i < count; i++) {
+        if (!names[i]) return ERROR_SYMBOL_NOT_DEFINED;
+        int v = find_variable(evaluator, names[i]);
+        if (v >= 0 && evaluator->variables[v].definition >= 0) return ERROR_SYMBOL_DERIVED;
+    }
+
+    // Add names new to the table first, so a failure leaves every tracked
+    // value as it was. Tracked inputs are already in the table.
+    for (int i = 0; i < count; i++) {
+        if (find_symbol_index(evaluator->symbol_table, names[i]) >= 0) continue;
+        int status = add_or_update_symbol(evaluator->symbol_table, names[i], values[i]);
+        if (status != 0) return status;
+    }
+
+    for (int i = 0; i < count; i++) {
+        add_or_update_symbol(evaluator->symbol_table, names[i], values[i]);
+
+        // Variables no statement reads need no further work
+        int v = find_variable(evaluator, names[i]);
+        if (v < 0) continue;
+        TrackedVariable* variable = &evaluator->variables[v];
+        int value = values[i] != 0;
+        if (variable->value == value) continue;
+        variable->value = value;
+        push_readers(evaluator, variable);
+    }
+    propagate(evaluator);
+    return evaluator->change_count;
+}
+
+int incremental_update_symbol(IncrementalEvaluator* evaluator, const char* name, int value) {
+    return incremental_update_symbols(evaluator, &name, &value, 1);
+}
+
+int get_incremental_result(const IncrementalEvaluator* evaluator, int index) {
+    if (!evaluator || index < 0 || index >= evaluator->statement_count) return ERROR_SYMBOL_NOT_FOUND;
+    return evaluator->slots[evaluator->first_slots[index + 1] - 1].value;
+}
+
+const int* get_incremental_changes(const IncrementalEvaluator* evaluator, int* count) {
+    if (!evaluator) {
+        if (count) *count = 0;
+        return NULL;
+    }
+    if (count) *count = evaluator->change_count;
+    return evaluator->changes;
+}
+
+void free_incremental_evaluator(IncrementalEvaluator* evaluator) {
+    if (!evaluator) return;
+
+    for (int v = 0; v < evaluator->variable_count; v++) {
+        free(evaluator->variables[v].readers);
+    }
+    free(evaluator->variables);
+    free_name_index(&evaluator->variable_index);
+    free(evaluator->slots);
+    free(evaluator->operands);
+    free(evaluator->first_slots);
+    free(evaluator->heap);
+    free(evaluator->changes);
+    free(evaluator->change_marks);
+    free(evaluator);
+}
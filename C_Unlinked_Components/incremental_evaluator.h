@@ -0,0 +1,47 @@
+#ifndef INCREMENTAL_EVALUATOR_H
+#define INCREMENTAL_EVALUATOR_H
+
+#include "ast.h"
+#include "symbol_table.h"
+
+// Error returned when updating a variable that an assignment statement defines
+#define ERROR_SYMBOL_DERIVED -4
+
+// Keeps the value of every node of a fixed set of statements and a reverse
+// index from each variable to the nodes that read it. Changing a variable
+// recomputes only the nodes on paths from its readers to their statement
+// roots, so the cost of an update follows the size of the change.
+//
+// Assignment statements define variables read by other statements; when an
+// assignment's value changes, the readers of its variable are updated too.
+// Quantifier subtrees are cached as a whole and recomputed when a free
+// variable inside them changes.
+typedef struct IncrementalEvaluator IncrementalEvaluator;
+
+// Evaluate statements once against symbol_table and index them. The
+// statements and the table must outlive the evaluator, and the statements
+// must not be modified while it exists. Returns NULL and sets *error_message
+// on undefined variables or circular assignments.
+IncrementalEvaluator* create_incremental_evaluator(Node** statements, int count, SymbolTable* symbol_table,
+                                                   char** error_message);
+void free_incremental_evaluator(IncrementalEvaluator* evaluator);
+
+// add_or_update_symbol on the evaluator's table, then re-evaluate the affected
+// nodes. Returns the number of statements whose value changed, or
+// ERROR_SYMBOL_DERIVED / an add_or_update_symbol error.
+int incremental_update_symbol(IncrementalEvaluator* evaluator, const char* name, int value);
+
+// Apply several updates, then propagate them together so nodes reading more
+// than one of the variables are recomputed once. A rejected batch changes
+// no value.
+int incremental_update_symbols(IncrementalEvaluator* evaluator, const char* const* names, const int* values,
+                               int count);
+
+// Current value (0 or 1) of statements[index]
+int get_incremental_result(const IncrementalEvaluator* evaluator, int index);
+
+// Indices of the statements whose value changed in the last update, in the
+// order they were recomputed
+const int* get_incremental_changes(const IncrementalEvaluator* evaluator, int* count);
+
+#endif /* INCREMENTAL_EVALUATOR_H */
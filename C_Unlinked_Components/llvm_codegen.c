@@ -1,4 +1,5 @@
 #include <stdio.h>
+#include <stdarg.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>  // For mkdtemp
@@ -12,8 +13,15 @@
 #include <llvm-c/BitWriter.h>
 #include <llvm-c/BitReader.h>
 #include <llvm-c/IRReader.h>
+#include <llvm-c/TargetMachine.h>
+#include <llvm-c/Transforms/PassBuilder.h>
+#include <llvm/Config/llvm-config.h>  // For LLVM_VERSION_STRING
 
 #include "llvm_codegen.h"
+#include "thread_pool.h"
+#include "and_inverter_graph.h"
+#include "truth_table.h"
+#include "binary_decision_diagram.h"
 
 // Helper function to get node type name
 static const char* get_node_type_name(NodeType type) {
@@ -31,139 +39,1116 @@ static const char* get_node_type_name(NodeType type) {
         case NODE_EXISTS: return "EXISTS";
         case NODE_FORALL: return "FORALL";
         case NODE_ASSIGN: return "ASSIGN";
+        case NODE_ATLEAST: return "ATLEAST";
+        case NODE_ATMOST: return "ATMOST";
+        case NODE_EXACTLY: return "EXACTLY";
         default: return "UNKNOWN";
     }
 }
 
+// Evaluation messages printed after each operator, indexed by node type
+static const char* const node_evaluation_messages[NODE_TYPE_COUNT] = {
+    [NODE_NOT] = "Evaluated NOT operation\n",
+    [NODE_AND] = "Evaluated AND operation\n",
+    [NODE_OR] = "Evaluated OR operation\n",
+    [NODE_XOR] = "Evaluated XOR operation\n",
+    [NODE_XNOR] = "Evaluated XNOR operation\n",
+    [NODE_IMPLIES] = "Evaluated IMPLIES operation\n",
+    [NODE_IFF] = "Evaluated IFF/EQUIV operation\n",
+    [NODE_EQUIV] = "Evaluated IFF/EQUIV operation\n",
+    [NODE_EXISTS] = "Evaluated EXISTS operation\n",
+    [NODE_FORALL] = "Evaluated FORALL operation\n",
+    [NODE_ATLEAST] = "Evaluated ATLEAST operation\n",
+    [NODE_ATMOST] = "Evaluated ATMOST operation\n",
+    [NODE_EXACTLY] = "Evaluated EXACTLY operation\n",
+};
+
+// Module-level pool of private string constants, keyed by content.
+// Every distinct literal is emitted once no matter how often it is printed.
+typedef struct {
+    char* text;
+    LLVMValueRef ptr;
+} PooledString;
+
+typedef struct {
+    LLVMContextRef context;
+    LLVMModuleRef module;
+    PooledString* entries;  // Open-addressing hash table
+    int size;
+    int capacity;           // Always a power of two
+} StringPool;
+
+// AND or OR of the current statement and its index in the branch profile
+typedef struct {
+    const Node* node;
+    int index;
+} ProfiledOperator;
+
+// Counters of one instrumented AND or OR: evaluations, then per operand how
+// often it had the deciding value
+typedef struct {
+    char key[BRANCH_PROFILE_KEY_LENGTH + 1];
+    int index;
+    int operand_count;
+    LLVMValueRef counters;      // [operand_count + 1 x i64]
+} ProfileSite;
+
+// Value of a quantified variable while generating one cofactor of its quantifier
+typedef struct BoundVariable {
+    const char* name;
+    int value;
+    const struct BoundVariable* next;   // Enclosing quantifiers
+} BoundVariable;
+
+// State shared by the code generation helpers while building one module
+typedef struct {
+    LLVMContextRef context;
+    LLVMModuleRef module;
+    LLVMBuilderRef builder;
+    SymbolTable* symbol_table;
+    StringPool* strings;
+    LLVMOutputFormat output_format;
+    int exports_runtime;        // Runtime helpers are shared with shard modules
+    int use_aig;                // Binary results come from an And-Inverter Graph
+    int use_lookup_tables;      // Binary results of small-support subexpressions come from truth tables
+    TruthTable* tables;         // Tables of the current statement, sorted by node address
+    int table_count;
+    int lookup_count;           // Subexpressions replaced by tables in this module
+    int use_decision_diagrams;  // Binary results branch through a decision diagram per statement
+    int diagram_count;          // Statements generated from diagrams in this module
+    int diagram_nodes;          // and their branch nodes
+    char* const* runtime_variables;
+    int runtime_variable_count;
+    LLVMValueRef inputs_global; // lec_inputs: one byte per runtime variable
+    const BoundVariable* bound; // Innermost quantified variable in scope, or NULL
+
+    // Branch profiles of AND and OR, keyed by the statement being generated
+    int instrument;             // Count operand outcomes into sites
+    const BranchProfile* profile;
+    char statement_key[BRANCH_PROFILE_KEY_LENGTH + 1];
+    ProfiledOperator* operators; // Sorted by node address
+    int operator_count;
+    ProfileSite* sites;
+    int site_count;
+    int site_capacity;
+
+    // Runtime output helpers emitted into the module
+    LLVMValueRef append_func;   // void lec_out_append(i8* data, i64 len)
+    LLVMTypeRef append_type;
+    LLVMValueRef flush_func;    // void lec_out_flush()
+    LLVMTypeRef flush_type;
+    LLVMValueRef write_all_func; // void lec_write_all(i8* data, i64 len)
+    LLVMTypeRef write_all_type;
+
+    // Trace text known at compile time that has not been emitted yet.
+    // Consecutive messages are coalesced into one append call.
+    char* pending;
+    size_t pending_len;
+    size_t pending_capacity;
+
+    // Result bitset for LLVM_OUTPUT_BINARY
+    LLVMValueRef results_global;
+    unsigned char* results_init;
+    size_t results_size;
+} CodegenState;
+
+// Size of the in-memory output buffer of generated executables
+#define OUTPUT_BUFFER_SIZE 65536
+
+// Statements are only split across modules when every shard gets at least
+// this many; shard sizes are multiples of 8 so that no two shards touch the
+// same byte of the binary result bitset
+#define SHARD_MIN_STATEMENTS 512
+
+#define STRING_POOL_INITIAL_CAPACITY 64
+
+// Statements whose decision diagram takes more nodes than this to build
+// are generated from the expression instead
+#define DIAGRAM_NODE_LIMIT 4096
+
+static unsigned long hash_string(const char* text) {
+    // FNV-1a
+    unsigned long hash = 14695981039346656037UL;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        hash ^= *p;
+        hash *= 1099511628211UL;
+    }
+    return hash;
+}
+
+static StringPool* init_string_pool(LLVMModuleRef module) {
+    StringPool* pool = calloc(1, sizeof(StringPool));
+    if (!pool) return NULL;
+
+    pool->context = LLVMGetModuleContext(module);
+    pool->module = module;
+    pool->capacity = STRING_POOL_INITIAL_CAPACITY;
+    pool->entries = calloc(pool->capacity, sizeof(PooledString));
+    if (!pool->entries) {
+        free(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+static void free_string_pool(StringPool* pool) {
+    if (!pool) return;
+    for (int i = 0; i < pool->capacity; i++) {
+        free(pool->entries[i].text);
+    }
+    free(pool->entries);
+    free(pool);
+}
+
+// Find the slot holding text, or the empty slot where it belongs
+static PooledString* string_pool_slot(PooledString* entries, int capacity, const char* text) {
+    int mask = capacity - 1;
+    int index = (int)(hash_string(text) & mask);
+    while (entries[index].text && strcmp(entries[index].text, text) != 0) {
+        index = (index + 1) & mask;
+    }
+    return &entries[index];
+}
+
+static int grow_string_pool(StringPool* pool) {
+    int new_capacity = pool->capacity * 2;
+    PooledString* new_entries = calloc(new_capacity, sizeof(PooledString));
+    if (!new_entries) return 0;
+
+    for (int i = 0; i < pool->capacity; i++) {
+        if (pool->entries[i].text) {
+            *string_pool_slot(new_entries, new_capacity, pool->entries[i].text) = pool->entries[i];
+        }
+    }
+    free(pool->entries);
+    pool->entries = new_entries;
+    pool->capacity = new_capacity;
+    return 1;
+}
+
+// Return an i8* to a private constant holding text, creating it on first use
+static LLVMValueRef string_pool_get(StringPool* pool, const char* text) {
+    PooledString* slot = string_pool_slot(pool->entries, pool->capacity, text);
+    if (slot->text) {
+        return slot->ptr;
+    }
+
+    size_t len = strlen(text);
+    LLVMTypeRef array_type = LLVMArrayType(LLVMInt8TypeInContext(pool->context), len + 1);
+    char global_name[32];
+    snprintf(global_name, sizeof(global_name), ".str.%d", pool->size);
+
+    LLVMValueRef global = LLVMAddGlobal(pool->module, array_type, global_name);
+    LLVMSetInitializer(global, LLVMConstStringInContext(pool->context, text, len, 0));
+    LLVMSetGlobalConstant(global, 1);
+    LLVMSetLinkage(global, LLVMPrivateLinkage);
+    LLVMSetUnnamedAddress(global, LLVMGlobalUnnamedAddr);
+    LLVMSetAlignment(global, 1);
+
+    LLVMValueRef zero = LLVMConstInt(LLVMInt32TypeInContext(pool->context), 0, 0);
+    LLVMValueRef indices[] = { zero, zero };
+    LLVMValueRef ptr = LLVMConstInBoundsGEP2(array_type, global, indices, 2);
+
+    slot->text = strdup(text);
+    slot->ptr = ptr;
+    pool->size++;
+
+    // Keep the load factor at or below one half
+    if (pool->size * 2 > pool->capacity) {
+        grow_string_pool(pool);
+    }
+    return ptr;
+}
+
 // Forward declarations
-static LLVMValueRef gen_expression(LLVMContextRef context, LLVMBuilderRef builder, 
-                                  Node* node, SymbolTable* symbol_table, 
-                                  LLVMValueRef true_str, LLVMValueRef false_str,
-                                  LLVMValueRef printf_func, LLVMTypeRef printf_type);
+static LLVMValueRef gen_expression(CodegenState* state, Node* node);
 
 // Function to save LLVM IR to a file
 LLVMCodegenResult save_llvm_ir(LLVMModuleRef module, const char* filename);
 
-// Generate detailed evaluation messages
-static void add_evaluation_message(LLVMBuilderRef builder, LLVMValueRef printf_func, 
-                                  LLVMTypeRef printf_type, const char* format, ...) {
-    LLVMValueRef fmt_str = LLVMBuildGlobalStringPtr(builder, format, "fmt_str");
-    LLVMValueRef args[] = { fmt_str };
-    LLVMBuildCall2(builder, printf_type, printf_func, args, 1, "");
+// Function types of the runtime output helpers
+static void init_output_runtime_types(CodegenState* state) {
+    LLVMContextRef context = state->context;
+    LLVMTypeRef data_params[] = {
+        LLVMPointerType(LLVMInt8TypeInContext(context), 0),
+        LLVMInt64TypeInContext(context)
+    };
+    state->write_all_type = LLVMFunctionType(LLVMVoidTypeInContext(context), data_params, 2, 0);
+    state->append_type = LLVMFunctionType(LLVMVoidTypeInContext(context), data_params, 2, 0);
+    state->flush_type = LLVMFunctionType(LLVMVoidTypeInContext(context), NULL, 0, 0);
 }
 
-// Generate a detailed output message for variable substitution
-static void add_var_substitution_message(LLVMBuilderRef builder, LLVMValueRef printf_func, 
-                                       LLVMTypeRef printf_type, const char* var_name, 
-                                       LLVMValueRef true_str, LLVMValueRef false_str, 
-                                       int value) {
-    LLVMValueRef fmt_str = LLVMBuildGlobalStringPtr(builder, "Substituted variable %s with value %s\n", "var_subst_fmt");
-    LLVMValueRef name_str = LLVMBuildGlobalStringPtr(builder, var_name, "var_name");
-    LLVMValueRef value_str = value ? true_str : false_str;
+// Give a runtime symbol internal linkage, or hidden external linkage when
+// shard modules link against it
+static void set_runtime_linkage(CodegenState* state, LLVMValueRef global) {
+    if (state->exports_runtime) {
+        LLVMSetLinkage(global, LLVMExternalLinkage);
+        LLVMSetVisibility(global, LLVMHiddenVisibility);
+    } else {
+        LLVMSetLinkage(global, LLVMInternalLinkage);
+    }
+}
+
+// Emit the runtime output helpers into the module: a preallocated buffer,
+// lec_out_append() which copies into it and lec_out_flush() which hands it
+// to write(2). Generated programs call libc once per buffer, not per line.
+static void build_output_runtime(CodegenState* state) {
+    LLVMContextRef context = state->context;
+    LLVMModuleRef module = state->module;
+    LLVMBuilderRef builder = state->builder;
+    LLVMBasicBlockRef saved_block = LLVMGetInsertBlock(builder);
+
+    LLVMTypeRef i8 = LLVMInt8TypeInContext(context);
+    LLVMTypeRef i8_ptr = LLVMPointerType(i8, 0);
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(context);
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(context);
+    init_output_runtime_types(state);
+
+    // ssize_t write(int fd, const void* buf, size_t count)
+    LLVMTypeRef write_params[] = { i32, i8_ptr, i64 };
+    LLVMTypeRef write_type = LLVMFunctionType(i64, write_params, 3, 0);
+    LLVMValueRef write_func = LLVMAddFunction(module, "write", write_type);
+
+    // void* memcpy(void* dest, const void* src, size_t n)
+    LLVMTypeRef memcpy_params[] = { i8_ptr, i8_ptr, i64 };
+    LLVMTypeRef memcpy_type = LLVMFunctionType(i8_ptr, memcpy_params, 3, 0);
+    LLVMValueRef memcpy_func = LLVMAddFunction(module, "memcpy", memcpy_type);
+
+    LLVMTypeRef buffer_type = LLVMArrayType(i8, OUTPUT_BUFFER_SIZE);
+    LLVMValueRef buffer = LLVMAddGlobal(module, buffer_type, "lec_out_buf");
+    LLVMSetInitializer(buffer, LLVMConstNull(buffer_type));
+    LLVMSetLinkage(buffer, LLVMInternalLinkage);
+
+    LLVMValueRef length = LLVMAddGlobal(module, i64, "lec_out_len");
+    LLVMSetInitializer(length, LLVMConstInt(i64, 0, 0));
+    LLVMSetLinkage(length, LLVMInternalLinkage);
+
+    LLVMValueRef zero32 = LLVMConstInt(i32, 0, 0);
+    LLVMValueRef zero64 = LLVMConstInt(i64, 0, 0);
+    LLVMValueRef capacity = LLVMConstInt(i64, OUTPUT_BUFFER_SIZE, 0);
+    LLVMValueRef stdout_fd = LLVMConstInt(i32, 1, 0);
+
+    // void lec_write_all(i8* data, i64 len): retry short writes until done
+    state->write_all_func = LLVMAddFunction(module, "lec_write_all", state->write_all_type);
+    set_runtime_linkage(state, state->write_all_func);
+    {
+        LLVMValueRef func = state->write_all_func;
+        LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(context, func, "entry");
+        LLVMBasicBlockRef loop = LLVMAppendBasicBlockInContext(context, func, "loop");
+        LLVMBasicBlockRef body = LLVMAppendBasicBlockInContext(context, func, "body");
+        LLVMBasicBlockRef done = LLVMAppendBasicBlockInContext(context, func, "done");
+
+        LLVMPositionBuilderAtEnd(builder, entry);
+        LLVMBuildBr(builder, loop);
+
+        LLVMPositionBuilderAtEnd(builder, loop);
+        LLVMValueRef data = LLVMBuildPhi(builder, i8_ptr, "data");
+        LLVMValueRef remaining = LLVMBuildPhi(builder, i64, "remaining");
+        LLVMValueRef finished = LLVMBuildICmp(builder, LLVMIntSLE, remaining, zero64, "finished");
+        LLVMBuildCondBr(builder, finished, done, body);
+
+        LLVMPositionBuilderAtEnd(builder, body);
+        LLVMValueRef write_args[] = { stdout_fd, data, remaining };
+        LLVMValueRef written = LLVMBuildCall2(builder, write_type, write_func, write_args, 3, "written");
+        LLVMValueRef failed = LLVMBuildICmp(builder, LLVMIntSLE, written, zero64, "failed");
+        LLVMValueRef next_data = LLVMBuildGEP2(builder, i8, data, &written, 1, "next_data");
+        LLVMValueRef next_remaining = LLVMBuildSub(builder, remaining, written, "next_remaining");
+        LLVMBuildCondBr(builder, failed, done, loop);
+
+        LLVMValueRef data_values[] = { LLVMGetParam(func, 0), next_data };
+        LLVMValueRef remaining_values[] = { LLVMGetParam(func, 1), next_remaining };
+        LLVMBasicBlockRef incoming[] = { entry, body };
+        LLVMAddIncoming(data, data_values, incoming, 2);
+        LLVMAddIncoming(remaining, remaining_values, incoming, 2);
+
+        LLVMPositionBuilderAtEnd(builder, done);
+        LLVMBuildRetVoid(builder);
+    }
+
+    // void lec_out_flush(): write out and empty the buffer
+    state->flush_func = LLVMAddFunction(module, "lec_out_flush", state->flush_type);
+    set_runtime_linkage(state, state->flush_func);
+    {
+        LLVMPositionBuilderAtEnd(builder, LLVMAppendBasicBlockInContext(context, state->flush_func, "entry"));
+        LLVMValueRef indices[] = { zero32, zero32 };
+        LLVMValueRef start = LLVMBuildInBoundsGEP2(builder, buffer_type, buffer, indices, 2, "start");
+        LLVMValueRef used = LLVMBuildLoad2(builder, i64, length, "used");
+        LLVMValueRef args[] = { start, used };
+        LLVMBuildCall2(builder, state->write_all_type, state->write_all_func, args, 2, "");
+        LLVMBuildStore(builder, zero64, length);
+        LLVMBuildRetVoid(builder);
+    }
+
+    // void lec_out_append(i8* data, i64 len): buffer data, flushing when full;
+    // chunks larger than the buffer bypass it
+    state->append_func = LLVMAddFunction(module, "lec_out_append", state->append_type);
+    set_runtime_linkage(state, state->append_func);
+    {
+        LLVMValueRef func = state->append_func;
+        LLVMValueRef data = LLVMGetParam(func, 0);
+        LLVMValueRef len = LLVMGetParam(func, 1);
+        LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(context, func, "entry");
+        LLVMBasicBlockRef flush = LLVMAppendBasicBlockInContext(context, func, "flush");
+        LLVMBasicBlockRef direct = LLVMAppendBasicBlockInContext(context, func, "direct");
+        LLVMBasicBlockRef copy = LLVMAppendBasicBlockInContext(context, func, "copy");
+
+        LLVMPositionBuilderAtEnd(builder, entry);
+        LLVMValueRef used = LLVMBuildLoad2(builder, i64, length, "used");
+        LLVMValueRef needed = LLVMBuildAdd(builder, used, len, "needed");
+        LLVMValueRef overflow = LLVMBuildICmp(builder, LLVMIntUGT, needed, capacity, "overflow");
+        LLVMBuildCondBr(builder, overflow, flush, copy);
+
+        LLVMPositionBuilderAtEnd(builder, flush);
+        LLVMBuildCall2(builder, state->flush_type, state->flush_func, NULL, 0, "");
+        LLVMValueRef too_large = LLVMBuildICmp(builder, LLVMIntUGT, len, capacity, "too_large");
+        LLVMBuildCondBr(builder, too_large, direct, copy);
+
+        LLVMPositionBuilderAtEnd(builder, direct);
+        LLVMValueRef direct_args[] = { data, len };
+        LLVMBuildCall2(builder, state->write_all_type, state->write_all_func, direct_args, 2, "");
+        LLVMBuildRetVoid(builder);
+
+        LLVMPositionBuilderAtEnd(builder, copy);
+        LLVMValueRef offset = LLVMBuildLoad2(builder, i64, length, "offset");
+        LLVMValueRef indices[] = { zero64, offset };
+        LLVMValueRef dest = LLVMBuildInBoundsGEP2(builder, buffer_type, buffer, indices, 2, "dest");
+        LLVMValueRef copy_args[] = { dest, data, len };
+        LLVMBuildCall2(builder, memcpy_type, memcpy_func, copy_args, 3, "");
+        LLVMBuildStore(builder, LLVMBuildAdd(builder, offset, len, "new_len"), length);
+        LLVMBuildRetVoid(builder);
+    }
+
+    LLVMPositionBuilderAtEnd(builder, saved_block);
+}
+
+// Define lec_inputs and fill it at the current position from the
+// environment: runtime variable x is TRUE when LEC_x starts with 1, T or t
+static void build_runtime_inputs(CodegenState* state) {
+    if (state->runtime_variable_count == 0) return;
+
+    LLVMContextRef context = state->context;
+    LLVMBuilderRef builder = state->builder;
+    LLVMTypeRef i8 = LLVMInt8TypeInContext(context);
+    LLVMTypeRef i8_ptr = LLVMPointerType(i8, 0);
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(context);
+
+    LLVMTypeRef inputs_type = LLVMArrayType(i8, state->runtime_variable_count);
+    state->inputs_global = LLVMAddGlobal(state->module, inputs_type, "lec_inputs");
+    LLVMSetInitializer(state->inputs_global, LLVMConstNull(inputs_type));
+    set_runtime_linkage(state, state->inputs_global);
+
+    // char* getenv(const char* name)
+    LLVMTypeRef getenv_type = LLVMFunctionType(i8_ptr, &i8_ptr, 1, 0);
+    LLVMValueRef getenv_func = LLVMAddFunction(state->module, "getenv", getenv_type);
+
+    for (int i = 0; i < state->runtime_variable_count; i++) {
+        char env_name[MAX_SYMBOL_NAME_LENGTH + 8];
+        snprintf(env_name, sizeof(env_name), "LEC_%s", state->runtime_variables[i]);
+        LLVMValueRef name = string_pool_get(state->strings, env_name);
+        LLVMValueRef text = LLVMBuildCall2(builder, getenv_type, getenv_func, &name, 1, "env");
+        LLVMValueRef unset = LLVMBuildIsNull(builder, text, "unset");
+        text = LLVMBuildSelect(builder, unset, string_pool_get(state->strings, ""), text, "env_text");
+        LLVMValueRef first = LLVMBuildLoad2(builder, i8, text, "first");
+        LLVMValueRef is_true = LLVMBuildOr(builder,
+            LLVMBuildICmp(builder, LLVMIntEQ, first, LLVMConstInt(i8, '1', 0), "is_one"),
+            LLVMBuildOr(builder,
+                        LLVMBuildICmp(builder, LLVMIntEQ, first, LLVMConstInt(i8, 'T', 0), "is_t"),
+                        LLVMBuildICmp(builder, LLVMIntEQ, first, LLVMConstInt(i8, 't', 0), "is_lower_t"),
+                        "is_letter"),
+            "is_true");
+
+        LLVMValueRef indices[] = { LLVMConstInt(i64, 0, 0), LLVMConstInt(i64, i, 0) };
+        LLVMValueRef slot = LLVMBuildInBoundsGEP2(builder, inputs_type, state->inputs_global, indices, 2, "input_slot");
+        LLVMBuildStore(builder, LLVMBuildZExt(builder, is_true, i8, "input_byte"), slot);
+    }
+}
+
+// Index of name among the runtime variables, or -1
+static int runtime_variable_index(const CodegenState* state, const char* name) {
+    for (int i = 0; i < state->runtime_variable_count; i++) {
+        if (strcmp(state->runtime_variables[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+// Load the value of runtime variable index as an i1
+static LLVMValueRef gen_runtime_input(CodegenState* state, int index) {
+    LLVMTypeRef i8 = LLVMInt8TypeInContext(state->context);
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(state->context);
+    LLVMValueRef indices[] = { LLVMConstInt(i64, 0, 0), LLVMConstInt(i64, index, 0) };
+    LLVMValueRef slot = LLVMBuildInBoundsGEP2(state->builder, LLVMGlobalGetValueType(state->inputs_global),
+                                              state->inputs_global, indices, 2, "input_slot");
+    LLVMValueRef byte = LLVMBuildLoad2(state->builder, i8, slot, "input_byte");
+    return LLVMBuildICmp(state->builder, LLVMIntNE, byte, LLVMConstInt(i8, 0, 0), "input");
+}
+
+// Declare the runtime helpers, result bitset and inputs defined by the main module
+static void declare_output_runtime(CodegenState* state, size_t results_size) {
+    init_output_runtime_types(state);
+    state->append_func = LLVMAddFunction(state->module, "lec_out_append", state->append_type);
+    LLVMSetVisibility(state->append_func, LLVMHiddenVisibility);
     
-    LLVMValueRef args[] = { fmt_str, name_str, value_str };
-    LLVMBuildCall2(builder, printf_type, printf_func, args, 3, "");
+    if (state->runtime_variable_count > 0) {
+        LLVMTypeRef inputs_type = LLVMArrayType(LLVMInt8TypeInContext(state->context),
+                                                state->runtime_variable_count);
+        state->inputs_global = LLVMAddGlobal(state->module, inputs_type, "lec_inputs");
+        LLVMSetVisibility(state->inputs_global, LLVMHiddenVisibility);
+    }
+
+    if (state->output_format == LLVM_OUTPUT_BINARY) {
+        LLVMTypeRef results_type = LLVMArrayType(LLVMInt8TypeInContext(state->context), results_size);
+        state->results_global = LLVMAddGlobal(state->module, results_type, "lec_results");
+        LLVMSetVisibility(state->results_global, LLVMHiddenVisibility);
+    }
+}
+
+// Emit the compile-time text accumulated so far as a single append call
+static void flush_pending_text(CodegenState* state) {
+    if (state->pending_len == 0) return;
+
+    LLVMValueRef args[] = {
+        string_pool_get(state->strings, state->pending),
+        LLVMConstInt(LLVMInt64TypeInContext(state->context), state->pending_len, 0)
+    };
+    LLVMBuildCall2(state->builder, state->append_type, state->append_func, args, 2, "");
+    state->pending_len = 0;
+    state->pending[0] = '\0';
+}
+
+// Queue trace text for the generated program to print
+static void emit_text(CodegenState* state, const char* text) {
+    if (state->output_format != LLVM_OUTPUT_TEXT) return;
+
+    size_t len = strlen(text);
+    if (state->pending_len + len + 1 > state->pending_capacity) {
+        size_t new_capacity = state->pending_capacity ? state->pending_capacity : 256;
+        while (state->pending_len + len + 1 > new_capacity) new_capacity *= 2;
+        char* new_pending = realloc(state->pending, new_capacity);
+        if (!new_pending) {
+            fprintf(stderr, "Error: Failed to grow trace text buffer\n");
+            return;
+        }
+        state->pending = new_pending;
+        state->pending_capacity = new_capacity;
+    }
+    memcpy(state->pending + state->pending_len, text, len + 1);
+    state->pending_len += len;
+
+    // Keep each emitted chunk within the runtime buffer
+    if (state->pending_len >= OUTPUT_BUFFER_SIZE / 2) {
+        flush_pending_text(state);
+    }
+}
+
+// Queue formatted trace text
+static void emit_textf(CodegenState* state, const char* format, ...) {
+    if (state->output_format != LLVM_OUTPUT_TEXT) return;
+
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(NULL, 0, format, args);
+    va_end(args);
+    if (len < 0) return;
+
+    char* text = malloc(len + 1);
+    if (!text) return;
+    va_start(args, format);
+    vsnprintf(text, len + 1, format, args);
+    va_end(args);
+
+    emit_text(state, text);
+    free(text);
+}
+
+// Print the message for an evaluated operator, looked up by node type
+static void add_operation_message(CodegenState* state, NodeType type) {
+    emit_text(state, node_evaluation_messages[type]);
+}
+
+// Generate a detailed output message for variable substitution
+static void add_var_substitution_message(CodegenState* state, const char* var_name, int value) {
+    emit_textf(state, "Substituted variable %s with value %s\n", var_name, value ? "TRUE" : "FALSE");
+}
+
+// Record the value of statement index in the binary result bitset
+static void record_binary_result(CodegenState* state, int index, LLVMValueRef value) {
+    size_t byte = LLVM_RESULTS_HEADER_SIZE + index / 8;
+    int bit = index % 8;
+
+    if (LLVMIsAConstantInt(value)) {
+        if (LLVMConstIntGetZExtValue(value)) {
+            state->results_init[byte] |= (unsigned char)(1u << bit);
+        }
+        return;
+    }
+
+    LLVMBuilderRef builder = state->builder;
+    LLVMTypeRef i8 = LLVMInt8TypeInContext(state->context);
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(state->context);
+    LLVMValueRef indices[] = { LLVMConstInt(i64, 0, 0), LLVMConstInt(i64, byte, 0) };
+    LLVMValueRef slot = LLVMBuildInBoundsGEP2(builder, LLVMGlobalGetValueType(state->results_global),
+                                              state->results_global, indices, 2, "result_slot");
+    LLVMValueRef old_bits = LLVMBuildLoad2(builder, i8, slot, "result_bits");
+    LLVMValueRef bit_value = LLVMBuildShl(builder, LLVMBuildZExt(builder, value, i8, "result_byte"),
+                                          LLVMConstInt(i8, bit, 0), "result_bit");
+    LLVMBuildStore(builder, LLVMBuildOr(builder, old_bits, bit_value, "new_bits"), slot);
+}
+
+// Print true_text or false_text depending on value, folding constant values
+// into the pending trace text
+static void emit_choice_text(CodegenState* state, LLVMValueRef value,
+                             const char* true_text, const char* false_text) {
+    if (state->output_format != LLVM_OUTPUT_TEXT) return;
+
+    if (LLVMIsAConstantInt(value)) {
+        emit_text(state, LLVMConstIntGetZExtValue(value) ? true_text : false_text);
+        return;
+    }
+
+    flush_pending_text(state);
+    LLVMBuilderRef builder = state->builder;
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(state->context);
+    LLVMValueRef line = LLVMBuildSelect(builder, value, string_pool_get(state->strings, true_text),
+                                        string_pool_get(state->strings, false_text), "choice_text");
+    LLVMValueRef length = LLVMBuildSelect(builder, value,
+                                          LLVMConstInt(i64, strlen(true_text), 0),
+                                          LLVMConstInt(i64, strlen(false_text), 0),
+                                          "choice_len");
+    LLVMValueRef args[] = { line, length };
+    LLVMBuildCall2(builder, state->append_type, state->append_func, args, 2, "");
+}
+
+// Print "Result: TRUE/FALSE" for a statement
+static void emit_result_text(CodegenState* state, LLVMValueRef value) {
+    emit_choice_text(state, value, "Result: TRUE\n\n", "Result: FALSE\n\n");
+}
+
+// Generate both operands of a binary operator, then print its message
+static int gen_binary_operands(CodegenState* state, Node* node,
+                               LLVMValueRef* left, LLVMValueRef* right) {
+    *left = gen_expression(state, node->left);
+    *right = gen_expression(state, node->right);
+    if (!*left || !*right) return 0;
+
+    add_operation_message(state, node->type);
+    return 1;
+}
+
+// Add the number of set bits of the packed operands in word to count
+static LLVMValueRef add_popcount(CodegenState* state, LLVMValueRef count, LLVMValueRef word) {
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(state->context);
+    unsigned id = LLVMLookupIntrinsicID("llvm.ctpop", strlen("llvm.ctpop"));
+    LLVMValueRef ctpop = LLVMGetIntrinsicDeclaration(state->module, id, &i64, 1);
+    LLVMValueRef bits = LLVMBuildCall2(state->builder, LLVMIntrinsicGetType(state->context, id, &i64, 1),
+                                       ctpop, &word, 1, "popcount");
+    return count ? LLVMBuildAdd(state->builder, count, bits, "count") : bits;
+}
+
+// Threshold nodes count their TRUE operands: constant operands at compile
+// time, the others 64 at a time by packing them into a word and taking its
+// population count, so the cost is linear in the number of operands
+static LLVMValueRef gen_threshold(CodegenState* state, Node* node) {
+    LLVMBuilderRef builder = state->builder;
+    LLVMTypeRef i1 = LLVMInt1TypeInContext(state->context);
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(state->context);
+    LLVMValueRef count = NULL;
+    LLVMValueRef word = NULL;
+    int packed = 0;
+    long known = 0;
+
+    for (int i = 0; i < node->child_count; i++) {
+        LLVMValueRef operand = gen_expression(state, node->children[i]);
+        if (!operand) return NULL;
+        if (LLVMIsAConstantInt(operand)) {
+            known += LLVMConstIntGetZExtValue(operand) != 0;
+            continue;
+        }
+        LLVMValueRef bit = LLVMBuildZExt(builder, operand, i64, "operand");
+        if (packed > 0) bit = LLVMBuildShl(builder, bit, LLVMConstInt(i64, packed, 0), "operand_bit");
+        word = word ? LLVMBuildOr(builder, word, bit, "operands") : bit;
+        if (++packed == 64) {
+            count = add_popcount(state, count, word);
+            word = NULL;
+            packed = 0;
+        }
+    }
+    if (word) count = add_popcount(state, count, word);
+    add_operation_message(state, node->type);
+
+    // Compare the runtime count with what the constants leave of the threshold
+    long threshold = node->threshold - known;
+    if (!count) return LLVMConstInt(i1, threshold_holds(node->type, threshold, 0), 0);
+    if (threshold < 0) return LLVMConstInt(i1, node->type == NODE_ATLEAST, 0);
+    LLVMIntPredicate predicate = node->type == NODE_ATLEAST ? LLVMIntUGE
+                               : node->type == NODE_ATMOST ? LLVMIntULE : LLVMIntEQ;
+    return LLVMBuildICmp(builder, predicate, count, LLVMConstInt(i64, threshold, 0), "threshold");
+}
+
+// Combine values pairwise with an AND, OR or XOR, so the result is a
+// balanced tree of depth log n instead of a chain whose depth is the number
+// of operands, and independent halves can issue in parallel. Overwrites values.
+static LLVMValueRef reduce_operands(CodegenState* state, NodeType type, LLVMValueRef* values, int n) {
+    while (n > 1) {
+        for (int i = 0; i < n / 2; i++) {
+            LLVMValueRef a = values[2 * i];
+            LLVMValueRef b = values[2 * i + 1];
+            switch (type) {
+                case NODE_AND: values[i] = LLVMBuildAnd(state->builder, a, b, "and"); break;
+                case NODE_OR: values[i] = LLVMBuildOr(state->builder, a, b, "or"); break;
+                default: values[i] = LLVMBuildXor(state->builder, a, b, "xor"); break;
+            }
+        }
+        if (n % 2) values[n / 2] = values[n - 1];
+        n = (n + 1) / 2;
+    }
+    return n == 1 ? values[0] : LLVMConstInt(LLVMInt1TypeInContext(state->context), type == NODE_AND, 0);
+}
+
+// Operands of a binary or n-ary node, in order. Returns the count, or -1
+// when out of memory; *operands is freed by the caller.
+static int collect_operands(Node* node, Node*** operands) {
+    int n = node->children ? node->child_count : 2;
+    *operands = malloc((n > 0 ? n : 1) * sizeof(Node*));
+    if (!*operands) {
+        fprintf(stderr, "Error: Failed to allocate operands\n");
+        return -1;
+    }
+    if (node->children) {
+        memcpy(*operands, node->children, n * sizeof(Node*));
+    } else {
+        (*operands)[0] = node->left;
+        (*operands)[1] = node->right;
+    }
+    return n;
+}
+
+// N-ary AND, OR and XOR evaluate every operand, then combine them as a balanced tree
+static LLVMValueRef gen_nary(CodegenState* state, Node* node) {
+    int n = node->child_count;
+    LLVMValueRef* values = malloc((n > 0 ? n : 1) * sizeof(LLVMValueRef));
+    if (!values) {
+        fprintf(stderr, "Error: Failed to allocate operands\n");
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) {
+        values[i] = gen_expression(state, node->children[i]);
+        if (!values[i]) {
+            free(values);
+            return NULL;
+        }
+    }
+    add_operation_message(state, node->type);
+
+    LLVMValueRef result = reduce_operands(state, node->type, values, n);
+    free(values);
+    return result;
+}
+
+static int compare_profiled_operators(const void* a, const void* b) {
+    const Node* x = ((const ProfiledOperator*)a)->node;
+    const Node* y = ((const ProfiledOperator*)b)->node;
+    return x < y ? -1 : x > y;
+}
+
+// Compute the profile key of statement and index its AND and OR nodes.
+// Returns 0, or -1 when out of memory.
+static int begin_profiled_statement(CodegenState* state, const Node* statement) {
+    const Node** nodes = NULL;
+    int count = list_profiled_operators(statement, &nodes);
+    if (count < 0) return -1;
+    state->operators = malloc((count > 0 ? count : 1) * sizeof(ProfiledOperator));
+    if (!state->operators) {
+        free(nodes);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        state->operators[i].node = nodes[i];
+        state->operators[i].index = i;
+    }
+    free(nodes);
+    qsort(state->operators, count, sizeof(ProfiledOperator), compare_profiled_operators);
+    state->operator_count = count;
+    branch_profile_statement_key(statement, state->statement_key);
+    return 0;
+}
+
+static void end_profiled_statement(CodegenState* state) {
+    free(state->operators);
+    state->operators = NULL;
+    state->operator_count = 0;
+}
+
+// Index of an AND or OR of the current statement in the profile, or -1
+static int profiled_operator_index(const CodegenState* state, const Node* node) {
+    ProfiledOperator key = {node, 0};
+    const ProfiledOperator* found = state->operators
+        ? bsearch(&key, state->operators, state->operator_count, sizeof(ProfiledOperator),
+                  compare_profiled_operators)
+        : NULL;
+    return found ? found->index : -1;
+}
+
+// Count an evaluation of the operator and which of its operands had the
+// deciding value. Operators whose operands are all constant are skipped.
+static void instrument_operator(CodegenState* state, NodeType type, int index,
+                                LLVMValueRef* values, int n) {
+    int runtime = 0;
+    for (int i = 0; i < n; i++) runtime |= !LLVMIsAConstantInt(values[i]);
+    if (!runtime) return;
+
+    if (state->site_count == state->site_capacity) {
+        int capacity = state->site_capacity ? state->site_capacity * 2 : 16;
+        ProfileSite* sites = realloc(state->sites, capacity * sizeof(ProfileSite));
+        if (!sites) {
+            fprintf(stderr, "Error: Failed to grow branch profile sites\n");
+            return;
+        }
+        state->sites = sites;
+        state->site_capacity = capacity;
+    }
+
+    LLVMBuilderRef builder = state->builder;
+    LLVMTypeRef i1 = LLVMInt1TypeInContext(state->context);
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(state->context);
+    LLVMTypeRef counters_type = LLVMArrayType(i64, n + 1);
+    LLVMValueRef counters = LLVMAddGlobal(state->module, counters_type, "lec_branch_counts");
+    LLVMSetInitializer(counters, LLVMConstNull(counters_type));
+    LLVMSetLinkage(counters, LLVMInternalLinkage);
+
+    LLVMValueRef dominant = LLVMConstInt(i1, type == NODE_OR, 0);
+    for (int i = 0; i <= n; i++) {
+        LLVMValueRef increment = i == 0 ? LLVMConstInt(i64, 1, 0)
+            : LLVMBuildZExt(builder, LLVMBuildICmp(builder, LLVMIntEQ, values[i - 1], dominant, "decides"),
+                            i64, "decided");
+        if (LLVMIsAConstantInt(increment) && LLVMConstIntGetZExtValue(increment) == 0) continue;
+        LLVMValueRef indices[] = { LLVMConstInt(i64, 0, 0), LLVMConstInt(i64, i, 0) };
+        LLVMValueRef slot = LLVMBuildInBoundsGEP2(builder, counters_type, counters, indices, 2, "counter_slot");
+        LLVMValueRef count = LLVMBuildLoad2(builder, i64, slot, "counter");
+        LLVMBuildStore(builder, LLVMBuildAdd(builder, count, increment, "new_counter"), slot);
+    }
+
+    ProfileSite* site = &state->sites[state->site_count++];
+    memcpy(site->key, state->statement_key, sizeof(site->key));
+    site->index = index;
+    site->operand_count = n;
+    site->counters = counters;
+}
+
+// Attach the profiled counts of a conditional branch as branch weights,
+// scaled down to fit the 32-bit weights LLVM expects
+static void set_branch_weights(CodegenState* state, LLVMValueRef branch, long taken, long not_taken) {
+    while (taken > 0xffffffffL || not_taken > 0xffffffffL) {
+        taken >>= 1;
+        not_taken >>= 1;
+    }
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(state->context);
+    LLVMValueRef weights[] = {
+        LLVMMDStringInContext(state->context, "branch_weights", strlen("branch_weights")),
+        LLVMConstInt(i32, taken, 0),
+        LLVMConstInt(i32, not_taken, 0)
+    };
+    unsigned kind = LLVMGetMDKindIDInContext(state->context, "prof", strlen("prof"));
+    LLVMSetMetadata(branch, kind, LLVMMDNodeInContext(state->context, weights, 3));
+}
+
+// Short-circuit an AND or OR with profiled counts: operands that decide it
+// most often are evaluated first, and once one has the deciding value the
+// rest are branched over. Only the operands actually evaluated are traced.
+static LLVMValueRef gen_short_circuit(CodegenState* state, Node* node, Node** operands, int n,
+                                      const BranchCounts* counts) {
+    int* order = malloc((n > 0 ? n : 1) * sizeof(int));
+    LLVMValueRef* incoming_values = malloc((n > 0 ? n : 1) * sizeof(LLVMValueRef));
+    LLVMBasicBlockRef* incoming_blocks = malloc((n > 0 ? n : 1) * sizeof(LLVMBasicBlockRef));
+    if (!order || !incoming_values || !incoming_blocks) {
+        fprintf(stderr, "Error: Failed to allocate operands\n");
+        free(order);
+        free(incoming_values);
+        free(incoming_blocks);
+        return NULL;
+    }
+
+    // Stable insertion sort, most often deciding first
+    for (int i = 0; i < n; i++) {
+        int j = i;
+        while (j > 0 && counts->decided[order[j - 1]] < counts->decided[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    LLVMBuilderRef builder = state->builder;
+    LLVMTypeRef i1 = LLVMInt1TypeInContext(state->context);
+    int dominant = node->type == NODE_OR;
+    LLVMValueRef dominant_value = LLVMConstInt(i1, dominant, 0);
+    LLVMValueRef result = LLVMConstInt(i1, !dominant, 0);
+    LLVMBasicBlockRef merge = NULL;
+    int incoming = 0;
+    for (int k = 0; k < n; k++) {
+        LLVMValueRef value = gen_expression(state, operands[order[k]]);
+        if (!value) {
+            result = NULL;
+            break;
+        }
+        if (LLVMIsAConstantInt(value)) {
+            if ((LLVMConstIntGetZExtValue(value) != 0) != dominant) continue;
+            result = dominant_value;
+            break;
+        }
+        if (k == n - 1) {
+            result = value;
+            break;
+        }
+
+        flush_pending_text(state);
+        LLVMValueRef function = LLVMGetBasicBlockParent(LLVMGetInsertBlock(builder));
+        if (!merge) merge = LLVMAppendBasicBlockInContext(state->context, function, "short_circuit");
+        LLVMBasicBlockRef next = LLVMAppendBasicBlockInContext(state->context, function, "next_operand");
+        long decided = counts->decided[order[k]];
+        long undecided = counts->evaluations > decided ? counts->evaluations - decided : 0;
+        LLVMValueRef branch = dominant ? LLVMBuildCondBr(builder, value, merge, next)
+                                       : LLVMBuildCondBr(builder, value, next, merge);
+        set_branch_weights(state, branch, dominant ? decided : undecided, dominant ? undecided : decided);
+        incoming_values[incoming] = dominant_value;
+        incoming_blocks[incoming] = LLVMGetInsertBlock(builder);
+        incoming++;
+        LLVMPositionBuilderAtEnd(builder, next);
+    }
+
+    if (result && merge) {
+        flush_pending_text(state);
+        incoming_values[incoming] = result;
+        incoming_blocks[incoming] = LLVMGetInsertBlock(builder);
+        incoming++;
+        LLVMBuildBr(builder, merge);
+        LLVMPositionBuilderAtEnd(builder, merge);
+        result = LLVMBuildPhi(builder, i1, node->type == NODE_AND ? "and" : "or");
+        LLVMAddIncoming(result, incoming_values, incoming_blocks, incoming);
+    }
+    if (result) add_operation_message(state, node->type);
+
+    free(order);
+    free(incoming_values);
+    free(incoming_blocks);
+    return result;
+}
+
+// AND and OR while instrumenting or using a branch profile
+static LLVMValueRef gen_profiled_operator(CodegenState* state, Node* node) {
+    Node** operands;
+    int n = collect_operands(node, &operands);
+    if (n < 0) return NULL;
+
+    int index = profiled_operator_index(state, node);
+    const BranchCounts* counts = index >= 0 ? find_branch_counts(state->profile, state->statement_key, index) : NULL;
+    if (counts && counts->operand_count == n && counts->evaluations > 0) {
+        LLVMValueRef result = gen_short_circuit(state, node, operands, n, counts);
+        free(operands);
+        return result;
+    }
+
+    LLVMValueRef* values = malloc((n > 0 ? n : 1) * sizeof(LLVMValueRef));
+    if (!values) {
+        fprintf(stderr, "Error: Failed to allocate operands\n");
+        free(operands);
+        return NULL;
+    }
+    for (int i = 0; i < n; i++) {
+        values[i] = gen_expression(state, operands[i]);
+        if (!values[i]) {
+            free(values);
+            free(operands);
+            return NULL;
+        }
+    }
+    add_operation_message(state, node->type);
+    if (state->instrument && index >= 0) instrument_operator(state, node->type, index, values, n);
+
+    LLVMValueRef result = reduce_operands(state, node->type, values, n);
+    free(values);
+    free(operands);
+    return result;
+}
+
+static int compare_truth_tables(const void* a, const void* b) {
+    const Node* x = ((const TruthTable*)a)->node;
+    const Node* y = ((const TruthTable*)b)->node;
+    return x < y ? -1 : x > y;
+}
+
+// Tabulate the small-support subexpressions of statement whose variables
+// are all runtime variables
+static void begin_table_statement(CodegenState* state, const Node* statement) {
+    int count = find_truth_tables(statement, state->symbol_table, TRUTH_TABLE_MAX_VARIABLES, &state->tables);
+    if (count < 0) {
+        fprintf(stderr, "Warning: Failed to compute truth tables\n");
+        count = 0;
+    }
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        TruthTable* table = &state->tables[i];
+        int runtime = 1;
+        for (int j = 0; j < table->variable_count && runtime; j++) {
+            runtime = runtime_variable_index(state, table->variables[j]) >= 0;
+        }
+        if (runtime) {
+            state->tables[kept++] = *table;
+        } else {
+            free(table->variables);
+            free(table->bits);
+        }
+    }
+    if (kept > 1) qsort(state->tables, kept, sizeof(TruthTable), compare_truth_tables);
+    state->table_count = kept;
+}
+
+static void end_table_statement(CodegenState* state) {
+    free_truth_tables(state->tables, state->table_count);
+    state->tables = NULL;
+    state->table_count = 0;
+}
+
+// A tabulated subexpression costs the same whatever its size: its runtime
+// variables are packed into an index, which selects a bit of the table,
+// held in a constant up to 6 variables and in a constant array beyond
+static LLVMValueRef gen_table_lookup(CodegenState* state, const TruthTable* table) {
+    LLVMBuilderRef builder = state->builder;
+    LLVMTypeRef i1 = LLVMInt1TypeInContext(state->context);
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(state->context);
+    LLVMValueRef index = NULL;
+    for (int i = 0; i < table->variable_count; i++) {
+        LLVMValueRef input = gen_runtime_input(state, runtime_variable_index(state, table->variables[i]));
+        LLVMValueRef bit = LLVMBuildZExt(builder, input, i64, "index_bit");
+        if (i > 0) bit = LLVMBuildShl(builder, bit, LLVMConstInt(i64, i, 0), "index_bit");
+        index = index ? LLVMBuildOr(builder, index, bit, "index") : bit;
+    }
+
+    LLVMValueRef word;
+    LLVMValueRef shift = index;
+    if (table->word_count == 1) {
+        word = LLVMConstInt(i64, table->bits[0], 0);
+    } else {
+        LLVMTypeRef table_type = LLVMArrayType(i64, table->word_count);
+        LLVMValueRef* words = malloc(table->word_count * sizeof(LLVMValueRef));
+        if (!words) {
+            fprintf(stderr, "Error: Failed to allocate truth table\n");
+            return NULL;
+        }
+        for (int i = 0; i < table->word_count; i++) words[i] = LLVMConstInt(i64, table->bits[i], 0);
+        LLVMValueRef global = LLVMAddGlobal(state->module, table_type, "lec_truth_table");
+        LLVMSetInitializer(global, LLVMConstArray(i64, words, table->word_count));
+        LLVMSetGlobalConstant(global, 1);
+        LLVMSetLinkage(global, LLVMPrivateLinkage);
+        LLVMSetUnnamedAddress(global, LLVMGlobalUnnamedAddr);
+        free(words);
+
+        LLVMValueRef indices[] = {
+            LLVMConstInt(i64, 0, 0), LLVMBuildLShr(builder, index, LLVMConstInt(i64, 6, 0), "word_index")
+        };
+        LLVMValueRef slot = LLVMBuildInBoundsGEP2(builder, table_type, global, indices, 2, "table_slot");
+        word = LLVMBuildLoad2(builder, i64, slot, "table_word");
+        shift = LLVMBuildAnd(builder, index, LLVMConstInt(i64, 63, 0), "bit_index");
+    }
+    state->lookup_count++;
+    return LLVMBuildTrunc(builder, LLVMBuildLShr(builder, word, shift, "table_bits"), i1, "lookup");
 }
 
 // Generate code for a logical expression with detailed output
-static LLVMValueRef gen_expression(LLVMContextRef context, LLVMBuilderRef builder, 
-                                  Node* node, SymbolTable* symbol_table,
-                                  LLVMValueRef true_str, LLVMValueRef false_str,
-                                  LLVMValueRef printf_func, LLVMTypeRef printf_type) {
+static LLVMValueRef gen_expression(CodegenState* state, Node* node) {
     if (!node) {
         printf("ERROR: Null node in gen_expression\n");
         return NULL;
     }
     
-    // Debug print
-    printf("Processing node: type=%s", get_node_type_name(node->type));
-    if (node->name) printf(", name='%s'", node->name);
-    if (node->type == NODE_BOOL) printf(", value=%s", node->bool_val ? "TRUE" : "FALSE");
-    printf("\n");
+    // Debug print, as a single call so lines from parallel shards stay whole
+    printf("Processing node: type=%s%s%s%s%s\n", get_node_type_name(node->type),
+           node->name ? ", name='" : "", node->name ? node->name : "", node->name ? "'" : "",
+           node->type == NODE_BOOL ? (node->bool_val ? ", value=TRUE" : ", value=FALSE") : "");
     
+    if (state->table_count > 0) {
+        TruthTable key = {.node = node};
+        const TruthTable* table = bsearch(&key, state->tables, state->table_count, sizeof(TruthTable),
+                                          compare_truth_tables);
+        if (table) return gen_table_lookup(state, table);
+    }
+    if ((state->instrument || state->profile) && is_profiled_operator(node)) {
+        return gen_profiled_operator(state, node);
+    }
+    if (is_nary_node(node)) return gen_nary(state, node);
+
+    LLVMBuilderRef builder = state->builder;
+    LLVMTypeRef i1 = LLVMInt1TypeInContext(state->context);
     LLVMValueRef left, right;
     
     switch (node->type) {
         case NODE_BOOL:
-            return LLVMConstInt(LLVMInt1Type(), node->bool_val, 0);
+            return LLVMConstInt(i1, node->bool_val, 0);
             
         case NODE_VAR:
+            // Quantified variables shadow everything else
+            for (const BoundVariable* bound = state->bound; bound; bound = bound->next) {
+                if (strcmp(bound->name, node->name) == 0) {
+                    add_var_substitution_message(state, node->name, bound->value);
+                    return LLVMConstInt(i1, bound->value, 0);
+                }
+            }
+            
             // Handle TRUE/FALSE literals
             if (strcmp(node->name, "TRUE") == 0) {
-                return LLVMConstInt(LLVMInt1Type(), 1, 0);
+                return LLVMConstInt(i1, 1, 0);
             }
             if (strcmp(node->name, "FALSE") == 0) {
-                return LLVMConstInt(LLVMInt1Type(), 0, 0);
+                return LLVMConstInt(i1, 0, 0);
             }
             
             // Look up in symbol table
-            int value = get_symbol_value(symbol_table, node->name);
+            int value = get_symbol_value(state->symbol_table, node->name);
             if (value == ERROR_SYMBOL_NOT_FOUND) {
-                fprintf(stderr, "Error: Undefined variable '%s'\n", node->name);
-                return NULL;
+                int input = runtime_variable_index(state, node->name);
+                if (input < 0) {
+                    fprintf(stderr, "Error: Undefined variable '%s'\n", node->name);
+                    return NULL;
+                }
+                
+                // The value is only known when the program runs
+                LLVMValueRef runtime_value = gen_runtime_input(state, input);
+                emit_textf(state, "Substituted variable %s with value ", node->name);
+                emit_choice_text(state, runtime_value, "TRUE\n", "FALSE\n");
+                return runtime_value;
             }
             
             // Add substitution message
-            add_var_substitution_message(builder, printf_func, printf_type, 
-                                       node->name, true_str, false_str, value);
+            add_var_substitution_message(state, node->name, value);
             
-            return LLVMConstInt(LLVMInt1Type(), value, 0);
+            return LLVMConstInt(i1, value, 0);
             
         case NODE_NOT:
-            left = gen_expression(context, builder, node->left, symbol_table, 
-                                true_str, false_str, printf_func, printf_type);
+            left = gen_expression(state, node->left);
             if (!left) return NULL;
             
             // Add evaluation message
-            add_evaluation_message(builder, printf_func, printf_type, "Evaluated NOT operation\n");
+            add_operation_message(state, NODE_NOT);
             
             return LLVMBuildNot(builder, left, "not");
             
         case NODE_AND:
-            left = gen_expression(context, builder, node->left, symbol_table, 
-                                true_str, false_str, printf_func, printf_type);
-            right = gen_expression(context, builder, node->right, symbol_table, 
-                                 true_str, false_str, printf_func, printf_type);
-            if (!left || !right) return NULL;
-            
-            // Add evaluation message
-            add_evaluation_message(builder, printf_func, printf_type, "Evaluated AND operation\n");
-            
+            if (!gen_binary_operands(state, node, &left, &right)) return NULL;
             return LLVMBuildAnd(builder, left, right, "and");
             
         case NODE_OR:
-            left = gen_expression(context, builder, node->left, symbol_table, 
-                                true_str, false_str, printf_func, printf_type);
-            right = gen_expression(context, builder, node->right, symbol_table, 
-                                 true_str, false_str, printf_func, printf_type);
-            if (!left || !right) return NULL;
-            
-            // Add evaluation message
-            add_evaluation_message(builder, printf_func, printf_type, "Evaluated OR operation\n");
-            
+            if (!gen_binary_operands(state, node, &left, &right)) return NULL;
             return LLVMBuildOr(builder, left, right, "or");
             
         case NODE_XOR:
-            left = gen_expression(context, builder, node->left, symbol_table, 
-                                true_str, false_str, printf_func, printf_type);
-            right = gen_expression(context, builder, node->right, symbol_table, 
-                                 true_str, false_str, printf_func, printf_type);
-            if (!left || !right) return NULL;
-            
-            // Add evaluation message
-            add_evaluation_message(builder, printf_func, printf_type, "Evaluated XOR operation\n");
-            
+            if (!gen_binary_operands(state, node, &left, &right)) return NULL;
             return LLVMBuildXor(builder, left, right, "xor");
             
-        case NODE_IMPLIES: {
-            left = gen_expression(context, builder, node->left, symbol_table, 
-                                true_str, false_str, printf_func, printf_type);
-            right = gen_expression(context, builder, node->right, symbol_table, 
-                                 true_str, false_str, printf_func, printf_type);
-            if (!left || !right) return NULL;
+        case NODE_XNOR:
+            if (!gen_binary_operands(state, node, &left, &right)) return NULL;
+            return LLVMBuildNot(builder, LLVMBuildXor(builder, left, right, "xor"), "xnor");
             
-            // Add evaluation message
-            add_evaluation_message(builder, printf_func, printf_type, "Evaluated IMPLIES operation\n");
+        case NODE_IMPLIES: {
+            if (!gen_binary_operands(state, node, &left, &right)) return NULL;
             
             // a -> b is equivalent to !a || b
             LLVMValueRef not_left = LLVMBuildNot(builder, left, "not_left");
@@ -172,14 +1157,7 @@ static LLVMValueRef gen_expression(LLVMContextRef context, LLVMBuilderRef builde
             
         case NODE_IFF:
         case NODE_EQUIV: {
-            left = gen_expression(context, builder, node->left, symbol_table, 
-                                true_str, false_str, printf_func, printf_type);
-            right = gen_expression(context, builder, node->right, symbol_table, 
-                                 true_str, false_str, printf_func, printf_type);
-            if (!left || !right) return NULL;
-            
-            // Add evaluation message
-            add_evaluation_message(builder, printf_func, printf_type, "Evaluated IFF/EQUIV operation\n");
+            if (!gen_binary_operands(state, node, &left, &right)) return NULL;
             
             // a <-> b is equivalent to (a && b) || (!a && !b)
             LLVMValueRef left_and_right = LLVMBuildAnd(builder, left, right, "left_and_right");
@@ -192,12 +1170,34 @@ static LLVMValueRef gen_expression(LLVMContextRef context, LLVMBuilderRef builde
         }
             
         case NODE_ASSIGN:
-            // Assignments are handled during pre-processing, just evaluate the right side
-            if (node->right) {
-                return gen_expression(context, builder, node->right, symbol_table, 
-                                    true_str, false_str, printf_func, printf_type);
+            // Assignments are handled during pre-processing, just evaluate the expression
+            if (get_assignment_expression(node)) {
+                return gen_expression(state, get_assignment_expression(node));
             }
             return NULL;
+
+        case NODE_EXISTS:
+        case NODE_FORALL: {
+            // Q x. f is f[x := FALSE] combined with f[x := TRUE]
+            const BoundVariable* outer = state->bound;
+            BoundVariable when_false = {node->name, 0, outer};
+            BoundVariable when_true = {node->name, 1, outer};
+            state->bound = &when_false;
+            left = gen_expression(state, node->left);
+            state->bound = &when_true;
+            right = left ? gen_expression(state, node->left) : NULL;
+            state->bound = outer;
+            if (!left || !right) return NULL;
+            
+            add_operation_message(state, node->type);
+            return node->type == NODE_EXISTS ? LLVMBuildOr(builder, left, right, "exists")
+                                             : LLVMBuildAnd(builder, left, right, "forall");
+        }
+            
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY:
+            return gen_threshold(state, node);
             
         default:
             fprintf(stderr, "Unsupported node type: %d\n", node->type);
@@ -205,13 +1205,659 @@ static LLVMValueRef gen_expression(LLVMContextRef context, LLVMBuilderRef builde
     }
 }
 
+// Value of an AIG literal, negating its node's value at most once
+static LLVMValueRef gen_aig_literal(CodegenState* state, LLVMValueRef* values, LLVMValueRef* negations,
+                                    AIGLiteral literal) {
+    int node = AIG_NODE(literal);
+    if (!AIG_IS_COMPLEMENTED(literal)) return values[node];
+    if (!negations[node]) negations[node] = LLVMBuildNot(state->builder, values[node], "not");
+    return negations[node];
+}
+
+// Lower the statements into one And-Inverter Graph, optimize it, and emit an
+// and per AIG node plus a not per complemented node. Returns 0, or -1 before
+// emitting anything when gen_expression has to handle the statements.
+static int gen_aig_statements(CodegenState* state, Node** statements, int count, int first_result) {
+    AIG* aig = create_aig();
+    if (!aig) return -1;
+    for (int i = 0; i < count; i++) {
+        if (aig_add_output(aig, aig_from_node(aig, statements[i])) < 0) {
+            free_aig(aig);
+            return -1;
+        }
+    }
+    
+    AIGStats before, after;
+    aig_optimize(aig, &before, &after);  // A failed pass leaves a valid graph
+    
+    LLVMTypeRef i1 = LLVMInt1TypeInContext(state->context);
+    LLVMValueRef* values = calloc(aig->node_count, sizeof(LLVMValueRef));
+    LLVMValueRef* negations = calloc(aig->node_count, sizeof(LLVMValueRef));
+    int status = values && negations ? 0 : -1;
+    for (int i = 0; i < aig->input_count && status == 0; i++) {
+        int value = get_symbol_value(state->symbol_table, aig->input_names[i]);
+        if (value == ERROR_SYMBOL_NOT_FOUND && runtime_variable_index(state, aig->input_names[i]) < 0) {
+            status = -1;
+        }
+    }
+    if (status != 0) {
+        free(values);
+        free(negations);
+        free_aig(aig);
+        return -1;
+    }
+    
+    printf("And-Inverter Graph: %d AND nodes at depth %d, %d at depth %d after optimization\n",
+           before.and_count, before.depth, after.and_count, after.depth);
+    
+    values[0] = LLVMConstInt(i1, 0, 0);
+    for (int i = 0; i < aig->input_count; i++) {
+        int value = get_symbol_value(state->symbol_table, aig->input_names[i]);
+        values[aig->input_nodes[i]] = value != ERROR_SYMBOL_NOT_FOUND
+            ? LLVMConstInt(i1, value, 0)
+            : gen_runtime_input(state, runtime_variable_index(state, aig->input_names[i]));
+    }
+    for (int i = 1; i < aig->node_count; i++) {
+        if (!aig_is_and(aig, i)) continue;
+        values[i] = LLVMBuildAnd(state->builder,
+                                 gen_aig_literal(state, values, negations, aig->nodes[i].fanin0),
+                                 gen_aig_literal(state, values, negations, aig->nodes[i].fanin1), "and");
+    }
+    for (int i = 0; i < count; i++) {
+        record_binary_result(state, first_result + i, gen_aig_literal(state, values, negations, aig->outputs[i]));
+    }
+    
+    free(values);
+    free(negations);
+    free_aig(aig);
+    return 0;
+}
+
+static AIGLiteral resolve_known_symbol(void* context, const char* name) {
+    int value = get_symbol_value(context, name);
+    if (value == ERROR_SYMBOL_NOT_FOUND) return AIG_INVALID;
+    return value ? AIG_TRUE : AIG_FALSE;
+}
+
+// Block testing the node of edge, created on first use and queued for emission
+static LLVMBasicBlockRef diagram_block(CodegenState* state, LLVMBasicBlockRef* blocks, BDDEdge edge,
+                                       BDDEdge* pending, int* pending_count) {
+    if (!blocks[edge]) {
+        LLVMValueRef function = LLVMGetBasicBlockParent(LLVMGetInsertBlock(state->builder));
+        blocks[edge] = LLVMAppendBasicBlockInContext(state->context, function, "diagram_node");
+        pending[(*pending_count)++] = edge;
+    }
+    return blocks[edge];
+}
+
+// Lower statement through a reduced ordered decision diagram: every node
+// becomes a block that loads one runtime variable and branches to the
+// blocks of its cofactors, which are shared wherever the diagram shares
+// them, so a run only executes the tests on its path. Returns the value,
+// or NULL before emitting anything when the statement has other free
+// variables or its diagram is too large.
+static LLVMValueRef gen_decision_diagram(CodegenState* state, Node* statement) {
+    AIG* aig = create_aig();
+    if (!aig) return NULL;
+    AIGLiteral literal = aig_from_node_resolved(aig, statement, resolve_known_symbol, state->symbol_table);
+    int* inputs = malloc((aig->input_count > 0 ? aig->input_count : 1) * sizeof(int));
+    int usable = literal != AIG_INVALID && inputs;
+    for (int i = 0; usable && i < aig->input_count; i++) {
+        inputs[i] = runtime_variable_index(state, aig->input_names[i]);
+        usable = inputs[i] >= 0;
+    }
+    BDD* bdd = usable ? create_bdd(aig->input_count, DIAGRAM_NODE_LIMIT) : NULL;
+    BDDEdge root = bdd ? bdd_from_aig(bdd, aig, literal) : BDD_INVALID;
+    free_aig(aig);
+
+    LLVMBasicBlockRef* blocks = NULL;
+    BDDEdge* pending = NULL;
+    LLVMValueRef* values = NULL;
+    LLVMBasicBlockRef* incoming = NULL;
+    if (root != BDD_INVALID) {
+        int edges = 2 * bdd->node_count;
+        blocks = calloc(edges, sizeof(LLVMBasicBlockRef));
+        pending = malloc(edges * sizeof(BDDEdge));
+        values = malloc(2 * edges * sizeof(LLVMValueRef));
+        incoming = malloc(2 * edges * sizeof(LLVMBasicBlockRef));
+    }
+    LLVMValueRef result = NULL;
+    if (!blocks || !pending || !values || !incoming) {
+        // Nothing emitted; the caller generates the expression
+    } else if (BDD_NODE(root) == 0) {
+        result = LLVMConstInt(LLVMInt1TypeInContext(state->context), root == BDD_TRUE, 0);
+    } else {
+        LLVMBuilderRef builder = state->builder;
+        LLVMValueRef function = LLVMGetBasicBlockParent(LLVMGetInsertBlock(builder));
+        LLVMBasicBlockRef done = LLVMAppendBasicBlockInContext(state->context, function, "diagram_done");
+        int pending_count = 0;
+        int incoming_count = 0;
+        LLVMBuildBr(builder, diagram_block(state, blocks, root, pending, &pending_count));
+
+        // Blocks are emitted in the order they are first reached
+        for (int next = 0; next < pending_count; next++) {
+            BDDEdge edge = pending[next];
+            BDDEdge low = bdd_low(bdd, edge);
+            BDDEdge high = bdd_high(bdd, edge);
+            LLVMPositionBuilderAtEnd(builder, blocks[edge]);
+            LLVMValueRef input = gen_runtime_input(state, inputs[bdd_top_variable(bdd, edge)]);
+            state->diagram_nodes++;
+
+            if (BDD_NODE(low) == 0 && BDD_NODE(high) == 0) {
+                // Both cofactors constant: the value is the variable or its negation
+                values[incoming_count] = high == BDD_TRUE ? input : LLVMBuildNot(builder, input, "not");
+                incoming[incoming_count++] = blocks[edge];
+                LLVMBuildBr(builder, done);
+                continue;
+            }
+            LLVMBasicBlockRef targets[2];
+            BDDEdge cofactors[2] = {high, low};
+            for (int i = 0; i < 2; i++) {
+                if (BDD_NODE(cofactors[i]) == 0) {
+                    targets[i] = done;
+                    values[incoming_count] = LLVMConstInt(LLVMInt1TypeInContext(state->context),
+                                                          cofactors[i] == BDD_TRUE, 0);
+                    incoming[incoming_count++] = blocks[edge];
+                } else {
+                    targets[i] = diagram_block(state, blocks, cofactors[i], pending, &pending_count);
+                }
+            }
+            LLVMBuildCondBr(builder, input, targets[0], targets[1]);
+        }
+
+        LLVMMoveBasicBlockAfter(done, LLVMGetLastBasicBlock(function));
+        LLVMPositionBuilderAtEnd(builder, done);
+        result = LLVMBuildPhi(builder, LLVMInt1TypeInContext(state->context), "diagram");
+        LLVMAddIncoming(result, values, incoming, incoming_count);
+        state->diagram_count++;
+    }
+
+    free(blocks);
+    free(pending);
+    free(values);
+    free(incoming);
+    free(inputs);
+    free_bdd(bdd);
+    return result;
+}
+
+// Error message for a statement that gen_expression could not lower
+static char* statement_error(Node* statement) {
+    char* text = node_to_string(statement);
+    const char* prefix = "Failed to generate code for expression: ";
+    char* message = malloc(strlen(prefix) + (text ? strlen(text) : 1) + 1);
+    if (message) {
+        strcpy(message, prefix);
+        strcat(message, text ? text : "?");
+    }
+    free(text);
+    return message ? message : strdup("Failed to generate code for an expression");
+}
+
+// Emit the trace and results of count non-assignment statements, the first
+// of which has result index first_result. Returns NULL on success or an
+// allocated error message for the first statement that cannot be generated.
+static char* gen_statements(CodegenState* state, Node** statements, int count, int first_result) {
+    // Binary results carry no trace, so the statements can be merged into one
+    // graph, unless operators have to keep their identity for the branch profile
+    int profiled = state->instrument || state->profile;
+    if (state->use_aig && !profiled && state->output_format == LLVM_OUTPUT_BINARY &&
+        gen_aig_statements(state, statements, count, first_result) == 0) {
+        return NULL;
+    }
+    int tabulate = state->use_lookup_tables && !profiled && state->output_format == LLVM_OUTPUT_BINARY &&
+                   state->runtime_variable_count > 0;
+    int diagrams = state->use_decision_diagrams && !profiled && state->output_format == LLVM_OUTPUT_BINARY;
+    
+    for (int i = 0; i < count; i++) {
+        Node* node = statements[i];
+        
+        // Show expression being evaluated
+        if (state->output_format == LLVM_OUTPUT_TEXT) {
+            char* expr_str = node_to_string(node);
+            if (expr_str) {
+                emit_textf(state, "Evaluating expression: %s\n", expr_str);
+                free(expr_str);
+            }
+        }
+        
+        // Statements without a usable decision diagram are generated from the expression
+        LLVMValueRef expr_result = diagrams ? gen_decision_diagram(state, node) : NULL;
+        if (!expr_result) {
+            if (profiled && begin_profiled_statement(state, node) != 0) {
+                fprintf(stderr, "Error: Failed to index operators for the branch profile\n");
+            }
+            if (tabulate) begin_table_statement(state, node);
+            
+            // Generate code with detailed evaluation
+            expr_result = gen_expression(state, node);
+            end_profiled_statement(state);
+            end_table_statement(state);
+        }
+        
+        if (!expr_result) return statement_error(node);
+        if (state->output_format == LLVM_OUTPUT_BINARY) {
+            record_binary_result(state, first_result + i, expr_result);
+        } else {
+            emit_result_text(state, expr_result);
+        }
+    }
+    if (state->diagram_count > 0) {
+        printf("Generated %d statement(s) from decision diagrams with %d branch node(s)\n",
+               state->diagram_count, state->diagram_nodes);
+    }
+    if (state->lookup_count > 0) {
+        printf("Replaced %d subexpression(s) by truth-table lookups\n", state->lookup_count);
+    }
+    return NULL;
+}
+
+// Append the counters of every instrumented site to path at the current
+// position, one line per site in the format of branch_profile.h. A profile
+// that cannot be opened is skipped without affecting the output.
+static void build_profile_writer(CodegenState* state, const char* path) {
+    LLVMContextRef context = state->context;
+    LLVMModuleRef module = state->module;
+    LLVMBuilderRef builder = state->builder;
+    LLVMBasicBlockRef saved_block = LLVMGetInsertBlock(builder);
+    LLVMTypeRef i8_ptr = LLVMPointerType(LLVMInt8TypeInContext(context), 0);
+    LLVMTypeRef i64 = LLVMInt64TypeInContext(context);
+    LLVMTypeRef i64_ptr = LLVMPointerType(i64, 0);
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(context);
+    LLVMTypeRef void_type = LLVMVoidTypeInContext(context);
+
+    // FILE* fopen(const char*, const char*), int fprintf(FILE*, const char*, ...), int fclose(FILE*)
+    LLVMTypeRef fopen_params[] = { i8_ptr, i8_ptr };
+    LLVMTypeRef fopen_type = LLVMFunctionType(i8_ptr, fopen_params, 2, 0);
+    LLVMValueRef fopen_func = LLVMAddFunction(module, "fopen", fopen_type);
+    LLVMTypeRef fprintf_params[] = { i8_ptr, i8_ptr };
+    LLVMTypeRef fprintf_type = LLVMFunctionType(i32, fprintf_params, 2, 1);
+    LLVMValueRef fprintf_func = LLVMAddFunction(module, "fprintf", fprintf_type);
+    LLVMTypeRef fclose_type = LLVMFunctionType(i32, &i8_ptr, 1, 0);
+    LLVMValueRef fclose_func = LLVMAddFunction(module, "fclose", fclose_type);
+
+    // void lec_write_counts(FILE* file, i8* prefix, i64* counts, i64 n):
+    // the prefix, then " %llu" per counter and a newline
+    LLVMTypeRef write_params[] = { i8_ptr, i8_ptr, i64_ptr, i64 };
+    LLVMTypeRef write_type = LLVMFunctionType(void_type, write_params, 4, 0);
+    LLVMValueRef write_func = LLVMAddFunction(module, "lec_write_counts", write_type);
+    LLVMSetLinkage(write_func, LLVMInternalLinkage);
+    {
+        LLVMValueRef file = LLVMGetParam(write_func, 0);
+        LLVMValueRef counts = LLVMGetParam(write_func, 2);
+        LLVMValueRef n = LLVMGetParam(write_func, 3);
+        LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(context, write_func, "entry");
+        LLVMBasicBlockRef loop = LLVMAppendBasicBlockInContext(context, write_func, "loop");
+        LLVMBasicBlockRef done = LLVMAppendBasicBlockInContext(context, write_func, "done");
+
+        LLVMPositionBuilderAtEnd(builder, entry);
+        LLVMValueRef prefix_args[] = { file, LLVMGetParam(write_func, 1) };
+        LLVMBuildCall2(builder, fprintf_type, fprintf_func, prefix_args, 2, "");
+        LLVMBuildBr(builder, loop);
+
+        LLVMPositionBuilderAtEnd(builder, loop);
+        LLVMValueRef i = LLVMBuildPhi(builder, i64, "i");
+        LLVMValueRef slot = LLVMBuildInBoundsGEP2(builder, i64, counts, &i, 1, "count_slot");
+        LLVMValueRef count_args[] = {
+            file, string_pool_get(state->strings, " %llu"), LLVMBuildLoad2(builder, i64, slot, "count")
+        };
+        LLVMBuildCall2(builder, fprintf_type, fprintf_func, count_args, 3, "");
+        LLVMValueRef next = LLVMBuildAdd(builder, i, LLVMConstInt(i64, 1, 0), "next");
+        LLVMBuildCondBr(builder, LLVMBuildICmp(builder, LLVMIntULT, next, n, "more"), loop, done);
+        LLVMValueRef i_values[] = { LLVMConstInt(i64, 0, 0), next };
+        LLVMBasicBlockRef i_blocks[] = { entry, loop };
+        LLVMAddIncoming(i, i_values, i_blocks, 2);
+
+        LLVMPositionBuilderAtEnd(builder, done);
+        LLVMValueRef newline_args[] = { file, string_pool_get(state->strings, "\n") };
+        LLVMBuildCall2(builder, fprintf_type, fprintf_func, newline_args, 2, "");
+        LLVMBuildRetVoid(builder);
+    }
+
+    LLVMPositionBuilderAtEnd(builder, saved_block);
+    LLVMValueRef function = LLVMGetBasicBlockParent(saved_block);
+    LLVMBasicBlockRef write = LLVMAppendBasicBlockInContext(context, function, "write_profile");
+    LLVMBasicBlockRef done = LLVMAppendBasicBlockInContext(context, function, "profile_done");
+    LLVMValueRef fopen_args[] = { string_pool_get(state->strings, path), string_pool_get(state->strings, "a") };
+    LLVMValueRef file = LLVMBuildCall2(builder, fopen_type, fopen_func, fopen_args, 2, "profile");
+    LLVMBuildCondBr(builder, LLVMBuildIsNull(builder, file, "no_profile"), done, write);
+
+    LLVMPositionBuilderAtEnd(builder, write);
+    LLVMValueRef zero = LLVMConstInt(i64, 0, 0);
+    for (int i = 0; i < state->site_count; i++) {
+        const ProfileSite* site = &state->sites[i];
+        char prefix[BRANCH_PROFILE_KEY_LENGTH + 16];
+        snprintf(prefix, sizeof(prefix), "%s %d", site->key, site->index);
+        LLVMValueRef indices[] = { zero, zero };
+        LLVMValueRef args[] = {
+            file,
+            string_pool_get(state->strings, prefix),
+            LLVMConstInBoundsGEP2(LLVMGlobalGetValueType(site->counters), site->counters, indices, 2),
+            LLVMConstInt(i64, site->operand_count + 1, 0)
+        };
+        LLVMBuildCall2(builder, write_type, write_func, args, 4, "");
+    }
+    LLVMBuildCall2(builder, fclose_type, fclose_func, &file, 1, "");
+    LLVMBuildBr(builder, done);
+    LLVMPositionBuilderAtEnd(builder, done);
+}
+
+// Create a target machine for the host at the given optimization level
+static LLVMTargetMachineRef create_native_target_machine(int opt_level, char** error_message) {
+    LLVMCodeGenOptLevel levels[] = {
+        LLVMCodeGenLevelNone, LLVMCodeGenLevelLess, LLVMCodeGenLevelDefault, LLVMCodeGenLevelAggressive
+    };
+    char* triple = LLVMGetDefaultTargetTriple();
+    LLVMTargetRef target;
+    LLVMTargetMachineRef machine = NULL;
+    
+    if (LLVMGetTargetFromTriple(triple, &target, error_message) == 0) {
+        machine = LLVMCreateTargetMachine(target, triple, "generic", "",
+                                          levels[opt_level < 0 ? 0 : opt_level > 3 ? 3 : opt_level],
+                                          LLVMRelocPIC, LLVMCodeModelDefault);
+    }
+    LLVMDisposeMessage(triple);
+    return machine;
+}
+
+// Apply optimizations to the module
+static void optimize_module(LLVMModuleRef module, LLVMTargetMachineRef target_machine, int opt_level) {
+    if (opt_level <= 0) return;
+    
+    char pipeline[32];
+    snprintf(pipeline, sizeof(pipeline), "default<O%d>", opt_level > 3 ? 3 : opt_level);
+    
+    LLVMPassBuilderOptionsRef pass_options = LLVMCreatePassBuilderOptions();
+    LLVMErrorRef error = LLVMRunPasses(module, pipeline, target_machine, pass_options);
+    if (error) {
+        char* message = LLVMGetErrorMessage(error);
+        fprintf(stderr, "Warning: Failed to optimize module: %s\n", message);
+        LLVMDisposeErrorMessage(message);
+    }
+    LLVMDisposePassBuilderOptions(pass_options);
+}
+
+// Verify a module. Returns NULL if it is valid or an allocated error message.
+static char* verify_module(LLVMModuleRef module) {
+    char* error_msg = NULL;
+    char* message = NULL;
+    
+    if (LLVMVerifyModule(module, LLVMReturnStatusAction, &error_msg)) {
+        message = strdup(error_msg && *error_msg ? error_msg : "Module verification failed");
+    }
+    if (error_msg) LLVMDisposeMessage(error_msg);
+    return message;
+}
+
+// Optimize and compile a verified module to an object file.
+// Returns NULL on success or an allocated error message.
+static char* emit_object_file(LLVMModuleRef module, int opt_level, const char* filename) {
+    char* error_msg = NULL;
+    
+    LLVMTargetMachineRef machine = create_native_target_machine(opt_level, &error_msg);
+    if (!machine) {
+        char* message = strdup(error_msg ? error_msg : "Failed to create target machine");
+        if (error_msg) LLVMDisposeMessage(error_msg);
+        return message;
+    }
+    
+    char* triple = LLVMGetTargetMachineTriple(machine);
+    LLVMTargetDataRef data_layout = LLVMCreateTargetDataLayout(machine);
+    char* layout = LLVMCopyStringRepOfTargetData(data_layout);
+    LLVMSetTarget(module, triple);
+    LLVMSetDataLayout(module, layout);
+    LLVMDisposeMessage(layout);
+    LLVMDisposeTargetData(data_layout);
+    LLVMDisposeMessage(triple);
+    
+    optimize_module(module, machine, opt_level);
+    
+    char* message = NULL;
+    if (LLVMTargetMachineEmitToFile(machine, module, (char*)filename, LLVMObjectFile, &error_msg)) {
+        message = strdup(error_msg ? error_msg : "Failed to emit object file");
+        if (error_msg) LLVMDisposeMessage(error_msg);
+    }
+    LLVMDisposeTargetMachine(machine);
+    return message;
+}
+
+// A contiguous run of statements compiled into its own module and object file
+typedef struct {
+    int index;
+    Node** statements;
+    int count;
+    int first_result;
+    SymbolTable* symbol_table;
+    const LLVMCodegenOptions* options;
+    unsigned char* results_init; // Shared; each shard owns whole bytes of it
+    size_t results_size;
+    char* object_file;
+    char* error_message;
+    int cached;                  // Object was taken from the cache
+} ShardJob;
+
+// Build "void lec_shard_N()" in a fresh context and compile it to the
+// shard's object file
+static void build_shard_object(ShardJob* job) {
+    char name[64];
+    snprintf(name, sizeof(name), "lec_shard_%d", job->index);
+    
+    LLVMContextRef context = LLVMContextCreate();
+    LLVMModuleRef module = LLVMModuleCreateWithNameInContext(name, context);
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
+    
+    LLVMTypeRef shard_type = LLVMFunctionType(LLVMVoidTypeInContext(context), NULL, 0, 0);
+    LLVMValueRef shard_func = LLVMAddFunction(module, name, shard_type);
+    LLVMSetVisibility(shard_func, LLVMHiddenVisibility);
+    LLVMPositionBuilderAtEnd(builder, LLVMAppendBasicBlockInContext(context, shard_func, "entry"));
+    
+    StringPool* strings = init_string_pool(module);
+    if (!strings) {
+        job->error_message = strdup("Failed to allocate string pool");
+    } else {
+        CodegenState state = {
+            .context = context,
+            .module = module,
+            .builder = builder,
+            .symbol_table = job->symbol_table,
+            .strings = strings,
+            .output_format = job->options->output_format,
+            .use_aig = job->options->use_aig,
+            .use_lookup_tables = job->options->use_lookup_tables,
+            .use_decision_diagrams = job->options->use_decision_diagrams,
+            .runtime_variables = job->options->runtime_variables,
+            .runtime_variable_count = job->options->runtime_variable_count,
+            .profile = job->options->profile,
+            .results_init = job->results_init,
+            .results_size = job->results_size,
+        };
+        declare_output_runtime(&state, job->results_size);
+        job->error_message = gen_statements(&state, job->statements, job->count, job->first_result);
+        flush_pending_text(&state);
+        LLVMBuildRetVoid(builder);
+        free(state.pending);
+        free_string_pool(strings);
+        
+        if (!job->error_message) job->error_message = verify_module(module);
+        if (!job->error_message) {
+            job->error_message = emit_object_file(module, job->options->optimization_level, job->object_file);
+        }
+    }
+    
+    LLVMDisposeBuilder(builder);
+    LLVMDisposeModule(module);
+    LLVMContextDispose(context);
+}
+
+// Thread pool job: reuse the shard's object from the cache or build it.
+// A cache entry is the object plus the constant result bits the shard
+// folded into the shared bitset.
+static void run_shard_job(void* arg) {
+    ShardJob* job = (ShardJob*)arg;
+    const char* cache_dir = job->options->cache_dir;
+    unsigned char* result_bytes = NULL;
+    size_t result_length = 0;
+    if (job->options->output_format == LLVM_OUTPUT_BINARY) {
+        result_bytes = job->results_init + LLVM_RESULTS_HEADER_SIZE + job->first_result / 8;
+        result_length = (job->count + 7) / 8;
+    }
+    
+    char key[CONTENT_HASH_HEX_LENGTH + 1];
+    if (cache_dir) {
+        ContentHash hash;
+        content_hash_init(&hash);
+        llvm_codegen_hash_options(&hash, job->options);
+        content_hash_string(&hash, "shard");
+        content_hash_int(&hash, job->index);
+        content_hash_int(&hash, job->first_result);
+        content_hash_int(&hash, job->count);
+        content_hash_int(&hash, (long)job->results_size);
+        for (int i = 0; i < job->count; i++) {
+            content_hash_node(&hash, job->statements[i], job->symbol_table);
+        }
+        content_hash_hex(&hash, key);
+        
+        unsigned char* cached_bytes = malloc(result_length + 1);
+        if (cached_bytes &&
+            compile_cache_fetch_data(cache_dir, key, ".bits", cached_bytes, result_length) &&
+            compile_cache_fetch(cache_dir, key, ".o", job->object_file)) {
+            if (result_length > 0) memcpy(result_bytes, cached_bytes, result_length);
+            job->cached = 1;
+        }
+        free(cached_bytes);
+        if (job->cached) return;
+    }
+    
+    build_shard_object(job);
+    
+    if (cache_dir && !job->error_message) {
+        // Store the bits before the object, which is what marks the entry complete
+        if (compile_cache_store_data(cache_dir, key, ".bits", result_bytes, result_length) == 0) {
+            compile_cache_store(cache_dir, key, ".o", job->object_file);
+        }
+    }
+}
+
+// Statements per shard when splitting count statements into at most
+// shard_count shards; always a multiple of 8
+static int shard_size(int count, int shard_count) {
+    int per_shard = (count + shard_count - 1) / shard_count;
+    return (per_shard + 7) / 8 * 8;
+}
+
+// Split statements into shards and compile them on a thread pool. Each
+// shard becomes a function called in order from main. Returns 0 and
+// appends the shard objects to result->object_files on success.
+static int gen_sharded_statements(CodegenState* state, Node** statements, int count,
+                                  int shard_count, const LLVMCodegenOptions* options,
+                                  LLVMCodegenResult* result) {
+    int per_shard = shard_size(count, shard_count);
+    shard_count = (count + per_shard - 1) / per_shard;
+    
+    ShardJob* jobs = calloc(shard_count, sizeof(ShardJob));
+    ThreadPool* pool = thread_pool_create(options->jobs);
+    if (!jobs || !pool) {
+        result->error_message = strdup("Failed to set up parallel code generation");
+        free(jobs);
+        if (pool) thread_pool_destroy(pool);
+        return 1;
+    }
+    
+    printf("Generating %d statements in %d shards on %d threads\n", count, shard_count, options->jobs);
+    
+    for (int k = 0; k < shard_count; k++) {
+        char object_file[PATH_MAX];
+        snprintf(object_file, sizeof(object_file), "%s/shard_%d.o", result->object_dir, k);
+        
+        ShardJob* job = &jobs[k];
+        job->index = k;
+        job->first_result = k * per_shard;
+        job->statements = statements + job->first_result;
+        job->count = count - job->first_result < per_shard ? count - job->first_result : per_shard;
+        job->symbol_table = state->symbol_table;
+        job->options = options;
+        job->results_init = state->results_init;
+        job->results_size = state->results_size;
+        job->object_file = strdup(object_file);
+        result->object_files[result->object_count++] = job->object_file;
+        
+        thread_pool_submit(pool, run_shard_job, job);
+    }
+    thread_pool_wait(pool);
+    thread_pool_destroy(pool);
+    
+    // Call the shards in statement order
+    LLVMTypeRef shard_type = LLVMFunctionType(LLVMVoidTypeInContext(state->context), NULL, 0, 0);
+    int failed = 0;
+    int cached = 0;
+    for (int k = 0; k < shard_count; k++) {
+        cached += jobs[k].cached;
+        if (jobs[k].error_message) {
+            if (!failed) {
+                result->error_message = jobs[k].error_message;
+            } else {
+                free(jobs[k].error_message);
+            }
+            failed = 1;
+            continue;
+        }
+        
+        char name[64];
+        snprintf(name, sizeof(name), "lec_shard_%d", k);
+        LLVMValueRef shard_func = LLVMAddFunction(state->module, name, shard_type);
+        LLVMSetVisibility(shard_func, LLVMHiddenVisibility);
+        LLVMBuildCall2(state->builder, shard_type, shard_func, NULL, 0, "");
+    }
+    
+    if (options->cache_dir) {
+        printf("Reused %d of %d shards from the cache\n", cached, shard_count);
+    }
+    
+    free(jobs);
+    return failed;
+}
+
+// Hash everything besides the statements that determines the generated code
+void llvm_codegen_hash_options(ContentHash* hash, const LLVMCodegenOptions* options) {
+    char* triple = LLVMGetDefaultTargetTriple();
+    content_hash_int(hash, COMPILE_CACHE_FORMAT_VERSION);
+    content_hash_string(hash, compile_cache_build_id());
+    content_hash_int(hash, LLVM_RESULTS_VERSION);
+    content_hash_string(hash, LLVM_VERSION_STRING);
+    content_hash_string(hash, triple);
+    content_hash_int(hash, options->optimization_level);
+    content_hash_int(hash, options->output_format);
+    content_hash_int(hash, options->use_aig);
+    content_hash_int(hash, options->use_lookup_tables);
+    content_hash_int(hash, options->use_decision_diagrams);
+    content_hash_int(hash, options->runtime_variable_count);
+    for (int i = 0; i < options->runtime_variable_count; i++) {
+        content_hash_string(hash, options->runtime_variables[i]);
+    }
+    content_hash_string(hash, options->profile_output);
+    hash_branch_profile(hash, options->profile);
+    LLVMDisposeMessage(triple);
+}
+
 // Generate LLVM IR for an AST with optimization level
 LLVMCodegenResult generate_llvm_ir(MultiStatementAST* multi_ast, SymbolTable* symbol_table, 
                                  const char* output_filename, int optimization_level) {
+    LLVMCodegenOptions options = {
+        .optimization_level = optimization_level,
+        .output_format = LLVM_OUTPUT_TEXT,
+        .jobs = 1,
+        .emit_llvm = 1,
+    };
+    return generate_llvm_ir_with_options(multi_ast, symbol_table, output_filename, &options);
+}
+
+// Generate LLVM IR for an AST with the given code generation options
+LLVMCodegenResult generate_llvm_ir_with_options(MultiStatementAST* multi_ast, SymbolTable* symbol_table,
+                                              const char* output_filename, const LLVMCodegenOptions* options) {
     LLVMCodegenResult result = {LLVM_CODEGEN_OK, NULL, NULL, NULL};
     
     // Validate inputs
-    if (!multi_ast || !symbol_table || !output_filename) {
+    if (!multi_ast || !symbol_table || !output_filename || !options) {
         result.error_code = LLVM_CODEGEN_ERROR;
         result.error_message = strdup("Invalid input parameters");
         return result;
@@ -233,148 +1879,218 @@ LLVMCodegenResult generate_llvm_ir(MultiStatementAST* multi_ast, SymbolTable* sy
     LLVMInitializeNativeTarget();
     LLVMInitializeNativeAsmPrinter();
     
+    // Collect the statements that produce a result, one bit each in binary mode
+    Node** statements = malloc((multi_ast->count > 0 ? multi_ast->count : 1) * sizeof(Node*));
+    if (!statements) {
+        result.error_code = LLVM_CODEGEN_ERROR;
+        result.error_message = strdup("Failed to allocate statement list");
+        return result;
+    }
+    int non_assignment_count = 0;
+    for (int i = 0; i < multi_ast->count; i++) {
+        Node* node = multi_ast->statements[i];
+        if (node && node->type != NODE_ASSIGN) statements[non_assignment_count++] = node;
+    }
+    
+    // Large inputs are split into shards compiled in parallel, except while
+    // instrumenting, since main writes out the counters of every operator
+    int shard_count = 0;
+    if (options->jobs > 1 && !options->profile_output) {
+        shard_count = non_assignment_count / SHARD_MIN_STATEMENTS;
+        if (shard_count > options->jobs * 2) shard_count = options->jobs * 2;
+        if (shard_count < 2) shard_count = 0;
+    }
+    
+    // Objects for the backend are written to a private directory
+    char object_dir[] = "/tmp/lec_objects_XXXXXX";
+    if (shard_count > 0) {
+        int per_shard = shard_size(non_assignment_count, shard_count);
+        shard_count = (non_assignment_count + per_shard - 1) / per_shard;
+    }
+    if (!mkdtemp(object_dir) ||
+        !(result.object_dir = strdup(object_dir)) ||
+        !(result.object_files = calloc(shard_count + 1, sizeof(char*)))) {
+        result.error_code = LLVM_CODEGEN_ERROR;
+        result.error_message = strdup("Failed to create directory for object files");
+        free(statements);
+        return result;
+    }
+    
     // Create context, module, and builder
     LLVMContextRef context = LLVMContextCreate();
     char module_name[256];
     snprintf(module_name, sizeof(module_name), "%s_module", output_filename);
-    LLVMModuleRef module = LLVMModuleCreateWithName(module_name);
-    LLVMBuilderRef builder = LLVMCreateBuilder();
+    LLVMModuleRef module = LLVMModuleCreateWithNameInContext(module_name, context);
+    LLVMBuilderRef builder = LLVMCreateBuilderInContext(context);
     
     // Store the module in the result structure
     result.module = module;
     
     // Create main function
-    LLVMTypeRef main_type = LLVMFunctionType(LLVMInt32Type(), NULL, 0, 0);
+    LLVMTypeRef i32 = LLVMInt32TypeInContext(context);
+    LLVMTypeRef main_type = LLVMFunctionType(i32, NULL, 0, 0);
     LLVMValueRef main_func = LLVMAddFunction(module, "main", main_type);
     
     // Create entry block
-    LLVMBasicBlockRef entry = LLVMAppendBasicBlock(main_func, "entry");
+    LLVMBasicBlockRef entry = LLVMAppendBasicBlockInContext(context, main_func, "entry");
     LLVMPositionBuilderAtEnd(builder, entry);
     
-    // Create printf function
-    LLVMTypeRef printf_param_types[] = { LLVMPointerType(LLVMInt8Type(), 0) };
-    LLVMTypeRef printf_type = LLVMFunctionType(LLVMInt32Type(), printf_param_types, 1, 1);
-    LLVMValueRef printf_func = LLVMAddFunction(module, "printf", printf_type);
+    // Create the string pool and the state shared by the generators
+    StringPool* strings = init_string_pool(module);
+    if (!strings) {
+        result.error_code = LLVM_CODEGEN_ERROR;
+        result.error_message = strdup("Failed to allocate string pool");
+        free(statements);
+        LLVMDisposeBuilder(builder);
+        LLVMDisposeModule(module);
+        LLVMContextDispose(context);
+        result.module = NULL;
+        return result;
+    }
     
-    // Create strings for output
-    LLVMValueRef true_str = LLVMBuildGlobalStringPtr(builder, "TRUE", "true_str");
-    LLVMValueRef false_str = LLVMBuildGlobalStringPtr(builder, "FALSE", "false_str");
+    CodegenState state = {
+        .context = context,
+        .module = module,
+        .builder = builder,
+        .symbol_table = symbol_table,
+        .strings = strings,
+        .output_format = options->output_format,
+        .exports_runtime = shard_count > 0,
+        .use_aig = options->use_aig,
+        .use_lookup_tables = options->use_lookup_tables,
+        .use_decision_diagrams = options->use_decision_diagrams,
+        .runtime_variables = options->runtime_variables,
+        .runtime_variable_count = options->runtime_variable_count,
+        .instrument = options->profile_output != NULL,
+        .profile = options->profile,
+    };
+    build_output_runtime(&state);
+    build_runtime_inputs(&state);
+    
+    if (state.output_format == LLVM_OUTPUT_BINARY) {
+        // Header: magic, format version, reserved, little-endian statement count
+        state.results_size = LLVM_RESULTS_HEADER_SIZE + (non_assignment_count + 7) / 8;
+        state.results_init = calloc(state.results_size, 1);
+        if (!state.results_init) {
+            result.error_code = LLVM_CODEGEN_ERROR;
+            result.error_message = strdup("Failed to allocate result bitset");
+            free(statements);
+            free_string_pool(strings);
+            LLVMDisposeBuilder(builder);
+            LLVMDisposeModule(module);
+            LLVMContextDispose(context);
+            result.module = NULL;
+            return result;
+        }
+        memcpy(state.results_init, LLVM_RESULTS_MAGIC, 4);
+        state.results_init[4] = LLVM_RESULTS_VERSION;
+        for (int byte = 0; byte < 4; byte++) {
+            state.results_init[8 + byte] = (unsigned char)((unsigned)non_assignment_count >> (8 * byte));
+        }
+        
+        LLVMTypeRef results_type = LLVMArrayType(LLVMInt8TypeInContext(context), state.results_size);
+        state.results_global = LLVMAddGlobal(module, results_type, "lec_results");
+        set_runtime_linkage(&state, state.results_global);
+    }
     
     // Print header
-    add_evaluation_message(builder, printf_func, printf_type, 
-                         "Logical Expression Evaluation\n");
-    add_evaluation_message(builder, printf_func, printf_type, 
-                         "---------------------------\n\n");
+    emit_text(&state, "Logical Expression Evaluation\n");
+    emit_text(&state, "---------------------------\n\n");
     
     // Indicate start of evaluation
-    add_evaluation_message(builder, printf_func, printf_type, 
-                         "Starting evaluation of multiple expressions\n");
+    emit_text(&state, "Starting evaluation of multiple expressions\n");
     
     // Process all variable assignments and print them
-    int non_assignment_count = 0;
-    
     for (int i = 0; i < multi_ast->count; i++) {
         Node* node = multi_ast->statements[i];
-        if (!node) continue;
+        if (!node || node->type != NODE_ASSIGN) continue;
         
-        if (node->type == NODE_ASSIGN) {
-            // For assignments, display the variable and its value
-            char* var_name = node->name;
-            int value = get_symbol_value(symbol_table, var_name);
-            
-            LLVMValueRef name_str = LLVMBuildGlobalStringPtr(builder, var_name, "var_name");
-            LLVMValueRef value_str = (value == 1) ? true_str : false_str;
-            
-            // Show expression evaluation
-            LLVMValueRef eval_fmt = LLVMBuildGlobalStringPtr(builder, "Evaluating expression: %s = %s\n", "eval_fmt");
-            LLVMValueRef eval_args[] = { eval_fmt, name_str, value_str };
-            LLVMBuildCall2(builder, printf_type, printf_func, eval_args, 3, "");
-            
-            // Show assignment
-            LLVMValueRef assign_fmt = LLVMBuildGlobalStringPtr(builder, "Assigned %s = %s\n", "assign_fmt");
-            LLVMValueRef assign_args[] = { assign_fmt, name_str, value_str };
-            LLVMBuildCall2(builder, printf_type, printf_func, assign_args, 3, "");
-            
-            // Show result
-            LLVMValueRef result_fmt = LLVMBuildGlobalStringPtr(builder, "Result: %s\n\n", "result_fmt");
-            LLVMValueRef result_args[] = { result_fmt, value_str };
-            LLVMBuildCall2(builder, printf_type, printf_func, result_args, 2, "");
-        } else {
-            // Count non-assignment expressions for later processing
-            non_assignment_count++;
-        }
+        // For assignments, display the variable and its value
+        const char* value_str = get_symbol_value(symbol_table, node->name) == 1 ? "TRUE" : "FALSE";
+        emit_textf(&state, "Evaluating expression: %s = %s\n", node->name, value_str);
+        emit_textf(&state, "Assigned %s = %s\n", node->name, value_str);
+        emit_textf(&state, "Result: %s\n\n", value_str);
     }
     
     // Process any non-assignment expressions (logical operations)
-    for (int i = 0; i < multi_ast->count; i++) {
-        Node* node = multi_ast->statements[i];
-        if (!node || node->type == NODE_ASSIGN) continue;
-        
-        // Show expression being evaluated
-        char* expr_str = node_to_string(node);
-        if (expr_str) {
-            LLVMValueRef expr_eval_fmt = LLVMBuildGlobalStringPtr(builder, "Evaluating expression: %s\n", "expr_eval_fmt");
-            LLVMValueRef expr_str_val = LLVMBuildGlobalStringPtr(builder, expr_str, "expr_str");
-            LLVMValueRef expr_eval_args[] = { expr_eval_fmt, expr_str_val };
-            LLVMBuildCall2(builder, printf_type, printf_func, expr_eval_args, 2, "");
-            free(expr_str);
-        }
-        
-        // Generate code with detailed evaluation
-        LLVMValueRef expr_result = gen_expression(context, builder, node, symbol_table, 
-                                               true_str, false_str, printf_func, printf_type);
-        
-        if (expr_result) {
-            // Convert boolean result to string
-            LLVMValueRef cond = LLVMBuildICmp(builder, LLVMIntNE, expr_result, 
-                                           LLVMConstInt(LLVMInt1Type(), 0, 0), "cond");
-            LLVMValueRef result_str = LLVMBuildSelect(builder, cond, true_str, false_str, "result_str");
-            
-            // Print result
-            LLVMValueRef result_fmt = LLVMBuildGlobalStringPtr(builder, "Result: %s\n\n", "result_fmt");
-            LLVMValueRef result_args[] = { result_fmt, result_str };
-            LLVMBuildCall2(builder, printf_type, printf_func, result_args, 2, "");
+    if (shard_count > 0) {
+        flush_pending_text(&state);
+        if (gen_sharded_statements(&state, statements, non_assignment_count, shard_count, options, &result)) {
+            result.error_code = LLVM_CODEGEN_ERROR;
         }
+    } else {
+        result.error_message = gen_statements(&state, statements, non_assignment_count, 0);
+        if (result.error_message) result.error_code = LLVM_CODEGEN_ERROR;
     }
+    free(statements);
     
     // Indicate completion
-    add_evaluation_message(builder, printf_func, printf_type, 
-                         "Completed evaluation of all expressions\n");
+    emit_text(&state, "Completed evaluation of all expressions\n");
+    flush_pending_text(&state);
     
-    // Return 0
-    LLVMBuildRet(builder, LLVMConstInt(LLVMInt32Type(), 0, 0));
+    if (state.output_format == LLVM_OUTPUT_BINARY) {
+        // Constant results were folded into the initializer, by shards too
+        LLVMSetInitializer(state.results_global,
+                           LLVMConstStringInContext(context, (const char*)state.results_init,
+                                                    state.results_size, 1));
+        LLVMValueRef zero = LLVMConstInt(i32, 0, 0);
+        LLVMValueRef indices[] = { zero, zero };
+        LLVMValueRef args[] = {
+            LLVMConstInBoundsGEP2(LLVMGlobalGetValueType(state.results_global), state.results_global, indices, 2),
+            LLVMConstInt(LLVMInt64TypeInContext(context), state.results_size, 0)
+        };
+        LLVMBuildCall2(builder, state.write_all_type, state.write_all_func, args, 2, "");
+    } else {
+        LLVMBuildCall2(builder, state.flush_type, state.flush_func, NULL, 0, "");
+    }
+    if (options->profile_output) build_profile_writer(&state, options->profile_output);
     
-    // Create filenames for bitcode and IR
-    char bitcode_filename[512];
-    char ir_filename[512];
+    free(state.pending);
+    free(state.sites);
+    free(state.results_init);
+    free_string_pool(strings);
     
-    snprintf(bitcode_filename, sizeof(bitcode_filename), "%s.bc", output_filename);
-    snprintf(ir_filename, sizeof(ir_filename), "%s.ll", output_filename);
+    // Return 0
+    LLVMBuildRet(builder, LLVMConstInt(i32, 0, 0));
     
-    // Save LLVM IR to file first
-    LLVMCodegenResult ir_result = save_llvm_ir(module, ir_filename);
-    if (ir_result.error_code != LLVM_CODEGEN_OK) {
-        // If we fail to save IR, still continue with compilation
-        printf("Warning: Failed to save LLVM IR: %s\n", ir_result.error_message);
-        free_llvm_codegen_result(&ir_result);
-    } else {
-        printf("LLVM IR saved to %s\n", ir_filename);
-        free_llvm_codegen_result(&ir_result);
+    if (result.error_code != LLVM_CODEGEN_OK) {
+        LLVMDisposeBuilder(builder);
+        return result;
     }
     
-    // Write bitcode to file
-    if (LLVMWriteBitcodeToFile(module, bitcode_filename) != 0) {
+    // Verify once; everything after this works on the in-memory module
+    result.error_message = verify_module(module);
+    if (result.error_message) {
         result.error_code = LLVM_CODEGEN_ERROR;
-        result.error_message = strdup("Failed to write bitcode to file");
-        
         LLVMDisposeBuilder(builder);
-        LLVMDisposeModule(module);
-        LLVMContextDispose(context);
-        
         return result;
     }
     
-    result.output_file = strdup(bitcode_filename);
+    // Textual IR is only written on request
+    if (options->emit_llvm) {
+        char ir_filename[PATH_MAX];
+        char* error_msg = NULL;
+        snprintf(ir_filename, sizeof(ir_filename), "%s.ll", output_filename);
+        if (LLVMPrintModuleToFile(module, ir_filename, &error_msg)) {
+            // If we fail to save IR, still continue with compilation
+            printf("Warning: Failed to save LLVM IR: %s\n", error_msg ? error_msg : "Unknown error");
+        } else {
+            printf("LLVM IR saved to %s\n", ir_filename);
+        }
+        if (error_msg) LLVMDisposeMessage(error_msg);
+    }
+    
+    // Hand the backend an object file rather than serialized IR
+    char object_filename[PATH_MAX];
+    snprintf(object_filename, sizeof(object_filename), "%s/main.o", result.object_dir);
+    result.error_message = emit_object_file(module, options->optimization_level, object_filename);
+    if (result.error_message) {
+        result.error_code = LLVM_CODEGEN_ERROR;
+        LLVMDisposeBuilder(builder);
+        return result;
+    }
+    result.object_files[result.object_count++] = strdup(object_filename);
+    result.output_file = strdup(object_filename);
     
     // Clean up (don't dispose of the module as it's being returned)
     LLVMDisposeBuilder(builder);
@@ -418,38 +2134,68 @@ LLVMCodegenResult save_llvm_ir(LLVMModuleRef module, const char* filename) {
 
 // Compile and link the IR
 LLVMCodegenResult compile_and_link_ir(const char* ir_filename, const char* output_filename) {
+    return compile_and_link_ir_with_objects(ir_filename, NULL, 0, output_filename);
+}
+
+// Link object files, such as those of an LLVMCodegenResult, into an executable
+LLVMCodegenResult link_object_files(char* const* object_files, int object_count, const char* output_filename) {
+    if (object_count <= 0) {
+        LLVMCodegenResult result = {LLVM_CODEGEN_ERROR, strdup("No object files to link"), NULL, NULL};
+        return result;
+    }
+    return compile_and_link_ir_with_objects(NULL, object_files, object_count, output_filename);
+}
+
+// Compile the IR, if any, and link it together with already compiled object files
+LLVMCodegenResult compile_and_link_ir_with_objects(const char* ir_filename, char* const* object_files,
+                                                 int object_count, const char* output_filename) {
     LLVMCodegenResult result = {LLVM_CODEGEN_OK, NULL, NULL, NULL};
     
     // Validate parameters
-    if (!ir_filename || !output_filename) {
+    if ((!ir_filename && object_count <= 0) || !output_filename || (object_count > 0 && !object_files)) {
         result.error_code = LLVM_CODEGEN_ERROR;
         result.error_message = strdup("Invalid filename parameters");
         return result;
     }
     
     // Check file extension to determine if it's LLVM IR (.ll) or bitcode (.bc)
-    const char* ext = strrchr(ir_filename, '.');
+    const char* ext = ir_filename ? strrchr(ir_filename, '.') : NULL;
     int is_ir_file = (ext && strcmp(ext, ".ll") == 0);
     
     // Create appropriate clang command
-    char command[1024];
-    if (is_ir_file) {
-        // For LLVM IR (.ll) files, we need to use -x ir
-        snprintf(command, sizeof(command), 
-                "clang -x ir %s -o %s", ir_filename, output_filename);
-    } else {
-        // For bitcode (.bc) files, we can use it directly
-        snprintf(command, sizeof(command), 
-                "clang %s -o %s", ir_filename, output_filename);
+    size_t command_size = (ir_filename ? strlen(ir_filename) : 0) + strlen(output_filename) + 64;
+    for (int i = 0; i < object_count; i++) {
+        command_size += strlen(object_files[i]) + 1;
+    }
+    char* command = malloc(command_size);
+    if (!command) {
+        result.error_code = LLVM_CODEGEN_ERROR;
+        result.error_message = strdup("Failed to allocate link command");
+        return result;
     }
     
+    // For LLVM IR (.ll) files, we need to use -x ir; bitcode (.bc) files can be used directly
+    size_t length = snprintf(command, command_size, "clang");
+    if (ir_filename) {
+        length += snprintf(command + length, command_size - length, " %s%s",
+                           is_ir_file ? "-x ir " : "", ir_filename);
+    }
+    if (object_count > 0) {
+        if (ir_filename) length += snprintf(command + length, command_size - length, " -x none");
+        for (int i = 0; i < object_count; i++) {
+            length += snprintf(command + length, command_size - length, " %s", object_files[i]);
+        }
+    }
+    snprintf(command + length, command_size - length, " -o %s", output_filename);
+    
     printf("Executing: %s\n", command);
     
     // Execute command
     int status = system(command);
+    free(command);
     if (status != 0) {
         result.error_code = LLVM_CODEGEN_ERROR;
-        result.error_message = strdup("Failed to compile and link bitcode");
+        result.error_message = strdup(ir_filename ? "Failed to compile and link bitcode" : "Failed to link object files");
         return result;
     }
     
@@ -458,19 +2204,6 @@ LLVMCodegenResult compile_and_link_ir(const char* ir_filename, const char* outpu
     return result;
 }
 
-// Apply optimizations to the module
-static void optimize_module(LLVMModuleRef module, int opt_level) {
-    // This is a placeholder for module optimization
-    // In a real implementation, you would use LLVM's optimization passes
-    // The exact passes would depend on the optimization level
-    
-    printf("Applying optimization level %d to the module\n", opt_level);
-    
-    // For now, this function doesn't do anything since LLVM C API
-    // doesn't provide direct optimization pass management
-    // You would need to use the C++ API for more advanced optimizations
-}
-
 // Free result
 void free_llvm_codegen_result(LLVMCodegenResult* result) {
     if (!result) return;
@@ -485,6 +2218,25 @@ void free_llvm_codegen_result(LLVMCodegenResult* result) {
         result->output_file = NULL;
     }
     
+    // Remove the shard objects and their directory
+    if (result->object_files) {
+        for (int i = 0; i < result->object_count; i++) {
+            if (result->object_files[i]) {
+                unlink(result->object_files[i]);
+                free(result->object_files[i]);
+            }
+        }
+        free(result->object_files);
+        result->object_files = NULL;
+        result->object_count = 0;
+    }
+    
+    if (result->object_dir) {
+        rmdir(result->object_dir);
+        free(result->object_dir);
+        result->object_dir = NULL;
+    }
+    
     // Clean up the LLVM module and its context if they exist
     if (result->module) {
         LLVMContextRef context = LLVMGetModuleContext(result->module);
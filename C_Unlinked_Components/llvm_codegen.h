@@ -15,6 +15,8 @@ typedef struct LLVMOpaqueModule *LLVMModuleRef;
 #include "ast.h"
 #include "symbol_table.h"
 #include "multi_statement.h"
+#include "compile_cache.h"
+#include "branch_profile.h"
 
 // Error codes for LLVM code generation
 typedef enum {
@@ -29,19 +31,74 @@ typedef enum {
 typedef struct {
     LLVMCodegenErrorCode error_code;
     char* error_message;    // Error message if any
-    char* output_file;      // Path to the generated file
+    char* output_file;      // Path to the generated file (the main object file)
     LLVMModuleRef module;   // The generated LLVM module (if any)
+    char** object_files;    // Compiled main module and shards, ready to link
+    int object_count;
+    char* object_dir;       // Temporary directory holding object_files
 } LLVMCodegenResult;
 
+// Output format of the generated executable
+typedef enum {
+    LLVM_OUTPUT_TEXT,   // Human-readable evaluation trace (default)
+    LLVM_OUTPUT_BINARY  // Compact result bitset for machine consumers
+} LLVMOutputFormat;
+
+// Binary result format written to stdout by LLVM_OUTPUT_BINARY programs:
+//   bytes 0-3   magic "LECR"
+//   byte  4     format version
+//   bytes 5-7   reserved (zero)
+//   bytes 8-11  number of results N, little-endian
+//   then ceil(N/8) bytes, bit i (LSB first) holding the result of the
+//   i-th non-assignment statement
+#define LLVM_RESULTS_MAGIC "LECR"
+#define LLVM_RESULTS_VERSION 1
+#define LLVM_RESULTS_HEADER_SIZE 12
+
+// Code generation options
+typedef struct {
+    int optimization_level;         // 0-3
+    LLVMOutputFormat output_format;
+    int jobs;                       // Threads for parallel code generation, 1 = single module
+    const char* cache_dir;          // Cache for shard objects, NULL disables it
+    int emit_llvm;                  // Also write the main module as textual IR to <output>.ll
+    int use_aig;                    // Emit binary results from an optimized And-Inverter Graph
+    int use_lookup_tables;          // Emit binary results of subexpressions over few runtime
+                                    // variables as truth-table lookups
+    int use_decision_diagrams;      // Emit binary results as branches over a decision diagram
+                                    // of each statement
+    char* const* runtime_variables; // Variables missing from the symbol table that the program
+    int runtime_variable_count;     // reads from LEC_<name> in its environment when it starts
+    const char* profile_output;     // The program appends the branch profile of AND and OR here
+    const BranchProfile* profile;   // Order AND and OR operands by this profile and short-circuit
+} LLVMCodegenOptions;
+
 // Function to generate LLVM IR from AST with optimization level
 // The returned LLVMCodegenResult contains the generated module in the 'module' field
 // optimization_level: 0 = no optimization, 1 = basic optimizations, 2 = more optimizations, 3 = aggressive optimizations
 LLVMCodegenResult generate_llvm_ir(MultiStatementAST* multi_ast, SymbolTable* symbol_table, 
                                  const char* output_filename, int optimization_level);
 
+// Function to generate LLVM IR from AST with explicit code generation options.
+// The module is verified once and compiled in memory to the object_files of
+// the result; textual IR is only written when emit_llvm is set.
+LLVMCodegenResult generate_llvm_ir_with_options(MultiStatementAST* multi_ast, SymbolTable* symbol_table,
+                                              const char* output_filename, const LLVMCodegenOptions* options);
+
+// Hash everything besides the statements that determines the generated code:
+// cache format, LLVM version, target triple and codegen options
+void llvm_codegen_hash_options(ContentHash* hash, const LLVMCodegenOptions* options);
+
 // Function to compile and link the generated LLVM IR
 LLVMCodegenResult compile_and_link_ir(const char* ir_filename, const char* output_filename);
 
+// Function to compile the IR (if ir_filename is not NULL) and link it with object files
+LLVMCodegenResult compile_and_link_ir_with_objects(const char* ir_filename, char* const* object_files,
+                                                 int object_count, const char* output_filename);
+
+// Function to link the object_files of an LLVMCodegenResult into an executable
+LLVMCodegenResult link_object_files(char* const* object_files, int object_count, const char* output_filename);
+
 // Function to save LLVM IR to a file
 LLVMCodegenResult save_llvm_ir(LLVMModuleRef module, const char* filename);
 
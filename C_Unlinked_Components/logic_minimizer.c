@@ -0,0 +1,860 @@
+#include "logic_minimizer.h"
+#include "thread_pool.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_MINIMIZE_VARIABLES 24
+#define DEFAULT_EXACT_VARIABLE_LIMIT 10
+#define DEFAULT_VARIABLE_LIMIT 20
+#define MINIMIZE_CHUNK_MIN_STATEMENTS 16
+#define COVER_SEARCH_BUDGET 100000
+#define ESPRESSO_MAX_ROUNDS 8
+
+// Slots of variable references that are constants rather than variables
+#define SLOT_TRUE (-2)
+#define SLOT_FALSE (-3)
+
+// Variable i is bit i. A cube fixes the variables in care to the bits in value.
+typedef struct {
+    uint32_t care;
+    uint32_t value;
+} Cube;
+
+typedef struct {
+    Cube* cubes;
+    int count;
+    int capacity;
+} Cover;
+
+// Expression with every variable reference resolved to a slot: free
+// variables first, then one slot per quantifier. A threshold node keeps its
+// first operand in left and their count in right; operands are chained by next.
+typedef struct {
+    NodeType type;
+    int slot;
+    int bool_val;
+    int left;
+    int right;
+    int threshold;
+    int next;
+} CompiledNode;
+
+typedef struct {
+    const char* name;
+    int slot;
+} Binding;
+
+typedef struct {
+    CompiledNode* nodes;
+    int node_count;
+    int node_capacity;
+    const char* variables[MAX_MINIMIZE_VARIABLES];
+    int variable_count;
+    int variable_limit;
+    int slot_count;         // Quantifier slots, numbered after the variables
+    Binding* bound;         // Quantifiers enclosing the node being compiled
+    int bound_count;
+    int bound_capacity;
+    int failed;
+} Compiler;
+
+void init_minimize_options(MinimizeOptions* options) {
+    options->exact_variable_limit = DEFAULT_EXACT_VARIABLE_LIMIT;
+    options->variable_limit = DEFAULT_VARIABLE_LIMIT;
+}
+
+static int popcount(uint32_t bits) {
+    return __builtin_popcount(bits);
+}
+
+static int add_cube(Cover* cover, Cube cube) {
+    if (cover->count >= cover->capacity) {
+        int capacity = cover->capacity ? cover->capacity * 2 : 64;
+        Cube* cubes = realloc(cover->cubes, capacity * sizeof(Cube));
+        if (!cubes) return -1;
+        cover->cubes = cubes;
+        cover->capacity = capacity;
+    }
+    cover->cubes[cover->count++] = cube;
+    return 0;
+}
+
+// Cost of a cover: fewer cubes first, then fewer literals
+static long cover_cost(const Cover* cover) {
+    long literals = 0;
+    for (int i = 0; i < cover->count; i++) literals += popcount(cover->cubes[i].care);
+    return ((long)cover->count << 32) | literals;
+}
+
+static int variable_slot(Compiler* compiler, const char* name) {
+    if (strcmp(name, "TRUE") == 0) return SLOT_TRUE;
+    if (strcmp(name, "FALSE") == 0) return SLOT_FALSE;
+    for (int i = compiler->bound_count - 1; i >= 0; i--) {
+        if (strcmp(compiler->bound[i].name, name) == 0) return compiler->bound[i].slot;
+    }
+    for (int i = 0; i < compiler->variable_count; i++) {
+        if (strcmp(compiler->variables[i], name) == 0) return i;
+    }
+    if (compiler->variable_count >= compiler->variable_limit) {
+        compiler->failed = 1;
+        return SLOT_FALSE;
+    }
+    compiler->variables[compiler->variable_count] = name;
+    return compiler->variable_count++;
+}
+
+static int compile_expression(Compiler* compiler, const Node* node) {
+    if (!node || compiler->failed) {
+        compiler->failed = 1;
+        return -1;
+    }
+    if (node->type == NODE_ASSIGN) return compile_expression(compiler, get_assignment_expression(node));
+
+    if (compiler->node_count >= compiler->node_capacity) {
+        int capacity = compiler->node_capacity ? compiler->node_capacity * 2 : 64;
+        CompiledNode* nodes = realloc(compiler->nodes, capacity * sizeof(CompiledNode));
+        if (!nodes) {
+            compiler->failed = 1;
+            return -1;
+        }
+        compiler->nodes = nodes;
+        compiler->node_capacity = capacity;
+    }
+    int index = compiler->node_count++;
+    CompiledNode compiled = {node->type, -1, node->bool_val, -1, -1, node->threshold, -1};
+
+    switch (node->type) {
+        case NODE_VAR:
+            compiled.slot = variable_slot(compiler, node->name);
+            break;
+        case NODE_BOOL:
+            break;
+        case NODE_EXISTS:
+        case NODE_FORALL:
+            if (compiler->bound_count >= compiler->bound_capacity) {
+                int capacity = compiler->bound_capacity ? compiler->bound_capacity * 2 : 8;
+                Binding* bound = realloc(compiler->bound, capacity * sizeof(Binding));
+                if (!bound) {
+                    compiler->failed = 1;
+                    return -1;
+                }
+                compiler->bound = bound;
+                compiler->bound_capacity = capacity;
+            }
+            compiled.slot = MAX_MINIMIZE_VARIABLES + compiler->slot_count++;
+            compiler->bound[compiler->bound_count++] = (Binding){node->name, compiled.slot};
+            compiled.left = compile_expression(compiler, node->left);
+            compiler->bound_count--;
+            break;
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY: {
+            int previous = -1;
+            for (int i = 0; i < node->child_count && !compiler->failed; i++) {
+                int operand = compile_expression(compiler, node->children[i]);
+                if (compiler->failed) break;
+                if (previous < 0) compiled.left = operand;
+                else compiler->nodes[previous].next = operand;
+                previous = operand;
+            }
+            compiled.right = node->child_count;
+            break;
+        }
+        default:
+            compiled.left = compile_expression(compiler, node->left);
+            if (node->type != NODE_NOT) compiled.right = compile_expression(compiler, node->right);
+            break;
+    }
+    if (!compiler->failed) compiler->nodes[index] = compiled;
+    return index;
+}
+
+static uint64_t evaluate_word(const CompiledNode* nodes, int index, uint64_t* slots);
+
+// Threshold over 64 assignments at once: the operands are summed into a
+// bit-sliced counter, count[b] holding bit b of the 64 sums, by a ripple
+// of half adders per operand, then compared with k bit by bit from the top
+static uint64_t evaluate_threshold(const CompiledNode* nodes, const CompiledNode* node, uint64_t* slots) {
+    int constant = threshold_constant(node->type, node->threshold, node->right);
+    if (constant >= 0) return constant ? ~0ULL : 0;
+
+    uint64_t count[32] = {0};
+    int width = 32 - __builtin_clz((uint32_t)node->right);
+    for (int operand = node->left; operand >= 0; operand = nodes[operand].next) {
+        uint64_t carry = evaluate_word(nodes, operand, slots);
+        for (int b = 0; b < width && carry; b++) {
+            uint64_t overflow = count[b] & carry;
+            count[b] ^= carry;
+            carry = overflow;
+        }
+    }
+
+    uint64_t greater = 0;
+    uint64_t equal = ~0ULL;
+    for (int b = width - 1; b >= 0; b--) {
+        if ((node->threshold >> b) & 1) {
+            equal &= count[b];
+        } else {
+            greater |= equal & count[b];
+            equal &= ~count[b];
+        }
+    }
+    switch (node->type) {
+        case NODE_ATLEAST: return greater | equal;
+        case NODE_ATMOST: return ~greater;
+        default: return equal;
+    }
+}
+
+// Value of the expression for 64 assignments at once
+static uint64_t evaluate_word(const CompiledNode* nodes, int index, uint64_t* slots) {
+    const CompiledNode* node = &nodes[index];
+    switch (node->type) {
+        case NODE_BOOL:
+            return node->bool_val ? ~0ULL : 0;
+        case NODE_VAR:
+            if (node->slot == SLOT_TRUE) return ~0ULL;
+            if (node->slot == SLOT_FALSE) return 0;
+            return slots[node->slot];
+        case NODE_NOT:
+            return ~evaluate_word(nodes, node->left, slots);
+        case NODE_EXISTS:
+        case NODE_FORALL: {
+            uint64_t saved = slots[node->slot];
+            slots[node->slot] = 0;
+            uint64_t when_false = evaluate_word(nodes, node->left, slots);
+            slots[node->slot] = ~0ULL;
+            uint64_t when_true = evaluate_word(nodes, node->left, slots);
+            slots[node->slot] = saved;
+            return node->type == NODE_EXISTS ? when_false | when_true : when_false & when_true;
+        }
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY:
+            return evaluate_threshold(nodes, node, slots);
+        default:
+            break;
+    }
+
+    uint64_t left = evaluate_word(nodes, node->left, slots);
+    uint64_t right = evaluate_word(nodes, node->right, slots);
+    switch (node->type) {
+        case NODE_AND: return left & right;
+        case NODE_OR: return left | right;
+        case NODE_XOR: return left ^ right;
+        case NODE_IMPLIES: return ~left | right;
+        default: return ~(left ^ right);  // XNOR, IFF, EQUIV
+    }
+}
+
+// Truth table of the compiled expression, bit m set if minterm m is true
+static uint64_t* build_truth_table(const Compiler* compiler) {
+    static const uint64_t low_variable_patterns[6] = {
+        0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+        0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL,
+    };
+    int n = compiler->variable_count;
+    long words = n > 6 ? 1L << (n - 6) : 1;
+    uint64_t* table = malloc(words * sizeof(uint64_t));
+    uint64_t* slots = calloc(MAX_MINIMIZE_VARIABLES + compiler->slot_count + 1, sizeof(uint64_t));
+    if (!table || !slots) {
+        free(table);
+        free(slots);
+        return NULL;
+    }
+
+    for (int i = 0; i < n && i < 6; i++) slots[i] = low_variable_patterns[i];
+    for (long w = 0; w < words; w++) {
+        for (int i = 6; i < n; i++) slots[i] = (w >> (i - 6)) & 1 ? ~0ULL : 0;
+        table[w] = evaluate_word(compiler->nodes, 0, slots);
+    }
+    if (n < 6) table[0] &= (1ULL << (1 << n)) - 1;
+    free(slots);
+    return table;
+}
+
+static int is_on(const uint64_t* table, uint32_t minterm) {
+    return (table[minterm >> 6] >> (minterm & 63)) & 1;
+}
+
+// Hash set of cubes, mapping each to its index in a level
+typedef struct {
+    int* slots;
+    int mask;
+} CubeIndex;
+
+static unsigned int hash_cube(Cube cube) {
+    uint64_t key = ((uint64_t)cube.care << 32) | cube.value;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return (unsigned int)key;
+}
+
+static int init_cube_index(CubeIndex* index, int capacity) {
+    int count = 64;
+    while (count < capacity * 2) count *= 2;
+    index->slots = malloc(count * sizeof(int));
+    if (!index->slots) return -1;
+    memset(index->slots, -1, count * sizeof(int));
+    index->mask = count - 1;
+    return 0;
+}
+
+// Index of cube in cubes, or -(slot + 1) for the empty slot where it belongs
+static int find_cube(const CubeIndex* index, const Cube* cubes, Cube cube) {
+    unsigned int slot = hash_cube(cube) & index->mask;
+    while (index->slots[slot] != -1) {
+        const Cube* other = &cubes[index->slots[slot]];
+        if (other->care == cube.care && other->value == cube.value) return index->slots[slot];
+        slot = (slot + 1) & index->mask;
+    }
+    return -(int)slot - 1;
+}
+
+// All prime implicants of the ON-set by Quine-McCluskey: merge cubes that
+// differ in one variable until no merge is possible
+static int prime_implicants(const uint64_t* table, int n, Cover* primes) {
+    uint32_t full = n == 32 ? ~0u : (1u << n) - 1;
+    Cover level = {0};
+    for (uint32_t m = 0; m < (1u << n); m++) {
+        if (is_on(table, m) && add_cube(&level, (Cube){full, m}) < 0) {
+            free(level.cubes);
+            return -1;
+        }
+    }
+
+    while (level.count > 0) {
+        CubeIndex index;
+        unsigned char* merged = calloc(level.count, 1);
+        if (!merged || init_cube_index(&index, level.count) < 0) {
+            free(merged);
+            free(level.cubes);
+            return -1;
+        }
+        for (int i = 0; i < level.count; i++) {
+            int found = find_cube(&index, level.cubes, level.cubes[i]);
+            index.slots[-found - 1] = i;
+        }
+
+        Cover next = {0};
+        CubeIndex next_index = {0};
+        int status = init_cube_index(&next_index, level.count * n / 2 + 1);
+        for (int i = 0; i < level.count && status == 0; i++) {
+            Cube cube = level.cubes[i];
+            for (int v = 0; v < n && status == 0; v++) {
+                uint32_t bit = 1u << v;
+                if (!(cube.care & bit) || (cube.value & bit)) continue;
+                int partner = find_cube(&index, level.cubes, (Cube){cube.care, cube.value | bit});
+                if (partner < 0) continue;
+
+                merged[i] = merged[partner] = 1;
+                Cube combined = {cube.care & ~bit, cube.value};
+                int slot = find_cube(&next_index, next.cubes, combined);
+                if (slot >= 0) continue;
+                if (next.count * 2 >= next_index.mask) {
+                    // Grow the index before it fills up
+                    free(next_index.slots);
+                    if (init_cube_index(&next_index, next.count * 2 + 1) < 0) {
+                        status = -1;
+                        break;
+                    }
+                    for (int k = 0; k < next.count; k++) {
+                        next_index.slots[-find_cube(&next_index, next.cubes, next.cubes[k]) - 1] = k;
+                    }
+                    slot = find_cube(&next_index, next.cubes, combined);
+                }
+                next_index.slots[-slot - 1] = next.count;
+                status = add_cube(&next, combined);
+            }
+        }
+        for (int i = 0; i < level.count && status == 0; i++) {
+            if (!merged[i]) status = add_cube(primes, level.cubes[i]);
+        }
+
+        free(index.slots);
+        free(next_index.slots);
+        free(merged);
+        free(level.cubes);
+        level = next;
+        if (status < 0) {
+            free(level.cubes);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Exact cover search state: ON minterms are numbered 0..minterm_count-1
+typedef struct {
+    const Cover* primes;
+    uint64_t** covers;      // covers[p] = ON minterms covered by prime p
+    int** covering;         // covering[m] = primes covering minterm m
+    int* covering_count;
+    int minterm_count;
+    int words;
+    int* chosen;
+    int chosen_count;
+    int* best;
+    int best_count;
+    long best_cost;
+    long budget;
+} CoverSearch;
+
+static long chosen_cost(const CoverSearch* search, const int* chosen, int count) {
+    long literals = 0;
+    for (int i = 0; i < count; i++) literals += popcount(search->primes->cubes[chosen[i]].care);
+    return ((long)count << 32) | literals;
+}
+
+static void search_cover(CoverSearch* search, uint64_t* covered) {
+    if (search->budget-- <= 0) return;
+
+    // Branch on the uncovered minterm with the fewest candidate primes
+    int pick = -1;
+    for (int m = 0; m < search->minterm_count; m++) {
+        if ((covered[m >> 6] >> (m & 63)) & 1) continue;
+        if (pick < 0 || search->covering_count[m] < search->covering_count[pick]) pick = m;
+    }
+    long cost = chosen_cost(search, search->chosen, search->chosen_count);
+    if (pick < 0) {
+        if (cost < search->best_cost) {
+            search->best_cost = cost;
+            search->best_count = search->chosen_count;
+            memcpy(search->best, search->chosen, search->chosen_count * sizeof(int));
+        }
+        return;
+    }
+    // Any completion needs at least one more cube
+    if (cost + (1L << 32) >= search->best_cost) return;
+
+    uint64_t* next = malloc(search->words * sizeof(uint64_t));
+    if (!next) return;
+    for (int k = 0; k < search->covering_count[pick]; k++) {
+        int prime = search->covering[pick][k];
+        for (int w = 0; w < search->words; w++) next[w] = covered[w] | search->covers[prime][w];
+        search->chosen[search->chosen_count++] = prime;
+        search_cover(search, next);
+        search->chosen_count--;
+    }
+    free(next);
+}
+
+// Minimum cover of the ON-set by primes: essential primes, then branch and
+// bound seeded with a greedy cover
+static int select_cover(const uint64_t* table, int n, const Cover* primes, Cover* result) {
+    uint32_t* minterms = NULL;
+    int minterm_count = 0;
+    for (uint32_t m = 0; m < (1u << n); m++) minterm_count += is_on(table, m);
+    CoverSearch search = {primes, NULL, NULL, NULL, minterm_count, (minterm_count + 63) / 64};
+    int status = -1;
+    uint64_t* covered = NULL;
+
+    minterms = malloc((minterm_count + 1) * sizeof(uint32_t));
+    search.covers = calloc(primes->count + 1, sizeof(uint64_t*));
+    search.covering = calloc(minterm_count + 1, sizeof(int*));
+    search.covering_count = calloc(minterm_count + 1, sizeof(int));
+    search.chosen = malloc((primes->count + 1) * sizeof(int));
+    search.best = malloc((primes->count + 1) * sizeof(int));
+    covered = calloc(search.words + 1, sizeof(uint64_t));
+    if (!minterms || !search.covers || !search.covering || !search.covering_count || !search.chosen ||
+        !search.best || !covered) {
+        goto done;
+    }
+
+    int k = 0;
+    for (uint32_t m = 0; m < (1u << n); m++) {
+        if (is_on(table, m)) minterms[k++] = m;
+    }
+    for (int p = 0; p < primes->count; p++) {
+        search.covers[p] = calloc(search.words + 1, sizeof(uint64_t));
+        if (!search.covers[p]) goto done;
+        Cube cube = primes->cubes[p];
+        for (int m = 0; m < minterm_count; m++) {
+            if ((minterms[m] & cube.care) == cube.value) {
+                search.covers[p][m >> 6] |= 1ULL << (m & 63);
+                search.covering_count[m]++;
+            }
+        }
+    }
+    for (int m = 0; m < minterm_count; m++) {
+        search.covering[m] = malloc((search.covering_count[m] + 1) * sizeof(int));
+        if (!search.covering[m]) goto done;
+        search.covering_count[m] = 0;
+    }
+    for (int p = 0; p < primes->count; p++) {
+        for (int m = 0; m < minterm_count; m++) {
+            if ((search.covers[p][m >> 6] >> (m & 63)) & 1) search.covering[m][search.covering_count[m]++] = p;
+        }
+    }
+
+    // Essential primes are the only cover of some minterm
+    for (int m = 0; m < minterm_count; m++) {
+        if (search.covering_count[m] != 1 || ((covered[m >> 6] >> (m & 63)) & 1)) continue;
+        int prime = search.covering[m][0];
+        search.chosen[search.chosen_count++] = prime;
+        for (int w = 0; w < search.words; w++) covered[w] |= search.covers[prime][w];
+    }
+
+    // Greedy completion gives the initial bound
+    int greedy_count = search.chosen_count;
+    memcpy(search.best, search.chosen, greedy_count * sizeof(int));
+    uint64_t* greedy_covered = malloc((search.words + 1) * sizeof(uint64_t));
+    if (!greedy_covered) goto done;
+    memcpy(greedy_covered, covered, search.words * sizeof(uint64_t));
+    for (;;) {
+        int best_prime = -1;
+        int best_gain = 0;
+        for (int p = 0; p < primes->count; p++) {
+            int gain = 0;
+            for (int w = 0; w < search.words; w++) gain += __builtin_popcountll(search.covers[p][w] & ~greedy_covered[w]);
+            if (gain > best_gain || (gain == best_gain && gain > 0 &&
+                                     popcount(primes->cubes[p].care) < popcount(primes->cubes[best_prime].care))) {
+                best_prime = p;
+                best_gain = gain;
+            }
+        }
+        if (best_prime < 0) break;
+        search.best[greedy_count++] = best_prime;
+        for (int w = 0; w < search.words; w++) greedy_covered[w] |= search.covers[best_prime][w];
+    }
+    free(greedy_covered);
+    search.best_count = greedy_count;
+    search.best_cost = chosen_cost(&search, search.best, greedy_count);
+
+    search.budget = COVER_SEARCH_BUDGET;
+    search_cover(&search, covered);
+
+    status = 0;
+    for (int i = 0; i < search.best_count && status == 0; i++) {
+        status = add_cube(result, primes->cubes[search.best[i]]);
+    }
+
+done:
+    if (search.covers) {
+        for (int p = 0; p < primes->count; p++) free(search.covers[p]);
+    }
+    if (search.covering) {
+        for (int m = 0; m < minterm_count; m++) free(search.covering[m]);
+    }
+    free(search.covers);
+    free(search.covering);
+    free(search.covering_count);
+    free(search.chosen);
+    free(search.best);
+    free(covered);
+    free(minterms);
+    return status;
+}
+
+// Espresso-style heuristic over the ON-set, with coverage counts per minterm
+typedef struct {
+    const uint64_t* table;
+    int n;
+    uint32_t full;
+    uint16_t* counts;       // Cubes of the cover containing each minterm
+} Espresso;
+
+// Does cube contain only ON minterms?
+static int cube_is_implicant(const Espresso* espresso, Cube cube) {
+    uint32_t free_bits = espresso->full & ~cube.care;
+    uint32_t subset = 0;
+    do {
+        if (!is_on(espresso->table, cube.value | subset)) return 0;
+        subset = (subset - free_bits) & free_bits;
+    } while (subset != 0);
+    return 1;
+}
+
+// Add delta to the coverage count of every minterm of cube outside skip
+static void count_minterms(Espresso* espresso, Cube cube, int delta, const Cube* skip) {
+    uint32_t free_bits = espresso->full & ~cube.care;
+    uint32_t subset = 0;
+    do {
+        uint32_t m = cube.value | subset;
+        if (!skip || (m & skip->care) != skip->value) espresso->counts[m] += delta;
+        subset = (subset - free_bits) & free_bits;
+    } while (subset != 0);
+}
+
+// Drop literals while the cube stays an implicant, starting at variable first
+static Cube expand_cube(const Espresso* espresso, Cube cube, int first) {
+    for (int k = 0; k < espresso->n; k++) {
+        uint32_t bit = 1u << ((first + k) % espresso->n);
+        if (!(cube.care & bit)) continue;
+        // The cube is an implicant, so only the half across this variable needs checking
+        Cube other_half = {cube.care, cube.value ^ bit};
+        if (cube_is_implicant(espresso, other_half)) cube = (Cube){cube.care & ~bit, cube.value & ~bit};
+    }
+    return cube;
+}
+
+static int compare_cube_size(const void* a, const void* b) {
+    return popcount(((const Cube*)b)->care) - popcount(((const Cube*)a)->care);
+}
+
+// Remove cubes whose minterms are all covered by other cubes, smallest first
+static void make_irredundant(Espresso* espresso, Cover* cover) {
+    qsort(cover->cubes, cover->count, sizeof(Cube), compare_cube_size);
+    int kept = 0;
+    for (int i = 0; i < cover->count; i++) {
+        Cube cube = cover->cubes[i];
+        uint32_t free_bits = espresso->full & ~cube.care;
+        uint32_t subset = 0;
+        int redundant = 1;
+        do {
+            if (espresso->counts[cube.value | subset] < 2) {
+                redundant = 0;
+                break;
+            }
+            subset = (subset - free_bits) & free_bits;
+        } while (subset != 0);
+
+        if (redundant) count_minterms(espresso, cube, -1, NULL);
+        else cover->cubes[kept++] = cube;
+    }
+    cover->count = kept;
+}
+
+// Shrink every cube to the smallest cube holding the minterms only it covers
+static void reduce_cover(Espresso* espresso, Cover* cover) {
+    for (int i = 0; i < cover->count; i++) {
+        Cube cube = cover->cubes[i];
+        uint32_t free_bits = espresso->full & ~cube.care;
+        uint32_t subset = 0;
+        uint32_t all_and = espresso->full;
+        uint32_t all_or = 0;
+        int unique = 0;
+        do {
+            uint32_t m = cube.value | subset;
+            if (espresso->counts[m] == 1) {
+                all_and &= m;
+                all_or |= m;
+                unique = 1;
+            }
+            subset = (subset - free_bits) & free_bits;
+        } while (subset != 0);
+        if (!unique) continue;
+
+        uint32_t care = espresso->full & ~(all_and ^ all_or);
+        Cube reduced = {care, all_and & care};
+        count_minterms(espresso, cube, -1, &reduced);
+        cover->cubes[i] = reduced;
+    }
+}
+
+// Returns 1 without a result when the first irredundant cover already has
+// more than cube_limit cubes (0 for no limit)
+static int espresso_cover(const uint64_t* table, int n, int cube_limit, Cover* result) {
+    Espresso espresso = {table, n, (1u << n) - 1, calloc((size_t)1 << n, sizeof(uint16_t))};
+    if (!espresso.counts) return -1;
+
+    Cover cover = {0};
+    for (uint32_t m = 0; m < (1u << n); m++) {
+        if (!is_on(table, m) || espresso.counts[m]) continue;
+        Cube cube = expand_cube(&espresso, (Cube){espresso.full, m}, 0);
+        if (add_cube(&cover, cube) < 0) {
+            free(cover.cubes);
+            free(espresso.counts);
+            return -1;
+        }
+        count_minterms(&espresso, cube, 1, NULL);
+    }
+    make_irredundant(&espresso, &cover);
+    if (cube_limit > 0 && cover.count > cube_limit) {
+        free(cover.cubes);
+        free(espresso.counts);
+        return 1;
+    }
+
+    Cover best = {0};
+    int status = 0;
+    for (int i = 0; i < cover.count && status == 0; i++) status = add_cube(&best, cover.cubes[i]);
+    for (int round = 1; round <= ESPRESSO_MAX_ROUNDS && status == 0; round++) {
+        reduce_cover(&espresso, &cover);
+        for (int i = 0; i < cover.count; i++) {
+            Cube reduced = cover.cubes[i];
+            Cube expanded = expand_cube(&espresso, reduced, round);
+            count_minterms(&espresso, expanded, 1, &reduced);
+            cover.cubes[i] = expanded;
+        }
+        make_irredundant(&espresso, &cover);
+        if (cover_cost(&cover) >= cover_cost(&best)) break;
+
+        best.count = 0;
+        for (int i = 0; i < cover.count && status == 0; i++) status = add_cube(&best, cover.cubes[i]);
+    }
+
+    for (int i = 0; i < best.count && status == 0; i++) status = add_cube(result, best.cubes[i]);
+    free(best.cubes);
+    free(cover.cubes);
+    free(espresso.counts);
+    return status;
+}
+
+static Node* variable_literal(const char* name, int positive) {
+    Node* variable = create_node(NODE_VAR, (char*)name, NULL, NULL, 0);
+    if (positive || !variable) return variable;
+    Node* negation = create_node(NODE_NOT, NULL, variable, NULL, 0);
+    if (!negation) free_ast(variable);
+    return negation;
+}
+
+static Node* join(NodeType type, Node* left, Node* right) {
+    if (!left || !right) {
+        free_ast(left);
+        free_ast(right);
+        return NULL;
+    }
+    Node* node = create_node(type, NULL, left, right, 0);
+    if (!node) {
+        free_ast(left);
+        free_ast(right);
+    }
+    return node;
+}
+
+static Node* cover_to_expression(const Cover* cover, const char* const* variables, int n) {
+    if (cover->count == 0) return create_boolean_node(0);
+
+    Node* sum = NULL;
+    for (int i = 0; i < cover->count; i++) {
+        Cube cube = cover->cubes[i];
+        if (cube.care == 0) {
+            free_ast(sum);
+            return create_boolean_node(1);
+        }
+
+        Node* product = NULL;
+        for (int v = 0; v < n; v++) {
+            uint32_t bit = 1u << v;
+            if (!(cube.care & bit)) continue;
+            Node* literal = variable_literal(variables[v], (cube.value & bit) != 0);
+            product = product ? join(NODE_AND, product, literal) : literal;
+            if (!product) {
+                free_ast(sum);
+                return NULL;
+            }
+        }
+        if (product->type == NODE_AND && cover->count > 1) product->is_parenthesized = 1;
+        sum = sum ? join(NODE_OR, sum, product) : product;
+        if (!sum) return NULL;
+    }
+    return sum;
+}
+
+static Node* minimize_within(const Node* node, const MinimizeOptions* options, int cube_limit) {
+    MinimizeOptions defaults;
+    if (!options) {
+        init_minimize_options(&defaults);
+        options = &defaults;
+    }
+
+    Compiler compiler = {0};
+    compiler.variable_limit = options->variable_limit;
+    if (compiler.variable_limit > MAX_MINIMIZE_VARIABLES) compiler.variable_limit = MAX_MINIMIZE_VARIABLES;
+    compile_expression(&compiler, node);
+    free(compiler.bound);
+    if (compiler.failed) {
+        free(compiler.nodes);
+        return NULL;
+    }
+
+    uint64_t* table = build_truth_table(&compiler);
+    free(compiler.nodes);
+    if (!table) return NULL;
+
+    Cover cover = {0};
+    int n = compiler.variable_count;
+    int status;
+    if (n <= options->exact_variable_limit) {
+        Cover primes = {0};
+        status = prime_implicants(table, n, &primes);
+        if (status == 0) status = select_cover(table, n, &primes, &cover);
+        free(primes.cubes);
+    } else {
+        status = espresso_cover(table, n, cube_limit, &cover);
+    }
+    free(table);
+
+    Node* result = status == 0 ? cover_to_expression(&cover, compiler.variables, n) : NULL;
+    free(cover.cubes);
+    return result;
+}
+
+Node* minimize_expression(const Node* node, const MinimizeOptions* options) {
+    return minimize_within(node, options, 0);
+}
+
+static int count_nodes(const Node* node) {
+    if (!node) return 0;
+    if (node->type == NODE_ASSIGN) return 1 + count_nodes(get_assignment_expression(node));
+    int count = 1 + count_nodes(node->left) + count_nodes(node->right);
+    for (int i = 0; i < node->child_count; i++) count += count_nodes(node->children[i]);
+    return count;
+}
+
+typedef struct {
+    Node** statements;
+    int count;
+    const MinimizeOptions* options;
+    int replaced;
+} MinimizeJob;
+
+static void run_minimize_job(void* arg) {
+    MinimizeJob* job = arg;
+    for (int i = 0; i < job->count; i++) {
+        Node* statement = job->statements[i];
+        if (!statement || statement->type == NODE_ASSIGN) continue;
+
+        // A sum of c cubes has at least 2c - 1 nodes, so stop early once
+        // the cover cannot beat the statement
+        int size = count_nodes(statement);
+        Node* minimized = minimize_within(statement, job->options, size / 2);
+        if (!minimized) continue;
+        if (count_nodes(minimized) < size) {
+            free_ast(statement);
+            job->statements[i] = minimized;
+            job->replaced++;
+        } else {
+            free_ast(minimized);
+        }
+    }
+}
+
+int minimize_statements(Node** statements, int count, const MinimizeOptions* options, int jobs) {
+    if (count <= 0) return 0;
+
+    // Aim for a few chunks per thread so uneven statements balance out
+    int chunk_size = jobs > 0 ? (count + jobs * 4 - 1) / (jobs * 4) : count;
+    if (chunk_size < MINIMIZE_CHUNK_MIN_STATEMENTS) chunk_size = MINIMIZE_CHUNK_MIN_STATEMENTS;
+    int chunk_count = (count + chunk_size - 1) / chunk_size;
+
+    ThreadPool* pool = chunk_count > 1 && jobs > 1 ? thread_pool_create(jobs) : NULL;
+    MinimizeJob* chunks = pool ? calloc(chunk_count, sizeof(MinimizeJob)) : NULL;
+    if (!chunks) {
+        if (pool) thread_pool_destroy(pool);
+        MinimizeJob job = {statements, count, options, 0};
+        run_minimize_job(&job);
+        return job.replaced;
+    }
+
+    for (int k = 0; k < chunk_count; k++) {
+        MinimizeJob* job = &chunks[k];
+        int first = k * chunk_size;
+        job->statements = statements + first;
+        job->count = count - first < chunk_size ? count - first : chunk_size;
+        job->options = options;
+        if (thread_pool_submit(pool, run_minimize_job, job) != 0) {
+            run_minimize_job(job);
+        }
+    }
+    thread_pool_wait(pool);
+    thread_pool_destroy(pool);
+
+    int replaced = 0;
+    for (int k = 0; k < chunk_count; k++) replaced += chunks[k].replaced;
+    free(chunks);
+    return replaced;
+}
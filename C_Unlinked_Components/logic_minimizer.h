@@ -0,0 +1,31 @@
+#ifndef LOGIC_MINIMIZER_H
+#define LOGIC_MINIMIZER_H
+
+#include "ast.h"
+
+// Two-level minimization to a sum of products.
+//
+// The truth table over the free variables is computed 64 assignments at a
+// time. Up to exact_variable_limit variables, all prime implicants are
+// generated (Quine-McCluskey) and a minimum cover is chosen by branch and
+// bound. Larger functions use an Espresso-style loop of expand, irredundant
+// and reduce over the ON-set. Cubes are bit-packed: a variable is a bit in
+// a care mask and a polarity mask.
+typedef struct {
+    int exact_variable_limit;   // Use Quine-McCluskey up to this many variables
+    int variable_limit;         // Statements with more free variables are left alone (at most 24)
+} MinimizeOptions;
+
+void init_minimize_options(MinimizeOptions* options);
+
+// Return a newly allocated sum of products equivalent to node, or NULL if
+// node has too many free variables or memory runs out. Quantifiers are
+// evaluated away.
+Node* minimize_expression(const Node* node, const MinimizeOptions* options);
+
+// Replace every non-assignment statement by its sum of products when that
+// has fewer nodes, spreading the statements over up to jobs threads.
+// Returns the number of statements replaced.
+int minimize_statements(Node** statements, int count, const MinimizeOptions* options, int jobs);
+
+#endif /* LOGIC_MINIMIZER_H */
@@ -0,0 +1,317 @@
+#include "model_counter.h"
+#include "and_inverter_graph.h"
+#include "binary_decision_diagram.h"
+#include "error_message.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Arbitrary-precision unsigned integers, 32-bit limbs, least significant
+// first, without leading zero limbs (zero has no limbs)
+typedef struct {
+    uint32_t* limbs;
+    int count;
+} BigCount;
+
+static int big_reserve(BigCount* x, int count) {
+    x->limbs = calloc(count > 0 ? count : 1, sizeof(uint32_t));
+    x->count = 0;
+    return x->limbs ? 0 : -1;
+}
+
+static void big_trim(BigCount* x, int count) {
+    while (count > 0 && x->limbs[count - 1] == 0) count--;
+    x->count = count;
+}
+
+static int big_power_of_two(BigCount* x, int bits) {
+    if (big_reserve(x, bits / 32 + 1) != 0) return -1;
+    x->limbs[bits / 32] = 1u << (bits % 32);
+    x->count = bits / 32 + 1;
+    return 0;
+}
+
+// x * 2^bits
+static int big_shifted(BigCount* result, const BigCount* x, int bits) {
+    int words = bits / 32;
+    int shift = bits % 32;
+    int count = x->count + words + 1;
+    if (big_reserve(result, count) != 0) return -1;
+    for (int i = 0; i < x->count; i++) {
+        uint64_t shifted = (uint64_t)x->limbs[i] << shift;
+        result->limbs[i + words] |= (uint32_t)shifted;
+        result->limbs[i + words + 1] |= (uint32_t)(shifted >> 32);
+    }
+    big_trim(result, count);
+    return 0;
+}
+
+static int big_add(BigCount* result, const BigCount* a, const BigCount* b) {
+    int count = (a->count > b->count ? a->count : b->count) + 1;
+    if (big_reserve(result, count) != 0) return -1;
+    uint64_t carry = 0;
+    for (int i = 0; i < count; i++) {
+        uint64_t sum = carry;
+        if (i < a->count) sum += a->limbs[i];
+        if (i < b->count) sum += b->limbs[i];
+        result->limbs[i] = (uint32_t)sum;
+        carry = sum >> 32;
+    }
+    big_trim(result, count);
+    return 0;
+}
+
+// a - b for a >= b
+static int big_subtract(BigCount* result, const BigCount* a, const BigCount* b) {
+    if (big_reserve(result, a->count) != 0) return -1;
+    int64_t borrow = 0;
+    for (int i = 0; i < a->count; i++) {
+        int64_t difference = (int64_t)a->limbs[i] - borrow - (i < b->count ? (int64_t)b->limbs[i] : 0);
+        borrow = difference < 0;
+        result->limbs[i] = (uint32_t)(difference + (borrow ? (int64_t)1 << 32 : 0));
+    }
+    big_trim(result, a->count);
+    return 0;
+}
+
+static char* big_to_decimal(const BigCount* x) {
+    // Repeatedly divide by 10^9, collecting nine digits at a time
+    uint32_t* limbs = malloc((x->count > 0 ? x->count : 1) * sizeof(uint32_t));
+    char* digits = malloc((size_t)x->count * 10 + 2);
+    if (!limbs || !digits) {
+        free(limbs);
+        free(digits);
+        return NULL;
+    }
+    memcpy(limbs, x->limbs, x->count * sizeof(uint32_t));
+    int count = x->count;
+    int length = 0;
+    do {
+        uint64_t remainder = 0;
+        for (int i = count - 1; i >= 0; i--) {
+            uint64_t value = remainder << 32 | limbs[i];
+            limbs[i] = (uint32_t)(value / 1000000000u);
+            remainder = value % 1000000000u;
+        }
+        while (count > 0 && limbs[count - 1] == 0) count--;
+        for (int d = 0; d < 9 && (count > 0 || remainder > 0 || d == 0); d++) {
+            digits[length++] = (char)('0' + remainder % 10);
+            remainder /= 10;
+        }
+    } while (count > 0);
+    free(limbs);
+
+    for (int i = 0; i < length / 2; i++) {
+        char swap = digits[i];
+        digits[i] = digits[length - 1 - i];
+        digits[length - 1 - i] = swap;
+    }
+    digits[length] = '\0';
+    return digits;
+}
+
+// Reachable nodes of the diagram below root, in increasing index order,
+// which puts children before their parents
+static int* reachable_nodes(const BDD* bdd, BDDEdge root, int* count) {
+    int top = BDD_NODE(root);
+    unsigned char* marks = calloc(top + 1, 1);
+    int* nodes = malloc((top + 1) * sizeof(int));
+    if (!marks || !nodes) {
+        free(marks);
+        free(nodes);
+        return NULL;
+    }
+    marks[top] = 1;
+    for (int i = top; i > 0; i--) {
+        if (!marks[i]) continue;
+        marks[BDD_NODE(bdd->nodes[i].low)] = 1;
+        marks[BDD_NODE(bdd->nodes[i].high)] = 1;
+    }
+    *count = 0;
+    for (int i = 1; i <= top; i++) {
+        if (marks[i]) nodes[(*count)++] = i;
+    }
+    free(marks);
+    return nodes;
+}
+
+// Models of edge over the variables from variable up, given the counts of
+// the regular nodes over the variables from their own
+static int count_edge(const BDD* bdd, const BigCount* counts, BDDEdge edge, int variable, BigCount* result) {
+    int node = BDD_NODE(edge);
+    int top = bdd->nodes[node].variable;
+    BigCount zero = {NULL, 0};
+    const BigCount* regular = node > 0 ? &counts[node] : &zero;
+
+    BigCount own = {NULL, 0};
+    if (BDD_IS_COMPLEMENTED(edge)) {
+        BigCount all;
+        if (big_power_of_two(&all, bdd->variable_count - top) != 0) return -1;
+        int status = big_subtract(&own, &all, regular);
+        free(all.limbs);
+        if (status != 0) return -1;
+        regular = &own;
+    }
+    int status = big_shifted(result, regular, top - variable);
+    free(own.limbs);
+    return status;
+}
+
+static char* count_diagram(const BDD* bdd, BDDEdge root) {
+    int count = 0;
+    int* nodes = reachable_nodes(bdd, root, &count);
+    BigCount* counts = calloc(BDD_NODE(root) + 1, sizeof(BigCount));
+    int failed = !nodes || !counts;
+
+    for (int i = 0; i < count && !failed; i++) {
+        const BDDNode* node = &bdd->nodes[nodes[i]];
+        BigCount low = {NULL, 0};
+        BigCount high = {NULL, 0};
+        failed = count_edge(bdd, counts, node->low, node->variable + 1, &low) != 0 ||
+                 count_edge(bdd, counts, node->high, node->variable + 1, &high) != 0 ||
+                 big_add(&counts[nodes[i]], &low, &high) != 0;
+        free(low.limbs);
+        free(high.limbs);
+    }
+
+    char* text = NULL;
+    BigCount total = {NULL, 0};
+    if (!failed && count_edge(bdd, counts, root, 0, &total) == 0) text = big_to_decimal(&total);
+    free(total.limbs);
+    if (counts) {
+        for (int i = 0; i <= BDD_NODE(root); i++) free(counts[i].limbs);
+    }
+    free(counts);
+    free(nodes);
+    return text;
+}
+
+// Probability of edge when variable v is TRUE with probability weights[v]
+static int diagram_probability(const BDD* bdd, BDDEdge root, const double* weights, double* probability) {
+    int count = 0;
+    int* nodes = reachable_nodes(bdd, root, &count);
+    double* probabilities = malloc((BDD_NODE(root) + 1) * sizeof(double));
+    if (!nodes || !probabilities) {
+        free(nodes);
+        free(probabilities);
+        return -1;
+    }
+
+    // P(NOT f) = 1 - P(f), and the terminal is FALSE
+    probabilities[0] = 0.0;
+#define EDGE_PROBABILITY(edge) \
+    (BDD_IS_COMPLEMENTED(edge) ? 1.0 - probabilities[BDD_NODE(edge)] : probabilities[BDD_NODE(edge)])
+    for (int i = 0; i < count; i++) {
+        const BDDNode* node = &bdd->nodes[nodes[i]];
+        double weight = weights[node->variable];
+        probabilities[nodes[i]] = (1.0 - weight) * EDGE_PROBABILITY(node->low) +
+                                  weight * EDGE_PROBABILITY(node->high);
+    }
+    *probability = EDGE_PROBABILITY(root);
+#undef EDGE_PROBABILITY
+
+    free(nodes);
+    free(probabilities);
+    return 0;
+}
+
+static AIGLiteral resolve_known(void* context, const char* name) {
+    int value = get_symbol_value(context, name);
+    if (value == ERROR_SYMBOL_NOT_FOUND) return AIG_INVALID;
+    return value ? AIG_TRUE : AIG_FALSE;
+}
+
+// Lower node to a diagram over the inputs of *aig; returns NULL or an error
+static char* build_diagram(const Node* node, SymbolTable* known, AIG** aig, BDD** bdd, BDDEdge* root) {
+    *bdd = NULL;
+    *aig = create_aig();
+    if (!*aig) return format_message("Out of memory counting models");
+    AIGLiteral literal = known ? aig_from_node_resolved(*aig, node, resolve_known, known)
+                               : aig_from_node(*aig, node);
+    if (literal == AIG_INVALID) return format_message("Failed to lower the expression for model counting");
+
+    *bdd = create_bdd((*aig)->input_count, BDD_DEFAULT_NODE_LIMIT);
+    if (!*bdd) return format_message("Out of memory counting models");
+    *root = bdd_from_aig(*bdd, *aig, literal);
+    if (*root == BDD_INVALID) {
+        return format_message("Decision diagram exceeds %d nodes; the expression is too large to count",
+                              (*bdd)->node_limit);
+    }
+    return NULL;
+}
+
+int count_models(const Node* node, SymbolTable* known, ModelCount* result, char** error_message) {
+    if (error_message) *error_message = NULL;
+    memset(result, 0, sizeof(ModelCount));
+
+    AIG* aig;
+    BDD* bdd;
+    BDDEdge root;
+    char* error = build_diagram(node, known, &aig, &bdd, &root);
+    double* weights = NULL;
+    if (!error) {
+        weights = malloc((aig->input_count > 0 ? aig->input_count : 1) * sizeof(double));
+        result->variables = calloc(aig->input_count > 0 ? aig->input_count : 1, sizeof(char*));
+        result->count = count_diagram(bdd, root);
+        if (!weights || !result->variables || !result->count) error = format_message("Out of memory counting models");
+    }
+    for (int i = 0; !error && i < aig->input_count; i++) {
+        weights[i] = 0.5;
+        result->variables[i] = strdup(aig->input_names[i]);
+        if (!result->variables[i]) error = format_message("Out of memory counting models");
+        result->variable_count++;
+    }
+    if (!error && diagram_probability(bdd, root, weights, &result->fraction) != 0) {
+        error = format_message("Out of memory counting models");
+    }
+
+    free(weights);
+    free_bdd(bdd);
+    free_aig(aig);
+    if (error) {
+        free_model_count(result);
+        set_error(error_message, error);
+        return -1;
+    }
+    return 0;
+}
+
+void free_model_count(ModelCount* result) {
+    if (!result) return;
+    free(result->count);
+    for (int i = 0; i < result->variable_count; i++) free(result->variables[i]);
+    free(result->variables);
+    memset(result, 0, sizeof(ModelCount));
+}
+
+int weighted_model_count(const Node* node, const SymbolTable* symbol_table, const double* probabilities,
+                         double* probability, char** error_message) {
+    if (error_message) *error_message = NULL;
+
+    AIG* aig;
+    BDD* bdd;
+    BDDEdge root;
+    char* error = build_diagram(node, NULL, &aig, &bdd, &root);
+    double* weights = NULL;
+    if (!error) {
+        weights = malloc((aig->input_count > 0 ? aig->input_count : 1) * sizeof(double));
+        if (!weights) error = format_message("Out of memory counting models");
+    }
+    for (int i = 0; !error && i < aig->input_count; i++) {
+        int index = symbol_table ? find_symbol_index(symbol_table, aig->input_names[i]) : -1;
+        weights[i] = index >= 0 ? probabilities[index] : 0.5;
+    }
+    if (!error && diagram_probability(bdd, root, weights, probability) != 0) {
+        error = format_message("Out of memory counting models");
+    }
+
+    free(weights);
+    free_bdd(bdd);
+    free_aig(aig);
+    if (error) {
+        set_error(error_message, error);
+        return -1;
+    }
+    return 0;
+}
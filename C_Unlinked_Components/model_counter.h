@@ -0,0 +1,34 @@
+#ifndef MODEL_COUNTER_H
+#define MODEL_COUNTER_H
+
+#include "ast.h"
+#include "symbol_table.h"
+
+// Model counting (#SAT) and weighted model counting. An expression is
+// lowered to an And-Inverter Graph and from there to a binary decision
+// diagram over its free variables, and counts are summed over the nodes of
+// the diagram. The cost follows the size of the diagram instead of the 2^n
+// assignments, and counts are exact at any number of variables.
+
+typedef struct {
+    char* count;            // Decimal number of satisfying assignments
+    char** variables;       // Variables the count ranges over, in order of first use
+    int variable_count;
+    double fraction;        // count / 2^variable_count
+} ModelCount;
+
+// Count the assignments to the free variables of node that make it TRUE.
+// Variables found in known, which may be NULL, keep their value there and
+// are not counted. Returns 0, or -1 with *error_message set when the
+// diagram exceeds its node limit or memory runs out.
+int count_models(const Node* node, SymbolTable* known, ModelCount* result, char** error_message);
+
+void free_model_count(ModelCount* result);
+
+// Probability that node is TRUE when each variable symbol_table->symbols[i]
+// is TRUE independently with probability probabilities[i]. Variables not in
+// the table are TRUE with probability 1/2. Returns 0 or -1 like count_models.
+int weighted_model_count(const Node* node, const SymbolTable* symbol_table, const double* probabilities,
+                         double* probability, char** error_message);
+
+#endif /* MODEL_COUNTER_H */
@@ -0,0 +1,319 @@
+#include "nary_flattener.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Flattened operand and its cost, the number of nodes it adds to the result
+typedef struct {
+    Node* node;
+    long cost;
+} Operand;
+
+typedef struct {
+    Operand* items;
+    int count;
+    int capacity;
+} OperandList;
+
+typedef struct {
+    int created;  // N-ary nodes built so far
+} Flattener;
+
+static Node* flatten_node(Flattener* flattener, const Node* node);
+
+static int is_chain_operator(NodeType type) {
+    return type == NODE_AND || type == NODE_OR || type == NODE_XOR;
+}
+
+static long expression_cost(const Node* node) {
+    if (!node) return 0;
+    long cost = 1 + expression_cost(node->left) + expression_cost(node->right);
+    for (int i = 0; i < node->child_count; i++) cost += expression_cost(node->children[i]);
+    return cost;
+}
+
+// Total order on expressions, ignoring parentheses; 0 when they are equal
+static int compare_expressions(const Node* a, const Node* b) {
+    if (a == b) return 0;
+    if (!a || !b) return a ? 1 : -1;
+    if (a->type != b->type) return a->type < b->type ? -1 : 1;
+    if (a->type == NODE_BOOL) return (a->bool_val != 0) - (b->bool_val != 0);
+    int order = strcmp(a->name ? a->name : "", b->name ? b->name : "");
+    if (order != 0) return order;
+    if (a->threshold != b->threshold) return a->threshold < b->threshold ? -1 : 1;
+    if (a->child_count != b->child_count) return a->child_count < b->child_count ? -1 : 1;
+    for (int i = 0; i < a->child_count; i++) {
+        order = compare_expressions(a->children[i], b->children[i]);
+        if (order != 0) return order;
+    }
+    order = compare_expressions(a->left, b->left);
+    return order != 0 ? order : compare_expressions(a->right, b->right);
+}
+
+// Cheapest first; equal operands end up next to each other
+static int compare_operands(const void* a, const void* b) {
+    const Operand* x = a;
+    const Operand* y = b;
+    if (x->cost != y->cost) return x->cost < y->cost ? -1 : 1;
+    return compare_expressions(x->node, y->node);
+}
+
+static void free_operands(OperandList* list) {
+    for (int i = 0; i < list->count; i++) free_ast(list->items[i].node);
+    free(list->items);
+}
+
+// Append node, taking ownership even on failure
+static int push_operand(OperandList* list, Node* node) {
+    if (list->count == list->capacity) {
+        int capacity = list->capacity ? list->capacity * 2 : 8;
+        Operand* items = realloc(list->items, capacity * sizeof(Operand));
+        if (!items) {
+            free_ast(node);
+            return -1;
+        }
+        list->items = items;
+        list->capacity = capacity;
+    }
+    list->items[list->count].node = node;
+    list->items[list->count].cost = expression_cost(node);
+    list->count++;
+    return 0;
+}
+
+// NOT of operand, folding constants and double negation. Takes ownership.
+static Node* negate(Node* operand) {
+    if (!operand) return NULL;
+    if (operand->type == NODE_BOOL) {
+        operand->bool_val = !operand->bool_val;
+        return operand;
+    }
+    if (operand->type == NODE_NOT) {
+        Node* inner = operand->left;
+        operand->left = NULL;
+        free_ast(operand);
+        return inner;
+    }
+    Node* node = create_node(NODE_NOT, NULL, operand, NULL, 0);
+    if (!node) free_ast(operand);
+    return node;
+}
+
+// Collect the flattened operands of the run of node's operator below node.
+// XOR operands of the form NOT x are stored as x, toggling *parity.
+static int collect_operands(Flattener* flattener, const Node* node, OperandList* list, int* parity) {
+    NodeType type = node->type;
+    int capacity = 16;
+    int top = 0;
+    const Node** pending = malloc(capacity * sizeof(Node*));
+    if (!pending) return -1;
+    pending[top++] = node;
+
+    int status = 0;
+    while (top > 0 && status == 0) {
+        const Node* current = pending[--top];
+        if (current->type == type) {
+            // Operands are pushed in reverse so they come out in source order
+            int needed = top + (current->children ? current->child_count : 2);
+            if (needed > capacity) {
+                while (capacity < needed) capacity *= 2;
+                const Node** grown = realloc(pending, capacity * sizeof(Node*));
+                if (!grown) {
+                    status = -1;
+                    break;
+                }
+                pending = grown;
+            }
+            if (current->children) {
+                for (int i = current->child_count - 1; i >= 0; i--) pending[top++] = current->children[i];
+            } else {
+                if (current->right) pending[top++] = current->right;
+                if (current->left) pending[top++] = current->left;
+            }
+            continue;
+        }
+
+        Node* operand = flatten_node(flattener, current);
+        if (!operand) {
+            status = -1;
+            break;
+        }
+        if (type == NODE_XOR && operand->type == NODE_NOT) {
+            operand = negate(operand);
+            *parity = !*parity;
+        }
+        if (is_nary_node(operand) && operand->type == type) {
+            // A run that only formed once its operands were simplified
+            for (int i = 0; i < operand->child_count && status == 0; i++) {
+                status = push_operand(list, operand->children[i]);
+                operand->children[i] = NULL;
+            }
+            free_ast(operand);
+            flattener->created--;
+        } else {
+            status = push_operand(list, operand);
+        }
+    }
+    free(pending);
+    return status;
+}
+
+// Drop the operands that cannot change an AND or OR. Returns the value that
+// decides it when an operand does, -1 otherwise.
+static int absorb_operands(OperandList* list, NodeType type) {
+    int dominant = type == NODE_OR;
+    for (int i = 0; i < list->count; i++) {
+        const Node* operand = list->items[i].node;
+        if (operand->type == NODE_BOOL && (operand->bool_val != 0) == dominant) return dominant;
+    }
+
+    int kept = 0;
+    for (int i = 0; i < list->count; i++) {
+        Node* operand = list->items[i].node;
+        int duplicate = kept > 0 && compare_operands(&list->items[kept - 1], &list->items[i]) == 0;
+        if (operand->type == NODE_BOOL || duplicate) {
+            free_ast(operand);
+            continue;
+        }
+        list->items[kept++] = list->items[i];
+    }
+    list->count = kept;
+
+    // x together with NOT x; x costs one node less than NOT x
+    for (int i = 0; i < list->count; i++) {
+        const Node* operand = list->items[i].node;
+        if (operand->type != NODE_NOT) continue;
+        Operand key = {operand->left, list->items[i].cost - 1};
+        if (bsearch(&key, list->items, list->count, sizeof(Operand), compare_operands)) return dominant;
+    }
+    return -1;
+}
+
+// Drop constants and pairs of equal operands from an XOR, toggling *parity
+static void cancel_operands(OperandList* list, int* parity) {
+    int kept = 0;
+    for (int i = 0; i < list->count; i++) {
+        Node* operand = list->items[i].node;
+        if (operand->type == NODE_BOOL) {
+            *parity ^= operand->bool_val != 0;
+            free_ast(operand);
+        } else if (kept > 0 && compare_operands(&list->items[kept - 1], &list->items[i]) == 0) {
+            free_ast(list->items[--kept].node);
+            free_ast(operand);
+        } else {
+            list->items[kept++] = list->items[i];
+        }
+    }
+    list->count = kept;
+}
+
+static Node* flatten_chain(Flattener* flattener, const Node* node) {
+    NodeType type = node->type;
+    OperandList list = {NULL, 0, 0};
+    int parity = 0;
+    if (collect_operands(flattener, node, &list, &parity) != 0) {
+        free_operands(&list);
+        return NULL;
+    }
+
+    qsort(list.items, list.count, sizeof(Operand), compare_operands);
+    if (type == NODE_XOR) {
+        cancel_operands(&list, &parity);
+    } else {
+        int decided = absorb_operands(&list, type);
+        if (decided >= 0) {
+            free_operands(&list);
+            return create_boolean_node(decided);
+        }
+    }
+
+    Node* result = NULL;
+    if (list.count == 0) {
+        result = create_boolean_node(type == NODE_AND);
+    } else if (list.count == 1) {
+        result = list.items[0].node;
+        list.count = 0;
+    } else {
+        result = create_node(type, NULL, NULL, NULL, 0);
+        for (int i = 0; result && i < list.count; i++) {
+            if (add_operand(result, list.items[i].node)->child_count != i + 1) {
+                free_ast(result);
+                result = NULL;
+                break;
+            }
+            list.items[i].node = NULL;
+        }
+        if (result) {
+            result->is_parenthesized = node->is_parenthesized;
+            flattener->created++;
+        }
+    }
+    free_operands(&list);
+    return parity ? negate(result) : result;
+}
+
+static Node* flatten_node(Flattener* flattener, const Node* node) {
+    if (!node) return NULL;
+    if (is_chain_operator(node->type)) return flatten_chain(flattener, node);
+
+    switch (node->type) {
+        case NODE_BOOL:
+        case NODE_VAR:
+            return clone_node(node);
+
+        case NODE_NOT:
+            return negate(flatten_node(flattener, node->left));
+
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY: {
+            Node* result = create_node(node->type, NULL, NULL, NULL, 0);
+            if (!result) return NULL;
+            result->threshold = node->threshold;
+            result->is_parenthesized = node->is_parenthesized;
+            for (int i = 0; i < node->child_count; i++) {
+                Node* operand = flatten_node(flattener, node->children[i]);
+                if (!operand || add_operand(result, operand)->child_count != i + 1) {
+                    free_ast(operand);
+                    free_ast(result);
+                    return NULL;
+                }
+            }
+            return result;
+        }
+
+        default: {
+            Node* left = flatten_node(flattener, node->left);
+            Node* right = flatten_node(flattener, node->right);
+            Node* result = NULL;
+            if ((left || !node->left) && (right || !node->right)) {
+                result = create_node(node->type, node->name, left, right, node->bool_val);
+            }
+            if (!result) {
+                free_ast(left);
+                free_ast(right);
+                return NULL;
+            }
+            result->is_parenthesized = node->is_parenthesized;
+            return result;
+        }
+    }
+}
+
+Node* flatten_expression(const Node* node) {
+    Flattener flattener = {0};
+    return flatten_node(&flattener, node);
+}
+
+int flatten_statements(Node** statements, int count) {
+    Flattener flattener = {0};
+    for (int i = 0; i < count; i++) {
+        Node* statement = statements[i];
+        if (!statement || statement->type == NODE_ASSIGN) continue;
+
+        Node* result = flatten_node(&flattener, statement);
+        if (!result) return -1;
+        free_ast(statement);
+        statements[i] = result;
+    }
+    return flattener.created;
+}
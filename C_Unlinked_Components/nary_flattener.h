@@ -0,0 +1,31 @@
+#ifndef NARY_FLATTENER_H
+#define NARY_FLATTENER_H
+
+#include "ast.h"
+
+// Flattening of AND, OR and XOR chains into n-ary nodes.
+//
+// The parser turns a1 AND a2 AND ... AND an into a left-deep chain of n - 1
+// binary nodes, so everything that walks it recurses n deep and code
+// generation emits a dependent chain of n - 1 instructions. Flattening
+// collects each maximal run of one operator, through parentheses, into a
+// single node holding its operands, which the code generators and the
+// And-Inverter Graph combine as a balanced tree. Operands are sorted,
+// cheapest first, and duplicates removed: x AND x and x OR x keep one x,
+// x XOR x cancels. Constants are folded, and x together with NOT x decides
+// an AND or OR outright.
+//
+// Only code generation, the And-Inverter Graph and what is built on it,
+// evaluation, printing and hashing understand n-ary nodes, so flattening
+// comes after the other rewrites, right before code generation.
+
+// Return the flattened form of node as a new expression, or NULL when out
+// of memory
+Node* flatten_expression(const Node* node);
+
+// Replace every non-assignment statement by its flattened form. Returns the
+// number of n-ary nodes created, or -1 when out of memory (statements
+// already replaced stay replaced).
+int flatten_statements(Node** statements, int count);
+
+#endif /* NARY_FLATTENER_H */
@@ -6,6 +6,31 @@
 // Internal function that handles precedence and parentheses
 static char* node_to_string_internal(Node* node, int parent_precedence);
 
+// Operands of an n-ary AND, OR or XOR joined by separator
+static char* join_operands(Node* node, const char* separator, int precedence) {
+    char** operands = calloc(node->child_count, sizeof(char*));
+    if (!operands) return NULL;
+    size_t length = 1; // null terminator
+    int complete = 1;
+    for (int i = 0; complete && i < node->child_count; i++) {
+        operands[i] = node_to_string_internal(node->children[i], precedence);
+        if (!operands[i]) complete = 0;
+        else length += strlen(operands[i]) + strlen(separator);
+    }
+    char* result = complete ? malloc(length) : NULL;
+    if (result) {
+        size_t used = 0;
+        for (int i = 0; i < node->child_count; i++) {
+            used += sprintf(result + used, "%s%s", i > 0 ? separator : "", operands[i]);
+        }
+    }
+    for (int i = 0; i < node->child_count; i++) {
+        free(operands[i]);
+    }
+    free(operands);
+    return result;
+}
+
 // Main function to convert a node to a string representation
 char* node_to_string(Node* node) {
     // Start with lowest precedence (0) to avoid unnecessary parentheses at top level
@@ -57,6 +82,10 @@ static char* node_to_string_internal(Node* node, int parent_precedence) {
             break;
             
         case NODE_AND:
+            if (is_nary_node(node)) {
+                result = join_operands(node, " AND ", precedence);
+                break;
+            }
             left_str = node_to_string_internal(node->left, precedence);
             right_str = node_to_string_internal(node->right, precedence);
             if (left_str && right_str) {
@@ -70,6 +99,10 @@ static char* node_to_string_internal(Node* node, int parent_precedence) {
             break;
             
         case NODE_OR:
+            if (is_nary_node(node)) {
+                result = join_operands(node, " OR ", precedence);
+                break;
+            }
             left_str = node_to_string_internal(node->left, precedence);
             right_str = node_to_string_internal(node->right, precedence);
             if (left_str && right_str) {
@@ -83,6 +116,10 @@ static char* node_to_string_internal(Node* node, int parent_precedence) {
             break;
             
         case NODE_XOR:
+            if (is_nary_node(node)) {
+                result = join_operands(node, " XOR ", precedence);
+                break;
+            }
             left_str = node_to_string_internal(node->left, precedence);
             right_str = node_to_string_internal(node->right, precedence);
             if (left_str && right_str) {
@@ -134,7 +171,37 @@ static char* node_to_string_internal(Node* node, int parent_precedence) {
                 }
             }
             break;
-            
+
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY: {
+            const char* keyword = node->type == NODE_ATLEAST ? "ATLEAST"
+                                : node->type == NODE_ATMOST ? "ATMOST" : "EXACTLY";
+            size_t length = strlen(keyword) + 16; // keyword + threshold + ( ) + null terminator
+            char** operands = calloc(node->child_count + 1, sizeof(char*));
+            int complete = operands != NULL;
+            for (int i = 0; complete && i < node->child_count; i++) {
+                operands[i] = node_to_string_internal(node->children[i], 0);
+                if (!operands[i]) complete = 0;
+                else length += strlen(operands[i]) + 2; // operand + ", "
+            }
+            if (complete) {
+                result = malloc(length);
+                if (result) {
+                    int used = sprintf(result, "%s %d (", keyword, node->threshold);
+                    for (int i = 0; i < node->child_count; i++) {
+                        used += sprintf(result + used, "%s%s", i > 0 ? ", " : "", operands[i]);
+                    }
+                    sprintf(result + used, ")");
+                }
+            }
+            for (int i = 0; operands && i < node->child_count; i++) {
+                free(operands[i]);
+            }
+            free(operands);
+            break;
+        }
+
         default:
             result = strdup("UNKNOWN");
             break;
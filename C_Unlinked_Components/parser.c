@@ -69,6 +69,7 @@
 /* First part of user prologue.  */
 #line 1 "parser.y"
 
+#include <stdlib.h>
 #include "ast.h"
 extern int yylex();
 extern int yyparse();
@@ -77,7 +78,7 @@ void yyerror(const char *s);
 // Declare the global variable as extern (defined in parser_globals.c)
 extern Node* parsed_expression;
 
-#line 81 "parser.c"
+#line 82 "parser.c"
 
 # ifndef YY_CAST
 #  ifdef __cplusplus
@@ -111,26 +112,32 @@ enum yysymbol_kind_t
   YYSYMBOL_IDENTIFIER = 3,                 /* IDENTIFIER  */
   YYSYMBOL_T_TRUE = 4,                     /* T_TRUE  */
   YYSYMBOL_T_FALSE = 5,                    /* T_FALSE  */
-  YYSYMBOL_INVALID_TOKEN = 6,              /* INVALID_TOKEN  */
-  YYSYMBOL_AND = 7,                        /* AND  */
-  YYSYMBOL_OR = 8,                         /* OR  */
-  YYSYMBOL_NOT = 9,                        /* NOT  */
-  YYSYMBOL_XOR = 10,                       /* XOR  */
-  YYSYMBOL_XNOR = 11,                      /* XNOR  */
-  YYSYMBOL_IMPLIES = 12,                   /* IMPLIES  */
-  YYSYMBOL_IFF = 13,                       /* IFF  */
-  YYSYMBOL_EQUIV = 14,                     /* EQUIV  */
-  YYSYMBOL_EXISTS = 15,                    /* EXISTS  */
-  YYSYMBOL_FORALL = 16,                    /* FORALL  */
-  YYSYMBOL_IF = 17,                        /* IF  */
-  YYSYMBOL_IFF_KEYWORD = 18,               /* IFF_KEYWORD  */
-  YYSYMBOL_ASSIGN = 19,                    /* ASSIGN  */
-  YYSYMBOL_LPAREN = 20,                    /* LPAREN  */
-  YYSYMBOL_RPAREN = 21,                    /* RPAREN  */
-  YYSYMBOL_YYACCEPT = 22,                  /* $accept  */
-  YYSYMBOL_program = 23,                   /* program  */
-  YYSYMBOL_statement = 24,                 /* statement  */
-  YYSYMBOL_expr = 25                       /* expr  */
+  YYSYMBOL_NUMBER = 6,                     /* NUMBER  */
+  YYSYMBOL_INVALID_TOKEN = 7,              /* INVALID_TOKEN  */
+  YYSYMBOL_AND = 8,                        /* AND  */
+  YYSYMBOL_OR = 9,                         /* OR  */
+  YYSYMBOL_NOT = 10,                       /* NOT  */
+  YYSYMBOL_XOR = 11,                       /* XOR  */
+  YYSYMBOL_XNOR = 12,                      /* XNOR  */
+  YYSYMBOL_IMPLIES = 13,                   /* IMPLIES  */
+  YYSYMBOL_IFF = 14,                       /* IFF  */
+  YYSYMBOL_EQUIV = 15,                     /* EQUIV  */
+  YYSYMBOL_EXISTS = 16,                    /* EXISTS  */
+  YYSYMBOL_FORALL = 17,                    /* FORALL  */
+  YYSYMBOL_ATLEAST = 18,                   /* ATLEAST  */
+  YYSYMBOL_ATMOST = 19,                    /* ATMOST  */
+  YYSYMBOL_EXACTLY = 20,                   /* EXACTLY  */
+  YYSYMBOL_IF = 21,                        /* IF  */
+  YYSYMBOL_IFF_KEYWORD = 22,               /* IFF_KEYWORD  */
+  YYSYMBOL_ASSIGN = 23,                    /* ASSIGN  */
+  YYSYMBOL_LPAREN = 24,                    /* LPAREN  */
+  YYSYMBOL_RPAREN = 25,                    /* RPAREN  */
+  YYSYMBOL_COMMA = 26,                     /* COMMA  */
+  YYSYMBOL_YYACCEPT = 27,                  /* $accept  */
+  YYSYMBOL_program = 28,                   /* program  */
+  YYSYMBOL_statement = 29,                 /* statement  */
+  YYSYMBOL_expr = 30,                      /* expr  */
+  YYSYMBOL_operands = 31                   /* operands  */
 };
 typedef enum yysymbol_kind_t yysymbol_kind_t;
 
@@ -456,21 +463,21 @@ union yyalloc
 #endif /* !YYCOPY_NEEDED */
 
 /* YYFINAL -- State number of the termination state.  */
-#define YYFINAL  18
+#define YYFINAL  24
 /* YYLAST -- Last index in YYTABLE.  */
-#define YYLAST   99
+#define YYLAST   132
 
 /* YYNTOKENS -- Number of terminals.  */
-#define YYNTOKENS  22
+#define YYNTOKENS  27
 /* YYNNTS -- Number of nonterminals.  */
-#define YYNNTS  4
+#define YYNNTS  5
 /* YYNRULES -- Number of rules.  */
-#define YYNRULES  20
+#define YYNRULES  25
 /* YYNSTATES -- Number of states.  */
-#define YYNSTATES  42
+#define YYNSTATES  60
 
 /* YYMAXUTOK -- Last valid token kind.  */
-#define YYMAXUTOK   276
+#define YYMAXUTOK   281
 
 
 /* YYTRANSLATE(TOKEN-NUM) -- Symbol number corresponding to TOKEN-NUM
@@ -511,16 +518,17 @@ static const yytype_int8 yytranslate[] =
        2,     2,     2,     2,     2,     2,     2,     2,     2,     2,
        2,     2,     2,     2,     2,     2,     1,     2,     3,     4,
        5,     6,     7,     8,     9,    10,    11,    12,    13,    14,
-      15,    16,    17,    18,    19,    20,    21
+      15,    16,    17,    18,    19,    20,    21,    22,    23,    24,
+      25,    26
 };
 
 #if YYDEBUG
 /* YYRLINE[YYN] -- Source line where rule number YYN was defined.  */
 static const yytype_int8 yyrline[] =
 {
-       0,    41,    41,    42,    46,    47,    51,    52,    53,    54,
-      55,    56,    57,    58,    59,    60,    61,    62,    63,    64,
-      69
+       0,    45,    45,    46,    50,    51,    55,    56,    57,    58,
+      59,    60,    61,    62,    63,    64,    65,    66,    67,    68,
+      69,    70,    71,    76,    80,    81
 };
 #endif
 
@@ -537,9 +545,10 @@ static const char *yysymbol_name (yysymbol_kind_t yysymbol) YY_ATTRIBUTE_UNUSED;
 static const char *const yytname[] =
 {
   "\"end of file\"", "error", "\"invalid token\"", "IDENTIFIER", "T_TRUE",
-  "T_FALSE", "INVALID_TOKEN", "AND", "OR", "NOT", "XOR", "XNOR", "IMPLIES",
-  "IFF", "EQUIV", "EXISTS", "FORALL", "IF", "IFF_KEYWORD", "ASSIGN",
-  "LPAREN", "RPAREN", "$accept", "program", "statement", "expr", YY_NULLPTR
+  "T_FALSE", "NUMBER", "INVALID_TOKEN", "AND", "OR", "NOT", "XOR", "XNOR",
+  "IMPLIES", "IFF", "EQUIV", "EXISTS", "FORALL", "ATLEAST", "ATMOST",
+  "EXACTLY", "IF", "IFF_KEYWORD", "ASSIGN", "LPAREN", "RPAREN", "COMMA",
+  "$accept", "program", "statement", "expr", "operands", YY_NULLPTR
 };
 
 static const char *
@@ -549,7 +558,7 @@ yysymbol_name (yysymbol_kind_t yysymbol)
 }
 #endif
 
-#define YYPACT_NINF (-16)
+#define YYPACT_NINF (-13)
 
 #define yypact_value_is_default(Yyn) \
   ((Yyn) == YYPACT_NINF)
@@ -563,11 +572,12 @@ yysymbol_name (yysymbol_kind_t yysymbol)
    STATE-NUM.  */
 static const yytype_int8 yypact[] =
 {
-      34,   -16,   -15,   -16,   -16,    43,    10,    11,    43,    25,
-     -16,    -2,    43,   -16,   -16,     2,     7,    54,   -16,   -16,
-      43,    43,    43,    43,    43,    43,    43,    -2,    43,    43,
-     -16,   -16,    24,    -6,    -6,    86,    86,    86,    66,    78,
-     -16,   -16
+      63,   -13,    17,   -13,   -13,    85,    30,    40,    42,    43,
+      44,    85,    41,   -13,    10,    85,   -13,   -13,    23,    28,
+      29,    31,    38,    -5,   -13,   -13,    85,    85,    85,    85,
+      85,    85,    85,    10,    85,    85,    85,    85,    85,   -13,
+     -13,    46,    -7,    -7,   117,   117,   117,    99,   107,    10,
+     -12,    -9,    11,   -13,   -13,   -13,    85,   -13,   -13,    10
 };
 
 /* YYDEFACT[STATE-NUM] -- Default reduction number in state STATE-NUM.
@@ -575,23 +585,24 @@ static const yytype_int8 yypact[] =
    means the default is an error.  */
 static const yytype_int8 yydefact[] =
 {
-       0,    20,     6,     7,     8,     0,     0,     0,     0,     0,
-       2,     5,     0,     6,     9,     0,     0,     0,     1,     3,
-       0,     0,     0,     0,     0,     0,     0,     4,     0,     0,
-      19,    10,    11,    12,    13,    14,    15,    16,     0,     0,
-      17,    18
+       0,    23,     6,     7,     8,     0,     0,     0,     0,     0,
+       0,     0,     0,     2,     5,     0,     6,     9,     0,     0,
+       0,     0,     0,     0,     1,     3,     0,     0,     0,     0,
+       0,     0,     0,     4,     0,     0,     0,     0,     0,    22,
+      10,    11,    12,    13,    14,    15,    16,     0,     0,    24,
+       0,     0,     0,    17,    18,    19,     0,    20,    21,    25
 };
 
 /* YYPGOTO[NTERM-NUM].  */
 static const yytype_int8 yypgoto[] =
 {
-     -16,   -16,    23,    -5
+     -13,   -13,    51,     0,     1
 };
 
 /* YYDEFGOTO[NTERM-NUM].  */
 static const yytype_int8 yydefgoto[] =
 {
-       0,     9,    10,    11
+       0,    12,    13,    49,    50
 };
 
 /* YYTABLE[YYPACT[STATE-NUM]] -- What to do in state STATE-NUM.  If
@@ -599,57 +610,66 @@ static const yytype_int8 yydefgoto[] =
    number is the opposite.  If YYTABLE_NINF, syntax error.  */
 static const yytype_int8 yytable[] =
 {
-      14,    20,    21,    17,    12,    20,    21,    27,    22,    23,
-      24,    25,    26,    15,    16,    31,    32,    33,    34,    35,
-      36,    37,    28,    38,    39,    18,     1,    29,     2,     3,
-       4,    20,    19,     0,     5,     1,     0,     2,     3,     4,
-       6,     7,     0,     5,     1,     8,    13,     3,     4,     6,
-       7,     0,     5,     0,     8,     0,     0,     0,     6,     7,
-       0,    20,    21,     8,    22,    23,    24,    25,    26,     0,
-       0,     0,     0,    20,    21,    30,    22,    23,    24,    25,
-      26,     0,     0,     0,     0,    20,    21,    40,    22,    23,
-      24,    25,    26,    20,    21,     0,    22,    23,    24,    41
+      14,    26,    27,    26,    27,    17,    28,    29,    30,    31,
+      32,    23,    14,    55,    56,    33,    57,    56,    26,    27,
+      39,    28,    29,    30,    31,    32,    40,    41,    42,    43,
+      44,    45,    46,    18,    47,    48,    58,    56,    51,    52,
+      15,    24,     1,    19,     2,     3,     4,    34,    20,    21,
+      22,     5,    35,    36,    26,    37,    59,     6,     7,     8,
+       9,    10,    38,    25,     1,    11,     2,     3,     4,     0,
+       0,     0,     0,     5,     0,     0,     0,     0,     0,     6,
+       7,     8,     9,    10,     0,     0,     1,    11,    16,     3,
+       4,     0,     0,     0,     0,     5,     0,     0,     0,     0,
+       0,     6,     7,     8,     9,    10,     0,    26,    27,    11,
+      28,    29,    30,    31,    32,    26,    27,     0,    28,    29,
+      30,    31,    32,     0,    53,    26,    27,     0,    28,    29,
+      30,     0,    54
 };
 
 static const yytype_int8 yycheck[] =
 {
-       5,     7,     8,     8,    19,     7,     8,    12,    10,    11,
-      12,    13,    14,     3,     3,    20,    21,    22,    23,    24,
-      25,    26,    20,    28,    29,     0,     1,    20,     3,     4,
-       5,     7,     9,    -1,     9,     1,    -1,     3,     4,     5,
-      15,    16,    -1,     9,     1,    20,     3,     4,     5,    15,
-      16,    -1,     9,    -1,    20,    -1,    -1,    -1,    15,    16,
-      -1,     7,     8,    20,    10,    11,    12,    13,    14,    -1,
-      -1,    -1,    -1,     7,     8,    21,    10,    11,    12,    13,
-      14,    -1,    -1,    -1,    -1,     7,     8,    21,    10,    11,
-      12,    13,    14,     7,     8,    -1,    10,    11,    12,    21
+       0,     8,     9,     8,     9,     5,    11,    12,    13,    14,
+      15,    11,    12,    25,    26,    15,    25,    26,     8,     9,
+      25,    11,    12,    13,    14,    15,    26,    27,    28,    29,
+      30,    31,    32,     3,    34,    35,    25,    26,    37,    38,
+      23,     0,     1,     3,     3,     4,     5,    24,     6,     6,
+       6,    10,    24,    24,     8,    24,    56,    16,    17,    18,
+      19,    20,    24,    12,     1,    24,     3,     4,     5,    -1,
+      -1,    -1,    -1,    10,    -1,    -1,    -1,    -1,    -1,    16,
+      17,    18,    19,    20,    -1,    -1,     1,    24,     3,     4,
+       5,    -1,    -1,    -1,    -1,    10,    -1,    -1,    -1,    -1,
+      -1,    16,    17,    18,    19,    20,    -1,     8,     9,    24,
+      11,    12,    13,    14,    15,     8,     9,    -1,    11,    12,
+      13,    14,    15,    -1,    25,     8,     9,    -1,    11,    12,
+      13,    -1,    25
 };
 
 /* YYSTOS[STATE-NUM] -- The symbol kind of the accessing symbol of
    state STATE-NUM.  */
 static const yytype_int8 yystos[] =
 {
-       0,     1,     3,     4,     5,     9,    15,    16,    20,    23,
-      24,    25,    19,     3,    25,     3,     3,    25,     0,    24,
-       7,     8,    10,    11,    12,    13,    14,    25,    20,    20,
-      21,    25,    25,    25,    25,    25,    25,    25,    25,    25,
-      21,    21
+       0,     1,     3,     4,     5,    10,    16,    17,    18,    19,
+      20,    24,    28,    29,    30,    23,     3,    30,     3,     3,
+       6,     6,     6,    30,     0,    29,     8,     9,    11,    12,
+      13,    14,    15,    30,    24,    24,    24,    24,    24,    25,
+      30,    30,    30,    30,    30,    30,    30,    30,    30,    30,
+      31,    31,    31,    25,    25,    25,    26,    25,    25,    30
 };
 
 /* YYR1[RULE-NUM] -- Symbol kind of the left-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr1[] =
 {
-       0,    22,    23,    23,    24,    24,    25,    25,    25,    25,
-      25,    25,    25,    25,    25,    25,    25,    25,    25,    25,
-      25
+       0,    27,    28,    28,    29,    29,    30,    30,    30,    30,
+      30,    30,    30,    30,    30,    30,    30,    30,    30,    30,
+      30,    30,    30,    30,    31,    31
 };
 
 /* YYR2[RULE-NUM] -- Number of symbols on the right-hand side of rule RULE-NUM.  */
 static const yytype_int8 yyr2[] =
 {
        0,     2,     1,     2,     3,     1,     1,     1,     1,     2,
-       3,     3,     3,     3,     3,     3,     3,     5,     5,     3,
-       1
+       3,     3,     3,     3,     3,     3,     3,     5,     5,     5,
+       5,     5,     3,     1,     1,     3
 };
 
 
@@ -1113,125 +1133,155 @@ yyreduce:
   switch (yyn)
     {
   case 2: /* program: statement  */
-#line 41 "parser.y"
+#line 45 "parser.y"
                            { parsed_expression = (yyvsp[0].node); }
-#line 1119 "parser.c"
+#line 1139 "parser.c"
     break;
 
   case 3: /* program: program statement  */
-#line 42 "parser.y"
+#line 46 "parser.y"
                            { parsed_expression = (yyvsp[0].node); }
-#line 1125 "parser.c"
+#line 1145 "parser.c"
     break;
 
   case 4: /* statement: IDENTIFIER ASSIGN expr  */
-#line 46 "parser.y"
+#line 50 "parser.y"
                                   { (yyval.node) = create_assignment_node((yyvsp[-2].str), (yyvsp[0].node)); }
-#line 1131 "parser.c"
+#line 1151 "parser.c"
     break;
 
   case 5: /* statement: expr  */
-#line 47 "parser.y"
+#line 51 "parser.y"
                                   { (yyval.node) = (yyvsp[0].node); }
-#line 1137 "parser.c"
+#line 1157 "parser.c"
     break;
 
   case 6: /* expr: IDENTIFIER  */
-#line 51 "parser.y"
+#line 55 "parser.y"
                                     { (yyval.node) = create_variable_node((yyvsp[0].str)); }
-#line 1143 "parser.c"
+#line 1163 "parser.c"
     break;
 
   case 7: /* expr: T_TRUE  */
-#line 52 "parser.y"
+#line 56 "parser.y"
                                     { (yyval.node) = create_boolean_node((yyvsp[0].bool_val)); }
-#line 1149 "parser.c"
+#line 1169 "parser.c"
     break;
 
   case 8: /* expr: T_FALSE  */
-#line 53 "parser.y"
+#line 57 "parser.y"
                                     { (yyval.node) = create_boolean_node((yyvsp[0].bool_val)); }
-#line 1155 "parser.c"
+#line 1175 "parser.c"
     break;
 
   case 9: /* expr: NOT expr  */
-#line 54 "parser.y"
+#line 58 "parser.y"
                                     { (yyval.node) = create_not_node((yyvsp[0].node)); }
-#line 1161 "parser.c"
+#line 1181 "parser.c"
     break;
 
   case 10: /* expr: expr AND expr  */
-#line 55 "parser.y"
+#line 59 "parser.y"
                                     { (yyval.node) = create_and_node((yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1167 "parser.c"
+#line 1187 "parser.c"
     break;
 
   case 11: /* expr: expr OR expr  */
-#line 56 "parser.y"
+#line 60 "parser.y"
                                     { (yyval.node) = create_or_node((yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1173 "parser.c"
+#line 1193 "parser.c"
     break;
 
   case 12: /* expr: expr XOR expr  */
-#line 57 "parser.y"
+#line 61 "parser.y"
                                     { (yyval.node) = create_xor_node((yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1179 "parser.c"
+#line 1199 "parser.c"
     break;
 
   case 13: /* expr: expr XNOR expr  */
-#line 58 "parser.y"
+#line 62 "parser.y"
                                     { (yyval.node) = create_xnor_node((yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1185 "parser.c"
+#line 1205 "parser.c"
     break;
 
   case 14: /* expr: expr IMPLIES expr  */
-#line 59 "parser.y"
+#line 63 "parser.y"
                                     { (yyval.node) = create_implies_node((yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1191 "parser.c"
+#line 1211 "parser.c"
     break;
 
   case 15: /* expr: expr IFF expr  */
-#line 60 "parser.y"
+#line 64 "parser.y"
                                     { (yyval.node) = create_iff_node((yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1197 "parser.c"
+#line 1217 "parser.c"
     break;
 
   case 16: /* expr: expr EQUIV expr  */
-#line 61 "parser.y"
+#line 65 "parser.y"
                                     { (yyval.node) = create_equiv_node((yyvsp[-2].node), (yyvsp[0].node)); }
-#line 1203 "parser.c"
+#line 1223 "parser.c"
     break;
 
   case 17: /* expr: EXISTS IDENTIFIER LPAREN expr RPAREN  */
-#line 62 "parser.y"
+#line 66 "parser.y"
                                                   { (yyval.node) = create_exists_node((yyvsp[-3].str), (yyvsp[-1].node)); }
-#line 1209 "parser.c"
+#line 1229 "parser.c"
     break;
 
   case 18: /* expr: FORALL IDENTIFIER LPAREN expr RPAREN  */
-#line 63 "parser.y"
+#line 67 "parser.y"
                                                   { (yyval.node) = create_forall_node((yyvsp[-3].str), (yyvsp[-1].node)); }
-#line 1215 "parser.c"
+#line 1235 "parser.c"
     break;
 
-  case 19: /* expr: LPAREN expr RPAREN  */
-#line 64 "parser.y"
+  case 19: /* expr: ATLEAST NUMBER LPAREN operands RPAREN  */
+#line 68 "parser.y"
+                                                  { (yyval.node) = create_threshold_node(NODE_ATLEAST, (yyvsp[-3].number), (yyvsp[-1].node)); }
+#line 1241 "parser.c"
+    break;
+
+  case 20: /* expr: ATMOST NUMBER LPAREN operands RPAREN  */
+#line 69 "parser.y"
+                                                  { (yyval.node) = create_threshold_node(NODE_ATMOST, (yyvsp[-3].number), (yyvsp[-1].node)); }
+#line 1247 "parser.c"
+    break;
+
+  case 21: /* expr: EXACTLY NUMBER LPAREN operands RPAREN  */
+#line 70 "parser.y"
+                                                  { (yyval.node) = create_threshold_node(NODE_EXACTLY, (yyvsp[-3].number), (yyvsp[-1].node)); }
+#line 1253 "parser.c"
+    break;
+
+  case 22: /* expr: LPAREN expr RPAREN  */
+#line 71 "parser.y"
                                     { 
         // Set the is_parenthesized flag for the expression
         (yyvsp[-1].node)->is_parenthesized = 1; 
         (yyval.node) = (yyvsp[-1].node); 
       }
-#line 1225 "parser.c"
+#line 1263 "parser.c"
     break;
 
-  case 20: /* expr: error  */
-#line 69 "parser.y"
+  case 23: /* expr: error  */
+#line 76 "parser.y"
             { yyerror("Syntax error: invalid expression"); YYABORT; }
-#line 1231 "parser.c"
+#line 1269 "parser.c"
     break;
 
+  case 24: /* operands: expr  */
+#line 80 "parser.y"
+                                    { (yyval.node) = add_operand(NULL, (yyvsp[0].node)); }
+#line 1275 "parser.c"
+    break;
 
-#line 1235 "parser.c"
+  case 25: /* operands: operands COMMA expr  */
+#line 81 "parser.y"
+                                    { (yyval.node) = add_operand((yyvsp[-2].node), (yyvsp[0].node)); }
+#line 1281 "parser.c"
+    break;
+
+
+#line 1285 "parser.c"
 
       default: break;
     }
@@ -1424,5 +1474,5 @@ yyreturnlab:
   return yyresult;
 }
 
-#line 72 "parser.y"
+#line 84 "parser.y"
 
@@ -57,22 +57,27 @@ extern int yydebug;
     IDENTIFIER = 258,              /* IDENTIFIER  */
     T_TRUE = 259,                  /* T_TRUE  */
     T_FALSE = 260,                 /* T_FALSE  */
-    INVALID_TOKEN = 261,           /* INVALID_TOKEN  */
-    AND = 262,                     /* AND  */
-    OR = 263,                      /* OR  */
-    NOT = 264,                     /* NOT  */
-    XOR = 265,                     /* XOR  */
-    XNOR = 266,                    /* XNOR  */
-    IMPLIES = 267,                 /* IMPLIES  */
-    IFF = 268,                     /* IFF  */
-    EQUIV = 269,                   /* EQUIV  */
-    EXISTS = 270,                  /* EXISTS  */
-    FORALL = 271,                  /* FORALL  */
-    IF = 272,                      /* IF  */
-    IFF_KEYWORD = 273,             /* IFF_KEYWORD  */
-    ASSIGN = 274,                  /* ASSIGN  */
-    LPAREN = 275,                  /* LPAREN  */
-    RPAREN = 276                   /* RPAREN  */
+    NUMBER = 261,                  /* NUMBER  */
+    INVALID_TOKEN = 262,           /* INVALID_TOKEN  */
+    AND = 263,                     /* AND  */
+    OR = 264,                      /* OR  */
+    NOT = 265,                     /* NOT  */
+    XOR = 266,                     /* XOR  */
+    XNOR = 267,                    /* XNOR  */
+    IMPLIES = 268,                 /* IMPLIES  */
+    IFF = 269,                     /* IFF  */
+    EQUIV = 270,                   /* EQUIV  */
+    EXISTS = 271,                  /* EXISTS  */
+    FORALL = 272,                  /* FORALL  */
+    ATLEAST = 273,                 /* ATLEAST  */
+    ATMOST = 274,                  /* ATMOST  */
+    EXACTLY = 275,                 /* EXACTLY  */
+    IF = 276,                      /* IF  */
+    IFF_KEYWORD = 277,             /* IFF_KEYWORD  */
+    ASSIGN = 278,                  /* ASSIGN  */
+    LPAREN = 279,                  /* LPAREN  */
+    RPAREN = 280,                  /* RPAREN  */
+    COMMA = 281                    /* COMMA  */
   };
   typedef enum yytokentype yytoken_kind_t;
 #endif
@@ -81,13 +86,14 @@ extern int yydebug;
 #if ! defined YYSTYPE && ! defined YYSTYPE_IS_DECLARED
 union YYSTYPE
 {
-#line 11 "parser.y"
+#line 12 "parser.y"
 
     char* str;
     struct Node* node;
     int bool_val;
+    int number;
 
-#line 91 "parser.h"
+#line 97 "parser.h"
 
 };
 typedef union YYSTYPE YYSTYPE;
@@ -1,4 +1,5 @@
 %{
+#include <stdlib.h>
 #include "ast.h"
 extern int yylex();
 extern int yyparse();
@@ -12,20 +13,23 @@ extern Node* parsed_expression;
     char* str;
     struct Node* node;
     int bool_val;
+    int number;
 }
 
 %token <str> IDENTIFIER
 %token <bool_val> T_TRUE T_FALSE
+%token <number> NUMBER
 %token INVALID_TOKEN
 
 
-%type <node> expr statement program
+%type <node> expr statement program operands
 
 %token AND OR NOT XOR XNOR
 %token IMPLIES IFF EQUIV
 %token EXISTS FORALL
+%token ATLEAST ATMOST EXACTLY
 %token IF IFF_KEYWORD
-%token ASSIGN LPAREN RPAREN
+%token ASSIGN LPAREN RPAREN COMMA
 
 /* Operator precedence and associativity (lowest to highest) */
 %left IFF EQUIV                /* lowest precedence */
@@ -61,6 +65,9 @@ expr:
     | expr EQUIV expr               { $$ = create_equiv_node($1, $3); }
     | EXISTS IDENTIFIER LPAREN expr RPAREN        { $$ = create_exists_node($2, $4); }
     | FORALL IDENTIFIER LPAREN expr RPAREN        { $$ = create_forall_node($2, $4); }
+    | ATLEAST NUMBER LPAREN operands RPAREN       { $$ = create_threshold_node(NODE_ATLEAST, $2, $4); }
+    | ATMOST NUMBER LPAREN operands RPAREN        { $$ = create_threshold_node(NODE_ATMOST, $2, $4); }
+    | EXACTLY NUMBER LPAREN operands RPAREN       { $$ = create_threshold_node(NODE_EXACTLY, $2, $4); }
     | LPAREN expr RPAREN            { 
         // Set the is_parenthesized flag for the expression
         $2->is_parenthesized = 1; 
@@ -69,4 +76,9 @@ expr:
     | error { yyerror("Syntax error: invalid expression"); YYABORT; }
     ;
 
+operands:
+      expr                          { $$ = add_operand(NULL, $1); }
+    | operands COMMA expr           { $$ = add_operand($1, $3); }
+    ;
+
 %%
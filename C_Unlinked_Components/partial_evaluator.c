@@ -0,0 +1,245 @@
+#include "partial_evaluator.h"
+#include <stdlib.h>
+#include <string.h>
+
+// Quantified variables in scope, innermost first
+typedef struct Binding {
+    const char* name;
+    int value;
+    const struct Binding* next;
+} Binding;
+
+static int is_constant(const Node* node) {
+    return node->type == NODE_BOOL;
+}
+
+// Structural equality, ignoring parentheses
+static int same_expression(const Node* a, const Node* b) {
+    while (a && b) {
+        if (a->type != b->type) return 0;
+        if (a->type == NODE_BOOL) return a->bool_val == b->bool_val;
+        if ((a->name || b->name) && (!a->name || !b->name || strcmp(a->name, b->name) != 0)) return 0;
+        if (a->threshold != b->threshold || a->child_count != b->child_count) return 0;
+        for (int i = 0; i < a->child_count; i++) {
+            if (!same_expression(a->children[i], b->children[i])) return 0;
+        }
+        if (!same_expression(a->right, b->right)) return 0;
+        a = a->left;
+        b = b->left;
+    }
+    return a == b;
+}
+
+static int is_negation(const Node* a, const Node* b) {
+    return (a->type == NODE_NOT && same_expression(a->left, b)) ||
+           (b->type == NODE_NOT && same_expression(b->left, a));
+}
+
+static Node* constant(int value) {
+    return create_boolean_node(value);
+}
+
+// NOT of operand, folding constants and double negation. Takes ownership.
+static Node* negate(Node* operand) {
+    if (!operand) return NULL;
+    if (is_constant(operand)) {
+        operand->bool_val = !operand->bool_val;
+        return operand;
+    }
+    if (operand->type == NODE_NOT) {
+        Node* inner = operand->left;
+        operand->left = NULL;
+        free_ast(operand);
+        return inner;
+    }
+    Node* node = create_node(NODE_NOT, NULL, operand, NULL, 0);
+    if (!node) free_ast(operand);
+    return node;
+}
+
+// Return keep and free drop
+static Node* keep(Node* keep, Node* drop) {
+    free_ast(drop);
+    return keep;
+}
+
+static Node* both_dropped(Node* left, Node* right, int value) {
+    free_ast(left);
+    free_ast(right);
+    return constant(value);
+}
+
+static int apply_operator(NodeType type, int left, int right) {
+    switch (type) {
+        case NODE_AND: return left && right;
+        case NODE_OR: return left || right;
+        case NODE_XOR: return left != right;
+        case NODE_IMPLIES: return !left || right;
+        default: return left == right;  // XNOR, IFF, EQUIV
+    }
+}
+
+// Binary operator of the given type over residuals left and right, which it
+// takes ownership of. original supplies the parenthesization when the
+// operator survives.
+static Node* simplify_binary(const Node* original, Node* left, Node* right) {
+    NodeType type = original->type;
+    if (!left || !right) {
+        free_ast(left);
+        free_ast(right);
+        return NULL;
+    }
+    if (is_constant(left) && is_constant(right)) {
+        return both_dropped(left, right, apply_operator(type, left->bool_val, right->bool_val));
+    }
+
+    // Put a constant operand on the right; IMPLIES is handled separately
+    if (type != NODE_IMPLIES && is_constant(left)) {
+        Node* swap = left;
+        left = right;
+        right = swap;
+    }
+    int same = same_expression(left, right);
+    int negation = !same && is_negation(left, right);
+
+    switch (type) {
+        case NODE_AND:
+            if (is_constant(right)) return right->bool_val ? keep(left, right) : keep(right, left);
+            if (same) return keep(left, right);
+            if (negation) return both_dropped(left, right, 0);
+            break;
+
+        case NODE_OR:
+            if (is_constant(right)) return right->bool_val ? keep(right, left) : keep(left, right);
+            if (same) return keep(left, right);
+            if (negation) return both_dropped(left, right, 1);
+            break;
+
+        case NODE_XOR:
+            if (is_constant(right)) return right->bool_val ? negate(keep(left, right)) : keep(left, right);
+            if (same || negation) return both_dropped(left, right, negation);
+            break;
+
+        case NODE_IMPLIES:
+            if (is_constant(left)) return left->bool_val ? keep(right, left) : both_dropped(left, right, 1);
+            if (is_constant(right)) return right->bool_val ? keep(right, left) : negate(keep(left, right));
+            if (same) return both_dropped(left, right, 1);
+            // NOT x -> x is x, and x -> NOT x is NOT x
+            if (negation) return keep(right, left);
+            break;
+
+        default:  // XNOR, IFF, EQUIV
+            if (is_constant(right)) return right->bool_val ? keep(left, right) : negate(keep(left, right));
+            if (same || negation) return both_dropped(left, right, same);
+            break;
+    }
+
+    Node* node = create_node(type, NULL, left, right, 0);
+    if (!node) {
+        free_ast(left);
+        free_ast(right);
+        return NULL;
+    }
+    node->is_parenthesized = original->is_parenthesized;
+    return node;
+}
+
+static Node* residual(const Node* node, SymbolTable* symbol_table, const Binding* bound);
+
+// Threshold over the residual operands: constant operands are dropped, a
+// TRUE one lowering the threshold, until the operands left cannot matter
+static Node* simplify_threshold(const Node* node, SymbolTable* symbol_table, const Binding* bound) {
+    Node* result = create_node(node->type, NULL, NULL, NULL, 0);
+    if (!result) return NULL;
+    result->is_parenthesized = node->is_parenthesized;
+
+    int true_count = 0;
+    for (int i = 0; i < node->child_count; i++) {
+        Node* operand = residual(node->children[i], symbol_table, bound);
+        if (!operand) {
+            free_ast(result);
+            return NULL;
+        }
+        if (is_constant(operand)) {
+            true_count += operand->bool_val != 0;
+            free_ast(operand);
+            continue;
+        }
+        int count = result->child_count;
+        if (add_operand(result, operand)->child_count == count) {
+            free_ast(operand);
+            free_ast(result);
+            return NULL;
+        }
+    }
+
+    result->threshold = node->threshold - true_count;
+    int value = threshold_constant(result->type, result->threshold, result->child_count);
+    if (value >= 0) return keep(constant(value), result);
+    return result;
+}
+
+static Node* residual(const Node* node, SymbolTable* symbol_table, const Binding* bound) {
+    if (!node) return NULL;
+
+    switch (node->type) {
+        case NODE_BOOL:
+            return constant(node->bool_val);
+
+        case NODE_VAR: {
+            for (const Binding* binding = bound; binding; binding = binding->next) {
+                if (strcmp(binding->name, node->name) == 0) return constant(binding->value);
+            }
+            if (strcmp(node->name, "TRUE") == 0) return constant(1);
+            if (strcmp(node->name, "FALSE") == 0) return constant(0);
+            int value = get_symbol_value(symbol_table, node->name);
+            if (value != ERROR_SYMBOL_NOT_FOUND) return constant(value);
+            return clone_node(node);
+        }
+
+        case NODE_ASSIGN:
+            return clone_node(node);
+
+        case NODE_NOT:
+            return negate(residual(node->left, symbol_table, bound));
+
+        case NODE_EXISTS:
+        case NODE_FORALL: {
+            // Q x. f is f[x := FALSE] combined with f[x := TRUE]
+            Binding when_false = {node->name, 0, bound};
+            Binding when_true = {node->name, 1, bound};
+            Node combine = {node->type == NODE_EXISTS ? NODE_OR : NODE_AND};
+            combine.is_parenthesized = node->is_parenthesized;
+            return simplify_binary(&combine, residual(node->left, symbol_table, &when_false),
+                                   residual(node->left, symbol_table, &when_true));
+        }
+
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY:
+            return simplify_threshold(node, symbol_table, bound);
+
+        default:
+            return simplify_binary(node, residual(node->left, symbol_table, bound),
+                                   residual(node->right, symbol_table, bound));
+    }
+}
+
+Node* partially_evaluate(const Node* node, SymbolTable* symbol_table) {
+    return residual(node, symbol_table, NULL);
+}
+
+int partially_evaluate_statements(Node** statements, int count, SymbolTable* symbol_table) {
+    int remaining = 0;
+    for (int i = 0; i < count; i++) {
+        Node* statement = statements[i];
+        if (!statement || statement->type == NODE_ASSIGN) continue;
+
+        Node* result = partially_evaluate(statement, symbol_table);
+        if (!result) return -1;
+        free_ast(statement);
+        statements[i] = result;
+        if (!is_constant(result)) remaining++;
+    }
+    return remaining;
+}
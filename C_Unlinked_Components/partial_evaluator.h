@@ -0,0 +1,22 @@
+#ifndef PARTIAL_EVALUATOR_H
+#define PARTIAL_EVALUATOR_H
+
+#include "ast.h"
+#include "symbol_table.h"
+
+// Partial evaluation against a symbol table that only knows some of the
+// variables. Known variables are substituted and constants folded, and
+// identities such as x AND FALSE, x XOR x, x OR NOT x and NOT NOT x are
+// simplified, leaving a residual expression over the unknown variables.
+// Quantifiers are expanded into both cofactors, so residuals contain no
+// quantifiers.
+
+// Return the residual of node as a new expression, or NULL when out of memory
+Node* partially_evaluate(const Node* node, SymbolTable* symbol_table);
+
+// Replace every non-assignment statement by its residual. Returns the
+// number of statements whose residual still depends on unknown variables,
+// or -1 when out of memory (statements already replaced stay replaced).
+int partially_evaluate_statements(Node** statements, int count, SymbolTable* symbol_table);
+
+#endif /* PARTIAL_EVALUATOR_H */
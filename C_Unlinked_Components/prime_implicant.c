@@ -0,0 +1,171 @@
+#include "prime_implicant.h"
+#include "and_inverter_graph.h"
+#include "sat_solver.h"
+#include "error_message.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define TERNARY_UNKNOWN 2
+
+struct Explainer {
+    AIG* aig;
+    AIGLiteral output;
+    unsigned char* ternary;     // Value of each node: 0, 1 or TERNARY_UNKNOWN
+    SATSolver* solver;          // Node n is variable n + 1
+    int* inputs;                // Value of each input, or -1 once dropped
+    int* assumptions;
+    const char** names;         // Explanation buffers
+    int* values;
+};
+
+static int sat_literal(AIGLiteral literal) {
+    int variable = AIG_NODE(literal) + 1;
+    return AIG_IS_COMPLEMENTED(literal) ? -variable : variable;
+}
+
+// Tseitin encoding of every node, so explanations only add assumptions
+static int encode_graph(Explainer* explainer) {
+    const AIG* aig = explainer->aig;
+    for (int node = 0; node < aig->node_count; node++) {
+        if (sat_new_variable(explainer->solver) < 0) return -1;
+    }
+    int constant = -1;
+    if (sat_add_clause(explainer->solver, &constant, 1) != 0) return -1;
+    for (int node = 1; node < aig->node_count; node++) {
+        if (!aig_is_and(aig, node)) continue;
+        int variable = node + 1;
+        int a = sat_literal(aig->nodes[node].fanin0);
+        int b = sat_literal(aig->nodes[node].fanin1);
+        int clauses[3][3] = {{-variable, a, 0}, {-variable, b, 0}, {variable, -a, -b}};
+        if (sat_add_clause(explainer->solver, clauses[0], 2) != 0 ||
+            sat_add_clause(explainer->solver, clauses[1], 2) != 0 ||
+            sat_add_clause(explainer->solver, clauses[2], 3) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+Explainer* create_explainer(const Node* statement, char** error_message) {
+    if (error_message) *error_message = NULL;
+    Explainer* explainer = calloc(1, sizeof(Explainer));
+    if (!explainer || !(explainer->aig = create_aig())) {
+        free(explainer);
+        set_error(error_message, format_message("Out of memory preparing the explanation"));
+        return NULL;
+    }
+
+    explainer->output = aig_from_node(explainer->aig, statement);
+    if (explainer->output == AIG_INVALID) {
+        free_explainer(explainer);
+        set_error(error_message, format_message("Failed to lower the statement to an And-Inverter Graph"));
+        return NULL;
+    }
+
+    int inputs = explainer->aig->input_count > 0 ? explainer->aig->input_count : 1;
+    explainer->ternary = malloc(explainer->aig->node_count);
+    explainer->inputs = malloc(inputs * sizeof(int));
+    explainer->assumptions = malloc((inputs + 1) * sizeof(int));
+    explainer->names = malloc(inputs * sizeof(char*));
+    explainer->values = malloc(inputs * sizeof(int));
+    explainer->solver = create_sat_solver();
+    if (!explainer->ternary || !explainer->inputs || !explainer->assumptions || !explainer->names ||
+        !explainer->values || !explainer->solver || encode_graph(explainer) != 0) {
+        free_explainer(explainer);
+        set_error(error_message, format_message("Out of memory preparing the explanation"));
+        return NULL;
+    }
+    return explainer;
+}
+
+void free_explainer(Explainer* explainer) {
+    if (!explainer) return;
+    free_aig(explainer->aig);
+    free_sat_solver(explainer->solver);
+    free(explainer->ternary);
+    free(explainer->inputs);
+    free(explainer->assumptions);
+    free(explainer->names);
+    free(explainer->values);
+    free(explainer);
+}
+
+static int ternary_literal(const Explainer* explainer, AIGLiteral literal) {
+    int value = explainer->ternary[AIG_NODE(literal)];
+    return value == TERNARY_UNKNOWN ? value : value ^ AIG_IS_COMPLEMENTED(literal);
+}
+
+// Three-valued simulation of the graph under explainer->inputs. Sound but
+// not complete: a known result is forced, an unknown one may still be.
+static int simulate(Explainer* explainer) {
+    const AIG* aig = explainer->aig;
+    explainer->ternary[0] = 0;
+    for (int node = 1; node < aig->node_count; node++) {
+        if (!aig_is_and(aig, node)) {
+            int value = explainer->inputs[aig->nodes[node].fanin1];
+            explainer->ternary[node] = value < 0 ? TERNARY_UNKNOWN : value;
+            continue;
+        }
+        int a = ternary_literal(explainer, aig->nodes[node].fanin0);
+        int b = ternary_literal(explainer, aig->nodes[node].fanin1);
+        explainer->ternary[node] = a == 0 || b == 0 ? 0 : a == 1 && b == 1 ? 1 : TERNARY_UNKNOWN;
+    }
+    return ternary_literal(explainer, explainer->output);
+}
+
+// Whether the kept inputs other than skip force the outcome
+static int forced_without(Explainer* explainer, int skip, int outcome) {
+    const AIG* aig = explainer->aig;
+    int count = 0;
+    for (int i = 0; i < aig->input_count; i++) {
+        if (i == skip || explainer->inputs[i] < 0) continue;
+        int variable = aig->input_nodes[i] + 1;
+        explainer->assumptions[count++] = explainer->inputs[i] ? variable : -variable;
+    }
+    // Look for an assignment extending them on which the statement differs
+    int output = sat_literal(explainer->output);
+    explainer->assumptions[count++] = outcome ? -output : output;
+    return sat_solve(explainer->solver, explainer->assumptions, count, 0) == SAT_UNSATISFIABLE;
+}
+
+int explain_statement(Explainer* explainer, SymbolTable* symbol_table, Explanation* explanation,
+                      char** error_message) {
+    if (error_message) *error_message = NULL;
+    const AIG* aig = explainer->aig;
+    for (int i = 0; i < aig->input_count; i++) {
+        int value = get_symbol_value(symbol_table, aig->input_names[i]);
+        if (value == ERROR_SYMBOL_NOT_FOUND) {
+            set_error(error_message, format_message("Variable '%s' has no value", aig->input_names[i]));
+            return -1;
+        }
+        explainer->inputs[i] = value != 0;
+    }
+    int outcome = simulate(explainer);
+
+    // Cheap pass: drop values while simulation still yields the outcome
+    for (int i = 0; i < aig->input_count; i++) {
+        int value = explainer->inputs[i];
+        explainer->inputs[i] = -1;
+        if (simulate(explainer) != outcome) explainer->inputs[i] = value;
+    }
+
+    // Exact pass over what is left. A value that could not go while more
+    // values were kept cannot go later either, so one sweep leaves a prime
+    // implicant.
+    for (int i = 0; i < aig->input_count; i++) {
+        if (explainer->inputs[i] >= 0 && forced_without(explainer, i, outcome)) explainer->inputs[i] = -1;
+    }
+
+    explanation->outcome = outcome;
+    explanation->count = 0;
+    for (int i = 0; i < aig->input_count; i++) {
+        if (explainer->inputs[i] < 0) continue;
+        explainer->names[explanation->count] = aig->input_names[i];
+        explainer->values[explanation->count] = explainer->inputs[i];
+        explanation->count++;
+    }
+    explanation->names = explainer->names;
+    explanation->values = explainer->values;
+    return 0;
+}
@@ -0,0 +1,37 @@
+#ifndef PRIME_IMPLICANT_H
+#define PRIME_IMPLICANT_H
+
+#include "ast.h"
+#include "symbol_table.h"
+
+// Minimal explanations of a statement's value. Given the current values of
+// its variables, an explanation is a prime implicant of the outcome: a
+// subset of those values that forces the statement to the same result
+// whatever the other variables are, and from which no value can be dropped.
+//
+// A statement is prepared once, lowering it to an And-Inverter Graph and
+// encoding that for an incremental SAT solver, and can then be explained
+// for any number of assignments. Each explanation first drops values
+// greedily while three-valued simulation of the graph still yields the
+// outcome, then asks the solver whether any remaining value can go, which
+// also catches what simulation cannot see (such as x AND NOT x).
+typedef struct Explainer Explainer;
+
+typedef struct {
+    int outcome;            // Value of the statement
+    const char** names;     // Variables of the implicant, in order of first use
+    const int* values;
+    int count;
+} Explanation;
+
+// Returns NULL and sets *error_message when out of memory
+Explainer* create_explainer(const Node* statement, char** error_message);
+void free_explainer(Explainer* explainer);
+
+// Explain the statement's value under symbol_table, which must define every
+// free variable. The explanation points into the explainer and stays valid
+// until the next call. Returns 0, or -1 with *error_message set.
+int explain_statement(Explainer* explainer, SymbolTable* symbol_table, Explanation* explanation,
+                      char** error_message);
+
+#endif /* PRIME_IMPLICANT_H */
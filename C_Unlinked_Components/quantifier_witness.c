@@ -0,0 +1,177 @@
+#include "quantifier_witness.h"
+#include "and_inverter_graph.h"
+#include "sat_solver.h"
+#include "error_message.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Variables of the block and the table the other variables come from
+typedef struct {
+    char* const* bound;
+    int bound_count;
+    SymbolTable* symbol_table;
+} Scope;
+
+static int is_bound(const Scope* scope, const char* name) {
+    for (int i = 0; i < scope->bound_count; i++) {
+        if (strcmp(scope->bound[i], name) == 0) return 1;
+    }
+    return 0;
+}
+
+// Known variables become constants; bound and unknown ones become inputs
+static AIGLiteral resolve_known(void* context, const char* name) {
+    const Scope* scope = context;
+    if (is_bound(scope, name)) return AIG_INVALID;
+    int value = get_symbol_value(scope->symbol_table, name);
+    if (value == ERROR_SYMBOL_NOT_FOUND) return AIG_INVALID;
+    return value ? AIG_TRUE : AIG_FALSE;
+}
+
+static int sat_literal(AIGLiteral literal) {
+    int variable = AIG_NODE(literal) + 1;
+    return AIG_IS_COMPLEMENTED(literal) ? -variable : variable;
+}
+
+// Tseitin encoding of every node; node n is variable n + 1
+static int encode_graph(SATSolver* solver, const AIG* aig) {
+    for (int node = 0; node < aig->node_count; node++) {
+        if (sat_new_variable(solver) < 0) return -1;
+    }
+    int constant = -1;
+    if (sat_add_clause(solver, &constant, 1) != 0) return -1;
+    for (int node = 1; node < aig->node_count; node++) {
+        if (!aig_is_and(aig, node)) continue;
+        int variable = node + 1;
+        int a = sat_literal(aig->nodes[node].fanin0);
+        int b = sat_literal(aig->nodes[node].fanin1);
+        int clauses[3][3] = {{-variable, a, 0}, {-variable, b, 0}, {variable, -a, -b}};
+        if (sat_add_clause(solver, clauses[0], 2) != 0 || sat_add_clause(solver, clauses[1], 2) != 0 ||
+            sat_add_clause(solver, clauses[2], 3) != 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Look for values of the bound inputs that give output the value target.
+// Returns 1 and fills result->values when found, 0 when there are none, -1
+// when out of memory.
+static int search_binding(const AIG* aig, AIGLiteral output, const AIGLiteral* bound, int target,
+                          QuantifierWitness* result) {
+    SATSolver* solver = create_sat_solver();
+    if (!solver || encode_graph(solver, aig) != 0) {
+        free_sat_solver(solver);
+        return -1;
+    }
+    int assumption = target ? sat_literal(output) : -sat_literal(output);
+    SATResult outcome = sat_solve(solver, &assumption, 1, 0);
+    if (outcome == SAT_SATISFIABLE) {
+        for (int i = 0; i < result->count; i++) {
+            result->values[i] = sat_model_value(solver, AIG_NODE(bound[i]) + 1);
+        }
+    }
+    free_sat_solver(solver);
+    return outcome == SAT_SATISFIABLE ? 1 : outcome == SAT_UNSATISFIABLE ? 0 : -1;
+}
+
+// Collect the distinct variables of the leading block; returns the
+// expression under it, or NULL when out of memory
+static const Node* collect_block(const Node* node, QuantifierWitness* result) {
+    NodeType kind = node->type;
+    int length = 0;
+    for (const Node* n = node; n && n->type == kind; n = n->left) length++;
+    result->names = calloc(length, sizeof(char*));
+    result->values = calloc(length, sizeof(int));
+    if (!result->names || !result->values) return NULL;
+
+    for (; node && node->type == kind; node = node->left) {
+        Scope seen = {result->names, result->count, NULL};
+        if (is_bound(&seen, node->name)) continue;
+        if (!(result->names[result->count] = strdup(node->name))) return NULL;
+        result->count++;
+    }
+    return node;
+}
+
+int find_quantifier_witness(const Node* statement, SymbolTable* symbol_table, QuantifierWitness* result,
+                            char** error_message) {
+    if (error_message) *error_message = NULL;
+    memset(result, 0, sizeof(QuantifierWitness));
+    if (statement && statement->type == NODE_ASSIGN) statement = get_assignment_expression(statement);
+    if (!statement) {
+        set_error(error_message, format_message("Missing statement"));
+        return -1;
+    }
+
+    NodeType kind = statement->type;
+    const Node* matrix = statement;
+    if (kind == NODE_EXISTS || kind == NODE_FORALL) {
+        matrix = collect_block(statement, result);
+        if (!matrix) {
+            free_quantifier_witness(result);
+            set_error(error_message, format_message("Out of memory collecting the quantified variables"));
+            return -1;
+        }
+    }
+
+    AIG* aig = create_aig();
+    AIGLiteral* bound = malloc((result->count > 0 ? result->count : 1) * sizeof(AIGLiteral));
+    if (!aig || !bound) {
+        free_aig(aig);
+        free(bound);
+        free_quantifier_witness(result);
+        set_error(error_message, format_message("Out of memory searching for a binding"));
+        return -1;
+    }
+
+    Scope scope = {result->names, result->count, symbol_table};
+    AIGLiteral output = aig_from_node_resolved(aig, matrix, resolve_known, &scope);
+    char* message = NULL;
+    if (output == AIG_INVALID) {
+        message = format_message("Failed to lower the statement to an And-Inverter Graph");
+    }
+    for (int i = 0; i < aig->input_count && !message; i++) {
+        if (!is_bound(&scope, aig->input_names[i])) {
+            message = format_message("Variable '%s' has no value", aig->input_names[i]);
+        }
+    }
+
+    // Bound variables the expression never reads still get an input, which
+    // the solver is free to set either way
+    for (int i = 0; i < result->count && !message; i++) {
+        bound[i] = aig_input(aig, result->names[i]);
+        if (bound[i] == AIG_INVALID) message = format_message("Out of memory searching for a binding");
+    }
+
+    if (!message) {
+        int target = kind != NODE_FORALL;
+        int found = search_binding(aig, output, bound, target, result);
+        if (found < 0) {
+            message = format_message("Out of memory searching for a binding");
+        } else if (kind == NODE_EXISTS || kind == NODE_FORALL) {
+            result->value = found ? target : !target;
+            result->has_binding = found;
+        } else {
+            result->value = found;
+        }
+    }
+
+    free_aig(aig);
+    free(bound);
+    if (message) {
+        free_quantifier_witness(result);
+        set_error(error_message, message);
+        return -1;
+    }
+    return 0;
+}
+
+void free_quantifier_witness(QuantifierWitness* result) {
+    if (!result) return;
+    for (int i = 0; i < result->count; i++) free(result->names[i]);
+    free(result->names);
+    free(result->values);
+    memset(result, 0, sizeof(QuantifierWitness));
+}
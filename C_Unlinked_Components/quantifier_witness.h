@@ -0,0 +1,32 @@
+#ifndef QUANTIFIER_WITNESS_H
+#define QUANTIFIER_WITNESS_H
+
+#include "ast.h"
+#include "symbol_table.h"
+
+// Witnesses and counterexamples for quantified statements. The leading run
+// of quantifiers of the same kind, E_Q x (E_Q y (...)) or U_Q x (U_Q y
+// (...)), is taken as one block over its bound variables. The expression
+// under the block is lowered to an And-Inverter Graph whose only inputs are
+// those variables and handed to the SAT solver, so a binding is found
+// without trying the 2^n values of the block one by one. Quantifiers further
+// down are expanded into both cofactors as usual.
+
+typedef struct {
+    int value;              // Value of the statement
+    int has_binding;        // Set for a TRUE EXISTS (witness) or a FALSE FORALL (counterexample)
+    char** names;           // Bound variables of the block, outermost first
+    int* values;            // Binding, when has_binding is set
+    int count;
+} QuantifierWitness;
+
+// Evaluate statement under symbol_table, which must define every free
+// variable, and find a binding of its leading quantifiers that makes an
+// EXISTS TRUE or a FORALL FALSE. Statements without a leading quantifier are
+// only evaluated. Returns 0, or -1 with *error_message set.
+int find_quantifier_witness(const Node* statement, SymbolTable* symbol_table, QuantifierWitness* result,
+                            char** error_message);
+
+void free_quantifier_witness(QuantifierWitness* result);
+
+#endif /* QUANTIFIER_WITNESS_H */
@@ -0,0 +1,535 @@
+#include "rewrite_engine.h"
+#include "rewrite_pattern.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_PATTERN_NODES 512
+#define TERM_SIZE_LIMIT (1 << 30)
+#define TERM_ERROR (-2)
+
+// A rule rewrites terms matching pattern into replacement (see
+// rewrite_pattern.h). Higher priorities are tried first.
+typedef struct {
+    const char* name;
+    int priority;
+    const char* pattern;
+    const char* replacement;
+} RewriteRule;
+
+static const RewriteRule rewrite_rules[] = {
+    // Identities and annihilators
+    {"AND identity", 90, "AND(a,T)", "a"},
+    {"AND annihilator", 90, "AND(a,F)", "F"},
+    {"OR identity", 90, "OR(a,F)", "a"},
+    {"OR annihilator", 90, "OR(a,T)", "T"},
+    {"XOR identity", 90, "XOR(a,F)", "a"},
+    {"XOR with TRUE", 90, "XOR(a,T)", "NOT(a)"},
+    {"IFF identity", 90, "IFF(a,T)", "a"},
+    {"IFF with FALSE", 90, "IFF(a,F)", "NOT(a)"},
+    {"Implication from TRUE", 90, "IMPLIES(T,a)", "a"},
+    {"Implication from FALSE", 90, "IMPLIES(F,a)", "T"},
+    {"Implication of TRUE", 90, "IMPLIES(a,T)", "T"},
+    {"Implication of FALSE", 90, "IMPLIES(a,F)", "NOT(a)"},
+
+    // Involution, idempotence and complements
+    {"Double negation", 80, "NOT(NOT(a))", "a"},
+    {"AND idempotence", 80, "AND(a,a)", "a"},
+    {"OR idempotence", 80, "OR(a,a)", "a"},
+    {"AND complement", 80, "AND(a,NOT(a))", "F"},
+    {"OR complement", 80, "OR(a,NOT(a))", "T"},
+    {"XOR self", 80, "XOR(a,a)", "F"},
+    {"XOR complement", 80, "XOR(a,NOT(a))", "T"},
+    {"IFF self", 80, "IFF(a,a)", "T"},
+    {"IFF complement", 80, "IFF(a,NOT(a))", "F"},
+    {"Implication self", 80, "IMPLIES(a,a)", "T"},
+    {"Implication of complement", 80, "IMPLIES(a,NOT(a))", "NOT(a)"},
+    {"Implication from complement", 80, "IMPLIES(NOT(a),a)", "a"},
+
+    // Absorption
+    {"AND absorption", 70, "AND(a,OR(a,b))", "a"},
+    {"OR absorption", 70, "OR(a,AND(a,b))", "a"},
+    {"AND absorption of complement", 70, "AND(a,OR(NOT(a),b))", "AND(a,b)"},
+    {"OR absorption of complement", 70, "OR(a,AND(NOT(a),b))", "OR(a,b)"},
+
+    // Canonical operators
+    {"XNOR as IFF", 60, "XNOR(a,b)", "IFF(a,b)"},
+    {"EQUIV as IFF", 60, "EQUIV(a,b)", "IFF(a,b)"},
+    {"Negated XOR", 60, "NOT(XOR(a,b))", "IFF(a,b)"},
+    {"Negated IFF", 60, "NOT(IFF(a,b))", "XOR(a,b)"},
+    {"XOR of negations", 60, "XOR(NOT(a),NOT(b))", "XOR(a,b)"},
+    {"IFF of negations", 60, "IFF(NOT(a),NOT(b))", "IFF(a,b)"},
+
+    // Factoring, in the direction that saves operators
+    {"De Morgan's Law (OR)", 50, "OR(NOT(a),NOT(b))", "NOT(AND(a,b))"},
+    {"De Morgan's Law (AND)", 50, "AND(NOT(a),NOT(b))", "NOT(OR(a,b))"},
+    {"Implication Law", 50, "OR(NOT(a),b)", "IMPLIES(a,b)"},
+    {"Distributive Law: AND over OR", 40, "OR(AND(a,b),AND(a,c))", "AND(a,OR(b,c))"},
+    {"Distributive Law: OR over AND", 40, "AND(OR(a,b),OR(a,c))", "OR(a,AND(b,c))"},
+};
+
+#define RULE_COUNT ((int)(sizeof(rewrite_rules) / sizeof(rewrite_rules[0])))
+
+typedef struct {
+    const RewriteRule* rule;
+    int pattern;
+    int replacement;
+    int choices;            // Number of commutative operators in the pattern
+} CompiledRule;
+
+// Rules are compiled once and shared read-only by every engine
+static PatternNode pattern_storage[MAX_PATTERN_NODES];
+static PatternPool patterns = {pattern_storage, 0, MAX_PATTERN_NODES};
+static CompiledRule compiled_rules[RULE_COUNT];
+static int rules_by_type[NODE_TYPE_COUNT + 1];  // Rules for type t are compiled_rules[rules_by_type[t]] ..
+static int rules_compiled;
+static pthread_once_t rules_once = PTHREAD_ONCE_INIT;
+
+typedef struct {
+    NodeType type;
+    int name;               // Index into names, -1 if none; into kept for thresholds
+    int bool_val;
+    int left;               // Term ids, -1 if absent
+    int right;
+    int size;               // Tree size, saturating at TERM_SIZE_LIMIT
+    int rank;               // XNOR and EQUIV nodes, which rules rewrite to IFF
+    int normal;             // Memoized normal form, -1 until computed
+} Term;
+
+struct RewriteEngine {
+    Term* terms;
+    int term_count;
+    int term_capacity;
+    int* term_slots;        // Open-addressing hash-consing index, -1 = empty
+    int term_slot_count;
+    char** names;
+    int name_count;
+    int name_capacity;
+    int* name_slots;
+    int name_slot_count;
+    Node** kept;            // Threshold expressions, which no rule applies to and are kept whole
+    int kept_count;
+    int kept_capacity;
+    int rewrite_count;
+};
+
+static int is_binary(NodeType type) {
+    return is_commutative_operator(type) || type == NODE_IMPLIES;
+}
+
+static void compile_rules(void) {
+    int order[RULE_COUNT];
+    for (int i = 0; i < RULE_COUNT; i++) order[i] = i;
+
+    // Stable insertion sort: by root operator, then descending priority
+    CompiledRule rules[RULE_COUNT];
+    for (int i = 0; i < RULE_COUNT; i++) {
+        const char* text = rewrite_rules[i].pattern;
+        rules[i].rule = &rewrite_rules[i];
+        rules[i].choices = 0;
+        rules[i].pattern = parse_rewrite_pattern(&patterns, &text, &rules[i].choices);
+        if (rules[i].pattern < 0 || *text || patterns.nodes[rules[i].pattern].kind != PATTERN_OPERATOR) return;
+        text = rewrite_rules[i].replacement;
+        rules[i].replacement = parse_rewrite_pattern(&patterns, &text, NULL);
+        if (rules[i].replacement < 0 || *text) return;
+    }
+    for (int i = 1; i < RULE_COUNT; i++) {
+        int current = order[i];
+        int j = i - 1;
+        for (; j >= 0; j--) {
+            const CompiledRule* a = &rules[order[j]];
+            const CompiledRule* b = &rules[current];
+            NodeType type_a = patterns.nodes[a->pattern].type;
+            NodeType type_b = patterns.nodes[b->pattern].type;
+            if (type_a < type_b || (type_a == type_b && a->rule->priority >= b->rule->priority)) break;
+            order[j + 1] = order[j];
+        }
+        order[j + 1] = current;
+    }
+
+    int next = 0;
+    for (int type = 0; type <= NODE_TYPE_COUNT; type++) {
+        rules_by_type[type] = next;
+        while (next < RULE_COUNT && type < NODE_TYPE_COUNT &&
+               patterns.nodes[rules[order[next]].pattern].type == (NodeType)type) {
+            compiled_rules[next] = rules[order[next]];
+            next++;
+        }
+    }
+    rules_compiled = 1;
+}
+
+static unsigned int hash_ints(const int* values, int count) {
+    // FNV-1a over the bytes of the values
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < count; i++) {
+        unsigned int value = (unsigned int)values[i];
+        for (int b = 0; b < 4; b++) {
+            hash ^= (value >> (8 * b)) & 0xff;
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+static unsigned int hash_string(const char* text) {
+    unsigned int hash = 2166136261u;
+    for (const unsigned char* p = (const unsigned char*)text; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static unsigned int term_hash(NodeType type, int name, int bool_val, int left, int right) {
+    int key[5] = {type, name, bool_val, left, right};
+    return hash_ints(key, 5);
+}
+
+// Double a hash index when it would become more than half full
+static int grow_slots(int** slots, int* slot_count, int needed) {
+    if (needed * 2 <= *slot_count) return 0;
+
+    int count = *slot_count ? *slot_count * 2 : 64;
+    while (count < needed * 2) count *= 2;
+    int* grown = malloc(count * sizeof(int));
+    if (!grown) return -1;
+    memset(grown, -1, count * sizeof(int));
+    free(*slots);
+    *slots = grown;
+    *slot_count = count;
+    return 1;
+}
+
+static int intern_name(RewriteEngine* engine, const char* name) {
+    unsigned int slot = hash_string(name) & (engine->name_slot_count - 1);
+    while (engine->name_slots[slot] != -1) {
+        if (strcmp(engine->names[engine->name_slots[slot]], name) == 0) return engine->name_slots[slot];
+        slot = (slot + 1) & (engine->name_slot_count - 1);
+    }
+
+    if (engine->name_count >= engine->name_capacity) {
+        int capacity = engine->name_capacity ? engine->name_capacity * 2 : 32;
+        char** names = realloc(engine->names, capacity * sizeof(char*));
+        if (!names) return TERM_ERROR;
+        engine->names = names;
+        engine->name_capacity = capacity;
+    }
+    char* copy = strdup(name);
+    if (!copy) return TERM_ERROR;
+
+    int rehash = grow_slots(&engine->name_slots, &engine->name_slot_count, engine->name_count + 1);
+    if (rehash < 0) {
+        free(copy);
+        return TERM_ERROR;
+    }
+    if (rehash) {
+        for (int i = 0; i < engine->name_count; i++) {
+            unsigned int s = hash_string(engine->names[i]) & (engine->name_slot_count - 1);
+            while (engine->name_slots[s] != -1) s = (s + 1) & (engine->name_slot_count - 1);
+            engine->name_slots[s] = i;
+        }
+    }
+    slot = hash_string(name) & (engine->name_slot_count - 1);
+    while (engine->name_slots[slot] != -1) slot = (slot + 1) & (engine->name_slot_count - 1);
+    engine->name_slots[slot] = engine->name_count;
+    engine->names[engine->name_count] = copy;
+    return engine->name_count++;
+}
+
+// The unique term with these fields; commutative operands are kept in id order
+static int intern_term(RewriteEngine* engine, NodeType type, int name, int bool_val, int left, int right) {
+    if (left == TERM_ERROR || right == TERM_ERROR || name == TERM_ERROR) return TERM_ERROR;
+    if (is_commutative_operator(type) && left > right) {
+        int swap = left;
+        left = right;
+        right = swap;
+    }
+    if (type != NODE_BOOL) bool_val = 0;
+
+    unsigned int hash = term_hash(type, name, bool_val, left, right);
+    unsigned int slot = hash & (engine->term_slot_count - 1);
+    while (engine->term_slots[slot] != -1) {
+        const Term* term = &engine->terms[engine->term_slots[slot]];
+        if (term->type == type && term->name == name && term->bool_val == bool_val &&
+            term->left == left && term->right == right) {
+            return engine->term_slots[slot];
+        }
+        slot = (slot + 1) & (engine->term_slot_count - 1);
+    }
+
+    if (engine->term_count >= engine->term_capacity) {
+        int capacity = engine->term_capacity ? engine->term_capacity * 2 : 256;
+        Term* terms = realloc(engine->terms, capacity * sizeof(Term));
+        if (!terms) return TERM_ERROR;
+        engine->terms = terms;
+        engine->term_capacity = capacity;
+    }
+    int rehash = grow_slots(&engine->term_slots, &engine->term_slot_count, engine->term_count + 1);
+    if (rehash < 0) return TERM_ERROR;
+    if (rehash) {
+        for (int i = 0; i < engine->term_count; i++) {
+            const Term* t = &engine->terms[i];
+            unsigned int s = term_hash(t->type, t->name, t->bool_val, t->left, t->right) & (engine->term_slot_count - 1);
+            while (engine->term_slots[s] != -1) s = (s + 1) & (engine->term_slot_count - 1);
+            engine->term_slots[s] = i;
+        }
+    }
+
+    Term* term = &engine->terms[engine->term_count];
+    term->type = type;
+    term->name = name;
+    term->bool_val = bool_val;
+    term->left = left;
+    term->right = right;
+    term->normal = -1;
+    long size = 1;
+    long rank = (type == NODE_XNOR || type == NODE_EQUIV);
+    if (left >= 0) {
+        size += engine->terms[left].size;
+        rank += engine->terms[left].rank;
+    }
+    if (right >= 0) {
+        size += engine->terms[right].size;
+        rank += engine->terms[right].rank;
+    }
+    term->size = size < TERM_SIZE_LIMIT ? (int)size : TERM_SIZE_LIMIT;
+    term->rank = rank < TERM_SIZE_LIMIT ? (int)rank : TERM_SIZE_LIMIT;
+
+    slot = hash & (engine->term_slot_count - 1);
+    while (engine->term_slots[slot] != -1) slot = (slot + 1) & (engine->term_slot_count - 1);
+    engine->term_slots[slot] = engine->term_count;
+    return engine->term_count++;
+}
+
+// A term standing for a copy of the threshold expression node
+static int intern_kept(RewriteEngine* engine, const Node* node) {
+    if (engine->kept_count >= engine->kept_capacity) {
+        int capacity = engine->kept_capacity ? engine->kept_capacity * 2 : 8;
+        Node** kept = realloc(engine->kept, capacity * sizeof(Node*));
+        if (!kept) return TERM_ERROR;
+        engine->kept = kept;
+        engine->kept_capacity = capacity;
+    }
+    Node* copy = clone_node(node);
+    if (!copy) return TERM_ERROR;
+    engine->kept[engine->kept_count] = copy;
+    return intern_term(engine, node->type, engine->kept_count++, 0, -1, -1);
+}
+
+static int intern_node(RewriteEngine* engine, const Node* node) {
+    if (!node) return -1;
+    if (is_threshold_type(node->type)) return intern_kept(engine, node);
+
+    int name = node->name ? intern_name(engine, node->name) : -1;
+    if (node->type == NODE_ASSIGN) {
+        int expression = intern_node(engine, get_assignment_expression(node));
+        return intern_term(engine, NODE_ASSIGN, name, 0, expression, -1);
+    }
+    int left = intern_node(engine, node->left);
+    int right = intern_node(engine, node->right);
+    return intern_term(engine, node->type, name, node->bool_val, left, right);
+}
+
+// Match pattern p against term t, taking operand orders from choice_mask
+static int match_pattern(const RewriteEngine* engine, int p, int t, int choice_mask, int* bindings) {
+    const PatternNode* pattern = &patterns.nodes[p];
+    const Term* term = &engine->terms[t];
+
+    switch (pattern->kind) {
+        case PATTERN_VARIABLE:
+            if (bindings[pattern->variable] < 0) {
+                bindings[pattern->variable] = t;
+                return 1;
+            }
+            return bindings[pattern->variable] == t;
+
+        case PATTERN_CONSTANT:
+            return term->type == NODE_BOOL && term->bool_val == pattern->bool_val;
+
+        case PATTERN_OPERATOR:
+            if (term->type != pattern->type || term->left < 0) return 0;
+            if (pattern->right < 0) return match_pattern(engine, pattern->left, term->left, choice_mask, bindings);
+            if (term->right < 0) return 0;
+            if (pattern->choice >= 0 && (choice_mask >> pattern->choice) & 1) {
+                return match_pattern(engine, pattern->left, term->right, choice_mask, bindings) &&
+                       match_pattern(engine, pattern->right, term->left, choice_mask, bindings);
+            }
+            return match_pattern(engine, pattern->left, term->left, choice_mask, bindings) &&
+                   match_pattern(engine, pattern->right, term->right, choice_mask, bindings);
+    }
+    return 0;
+}
+
+static int instantiate(RewriteEngine* engine, int p, const int* bindings) {
+    const PatternNode* pattern = &patterns.nodes[p];
+    switch (pattern->kind) {
+        case PATTERN_VARIABLE:
+            return bindings[pattern->variable];
+        case PATTERN_CONSTANT:
+            return intern_term(engine, NODE_BOOL, -1, pattern->bool_val, -1, -1);
+        default: {
+            int left = instantiate(engine, pattern->left, bindings);
+            int right = pattern->right >= 0 ? instantiate(engine, pattern->right, bindings) : -1;
+            return intern_term(engine, pattern->type, -1, 0, left, right);
+        }
+    }
+}
+
+static void record_step(EvaluationSteps* steps, const char* format, const char* name) {
+    if (!steps) return;
+    char description[256];
+    snprintf(description, sizeof(description), format, name);
+    add_evaluation_step(steps, description);
+}
+
+// Evaluate an operator whose operands are all constants; -1 if not applicable
+static int fold_constants(RewriteEngine* engine, int t, EvaluationSteps* steps) {
+    const Term* term = &engine->terms[t];
+    if (term->left < 0 || engine->terms[term->left].type != NODE_BOOL) return -1;
+    int left = engine->terms[term->left].bool_val;
+    int right = 0;
+    if (term->right >= 0) {
+        if (engine->terms[term->right].type != NODE_BOOL) return -1;
+        right = engine->terms[term->right].bool_val;
+    }
+
+    int value;
+    switch (term->type) {
+        case NODE_NOT: value = !left; break;
+        case NODE_AND: value = left && right; break;
+        case NODE_OR: value = left || right; break;
+        case NODE_XOR: value = left != right; break;
+        case NODE_IMPLIES: value = !left || right; break;
+        case NODE_XNOR:
+        case NODE_IFF:
+        case NODE_EQUIV: value = left == right; break;
+        case NODE_EXISTS:
+        case NODE_FORALL: value = left; break;  // The bound variable does not occur
+        default: return -1;
+    }
+    record_step(steps, "Evaluated %s operation", get_operator_name(term->type) ? get_operator_name(term->type)
+                                                                             : get_node_type_str(term->type));
+    engine->rewrite_count++;
+    return intern_term(engine, NODE_BOOL, -1, value, -1, -1);
+}
+
+static int smaller(const RewriteEngine* engine, int a, int b) {
+    const Term* x = &engine->terms[a];
+    const Term* y = &engine->terms[b];
+    return x->size < y->size || (x->size == y->size && x->rank < y->rank);
+}
+
+static int normalize(RewriteEngine* engine, int t, EvaluationSteps* steps);
+
+// Apply the first rule that matches at the root of t and shrinks it
+static int rewrite_root(RewriteEngine* engine, int t, EvaluationSteps* steps) {
+    int folded = fold_constants(engine, t, steps);
+    if (folded != -1) return folded;
+
+    NodeType type = engine->terms[t].type;
+    for (int r = rules_by_type[type]; r < rules_by_type[type + 1]; r++) {
+        const CompiledRule* rule = &compiled_rules[r];
+        for (int mask = 0; mask < (1 << rule->choices); mask++) {
+            int bindings[MAX_PATTERN_VARIABLES] = {-1, -1, -1, -1};
+            if (!match_pattern(engine, rule->pattern, t, mask, bindings)) continue;
+
+            int replacement = instantiate(engine, rule->replacement, bindings);
+            if (replacement == TERM_ERROR) return TERM_ERROR;
+            if (!smaller(engine, replacement, t)) continue;
+
+            record_step(steps, "Applied %s", rule->rule->name);
+            engine->rewrite_count++;
+            return normalize(engine, replacement, steps);
+        }
+    }
+    return t;
+}
+
+// Normal form of t: operands first, then rules at the root until none applies.
+// Every accepted rewrite shrinks the term, so this terminates.
+static int normalize(RewriteEngine* engine, int t, EvaluationSteps* steps) {
+    if (t < 0) return t;
+    if (engine->terms[t].normal >= 0) return engine->terms[t].normal;
+
+    Term term = engine->terms[t];
+    int left = normalize(engine, term.left, steps);
+    int right = normalize(engine, term.right, steps);
+    int current = intern_term(engine, term.type, term.name, term.bool_val, left, right);
+    if (current == TERM_ERROR) return TERM_ERROR;
+
+    int result = current;
+    if (term.type != NODE_VAR && term.type != NODE_BOOL && term.type != NODE_ASSIGN) {
+        result = rewrite_root(engine, current, steps);
+        if (result == TERM_ERROR) return TERM_ERROR;
+    }
+    engine->terms[t].normal = result;
+    engine->terms[current].normal = result;
+    engine->terms[result].normal = result;
+    return result;
+}
+
+static Node* build_node(const RewriteEngine* engine, int t, int under_operator) {
+    if (t < 0) return NULL;
+
+    const Term* term = &engine->terms[t];
+    if (is_threshold_type(term->type)) return clone_node(engine->kept[term->name]);
+    Node* left = build_node(engine, term->left, term->type != NODE_ASSIGN);
+    Node* right = build_node(engine, term->right, 1);
+    Node* node = create_node(term->type, term->name >= 0 ? engine->names[term->name] : NULL, left, right,
+                             term->bool_val);
+    if (!node) {
+        free_ast(left);
+        free_ast(right);
+        return NULL;
+    }
+    // Keep the tree unambiguous when printed
+    node->is_parenthesized = under_operator && is_binary(term->type);
+    return node;
+}
+
+RewriteEngine* create_rewrite_engine(void) {
+    pthread_once(&rules_once, compile_rules);
+    if (!rules_compiled) return NULL;
+
+    RewriteEngine* engine = calloc(1, sizeof(RewriteEngine));
+    if (!engine) return NULL;
+    if (grow_slots(&engine->term_slots, &engine->term_slot_count, 1) < 0 ||
+        grow_slots(&engine->name_slots, &engine->name_slot_count, 1) < 0) {
+        free_rewrite_engine(engine);
+        return NULL;
+    }
+    return engine;
+}
+
+void free_rewrite_engine(RewriteEngine* engine) {
+    if (!engine) return;
+
+    for (int i = 0; i < engine->name_count; i++) {
+        free(engine->names[i]);
+    }
+    free(engine->names);
+    free(engine->name_slots);
+    for (int i = 0; i < engine->kept_count; i++) {
+        free_ast(engine->kept[i]);
+    }
+    free(engine->kept);
+    free(engine->terms);
+    free(engine->term_slots);
+    free(engine);
+}
+
+Node* rewrite_to_normal_form(RewriteEngine* engine, const Node* node, EvaluationSteps* steps) {
+    if (!engine || !node) return NULL;
+
+    int term = intern_node(engine, node);
+    if (term < 0) return NULL;
+    term = normalize(engine, term, steps);
+    if (term < 0) return NULL;
+    return build_node(engine, term, 0);
+}
+
+int get_rewrite_count(const RewriteEngine* engine) {
+    return engine ? engine->rewrite_count : 0;
+}
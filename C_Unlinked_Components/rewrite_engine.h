@@ -0,0 +1,27 @@
+#ifndef REWRITE_ENGINE_H
+#define REWRITE_ENGINE_H
+
+#include "ast.h"
+
+// Table-driven term rewriting to a normal form.
+//
+// Expressions are hash-consed into a term store, so structurally equal
+// subtrees share one term and are normalized once. Rules are matched on node
+// shapes, commutative operators in either operand order, and tried in
+// priority order. A rewrite is only accepted if it makes the term strictly
+// smaller (then strictly less non-canonical at equal size), so
+// normalization always terminates and never grows the expression. No rule
+// applies to ATLEAST, ATMOST and EXACTLY, which are kept whole.
+typedef struct RewriteEngine RewriteEngine;
+
+RewriteEngine* create_rewrite_engine(void);
+void free_rewrite_engine(RewriteEngine* engine);
+
+// Return a newly allocated normal form of node; node itself is not modified.
+// When steps is given, the name of every rule applied is recorded in it.
+Node* rewrite_to_normal_form(RewriteEngine* engine, const Node* node, EvaluationSteps* steps);
+
+// Number of rewrites applied by the engine so far
+int get_rewrite_count(const RewriteEngine* engine);
+
+#endif /* REWRITE_ENGINE_H */
@@ -0,0 +1,78 @@
+#include "rewrite_pattern.h"
+#include <string.h>
+
+const char* get_operator_name(NodeType type) {
+    switch (type) {
+        case NODE_NOT: return "NOT";
+        case NODE_AND: return "AND";
+        case NODE_OR: return "OR";
+        case NODE_XOR: return "XOR";
+        case NODE_XNOR: return "XNOR";
+        case NODE_IMPLIES: return "IMPLIES";
+        case NODE_IFF: return "IFF";
+        case NODE_EQUIV: return "EQUIV";
+        default: return NULL;
+    }
+}
+
+int is_commutative_operator(NodeType type) {
+    return type == NODE_AND || type == NODE_OR || type == NODE_XOR || type == NODE_XNOR ||
+           type == NODE_IFF || type == NODE_EQUIV;
+}
+
+static int new_pattern_node(PatternPool* pool, PatternKind kind) {
+    if (pool->count >= pool->capacity) return -1;
+
+    PatternNode* node = &pool->nodes[pool->count];
+    memset(node, 0, sizeof(*node));
+    node->kind = kind;
+    node->left = node->right = node->choice = -1;
+    return pool->count++;
+}
+
+int parse_rewrite_pattern(PatternPool* pool, const char** text, int* choices) {
+    while (**text == ' ') (*text)++;
+
+    const char* start = *text;
+    if (*start >= 'a' && *start < 'a' + MAX_PATTERN_VARIABLES) {
+        (*text)++;
+        int index = new_pattern_node(pool, PATTERN_VARIABLE);
+        if (index >= 0) pool->nodes[index].variable = *start - 'a';
+        return index;
+    }
+
+    while (**text >= 'A' && **text <= 'Z') (*text)++;
+    size_t length = *text - start;
+    if (length == 1 && (*start == 'T' || *start == 'F')) {
+        int index = new_pattern_node(pool, PATTERN_CONSTANT);
+        if (index >= 0) pool->nodes[index].bool_val = *start == 'T';
+        return index;
+    }
+
+    NodeType type = NODE_TYPE_COUNT;
+    for (int t = 0; t < NODE_TYPE_COUNT; t++) {
+        const char* name = get_operator_name((NodeType)t);
+        if (name && strlen(name) == length && strncmp(name, start, length) == 0) type = (NodeType)t;
+    }
+    if (type == NODE_TYPE_COUNT || **text != '(') return -1;
+    (*text)++;
+
+    int index = new_pattern_node(pool, PATTERN_OPERATOR);
+    if (index < 0) return -1;
+    pool->nodes[index].type = type;
+    if (choices && is_commutative_operator(type)) pool->nodes[index].choice = (*choices)++;
+
+    int left = parse_rewrite_pattern(pool, text, choices);
+    if (left < 0) return -1;
+    pool->nodes[index].left = left;
+    if (type != NODE_NOT) {
+        if (**text != ',') return -1;
+        (*text)++;
+        int right = parse_rewrite_pattern(pool, text, choices);
+        if (right < 0) return -1;
+        pool->nodes[index].right = right;
+    }
+    if (**text != ')') return -1;
+    (*text)++;
+    return index;
+}
@@ -0,0 +1,44 @@
+#ifndef REWRITE_PATTERN_H
+#define REWRITE_PATTERN_H
+
+#include "ast.h"
+
+// Rewrite patterns are written in prefix form over the operator names, with
+// T and F for the constants and lowercase letters for subterms, e.g.
+// "AND(a,OR(a,b))". A letter used twice only matches identical subterms.
+#define MAX_PATTERN_VARIABLES 4
+
+typedef enum {
+    PATTERN_VARIABLE,
+    PATTERN_CONSTANT,
+    PATTERN_OPERATOR
+} PatternKind;
+
+typedef struct {
+    PatternKind kind;
+    NodeType type;
+    int variable;
+    int bool_val;
+    int left;               // Child pattern nodes, -1 if absent
+    int right;
+    int choice;             // Bit selecting the operand order of a commutative operator, -1 otherwise
+} PatternNode;
+
+// Caller-provided storage for parsed patterns
+typedef struct {
+    PatternNode* nodes;
+    int count;
+    int capacity;
+} PatternPool;
+
+// Parse the pattern at *text into pool and advance *text past it. When
+// choices is given, every commutative operator gets the next choice bit.
+// Returns the index of the root node, or -1 on a syntax error or a full pool.
+int parse_rewrite_pattern(PatternPool* pool, const char** text, int* choices);
+
+// Operator name used in patterns, NULL for non-operators
+const char* get_operator_name(NodeType type);
+
+int is_commutative_operator(NodeType type);
+
+#endif /* REWRITE_PATTERN_H */
@@ -0,0 +1,551 @@
+#include "sat_solver.h"
+#include <stdlib.h>
+#include <string.h>
+
+#define SAT_INITIAL_CAPACITY 64
+#define SAT_RESTART_UNIT 100        // Conflicts per step of the Luby sequence
+#define SAT_ACTIVITY_DECAY 0.95
+#define SAT_ACTIVITY_LIMIT 1e100    // Rescale all activities beyond this
+
+// Internally literal 2 * v is v and 2 * v + 1 is NOT v
+#define LITERAL_VARIABLE(literal) ((literal) >> 1)
+#define LITERAL_NEGATE(literal) ((literal) ^ 1)
+
+typedef struct {
+    int* items;
+    int count;
+    int capacity;
+} IntVector;
+
+struct SATSolver {
+    int variable_count;
+    int variable_capacity;
+    signed char* values;        // -1 unassigned, else 0 or 1
+    int* levels;
+    int* reasons;               // Clause that implied the variable, -1 for decisions
+    signed char* phases;        // Last value, tried first on the next decision
+    unsigned char* seen;
+    signed char* model;
+    double* activity;
+    double activity_increment;
+    int* heap;                  // Unassigned variables by activity, largest first
+    int* heap_positions;        // -1 when not in the heap
+    int heap_count;
+
+    IntVector* watches;         // Per literal, clauses watching it in their first two positions
+
+    int* literals;              // Clause i is literals[clause_starts[i]] .. + clause_sizes[i]
+    long literal_count;
+    long literal_capacity;
+    long* clause_starts;
+    int* clause_sizes;
+    int clause_count;
+    int clause_capacity;
+
+    int* trail;                 // Assigned literals in order
+    int trail_count;
+    int* level_starts;          // Trail position where each decision level starts
+    int level_count;
+    int propagated;             // Trail entries already propagated
+
+    IntVector learned;
+    int inconsistent;           // The clauses alone are unsatisfiable
+    int broken;                 // An allocation failed during search
+};
+
+static int vector_push(IntVector* vector, int item) {
+    if (vector->count >= vector->capacity) {
+        int capacity = vector->capacity ? vector->capacity * 2 : 4;
+        int* items = realloc(vector->items, capacity * sizeof(int));
+        if (!items) return -1;
+        vector->items = items;
+        vector->capacity = capacity;
+    }
+    vector->items[vector->count++] = item;
+    return 0;
+}
+
+static int to_internal(int literal) {
+    return literal > 0 ? 2 * literal : 2 * -literal + 1;
+}
+
+static int literal_value(const SATSolver* solver, int literal) {
+    int value = solver->values[LITERAL_VARIABLE(literal)];
+    return value < 0 ? -1 : value ^ (literal & 1);
+}
+
+static int* clause_literals(const SATSolver* solver, int clause) {
+    return solver->literals + solver->clause_starts[clause];
+}
+
+SATSolver* create_sat_solver(void) {
+    SATSolver* solver = calloc(1, sizeof(SATSolver));
+    if (!solver) return NULL;
+    solver->activity_increment = 1.0;
+    return solver;
+}
+
+void free_sat_solver(SATSolver* solver) {
+    if (!solver) return;
+    if (solver->watches) {
+        for (int i = 0; i < 2 * (solver->variable_capacity + 1); i++) free(solver->watches[i].items);
+    }
+    free(solver->watches);
+    free(solver->values);
+    free(solver->levels);
+    free(solver->reasons);
+    free(solver->phases);
+    free(solver->seen);
+    free(solver->model);
+    free(solver->activity);
+    free(solver->heap);
+    free(solver->heap_positions);
+    free(solver->literals);
+    free(solver->clause_starts);
+    free(solver->clause_sizes);
+    free(solver->trail);
+    free(solver->level_starts);
+    free(solver->learned.items);
+    free(solver);
+}
+
+// Activity heap
+
+static int heap_before(const SATSolver* solver, int a, int b) {
+    return solver->activity[a] > solver->activity[b];
+}
+
+static void heap_place(SATSolver* solver, int position, int variable) {
+    solver->heap[position] = variable;
+    solver->heap_positions[variable] = position;
+}
+
+static void heap_up(SATSolver* solver, int position) {
+    int variable = solver->heap[position];
+    while (position > 0) {
+        int parent = (position - 1) / 2;
+        if (!heap_before(solver, variable, solver->heap[parent])) break;
+        heap_place(solver, position, solver->heap[parent]);
+        position = parent;
+    }
+    heap_place(solver, position, variable);
+}
+
+static void heap_down(SATSolver* solver, int position) {
+    int variable = solver->heap[position];
+    for (;;) {
+        int child = 2 * position + 1;
+        if (child >= solver->heap_count) break;
+        if (child + 1 < solver->heap_count && heap_before(solver, solver->heap[child + 1], solver->heap[child])) {
+            child++;
+        }
+        if (!heap_before(solver, solver->heap[child], variable)) break;
+        heap_place(solver, position, solver->heap[child]);
+        position = child;
+    }
+    heap_place(solver, position, variable);
+}
+
+static void heap_insert(SATSolver* solver, int variable) {
+    if (solver->heap_positions[variable] >= 0) return;
+    heap_place(solver, solver->heap_count++, variable);
+    heap_up(solver, solver->heap_count - 1);
+}
+
+static int heap_pop(SATSolver* solver) {
+    int top = solver->heap[0];
+    solver->heap_positions[top] = -1;
+    if (--solver->heap_count > 0) {
+        heap_place(solver, 0, solver->heap[solver->heap_count]);
+        heap_down(solver, 0);
+    }
+    return top;
+}
+
+static void bump_activity(SATSolver* solver, int variable) {
+    solver->activity[variable] += solver->activity_increment;
+    if (solver->activity[variable] > SAT_ACTIVITY_LIMIT) {
+        for (int v = 1; v <= solver->variable_count; v++) solver->activity[v] /= SAT_ACTIVITY_LIMIT;
+        solver->activity_increment /= SAT_ACTIVITY_LIMIT;
+    }
+    if (solver->heap_positions[variable] >= 0) heap_up(solver, solver->heap_positions[variable]);
+}
+
+// Variables
+
+static int grow_variables(SATSolver* solver) {
+    int old_capacity = solver->variable_capacity;
+    int capacity = old_capacity ? old_capacity * 2 : SAT_INITIAL_CAPACITY;
+    size_t count = (size_t)capacity + 1;
+
+    // Each array is replaced only once it has been reallocated, so a failure
+    // leaves the solver consistent at the old capacity
+#define GROW(field, type) do { \
+        type* grown = realloc(solver->field, count * sizeof(type)); \
+        if (!grown) return -1; \
+        solver->field = grown; \
+    } while (0)
+    GROW(values, signed char);
+    GROW(levels, int);
+    GROW(reasons, int);
+    GROW(phases, signed char);
+    GROW(seen, unsigned char);
+    GROW(model, signed char);
+    GROW(activity, double);
+    GROW(heap, int);
+    GROW(heap_positions, int);
+    GROW(trail, int);
+    GROW(level_starts, int);
+#undef GROW
+
+    IntVector* watches = realloc(solver->watches, 2 * count * sizeof(IntVector));
+    if (!watches) return -1;
+    size_t old_watch_count = old_capacity ? 2 * ((size_t)old_capacity + 1) : 0;
+    memset(watches + old_watch_count, 0, (2 * count - old_watch_count) * sizeof(IntVector));
+    solver->watches = watches;
+    solver->variable_capacity = capacity;
+    return 0;
+}
+
+int sat_new_variable(SATSolver* solver) {
+    if (solver->variable_count >= solver->variable_capacity && grow_variables(solver) != 0) return -1;
+    int variable = ++solver->variable_count;
+    solver->values[variable] = -1;
+    solver->levels[variable] = 0;
+    solver->reasons[variable] = -1;
+    solver->phases[variable] = 0;
+    solver->seen[variable] = 0;
+    solver->model[variable] = 0;
+    solver->activity[variable] = 0.0;
+    solver->heap_positions[variable] = -1;
+    heap_insert(solver, variable);
+    return variable;
+}
+
+// Assignment and propagation
+
+static void assign(SATSolver* solver, int literal, int reason) {
+    int variable = LITERAL_VARIABLE(literal);
+    solver->values[variable] = !(literal & 1);
+    solver->levels[variable] = solver->level_count;
+    solver->reasons[variable] = reason;
+    solver->trail[solver->trail_count++] = literal;
+}
+
+static void backtrack(SATSolver* solver, int level) {
+    if (solver->level_count <= level) return;
+    int start = solver->level_starts[level];
+    for (int i = solver->trail_count - 1; i >= start; i--) {
+        int variable = LITERAL_VARIABLE(solver->trail[i]);
+        solver->phases[variable] = solver->values[variable];
+        solver->values[variable] = -1;
+        heap_insert(solver, variable);
+    }
+    solver->trail_count = start;
+    solver->propagated = start;
+    solver->level_count = level;
+}
+
+static void new_level(SATSolver* solver) {
+    solver->level_starts[solver->level_count++] = solver->trail_count;
+}
+
+// Propagate the trail; returns a falsified clause or -1
+static int propagate(SATSolver* solver) {
+    while (solver->propagated < solver->trail_count) {
+        int false_literal = LITERAL_NEGATE(solver->trail[solver->propagated++]);
+        IntVector* watching = &solver->watches[false_literal];
+        int kept = 0;
+        int i = 0;
+        while (i < watching->count) {
+            int clause = watching->items[i++];
+            int* literals = clause_literals(solver, clause);
+            int size = solver->clause_sizes[clause];
+
+            // Keep the false literal second
+            if (literals[0] == false_literal) {
+                literals[0] = literals[1];
+                literals[1] = false_literal;
+            }
+            if (literal_value(solver, literals[0]) == 1) {
+                watching->items[kept++] = clause;
+                continue;
+            }
+
+            int moved = 0;
+            for (int k = 2; k < size; k++) {
+                if (literal_value(solver, literals[k]) != 0) {
+                    literals[1] = literals[k];
+                    literals[k] = false_literal;
+                    if (vector_push(&solver->watches[literals[1]], clause) != 0) {
+                        // Undo and stop; the search gives up on a broken solver
+                        literals[k] = literals[1];
+                        literals[1] = false_literal;
+                        solver->broken = 1;
+                        break;
+                    }
+                    moved = 1;
+                    break;
+                }
+            }
+            if (moved) continue;
+
+            watching->items[kept++] = clause;
+            if (literal_value(solver, literals[0]) == 0) {
+                while (i < watching->count) watching->items[kept++] = watching->items[i++];
+                watching->count = kept;
+                return clause;
+            }
+            assign(solver, literals[0], clause);
+        }
+        watching->count = kept;
+    }
+    return -1;
+}
+
+// Clauses
+
+static int store_clause(SATSolver* solver, const int* literals, int count) {
+    if (solver->clause_count >= solver->clause_capacity) {
+        int capacity = solver->clause_capacity ? solver->clause_capacity * 2 : SAT_INITIAL_CAPACITY;
+        long* starts = realloc(solver->clause_starts, capacity * sizeof(long));
+        if (!starts) return -1;
+        solver->clause_starts = starts;
+        int* sizes = realloc(solver->clause_sizes, capacity * sizeof(int));
+        if (!sizes) return -1;
+        solver->clause_sizes = sizes;
+        solver->clause_capacity = capacity;
+    }
+    if (solver->literal_count + count > solver->literal_capacity) {
+        long capacity = solver->literal_capacity ? solver->literal_capacity * 2 : 4 * SAT_INITIAL_CAPACITY;
+        while (capacity < solver->literal_count + count) capacity *= 2;
+        int* grown = realloc(solver->literals, capacity * sizeof(int));
+        if (!grown) return -1;
+        solver->literals = grown;
+        solver->literal_capacity = capacity;
+    }
+
+    int clause = solver->clause_count;
+    solver->clause_starts[clause] = solver->literal_count;
+    solver->clause_sizes[clause] = count;
+    memcpy(solver->literals + solver->literal_count, literals, count * sizeof(int));
+    if (vector_push(&solver->watches[literals[0]], clause) != 0) return -1;
+    if (vector_push(&solver->watches[literals[1]], clause) != 0) {
+        solver->watches[literals[0]].count--;
+        return -1;
+    }
+    solver->literal_count += count;
+    solver->clause_count++;
+    return clause;
+}
+
+static int compare_ints(const void* a, const void* b) {
+    int x = *(const int*)a;
+    int y = *(const int*)b;
+    return (x > y) - (x < y);
+}
+
+int sat_add_clause(SATSolver* solver, const int* literals, int count) {
+    if (solver->inconsistent) return 0;
+    backtrack(solver, 0);
+
+    int* clause = malloc((count > 0 ? count : 1) * sizeof(int));
+    if (!clause) return -1;
+    for (int i = 0; i < count; i++) {
+        int variable = literals[i] > 0 ? literals[i] : -literals[i];
+        if (variable == 0 || variable > solver->variable_count) {
+            free(clause);
+            return -1;
+        }
+        clause[i] = to_internal(literals[i]);
+    }
+
+    // Drop duplicates and literals false at level 0; a tautology or a
+    // literal true at level 0 satisfies the clause
+    qsort(clause, count, sizeof(int), compare_ints);
+    int size = 0;
+    for (int i = 0; i < count; i++) {
+        int value = literal_value(solver, clause[i]);
+        if (value == 1 || (size > 0 && clause[size - 1] == LITERAL_NEGATE(clause[i]))) {
+            free(clause);
+            return 0;
+        }
+        if (value == 0 || (size > 0 && clause[size - 1] == clause[i])) continue;
+        clause[size++] = clause[i];
+    }
+
+    int status = 0;
+    if (size == 0) {
+        solver->inconsistent = 1;
+    } else if (size == 1) {
+        assign(solver, clause[0], -1);
+        if (propagate(solver) >= 0) solver->inconsistent = 1;
+        if (solver->broken) status = -1;
+    } else if (store_clause(solver, clause, size) < 0) {
+        status = -1;
+    }
+    free(clause);
+    return status;
+}
+
+// Search
+
+// Learn the first-UIP clause of conflict into solver->learned, asserting
+// literal first and the literal of the backtrack level second. Returns the
+// backtrack level, or -1 when out of memory.
+static int analyze(SATSolver* solver, int conflict) {
+    IntVector* learned = &solver->learned;
+    learned->count = 0;
+    if (vector_push(learned, 0) != 0) return -1;
+
+    int pending = 0;
+    int literal = -1;
+    int index = solver->trail_count - 1;
+    int clause = conflict;
+    do {
+        int* literals = clause_literals(solver, clause);
+        int size = solver->clause_sizes[clause];
+        // The first literal of a reason clause is the one it implied
+        for (int k = literal < 0 ? 0 : 1; k < size; k++) {
+            int variable = LITERAL_VARIABLE(literals[k]);
+            if (solver->seen[variable] || solver->levels[variable] == 0) continue;
+            solver->seen[variable] = 1;
+            bump_activity(solver, variable);
+            if (solver->levels[variable] >= solver->level_count) {
+                pending++;
+            } else if (vector_push(learned, literals[k]) != 0) {
+                for (int i = 1; i < learned->count; i++) solver->seen[LITERAL_VARIABLE(learned->items[i])] = 0;
+                for (int i = index; i >= 0; i--) solver->seen[LITERAL_VARIABLE(solver->trail[i])] = 0;
+                return -1;
+            }
+        }
+        while (!solver->seen[LITERAL_VARIABLE(solver->trail[index])]) index--;
+        literal = solver->trail[index--];
+        clause = solver->reasons[LITERAL_VARIABLE(literal)];
+        solver->seen[LITERAL_VARIABLE(literal)] = 0;
+        pending--;
+    } while (pending > 0);
+    learned->items[0] = LITERAL_NEGATE(literal);
+
+    int level = 0;
+    for (int i = 1; i < learned->count; i++) {
+        int variable = LITERAL_VARIABLE(learned->items[i]);
+        solver->seen[variable] = 0;
+        if (solver->levels[variable] > level) {
+            level = solver->levels[variable];
+            int swap = learned->items[1];
+            learned->items[1] = learned->items[i];
+            learned->items[i] = swap;
+        }
+    }
+    return level;
+}
+
+// Element i of the Luby sequence 1 1 2 1 1 2 4 1 1 2 ...
+static long luby(long i) {
+    long size = 1;
+    int exponent = 0;
+    while (size < i + 1) {
+        size = 2 * size + 1;
+        exponent++;
+    }
+    while (size - 1 != i) {
+        size = (size - 1) / 2;
+        exponent--;
+        i %= size;
+    }
+    return 1L << exponent;
+}
+
+static int pick_branch(SATSolver* solver) {
+    while (solver->heap_count > 0) {
+        int variable = heap_pop(solver);
+        if (solver->values[variable] < 0) return 2 * variable + !solver->phases[variable];
+    }
+    return -1;
+}
+
+SATResult sat_solve(SATSolver* solver, const int* assumptions, int assumption_count, long conflict_limit) {
+    if (solver->broken) return SAT_UNKNOWN;
+    if (solver->inconsistent) return SAT_UNSATISFIABLE;
+    for (int i = 0; i < assumption_count; i++) {
+        int variable = assumptions[i] > 0 ? assumptions[i] : -assumptions[i];
+        if (variable == 0 || variable > solver->variable_count) return SAT_UNKNOWN;
+    }
+    backtrack(solver, 0);
+
+    long conflicts = 0;
+    long restarts = 0;
+    long next_restart = SAT_RESTART_UNIT * luby(0);
+    for (;;) {
+        int conflict = propagate(solver);
+        if (solver->broken) break;
+
+        if (conflict >= 0) {
+            conflicts++;
+            if (solver->level_count == 0) {
+                solver->inconsistent = 1;
+                return SAT_UNSATISFIABLE;
+            }
+            int level = analyze(solver, conflict);
+            if (level < 0) {
+                solver->broken = 1;
+                break;
+            }
+            backtrack(solver, level);
+            if (solver->learned.count == 1) {
+                assign(solver, solver->learned.items[0], -1);
+            } else {
+                int clause = store_clause(solver, solver->learned.items, solver->learned.count);
+                if (clause < 0) {
+                    solver->broken = 1;
+                    break;
+                }
+                assign(solver, solver->learned.items[0], clause);
+            }
+            solver->activity_increment /= SAT_ACTIVITY_DECAY;
+
+            if (conflict_limit > 0 && conflicts >= conflict_limit) break;
+            continue;
+        }
+
+        if (conflicts >= next_restart) {
+            restarts++;
+            next_restart = conflicts + SAT_RESTART_UNIT * luby(restarts);
+            backtrack(solver, 0);
+            continue;
+        }
+
+        // Assumptions take the first decision levels
+        int decision = -1;
+        while (solver->level_count < assumption_count) {
+            int literal = to_internal(assumptions[solver->level_count]);
+            int value = literal_value(solver, literal);
+            if (value == 0) {
+                backtrack(solver, 0);
+                return SAT_UNSATISFIABLE;
+            }
+            if (value < 0) {
+                decision = literal;
+                break;
+            }
+            new_level(solver);
+        }
+        if (decision < 0) decision = pick_branch(solver);
+        if (decision < 0) {
+            for (int v = 1; v <= solver->variable_count; v++) solver->model[v] = solver->values[v];
+            backtrack(solver, 0);
+            return SAT_SATISFIABLE;
+        }
+        new_level(solver);
+        assign(solver, decision, -1);
+    }
+
+    backtrack(solver, 0);
+    return SAT_UNKNOWN;
+}
+
+int sat_model_value(const SATSolver* solver, int variable) {
+    if (variable < 1 || variable > solver->variable_count) return 0;
+    return solver->model[variable] == 1;
+}
@@ -0,0 +1,37 @@
+#ifndef SAT_SOLVER_H
+#define SAT_SOLVER_H
+
+// Conflict-driven clause learning SAT solver: two watched literals per
+// clause, first-UIP learning, activity-based branching with phase saving and
+// Luby restarts. Literals follow DIMACS like the CNF converter: variable v is
+// v and its negation -v, and variables are numbered from 1.
+//
+// The solver is incremental. Clauses can be added between calls, learned
+// clauses are kept, and each call may assume some literals that only hold
+// for that call.
+typedef struct SATSolver SATSolver;
+
+typedef enum {
+    SAT_UNKNOWN,            // Conflict limit reached or out of memory
+    SAT_SATISFIABLE,
+    SAT_UNSATISFIABLE
+} SATResult;
+
+SATSolver* create_sat_solver(void);
+void free_sat_solver(SATSolver* solver);
+
+// Add a variable and return its number, or -1 when out of memory
+int sat_new_variable(SATSolver* solver);
+
+// Add a clause over existing variables; returns 0, or -1 when out of memory
+// or for an unknown variable
+int sat_add_clause(SATSolver* solver, const int* literals, int count);
+
+// Look for an assignment satisfying the clauses and the assumptions. Stops
+// with SAT_UNKNOWN after conflict_limit conflicts unless it is 0.
+SATResult sat_solve(SATSolver* solver, const int* assumptions, int assumption_count, long conflict_limit);
+
+// Value of variable in the model of the last satisfiable sat_solve
+int sat_model_value(const SATSolver* solver, int variable);
+
+#endif /* SAT_SOLVER_H */
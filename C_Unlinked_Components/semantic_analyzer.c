@@ -4,113 +4,49 @@
 #include "semantic_analyzer.h"
 #include "ast.h"
 #include "symbol_table.h"
+#include "thread_pool.h"
+#include "error_message.h"
 
-// Pre-process the AST to build the symbol table from assignments
-void preprocess_symbol_table(Node* node, SymbolTable* symbol_table) {
-    if (!node) return;
-    
-    // Process assignment nodes
-    if (node->type == NODE_ASSIGN && node->name) {
-        int value = 0;
-        // If the right side is a boolean literal, use its value
-        if (node->right && node->right->type == NODE_BOOL) {
-            value = node->right->bool_val;
-        }
-        // Add the variable to the symbol table
-        add_or_update_symbol(symbol_table, node->name, value);
-    }
-    
-    // Recursively process child nodes
-    if (node->left) preprocess_symbol_table(node->left, symbol_table);
-    if (node->right) preprocess_symbol_table(node->right, symbol_table);
-}
+// Statements analyzed per thread pool job, at least
+#define SEMANTIC_CHUNK_MIN_STATEMENTS 256
 
-SemanticAnalysisResult perform_semantic_analysis(Node* ast, SymbolTable* symbol_table) {
-    SemanticAnalysisResult result = {SEMANTIC_OK, NULL};
+// Traversal stages of a node on the analyzer stack
+typedef enum {
+    VISIT_ENTER,    // Before the left child
+    VISIT_BETWEEN,  // After the left child, before the right child (or the next operand)
+    VISIT_EXIT      // After all children
+} VisitStage;
 
-    if (!ast) {
-        result.error_code = SEMANTIC_INVALID_QUANTIFIER;
-        result.error_message = strdup("Invalid AST: NULL node");
-        return result;
-    }
+typedef struct {
+    Node* node;
+    VisitStage stage;
+    bool check_ambiguity;   // Node is reached without crossing explicit parentheses
+    int operand;            // Next operand of an n-ary node
+} VisitFrame;
 
-    // First, preprocess the AST to build the symbol table from assignments
-    preprocess_symbol_table(ast, symbol_table);
-    
-    // Validate variable usage
-    if (!validate_variable_usage(ast, symbol_table)) {
-        result.error_code = SEMANTIC_UNDEFINED_VARIABLE;
-        result.error_message = strdup("Undefined variable used in expression");
-        return result;
-    }
+struct SemanticAnalyzer {
+    const SymbolSnapshot* symbols;  // Frozen, shared with other analyzers
 
-    // Validate quantifier expressions
-    if (!validate_quantifier_expression(ast, symbol_table)) {
-        result.error_code = SEMANTIC_INVALID_QUANTIFIER;
-        result.error_message = strdup("Invalid quantifier expression");
-        return result;
-    }
-    
-    // Check for ambiguous expressions that should have parentheses
-    bool ambiguous = false;
-    if (!check_ambiguous_expression(ast, &ambiguous) && ambiguous) {
-        char* parenthesized = generate_parenthesized_expression(ast);
-        if (parenthesized) {
-            char* error_msg = malloc(strlen(parenthesized) + 100);
-            if (error_msg) {
-                sprintf(error_msg, "Ambiguous expression detected. Please use parentheses to clarify. Suggested: %s", parenthesized);
-                result.error_code = SEMANTIC_AMBIGUOUS_EXPRESSION;
-                result.error_message = error_msg;
-            }
-            free(parenthesized);
-            return result;
-        } else {
-            result.error_code = SEMANTIC_AMBIGUOUS_EXPRESSION;
-            result.error_message = strdup("Ambiguous expression detected. Please use parentheses to clarify precedence.");
-            return result;
-        }
-    }
-
-    return result;
-}
-
-bool validate_variable_usage(Node* node, SymbolTable* symbol_table) {
-    if (!node) return true;
-
-    switch (node->type) {
-        case NODE_VAR:
-            // Check if variable exists in symbol table using the refactored function
-            if (get_symbol_value(symbol_table, node->name) == ERROR_SYMBOL_NOT_FOUND) {
-                return false;
-            }
-            return true;
+    // Variables bound by the enclosing quantifiers of the current node
+    const char** scope;
+    int scope_size;
+    int scope_capacity;
 
-        case NODE_ASSIGN:
-            // For assignments, add the variable to the symbol table and validate the right side
-            if (node->right) {
-                // Evaluate the right side first to ensure it's valid
-                if (!validate_variable_usage(node->right, symbol_table)) {
-                    return false;
-                }
-                
-                // Determine the boolean value (assuming right node has been evaluated)
-                int value = 0;
-                if (node->right->type == NODE_BOOL) {
-                    value = node->right->bool_val;
-                }
-                
-                // Add or update the symbol in the table
-                int result = add_or_update_symbol(symbol_table, node->name, value);
-                if (result < 0) {
-                    return false; // Failed to add to symbol table
-                }
-                return true;
-            }
-            return false;
+    // Explicit node stack shared by all statements
+    VisitFrame* stack;
+    int stack_size;
+    int stack_capacity;
 
-        case NODE_NOT:
-            return validate_variable_usage(node->left, symbol_table);
+    // Fully parenthesized rendering of the current statement, used as the
+    // suggestion when it turns out to be ambiguous
+    char* text;
+    size_t text_length;
+    size_t text_capacity;
+    int text_suppressed;    // Inside a node rendered as a placeholder
+};
 
+static bool is_binary_operator(NodeType type) {
+    switch (type) {
         case NODE_AND:
         case NODE_OR:
         case NODE_XOR:
@@ -118,280 +54,438 @@ bool validate_variable_usage(Node* node, SymbolTable* symbol_table) {
         case NODE_IMPLIES:
         case NODE_IFF:
         case NODE_EQUIV:
-            return validate_variable_usage(node->left, symbol_table) &&
-                   validate_variable_usage(node->right, symbol_table);
-
-        case NODE_EXISTS:
-        case NODE_FORALL:
-            // Add variable to symbol table for the quantified expression using refactored function
-            if (add_or_update_symbol(symbol_table, node->name, 0) < 0) {
-                return false;
-            }
-            return validate_variable_usage(node->left, symbol_table);
-
-        case NODE_BOOL:
-            // Boolean literals are always valid
             return true;
-
         default:
-            return true;
+            return false;
     }
 }
 
-bool validate_quantifier_expression(Node* node, SymbolTable* symbol_table) {
-    if (!node) return true;
+static bool is_low_precedence_operator(NodeType type) {
+    return type == NODE_IMPLIES || type == NODE_IFF || type == NODE_EQUIV;
+}
 
-    switch (node->type) {
-        case NODE_EXISTS:
-        case NODE_FORALL:
-            // Ensure quantified variable is used in the expression
-            if (!node->left || !node->name) return false;
-            return true;
+// Whether the operands of node need explicit parentheses to be unambiguous.
+// NOT needs them around any binary operator; IMPLIES/IFF/EQUIV need them
+// around a low-precedence left operand and any binary right operand;
+// AND/OR/XOR/XNOR need them around low-precedence operands.
+static bool has_ambiguous_operand(const Node* node) {
+    const Node* left = node->left;
+    const Node* right = node->right;
 
+    switch (node->type) {
         case NODE_NOT:
-            return validate_quantifier_expression(node->left, symbol_table);
+            return left && is_binary_operator(left->type);
+
+        case NODE_IMPLIES:
+        case NODE_IFF:
+        case NODE_EQUIV:
+            return (left && is_low_precedence_operator(left->type)) ||
+                   (right && is_binary_operator(right->type));
 
         case NODE_AND:
         case NODE_OR:
         case NODE_XOR:
         case NODE_XNOR:
-        case NODE_IMPLIES:
-        case NODE_IFF:
-        case NODE_EQUIV:
-            return validate_quantifier_expression(node->left, symbol_table) &&
-                   validate_quantifier_expression(node->right, symbol_table);
+            return (left && is_low_precedence_operator(left->type)) ||
+                   (right && is_low_precedence_operator(right->type));
 
         default:
-            return true;
+            return false;
+    }
+}
+
+static void append_text(SemanticAnalyzer* analyzer, const char* text) {
+    if (analyzer->text_suppressed || !analyzer->text) return;
+
+    size_t length = strlen(text);
+    if (analyzer->text_length + length + 1 > analyzer->text_capacity) {
+        size_t capacity = analyzer->text_capacity * 2;
+        while (analyzer->text_length + length + 1 > capacity) capacity *= 2;
+        char* grown = realloc(analyzer->text, capacity);
+        if (!grown) {
+            // Without a suggestion the generic ambiguity message is used
+            free(analyzer->text);
+            analyzer->text = NULL;
+            return;
+        }
+        analyzer->text = grown;
+        analyzer->text_capacity = capacity;
+    }
+    memcpy(analyzer->text + analyzer->text_length, text, length + 1);
+    analyzer->text_length += length;
+}
+
+// Separator written between the operands of a binary node
+static const char* binary_separator(NodeType type) {
+    switch (type) {
+        case NODE_AND: return ") AND (";
+        case NODE_OR: return ") OR (";
+        case NODE_XOR: return ") XOR (";
+        case NODE_IMPLIES: return ") -> (";
+        case NODE_IFF:
+        case NODE_EQUIV: return ") <-> (";
+        default: return NULL;
+    }
+}
+
+static bool push_frame(SemanticAnalyzer* analyzer, Node* node, bool check_ambiguity) {
+    if (analyzer->stack_size == analyzer->stack_capacity) {
+        int capacity = analyzer->stack_capacity * 2;
+        VisitFrame* grown = realloc(analyzer->stack, capacity * sizeof(VisitFrame));
+        if (!grown) return false;
+        analyzer->stack = grown;
+        analyzer->stack_capacity = capacity;
+    }
+    VisitFrame* frame = &analyzer->stack[analyzer->stack_size++];
+    frame->node = node;
+    frame->stage = VISIT_ENTER;
+    frame->operand = 0;
+    frame->check_ambiguity = check_ambiguity && !node->is_parenthesized;
+    return true;
+}
+
+static void add_diagnostic(SemanticAnalysisResult* result, SemanticErrorCode code, char* message) {
+    if (!message) return;
+
+    // Report a repeated problem, such as the same undefined variable, once
+    for (int i = 0; i < result->diagnostic_count; i++) {
+        if (result->diagnostics[i].code == code && strcmp(result->diagnostics[i].message, message) == 0) {
+            free(message);
+            return;
+        }
+    }
+
+    SemanticDiagnostic* grown = realloc(result->diagnostics,
+                                        (result->diagnostic_count + 1) * sizeof(SemanticDiagnostic));
+    if (!grown) {
+        free(message);
+        return;
+    }
+    result->diagnostics = grown;
+    result->diagnostics[result->diagnostic_count].code = code;
+    result->diagnostics[result->diagnostic_count].message = message;
+    result->diagnostic_count++;
+}
+
+static bool is_defined(const SemanticAnalyzer* analyzer, const char* name) {
+    for (int i = analyzer->scope_size - 1; i >= 0; i--) {
+        if (strcmp(analyzer->scope[i], name) == 0) return true;
     }
+    return get_snapshot_value(analyzer->symbols, name) != ERROR_SYMBOL_NOT_FOUND;
 }
 
-// Function to check if an expression is ambiguous (e.g. needs parentheses)
-bool check_ambiguous_expression(Node* node, bool* ambiguous) {
-    if (!node) return true;
-    
-    // Initialize ambiguous flag to false if not already set
-    if (!ambiguous) return false;
-    
-    // If the node is explicitly parenthesized, it's not ambiguous
-    if (node->is_parenthesized) {
-        return true;
+static bool push_scope(SemanticAnalyzer* analyzer, const char* name) {
+    if (analyzer->scope_size == analyzer->scope_capacity) {
+        int capacity = analyzer->scope_capacity ? analyzer->scope_capacity * 2 : 8;
+        const char** grown = realloc(analyzer->scope, capacity * sizeof(const char*));
+        if (!grown) return false;
+        analyzer->scope = grown;
+        analyzer->scope_capacity = capacity;
     }
-    
+    analyzer->scope[analyzer->scope_size++] = name;
+    return true;
+}
+
+// Enter a node: check it and render its prefix
+static void enter_node(SemanticAnalyzer* analyzer, const VisitFrame* frame, SemanticAnalysisResult* result,
+                       bool* ambiguous) {
+    Node* node = frame->node;
+
+    if (frame->check_ambiguity && has_ambiguous_operand(node)) {
+        *ambiguous = true;
+    }
+
     switch (node->type) {
         case NODE_VAR:
+            if (!is_defined(analyzer, node->name)) {
+                add_diagnostic(result, SEMANTIC_UNDEFINED_VARIABLE,
+                               format_message("Undefined variable '%s' used in expression", node->name));
+            }
+            append_text(analyzer, node->name);
+            break;
+
         case NODE_BOOL:
+            append_text(analyzer, node->bool_val ? "TRUE" : "FALSE");
+            break;
+
         case NODE_ASSIGN:
-            // These are not ambiguous
-            return true;
-            
-        case NODE_NOT:
-            // For NOT nodes, only require parentheses around other operators
-            // Allow NOT without parentheses for variables, booleans, and other NOTs
-            if (node->left) {
-                // If the left child is a binary operator, it needs parentheses
-                if (node->left->type == NODE_AND || node->left->type == NODE_OR ||
-                    node->left->type == NODE_XOR || node->left->type == NODE_XNOR ||
-                    node->left->type == NODE_IMPLIES || node->left->type == NODE_IFF ||
-                    node->left->type == NODE_EQUIV) {
-                    *ambiguous = true;
-                    return false;
-                }
-                // For other cases (variables, booleans, or other NOTs), continue checking
-                return check_ambiguous_expression(node->left, ambiguous);
-            }
-            return true;
-            
-        case NODE_IMPLIES:
-        case NODE_IFF:
-        case NODE_EQUIV: {
-            // These operators have lower precedence, so their operands might need parentheses
-            bool left_ok = true;
-            bool right_ok = true;
-            
-            // Check left child
-            if (node->left) {
-                // Left side needs parentheses if it's a binary operator with lower or equal precedence
-                if (node->left->type == NODE_IMPLIES || node->left->type == NODE_IFF || 
-                    node->left->type == NODE_EQUIV) {
-                    *ambiguous = true;
-                    return false;
-                }
-                left_ok = check_ambiguous_expression(node->left, ambiguous);
-            }
-            
-            // Check right child
-            if (node->right) {
-                // Right side needs parentheses if it's a binary operator
-                if (node->right->type == NODE_AND || node->right->type == NODE_OR ||
-                    node->right->type == NODE_XOR || node->right->type == NODE_XNOR ||
-                    node->right->type == NODE_IMPLIES || node->right->type == NODE_IFF ||
-                    node->right->type == NODE_EQUIV) {
-                    *ambiguous = true;
-                    return false;
-                }
-                right_ok = check_ambiguous_expression(node->right, ambiguous);
-            }
-            
-            return left_ok && right_ok;
-        }
-            
-        case NODE_AND:
-        case NODE_OR:
-        case NODE_XOR:
-        case NODE_XNOR: {
-            // These operators have higher precedence
-            bool left_ok = true;
-            bool right_ok = true;
-            
-            // Check left child
-            if (node->left) {
-                // Left side needs parentheses if it's a binary operator with lower precedence
-                if (node->left->type == NODE_IMPLIES || node->left->type == NODE_IFF || 
-                    node->left->type == NODE_EQUIV) {
-                    *ambiguous = true;
-                    return false;
-                }
-                left_ok = check_ambiguous_expression(node->left, ambiguous);
+            // Assignments were entered into the symbol table while parsing
+            if (!get_assignment_expression(node)) {
+                add_diagnostic(result, SEMANTIC_UNDEFINED_VARIABLE,
+                               format_message("Invalid assignment to '%s'", node->name ? node->name : "?"));
             }
-            
-            // Check right child
-            if (node->right) {
-                // Right side needs parentheses if it's a binary operator with lower or equal precedence
-                if (node->right->type == NODE_IMPLIES || node->right->type == NODE_IFF || 
-                    node->right->type == NODE_EQUIV) {
-                    *ambiguous = true;
-                    return false;
-                }
-                right_ok = check_ambiguous_expression(node->right, ambiguous);
+            append_text(analyzer, node->name ? node->name : "?");
+            append_text(analyzer, " = ");
+            break;
+
+        case NODE_EXISTS:
+        case NODE_FORALL:
+            if (!node->left || !node->name) {
+                add_diagnostic(result, SEMANTIC_INVALID_QUANTIFIER,
+                               format_message("Invalid quantifier expression over '%s'",
+                                              node->name ? node->name : "?"));
+            } else if (!push_scope(analyzer, node->name)) {
+                // The bound variable is visible in the quantified expression only
+                add_diagnostic(result, SEMANTIC_TYPE_MISMATCH, strdup("Out of memory during semantic analysis"));
             }
-            
-            return left_ok && right_ok;
+            append_text(analyzer, "UNKNOWN");
+            analyzer->text_suppressed++;
+            break;
+
+        case NODE_NOT:
+            append_text(analyzer, "NOT (");
+            break;
+
+        case NODE_XNOR:
+            append_text(analyzer, "UNKNOWN");
+            analyzer->text_suppressed++;
+            break;
+
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY: {
+            char prefix[32];
+            snprintf(prefix, sizeof(prefix), "%s %d (",
+                     node->type == NODE_ATLEAST ? "ATLEAST" : node->type == NODE_ATMOST ? "ATMOST" : "EXACTLY",
+                     node->threshold);
+            append_text(analyzer, prefix);
+            break;
         }
-            
+
         default:
-            return true;
+            if (is_binary_operator(node->type)) {
+                append_text(analyzer, "(");
+            }
+            break;
     }
 }
 
-// Function to generate a fully parenthesized expression string
-char* generate_parenthesized_expression(Node* node) {
-    if (!node) return NULL;
-    
-    char* left_str = NULL;
-    char* right_str = NULL;
-    char* result = NULL;
-    
+// Leave a node: render its suffix
+static void exit_node(SemanticAnalyzer* analyzer, const Node* node) {
     switch (node->type) {
-        case NODE_BOOL:
-            result = strdup(node->bool_val ? "TRUE" : "FALSE");
+        case NODE_EXISTS:
+        case NODE_FORALL:
+            if (analyzer->scope_size > 0 && analyzer->scope[analyzer->scope_size - 1] == node->name) {
+                analyzer->scope_size--;
+            }
+            analyzer->text_suppressed--;
             break;
-            
-        case NODE_VAR:
-            result = strdup(node->name);
+        case NODE_XNOR:
+            analyzer->text_suppressed--;
             break;
-            
         case NODE_NOT:
-            left_str = generate_parenthesized_expression(node->left);
-            if (left_str) {
-                // Always add parentheses around NOT expressions
-                result = malloc(strlen(left_str) + 10); // NOT + ( + ) + null terminator
-                if (result) {
-                    sprintf(result, "NOT (%s)", left_str);
-                }
-                free(left_str);
-            }
-            break;
-            
         case NODE_AND:
-            left_str = generate_parenthesized_expression(node->left);
-            right_str = generate_parenthesized_expression(node->right);
-            if (left_str && right_str) {
-                // Always add parentheses around AND expressions
-                result = malloc(strlen(left_str) + strlen(right_str) + 10);
-                if (result) {
-                    sprintf(result, "(%s) AND (%s)", left_str, right_str);
-                }
-                free(left_str);
-                free(right_str);
-            }
-            break;
-            
         case NODE_OR:
-            left_str = generate_parenthesized_expression(node->left);
-            right_str = generate_parenthesized_expression(node->right);
-            if (left_str && right_str) {
-                // Always add parentheses around OR expressions
-                result = malloc(strlen(left_str) + strlen(right_str) + 10);
-                if (result) {
-                    sprintf(result, "(%s) OR (%s)", left_str, right_str);
-                }
-                free(left_str);
-                free(right_str);
-            }
-            break;
-            
         case NODE_XOR:
-            left_str = generate_parenthesized_expression(node->left);
-            right_str = generate_parenthesized_expression(node->right);
-            if (left_str && right_str) {
-                // Always add parentheses around XOR expressions
-                result = malloc(strlen(left_str) + strlen(right_str) + 10);
-                if (result) {
-                    sprintf(result, "(%s) XOR (%s)", left_str, right_str);
-                }
-                free(left_str);
-                free(right_str);
-            }
-            break;
-            
         case NODE_IMPLIES:
-            left_str = generate_parenthesized_expression(node->left);
-            right_str = generate_parenthesized_expression(node->right);
-            if (left_str && right_str) {
-                // Always add parentheses around IMPLIES expressions
-                result = malloc(strlen(left_str) + strlen(right_str) + 10);
-                if (result) {
-                    sprintf(result, "(%s) -> (%s)", left_str, right_str);
-                }
-                free(left_str);
-                free(right_str);
-            }
-            break;
-            
         case NODE_IFF:
         case NODE_EQUIV:
-            left_str = generate_parenthesized_expression(node->left);
-            right_str = generate_parenthesized_expression(node->right);
-            if (left_str && right_str) {
-                // Always add parentheses around IFF/EQUIV expressions
-                result = malloc(strlen(left_str) + strlen(right_str) + 12);
-                if (result) {
-                    sprintf(result, "(%s) <-> (%s)", left_str, right_str);
-                }
-                free(left_str);
-                free(right_str);
-            }
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY:
+            append_text(analyzer, ")");
             break;
-            
-        case NODE_ASSIGN:
-            if (node->left && node->left->type == NODE_VAR) {
-                right_str = generate_parenthesized_expression(node->right);
-                if (right_str) {
-                    result = malloc(strlen(node->left->name) + strlen(right_str) + 5);
-                    if (result) {
-                        sprintf(result, "%s = %s", node->left->name, right_str);
-                    }
-                    free(right_str);
-                }
-            }
-            break;
-            
         default:
-            // For other node types, return a default string
-            result = strdup("UNKNOWN");
             break;
     }
-    
+}
+
+SemanticAnalyzer* create_semantic_analyzer(const SymbolSnapshot* symbols) {
+    SemanticAnalyzer* analyzer = calloc(1, sizeof(SemanticAnalyzer));
+    if (!analyzer) return NULL;
+
+    analyzer->symbols = symbols;
+    analyzer->stack_capacity = 64;
+    analyzer->stack = malloc(analyzer->stack_capacity * sizeof(VisitFrame));
+    analyzer->text_capacity = 256;
+    analyzer->text = malloc(analyzer->text_capacity);
+    if (!analyzer->stack || !analyzer->text) {
+        free_semantic_analyzer(analyzer);
+        return NULL;
+    }
+    return analyzer;
+}
+
+void free_semantic_analyzer(SemanticAnalyzer* analyzer) {
+    if (!analyzer) return;
+    free(analyzer->stack);
+    free(analyzer->scope);
+    free(analyzer->text);
+    free(analyzer);
+}
+
+SemanticAnalysisResult analyze_statement(SemanticAnalyzer* analyzer, Node* ast) {
+    SemanticAnalysisResult result = {SEMANTIC_OK, NULL, NULL, 0};
+
+    if (!ast) {
+        result.error_code = SEMANTIC_INVALID_QUANTIFIER;
+        result.error_message = strdup("Invalid AST: NULL node");
+        return result;
+    }
+
+    // The rendering buffer may have been dropped after a failed allocation
+    if (!analyzer->text) {
+        analyzer->text_capacity = 256;
+        analyzer->text = malloc(analyzer->text_capacity);
+    }
+    if (analyzer->text) analyzer->text[0] = '\0';
+    analyzer->text_length = 0;
+    analyzer->text_suppressed = 0;
+    analyzer->stack_size = 0;
+    analyzer->scope_size = 0;
+
+    // Single depth-first traversal; each node is entered once, visited
+    // between its operands and left once its operands are done
+    bool ambiguous = false;
+    push_frame(analyzer, ast, true);
+    while (analyzer->stack_size > 0) {
+        VisitFrame* frame = &analyzer->stack[analyzer->stack_size - 1];
+        Node* node = frame->node;
+        Node* child = NULL;
+        bool check_children = frame->check_ambiguity &&
+                              (node->type == NODE_NOT || is_binary_operator(node->type));
+
+        switch (frame->stage) {
+            case VISIT_ENTER:
+                enter_node(analyzer, frame, &result, &ambiguous);
+                frame->stage = VISIT_BETWEEN;
+                if (node->child_count > 0) {
+                    child = node->children[frame->operand++];
+                } else {
+                    child = node->type == NODE_ASSIGN ? get_assignment_expression(node) : node->left;
+                }
+                break;
+
+            case VISIT_BETWEEN:
+                if (frame->operand < node->child_count) {
+                    append_text(analyzer, is_nary_node(node) ? binary_separator(node->type) : ", ");
+                    child = node->children[frame->operand++];
+                    break;
+                }
+                if (node->right) {
+                    const char* separator = binary_separator(node->type);
+                    if (separator) append_text(analyzer, separator);
+                }
+                frame->stage = VISIT_EXIT;
+                if (node->type != NODE_ASSIGN) child = node->right;
+                break;
+
+            case VISIT_EXIT:
+                exit_node(analyzer, node);
+                analyzer->stack_size--;
+                break;
+        }
+
+        // frame may move when the stack grows
+        if (child && !push_frame(analyzer, child, check_children)) {
+            add_diagnostic(&result, SEMANTIC_TYPE_MISMATCH, strdup("Out of memory during semantic analysis"));
+            break;
+        }
+    }
+
+    if (ambiguous) {
+        char* message;
+        if (analyzer->text) {
+            message = format_message("Ambiguous expression detected. Please use parentheses to clarify. Suggested: %s",
+                                     analyzer->text);
+        } else {
+            message = strdup("Ambiguous expression detected. Please use parentheses to clarify precedence.");
+        }
+        add_diagnostic(&result, SEMANTIC_AMBIGUOUS_EXPRESSION, message);
+    }
+
+    if (result.diagnostic_count > 0) {
+        result.error_code = result.diagnostics[0].code;
+        result.error_message = strdup(result.diagnostics[0].message);
+    }
     return result;
 }
+
+SemanticAnalysisResult perform_semantic_analysis(Node* ast, SymbolTable* symbol_table) {
+    SymbolSnapshot* symbols = snapshot_symbol_table(symbol_table);
+    SemanticAnalyzer* analyzer = symbols ? create_semantic_analyzer(symbols) : NULL;
+    if (!analyzer) {
+        SemanticAnalysisResult result = {SEMANTIC_TYPE_MISMATCH, strdup("Out of memory during semantic analysis"), NULL, 0};
+        free_symbol_snapshot(symbols);
+        return result;
+    }
+
+    SemanticAnalysisResult result = analyze_statement(analyzer, ast);
+    free_semantic_analyzer(analyzer);
+    free_symbol_snapshot(symbols);
+    return result;
+}
+
+// A contiguous run of statements analyzed by one thread pool job
+typedef struct {
+    Node** statements;
+    int count;
+    const SymbolSnapshot* symbols;
+    SemanticAnalysisResult* results;
+} AnalysisJob;
+
+static void analyze_chunk(Node** statements, int count, const SymbolSnapshot* symbols,
+                          SemanticAnalysisResult* results) {
+    SemanticAnalyzer* analyzer = create_semantic_analyzer(symbols);
+    for (int i = 0; i < count; i++) {
+        if (analyzer) {
+            results[i] = analyze_statement(analyzer, statements[i]);
+        } else {
+            SemanticAnalysisResult failure = {SEMANTIC_TYPE_MISMATCH, strdup("Out of memory during semantic analysis"), NULL, 0};
+            results[i] = failure;
+        }
+    }
+    free_semantic_analyzer(analyzer);
+}
+
+static void run_analysis_job(void* arg) {
+    AnalysisJob* job = (AnalysisJob*)arg;
+    analyze_chunk(job->statements, job->count, job->symbols, job->results);
+}
+
+void analyze_statements(Node** statements, int count, const SymbolSnapshot* symbols, int jobs,
+                        SemanticAnalysisResult* results) {
+    if (count <= 0) return;
+
+    // Aim for a few chunks per thread so uneven statements balance out
+    int chunk_size = jobs > 0 ? (count + jobs * 4 - 1) / (jobs * 4) : count;
+    if (chunk_size < SEMANTIC_CHUNK_MIN_STATEMENTS) chunk_size = SEMANTIC_CHUNK_MIN_STATEMENTS;
+    int chunk_count = (count + chunk_size - 1) / chunk_size;
+
+    ThreadPool* pool = chunk_count > 1 && jobs > 1 ? thread_pool_create(jobs) : NULL;
+    AnalysisJob* chunks = pool ? calloc(chunk_count, sizeof(AnalysisJob)) : NULL;
+    if (!chunks) {
+        if (pool) thread_pool_destroy(pool);
+        analyze_chunk(statements, count, symbols, results);
+        return;
+    }
+
+    for (int k = 0; k < chunk_count; k++) {
+        AnalysisJob* job = &chunks[k];
+        int first = k * chunk_size;
+        job->statements = statements + first;
+        job->count = count - first < chunk_size ? count - first : chunk_size;
+        job->symbols = symbols;
+        job->results = results + first;
+        if (thread_pool_submit(pool, run_analysis_job, job) != 0) {
+            run_analysis_job(job);
+        }
+    }
+    thread_pool_wait(pool);
+    thread_pool_destroy(pool);
+    free(chunks);
+}
+
+void free_semantic_analysis_result(SemanticAnalysisResult* result) {
+    if (!result) return;
+
+    for (int i = 0; i < result->diagnostic_count; i++) {
+        free(result->diagnostics[i].message);
+    }
+    free(result->diagnostics);
+    free(result->error_message);
+    result->diagnostics = NULL;
+    result->diagnostic_count = 0;
+    result->error_message = NULL;
+    result->error_code = SEMANTIC_OK;
+}
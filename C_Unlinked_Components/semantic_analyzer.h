@@ -13,17 +13,40 @@ typedef enum {
     SEMANTIC_AMBIGUOUS_EXPRESSION
 } SemanticErrorCode;
 
+// A single problem found in a statement
+typedef struct {
+    SemanticErrorCode code;
+    char* message;
+} SemanticDiagnostic;
+
 // Semantic analysis result structure
 typedef struct {
-    SemanticErrorCode error_code;
-    char* error_message;
+    SemanticErrorCode error_code;       // Code of the first diagnostic
+    char* error_message;                // Message of the first diagnostic
+    SemanticDiagnostic* diagnostics;    // Every diagnostic, in traversal order
+    int diagnostic_count;
 } SemanticAnalysisResult;
 
+// Reusable analysis state. Checking many statements with one analyzer
+// reuses its traversal stack and text buffer. Analysis never modifies the
+// symbols; quantifier-bound variables live in a per-statement scope.
+// Analyzers are not thread-safe, but any number of them may share a snapshot.
+typedef struct SemanticAnalyzer SemanticAnalyzer;
+
+SemanticAnalyzer* create_semantic_analyzer(const SymbolSnapshot* symbols);
+void free_semantic_analyzer(SemanticAnalyzer* analyzer);
+
+// Check one statement in a single traversal, collecting every diagnostic:
+// undefined variables, invalid quantifiers and ambiguous precedence
+SemanticAnalysisResult analyze_statement(SemanticAnalyzer* analyzer, Node* ast);
+
+// Analyze count statements on up to jobs threads, storing the result of
+// statements[i] in results[i] so diagnostics can be reported in order
+void analyze_statements(Node** statements, int count, const SymbolSnapshot* symbols, int jobs,
+                        SemanticAnalysisResult* results);
+
 // Function prototypes for semantic analysis
 SemanticAnalysisResult perform_semantic_analysis(Node* ast, SymbolTable* symbol_table);
-bool validate_variable_usage(Node* node, SymbolTable* symbol_table);
-bool validate_quantifier_expression(Node* node, SymbolTable* symbol_table);
-bool check_ambiguous_expression(Node* node, bool* ambiguous);
-char* generate_parenthesized_expression(Node* node);
+void free_semantic_analysis_result(SemanticAnalysisResult* result);
 
 #endif // SEMANTIC_ANALYZER_H
@@ -4,6 +4,92 @@
 
 #define INITIAL_CAPACITY 10
 
+static unsigned int hash_symbol_name(const char *name)
+{
+    // FNV-1a
+    unsigned int hash = 2166136261u;
+    for (const unsigned char *p = (const unsigned char *)name; *p; p++) {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+int name_index_find(const NameIndex *index, const char *name, NameOfEntry name_of, const void *owner)
+{
+    if (index->slot_count == 0) {
+        return -1;
+    }
+
+    unsigned int slot = hash_symbol_name(name) & (index->slot_count - 1);
+    while (index->slots[slot] != -1)
+    {
+        int entry = index->slots[slot];
+        if (strcmp(name_of(owner, entry), name) == 0)
+        {
+            return entry;
+        }
+        slot = (slot + 1) & (index->slot_count - 1);
+    }
+    return -1;
+}
+
+static void insert_name(int *slots, int slot_count, const char *name, int entry)
+{
+    unsigned int slot = hash_symbol_name(name) & (slot_count - 1);
+    while (slots[slot] != -1) {
+        slot = (slot + 1) & (slot_count - 1);
+    }
+    slots[slot] = entry;
+}
+
+// The index is rebuilt as needed to stay at most half full
+int name_index_add(NameIndex *index, const char *name, int entry, NameOfEntry name_of, const void *owner)
+{
+    if ((index->count + 1) * 2 > index->slot_count)
+    {
+        int slot_count = index->slot_count ? index->slot_count * 2 : 16;
+        int *slots = malloc(slot_count * sizeof(int));
+        if (slots == NULL) {
+            return -1;
+        }
+
+        memset(slots, -1, slot_count * sizeof(int));
+        for (int i = 0; i < index->slot_count; i++)
+        {
+            if (index->slots[i] != -1) {
+                insert_name(slots, slot_count, name_of(owner, index->slots[i]), index->slots[i]);
+            }
+        }
+        free(index->slots);
+        index->slots = slots;
+        index->slot_count = slot_count;
+    }
+
+    insert_name(index->slots, index->slot_count, name, entry);
+    index->count++;
+    return 0;
+}
+
+void free_name_index(NameIndex *index)
+{
+    free(index->slots);
+    index->slots = NULL;
+    index->slot_count = 0;
+    index->count = 0;
+}
+
+static const char *symbol_name(const void *symbols, int entry)
+{
+    return ((const Symbol *)symbols)[entry].name;
+}
+
+// Index of name in the table, or -1
+int find_symbol_index(const SymbolTable *table, const char *name)
+{
+    return name_index_find(&table->index, name, symbol_name, table->symbols);
+}
+
 SymbolTable *init_symbol_table()
 {
     // Allocate memory for symbol table
@@ -17,6 +103,7 @@ SymbolTable *init_symbol_table()
     table->capacity = INITIAL_CAPACITY;
     table->size = 0;
     table->symbols = malloc(table->capacity * sizeof(Symbol));
+    table->index = (NameIndex){0};
     
     if (table->symbols == NULL) {
         free(table);
@@ -40,16 +127,15 @@ int add_or_update_symbol(SymbolTable *table, const char *name, int value)
             return ERROR_SYMBOL_TABLE_FULL;
         }
         table->size = 0;
+        free_name_index(&table->index);
     }
     
     // Check if symbol already exists
-    for (int i = 0; i < table->size; i++)
+    int existing = find_symbol_index(table, name);
+    if (existing >= 0)
     {
-        if (strcmp(table->symbols[i].name, name) == 0)
-        {
-            table->symbols[i].value = value;
-            return 0; // Success
-        }
+        table->symbols[existing].value = value;
+        return 0; // Success
     }
 
     // Resize if needed
@@ -67,6 +153,10 @@ int add_or_update_symbol(SymbolTable *table, const char *name, int value)
     strncpy(table->symbols[table->size].name, name, MAX_SYMBOL_NAME_LENGTH - 1);
     table->symbols[table->size].name[MAX_SYMBOL_NAME_LENGTH - 1] = '\0';
     table->symbols[table->size].value = value;
+    const char *stored_name = table->symbols[table->size].name;
+    if (name_index_add(&table->index, stored_name, table->size, symbol_name, table->symbols) != 0) {
+        return ERROR_SYMBOL_TABLE_FULL;
+    }
     table->size++;
 
     return 0; // Success
@@ -85,21 +175,69 @@ int get_symbol_value(SymbolTable *table, const char *name)
         return 0;
     }
     
-    for (int i = 0; i < table->size; i++)
-    {
-        if (strcmp(table->symbols[i].name, name) == 0)
-        {
-            return table->symbols[i].value;
-        }
-    }
-
-    return ERROR_SYMBOL_NOT_FOUND;
+    int index = find_symbol_index(table, name);
+    return index >= 0 ? table->symbols[index].value : ERROR_SYMBOL_NOT_FOUND;
 }
 
 void free_symbol_table(SymbolTable *table)
 {
     if (table) {
         free(table->symbols);
+        free_name_index(&table->index);
         free(table);
     }
-}
\ No newline at end of file
+}
+
+SymbolSnapshot *snapshot_symbol_table(const SymbolTable *table)
+{
+    SymbolSnapshot *snapshot = calloc(1, sizeof(SymbolSnapshot));
+    if (snapshot == NULL) {
+        return NULL;
+    }
+
+    int size = (table && table->symbols) ? table->size : 0;
+    snapshot->symbols = malloc((size > 0 ? size : 1) * sizeof(Symbol));
+    if (snapshot->symbols == NULL) {
+        free_symbol_snapshot(snapshot);
+        return NULL;
+    }
+
+    for (int i = 0; i < size; i++)
+    {
+        snapshot->symbols[i] = table->symbols[i];
+        if (name_index_add(&snapshot->index, snapshot->symbols[i].name, i, symbol_name, snapshot->symbols) != 0) {
+            free_symbol_snapshot(snapshot);
+            return NULL;
+        }
+    }
+    snapshot->size = size;
+
+    return snapshot;
+}
+
+// Same results as get_symbol_value on the table the snapshot was taken from
+int get_snapshot_value(const SymbolSnapshot *snapshot, const char *name)
+{
+    if (!snapshot || !name) {
+        return ERROR_SYMBOL_NOT_FOUND;
+    }
+
+    // Handle special case for TRUE/FALSE constants
+    if (strcmp(name, "TRUE") == 0) {
+        return 1;
+    } else if (strcmp(name, "FALSE") == 0) {
+        return 0;
+    }
+
+    int index = name_index_find(&snapshot->index, name, symbol_name, snapshot->symbols);
+    return index >= 0 ? snapshot->symbols[index].value : ERROR_SYMBOL_NOT_FOUND;
+}
+
+void free_symbol_snapshot(SymbolSnapshot *snapshot)
+{
+    if (snapshot) {
+        free(snapshot->symbols);
+        free_name_index(&snapshot->index);
+        free(snapshot);
+    }
+}
@@ -9,6 +9,23 @@
 #define ERROR_SYMBOL_NOT_DEFINED -2
 #define ERROR_SYMBOL_NOT_FOUND -3
 
+// Open-addressing hash index from names to the entries of an array its
+// owner keeps. Only entry numbers are stored; name_of returns the name of an
+// entry when the index needs it to compare or rehash.
+typedef const char *(*NameOfEntry)(const void *owner, int entry);
+
+typedef struct {
+    int *slots;       // Entry numbers, -1 = empty
+    int slot_count;   // Always a power of two, or 0 before the first entry
+    int count;
+} NameIndex;
+
+// Entry named name, or -1
+int name_index_find(const NameIndex *index, const char *name, NameOfEntry name_of, const void *owner);
+// Index an entry whose name is not indexed yet; returns 0 on success
+int name_index_add(NameIndex *index, const char *name, int entry, NameOfEntry name_of, const void *owner);
+void free_name_index(NameIndex *index);
+
 typedef struct {
     char name[MAX_SYMBOL_NAME_LENGTH];  // Fixed-length name to simplify memory management
     int value;
@@ -18,11 +35,25 @@ typedef struct {
     Symbol *symbols;  // Dynamic array of symbols
     int size;         // Current number of symbols
     int capacity;     // Total allocated capacity
+    NameIndex index;  // Symbols by name
 } SymbolTable;
 
+// Frozen copy of a symbol table with hashed lookup. It is never modified
+// after creation, so any number of threads may read it concurrently.
+typedef struct {
+    Symbol *symbols;  // Copy of the table's symbols
+    int size;
+    NameIndex index;  // Symbols by name
+} SymbolSnapshot;
+
 SymbolTable *init_symbol_table();
 int add_or_update_symbol(SymbolTable *table, const char *name, int value);
 int get_symbol_value(SymbolTable *table, const char *name);
+int find_symbol_index(const SymbolTable *table, const char *name);  // Index into symbols, or -1
 void free_symbol_table(SymbolTable *table);
 
+SymbolSnapshot *snapshot_symbol_table(const SymbolTable *table);
+int get_snapshot_value(const SymbolSnapshot *snapshot, const char *name);
+void free_symbol_snapshot(SymbolSnapshot *snapshot);
+
 #endif /* SYMBOL_TABLE_H */
\ No newline at end of file
@@ -0,0 +1,142 @@
+#include "thread_pool.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+typedef struct ThreadPoolTask {
+    ThreadPoolJob job;
+    void* arg;
+    struct ThreadPoolTask* next;
+} ThreadPoolTask;
+
+struct ThreadPool {
+    pthread_t* threads;
+    int thread_count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t work_available;  // Signalled when a task is queued or on shutdown
+    pthread_cond_t work_done;       // Signalled when the pool becomes idle
+
+    ThreadPoolTask* head;
+    ThreadPoolTask* tail;
+    int active;                     // Tasks currently running
+    int shutting_down;
+};
+
+int thread_pool_cpu_count(void) {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+static void* thread_pool_worker(void* arg) {
+    ThreadPool* pool = arg;
+
+    pthread_mutex_lock(&pool->lock);
+    for (;;) {
+        while (!pool->head && !pool->shutting_down) {
+            pthread_cond_wait(&pool->work_available, &pool->lock);
+        }
+        if (!pool->head) break;  // Shutting down and nothing left to run
+
+        ThreadPoolTask* task = pool->head;
+        pool->head = task->next;
+        if (!pool->head) pool->tail = NULL;
+        pool->active++;
+        pthread_mutex_unlock(&pool->lock);
+
+        task->job(task->arg);
+        free(task);
+
+        pthread_mutex_lock(&pool->lock);
+        pool->active--;
+        if (!pool->head && pool->active == 0) {
+            pthread_cond_broadcast(&pool->work_done);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+ThreadPool* thread_pool_create(int thread_count) {
+    if (thread_count <= 0) {
+        thread_count = thread_pool_cpu_count();
+    }
+
+    ThreadPool* pool = calloc(1, sizeof(ThreadPool));
+    if (!pool) return NULL;
+
+    pool->threads = malloc(sizeof(pthread_t) * thread_count);
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_available, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    for (int i = 0; i < thread_count; i++) {
+        if (pthread_create(&pool->threads[i], NULL, thread_pool_worker, pool) != 0) {
+            fprintf(stderr, "Warning: Could only start %d of %d worker threads\n", i, thread_count);
+            break;
+        }
+        pool->thread_count++;
+    }
+
+    if (pool->thread_count == 0) {
+        thread_pool_destroy(pool);
+        return NULL;
+    }
+    return pool;
+}
+
+int thread_pool_submit(ThreadPool* pool, ThreadPoolJob job, void* arg) {
+    if (!pool || !job) return -1;
+
+    ThreadPoolTask* task = malloc(sizeof(ThreadPoolTask));
+    if (!task) return -1;
+    task->job = job;
+    task->arg = arg;
+    task->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->tail) {
+        pool->tail->next = task;
+    } else {
+        pool->head = task;
+    }
+    pool->tail = task;
+    pthread_cond_signal(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+void thread_pool_wait(ThreadPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->head || pool->active > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void thread_pool_destroy(ThreadPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutting_down = 1;
+    pthread_cond_broadcast(&pool->work_available);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_available);
+    pthread_cond_destroy(&pool->work_done);
+    free(pool->threads);
+    free(pool);
+}
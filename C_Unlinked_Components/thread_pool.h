@@ -0,0 +1,24 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Fixed-size pool of worker threads executing submitted jobs in FIFO order
+typedef void (*ThreadPoolJob)(void* arg);
+
+typedef struct ThreadPool ThreadPool;
+
+// Create a pool with the given number of workers (<= 0 selects one per online CPU)
+ThreadPool* thread_pool_create(int thread_count);
+
+// Queue a job; returns 0 on success, -1 if it could not be queued
+int thread_pool_submit(ThreadPool* pool, ThreadPoolJob job, void* arg);
+
+// Block until every submitted job has finished
+void thread_pool_wait(ThreadPool* pool);
+
+// Wait for outstanding jobs, stop the workers and free the pool
+void thread_pool_destroy(ThreadPool* pool);
+
+// Number of online CPUs (at least 1)
+int thread_pool_cpu_count(void);
+
+#endif /* THREAD_POOL_H */
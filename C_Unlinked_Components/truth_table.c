@@ -0,0 +1,277 @@
+#include "truth_table.h"
+#include <stdlib.h>
+#include <string.h>
+#include "and_inverter_graph.h"
+
+// Free variables of a node in strcmp order, and the operators below it
+typedef struct {
+    const char** names;
+    int count;              // -1 once there are more than max_variables
+    long operators;
+} Support;
+
+typedef struct {
+    SymbolTable* symbol_table;
+    int max_variables;
+    TruthTable* tables;     // Candidates in postorder, tabulated at the end
+    int count;
+    int capacity;
+    int failed;
+} Finder;
+
+static int is_free_variable(const Finder* finder, const char* name) {
+    return strcmp(name, "TRUE") != 0 && strcmp(name, "FALSE") != 0 &&
+           get_symbol_value(finder->symbol_table, name) == ERROR_SYMBOL_NOT_FOUND;
+}
+
+// Instructions the operator itself takes when generated directly
+static long operator_cost(const Node* node) {
+    if (node->type == NODE_VAR || node->type == NODE_BOOL) return 0;
+    if (is_nary_node(node)) return node->child_count - 1;
+    if (is_threshold_type(node->type)) return node->child_count;
+    return 1;
+}
+
+static void overflow_support(Support* support) {
+    free(support->names);
+    support->names = NULL;
+    support->count = -1;
+}
+
+// Insert name, keeping the names sorted and distinct
+static void add_name(Finder* finder, Support* support, const char* name) {
+    if (support->count < 0) return;
+    int position = 0;
+    while (position < support->count) {
+        int order = strcmp(support->names[position], name);
+        if (order == 0) return;
+        if (order > 0) break;
+        position++;
+    }
+    if (support->count == finder->max_variables) {
+        overflow_support(support);
+        return;
+    }
+    if (!support->names) {
+        support->names = malloc(finder->max_variables * sizeof(char*));
+        if (!support->names) {
+            finder->failed = 1;
+            support->count = -1;
+            return;
+        }
+    }
+    memmove(support->names + position + 1, support->names + position,
+            (support->count - position) * sizeof(char*));
+    support->names[position] = name;
+    support->count++;
+}
+
+// Add the support of an operand to that of its operator, consuming it
+static void merge_support(Finder* finder, Support* into, Support* from) {
+    into->operators += from->operators;
+    if (from->count < 0) {
+        overflow_support(into);
+    } else {
+        for (int i = 0; i < from->count && into->count >= 0; i++) add_name(finder, into, from->names[i]);
+    }
+    free(from->names);
+}
+
+static void drop_candidates(Finder* finder, int first) {
+    for (int i = first; i < finder->count; i++) free(finder->tables[i].variables);
+    finder->count = first;
+}
+
+static int uses_variable(const TruthTable* table, const char* name) {
+    for (int i = 0; i < table->variable_count; i++) {
+        if (strcmp(table->variables[i], name) == 0) return 1;
+    }
+    return 0;
+}
+
+static Support find_support(Finder* finder, const Node* node) {
+    Support support = {NULL, 0, 0};
+    if (!node || finder->failed) return support;
+    int first = finder->count;
+
+    if (node->type == NODE_BOOL) return support;
+    if (node->type == NODE_VAR) {
+        if (is_free_variable(finder, node->name)) add_name(finder, &support, node->name);
+        return support;
+    }
+
+    Support operand = find_support(finder, node->left);
+    merge_support(finder, &support, &operand);
+    operand = find_support(finder, node->right);
+    merge_support(finder, &support, &operand);
+    for (int i = 0; i < node->child_count; i++) {
+        operand = find_support(finder, node->children[i]);
+        merge_support(finder, &support, &operand);
+    }
+    support.operators += operator_cost(node);
+
+    if (node->type == NODE_EXISTS || node->type == NODE_FORALL) {
+        // The bound variable is not free here, and tables below that use it
+        // would read a variable of the same name outside
+        int kept = first;
+        for (int i = first; i < finder->count; i++) {
+            if (uses_variable(&finder->tables[i], node->name)) {
+                free(finder->tables[i].variables);
+            } else {
+                finder->tables[kept++] = finder->tables[i];
+            }
+        }
+        finder->count = kept;
+        for (int i = 0; i < support.count; i++) {
+            if (strcmp(support.names[i], node->name) != 0) continue;
+            memmove(support.names + i, support.names + i + 1, (support.count - i - 1) * sizeof(char*));
+            support.count--;
+            break;
+        }
+    }
+
+    if (support.count >= 1 && support.operators >= (long)TRUTH_TABLE_MIN_OPERATORS * support.count) {
+        // Replaces the candidates below it, which were recorded after first
+        drop_candidates(finder, first);
+        if (finder->count == finder->capacity) {
+            int capacity = finder->capacity ? finder->capacity * 2 : 8;
+            TruthTable* tables = realloc(finder->tables, capacity * sizeof(TruthTable));
+            if (!tables) {
+                finder->failed = 1;
+                return support;
+            }
+            finder->tables = tables;
+            finder->capacity = capacity;
+        }
+        TruthTable* table = &finder->tables[finder->count];
+        memset(table, 0, sizeof(TruthTable));
+        table->node = node;
+        table->variable_count = support.count;
+        table->variables = malloc(support.count * sizeof(char*));
+        if (!table->variables) {
+            finder->failed = 1;
+            return support;
+        }
+        memcpy(table->variables, support.names, support.count * sizeof(char*));
+        finder->count++;
+    }
+    return support;
+}
+
+static AIGLiteral resolve_known(void* context, const char* name) {
+    int value = get_symbol_value(context, name);
+    if (value == ERROR_SYMBOL_NOT_FOUND) return AIG_INVALID;
+    return value ? AIG_TRUE : AIG_FALSE;
+}
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
+static uint64_t literal_bits(const uint64_t* values, AIGLiteral literal) {
+    uint64_t bits = values[AIG_NODE(literal)];
+    return AIG_IS_COMPLEMENTED(literal) ? ~bits : bits;
+}
+
+// Fill table->bits by simulating the subexpression on 64 assignments per
+// word. Returns 0, 1 when it cannot be lowered, or -1 when out of memory.
+static int tabulate(TruthTable* table, SymbolTable* symbol_table) {
+    // Lanes of the first six variables within a word
+    static const uint64_t lane_masks[6] = {
+        0xAAAAAAAAAAAAAAAAULL, 0xCCCCCCCCCCCCCCCCULL, 0xF0F0F0F0F0F0F0F0ULL,
+        0xFF00FF00FF00FF00ULL, 0xFFFF0000FFFF0000ULL, 0xFFFFFFFF00000000ULL
+    };
+    int k = table->variable_count;
+    AIG* aig = create_aig();
+    if (!aig) return -1;
+    AIGLiteral output = aig_from_node_resolved(aig, table->node, resolve_known, symbol_table);
+    if (output == AIG_INVALID) {
+        free_aig(aig);
+        return 1;
+    }
+
+    int* input_variables = malloc((aig->input_count > 0 ? aig->input_count : 1) * sizeof(int));
+    uint64_t* values = malloc(aig->node_count * sizeof(uint64_t));
+    table->word_count = k <= 6 ? 1 : 1 << (k - 6);
+    table->bits = calloc(table->word_count, sizeof(uint64_t));
+    if (!input_variables || !values || !table->bits) {
+        free(input_variables);
+        free(values);
+        free_aig(aig);
+        return -1;
+    }
+    int status = 0;
+    for (int i = 0; i < aig->input_count && status == 0; i++) {
+        const char* name = aig->input_names[i];
+        const char** found = bsearch(&name, table->variables, k, sizeof(char*), compare_names);
+        if (found) {
+            input_variables[i] = (int)(found - table->variables);
+        } else {
+            status = 1;
+        }
+    }
+
+    for (int word = 0; word < table->word_count && status == 0; word++) {
+        values[0] = 0;
+        for (int i = 0; i < aig->input_count; i++) {
+            int variable = input_variables[i];
+            values[aig->input_nodes[i]] = variable < 6 ? lane_masks[variable]
+                                        : (word >> (variable - 6)) & 1 ? ~0ULL : 0;
+        }
+        for (int i = 1; i < aig->node_count; i++) {
+            if (!aig_is_and(aig, i)) continue;
+            values[i] = literal_bits(values, aig->nodes[i].fanin0) & literal_bits(values, aig->nodes[i].fanin1);
+        }
+        table->bits[word] = literal_bits(values, output);
+    }
+    if (k < 6) table->bits[0] &= (1ULL << (1 << k)) - 1;
+
+    free(input_variables);
+    free(values);
+    free_aig(aig);
+    return status;
+}
+
+int find_truth_tables(const Node* node, SymbolTable* symbol_table, int max_variables, TruthTable** tables) {
+    Finder finder = {symbol_table, max_variables, NULL, 0, 0, 0};
+    if (finder.max_variables > TRUTH_TABLE_MAX_VARIABLES) finder.max_variables = TRUTH_TABLE_MAX_VARIABLES;
+    *tables = NULL;
+    if (finder.max_variables < 1) return 0;
+
+    Support support = find_support(&finder, node);
+    free(support.names);
+
+    int kept = 0;
+    int next = 0;
+    for (; next < finder.count && !finder.failed; next++) {
+        TruthTable* table = &finder.tables[next];
+        int status = tabulate(table, symbol_table);
+        if (status < 0) finder.failed = 1;
+        if (status != 0) {
+            free(table->variables);
+            free(table->bits);
+        } else {
+            finder.tables[kept++] = *table;
+        }
+    }
+    if (finder.failed) {
+        for (; next < finder.count; next++) free(finder.tables[next].variables);
+        free_truth_tables(finder.tables, kept);
+        return -1;
+    }
+    *tables = finder.tables;
+    return kept;
+}
+
+void free_truth_tables(TruthTable* tables, int count) {
+    if (!tables) return;
+    for (int i = 0; i < count; i++) {
+        free(tables[i].variables);
+        free(tables[i].bits);
+    }
+    free(tables);
+}
+
+int truth_table_value(const TruthTable* table, uint32_t index) {
+    return (int)(table->bits[index >> 6] >> (index & 63) & 1);
+}
@@ -0,0 +1,49 @@
+#ifndef TRUTH_TABLE_H
+#define TRUTH_TABLE_H
+
+#include <stdint.h>
+#include "ast.h"
+#include "symbol_table.h"
+
+// Truth tables of subexpressions over few variables.
+//
+// Any subexpression whose value depends on k free variables is a function
+// of k bits, so its whole truth table fits in 2^k bits: one 64-bit constant
+// for k <= 6, and 2^k / 64 words for larger k. Code generation can replace
+// such a subexpression, however many operators it has, by packing its
+// variables into an index and extracting one bit of the table.
+//
+// The support of every node, its free variables outside the symbol table,
+// is computed bottom-up, and the maximal subexpressions over at most
+// max_variables variables with at least TRUTH_TABLE_MIN_OPERATORS operators
+// per variable are tabulated. Tables are filled by lowering the
+// subexpression to an And-Inverter Graph and simulating it on 64
+// assignments at a time.
+
+#define TRUTH_TABLE_MAX_VARIABLES 16
+
+// Packing a variable into the index costs about two instructions, so only
+// subexpressions with at least that many operators per variable are tabulated
+#define TRUTH_TABLE_MIN_OPERATORS 2
+
+typedef struct {
+    const Node* node;           // Root of the subexpression
+    const char** variables;     // Support in strcmp order, names owned by the AST;
+    int variable_count;         // variable i is bit i of the table index
+    uint64_t* bits;             // Bit j of word i holds the value at index 64 * i + j
+    int word_count;             // 1 for up to 6 variables, 2^(k - 6) otherwise
+} TruthTable;
+
+// Tabulate the maximal subexpressions of node over between 1 and
+// max_variables (at most TRUTH_TABLE_MAX_VARIABLES) free variables, with
+// symbol_table values substituted. Returns the number of tables and sets
+// *tables, ordered as the subexpressions occur in node, or -1 when out of
+// memory. Subexpressions that cannot be lowered are left out.
+int find_truth_tables(const Node* node, SymbolTable* symbol_table, int max_variables, TruthTable** tables);
+
+void free_truth_tables(TruthTable* tables, int count);
+
+// Value of table at index, bit i of index being variable i
+int truth_table_value(const TruthTable* table, uint32_t index);
+
+#endif /* TRUTH_TABLE_H */
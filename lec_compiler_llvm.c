@@ -3,11 +3,24 @@
 #include <string.h>
 #include <libgen.h>
 #include <unistd.h>  // For mkdtemp
+#include <time.h>
 #include "C_Unlinked_Components/ast.h"
 #include "C_Unlinked_Components/symbol_table.h"
 #include "C_Unlinked_Components/semantic_analyzer.h"
 #include "C_Unlinked_Components/multi_statement.h"
 #include "C_Unlinked_Components/llvm_codegen.h"
+#include "C_Unlinked_Components/thread_pool.h"
+#include "C_Unlinked_Components/compile_cache.h"
+#include "C_Unlinked_Components/assignment_graph.h"
+#include "C_Unlinked_Components/egraph_optimizer.h"
+#include "C_Unlinked_Components/logic_minimizer.h"
+#include "C_Unlinked_Components/partial_evaluator.h"
+#include "C_Unlinked_Components/nary_flattener.h"
+#include "C_Unlinked_Components/branch_profile.h"
+#include "C_Unlinked_Components/equivalence_checker.h"
+#include "C_Unlinked_Components/model_counter.h"
+#include "C_Unlinked_Components/prime_implicant.h"
+#include "C_Unlinked_Components/quantifier_witness.h"
 
 // Forward declarations for parser functions (generated by bison)
 extern int yyparse();
@@ -64,8 +77,29 @@ void free_multi_statement_ast(MultiStatementAST* ast) {
 
 // Function to print usage information
 void print_usage() {
-    printf("Usage: lec_compiler_llvm <input_file> [-oN]\n");
-    printf("  -oN  Set optimization level (0-3, default: 0)\n");
+    printf("Usage: lec_compiler_llvm <input_file> [-oN] [-jN] [--binary-results] [--no-cache] [--emit-llvm] [--egraph] [--minimize] [--flatten] [--aig] [--lookup-tables] [--bdd] [--runtime=VARS]\n");
+    printf("                         [--profile-generate=FILE] [--profile-use=FILE]\n");
+    printf("       lec_compiler_llvm --equiv <old_file> <new_file>\n");
+    printf("       lec_compiler_llvm --count | --explain | --witness <input_file>\n");
+    printf("  -oN               Set optimization level (0-3, default: 0)\n");
+    printf("  -jN               Generate code for large inputs on N threads (default: one per CPU)\n");
+    printf("  --binary-results  Generated program writes a compact result bitset instead of a trace\n");
+    printf("  --no-cache        Do not use the compilation cache (~/.cache/lec)\n");
+    printf("  --emit-llvm       Also write the generated LLVM IR to <output>.ll\n");
+    printf("  --egraph          Simplify expressions by equality saturation before code generation\n");
+    printf("  --minimize        Rewrite expressions as minimal sums of products where smaller\n");
+    printf("  --flatten         Merge AND, OR and XOR chains into sorted, deduplicated n-ary operations\n");
+    printf("  --aig             Compute binary results through an optimized And-Inverter Graph\n");
+    printf("  --lookup-tables   Compute binary results of parts over at most 16 runtime variables by table lookup\n");
+    printf("  --bdd             Compute binary results by branching through a decision diagram of each statement\n");
+    printf("  --runtime=A,B     Read A and B from LEC_A and LEC_B when the program runs and\n");
+    printf("                    specialize the statements to the variables known now\n");
+    printf("  --profile-generate=FILE  Program appends how often each AND and OR operand decides it to FILE\n");
+    printf("  --profile-use=FILE       Evaluate the deciding AND and OR operands of FILE first and short-circuit\n");
+    printf("  --equiv OLD NEW   Prove each statement of NEW equivalent to the same statement of OLD\n");
+    printf("  --count           Count the assignments to unassigned variables that make each statement TRUE\n");
+    printf("  --explain         Print a minimal set of variable values that forces each statement's value\n");
+    printf("  --witness         Print a witness for each TRUE EXISTS and a counterexample for each FALSE FORALL\n");
     printf("Example: lec_compiler_llvm input.lec -o2\n");
 }
 
@@ -123,127 +157,125 @@ char* read_file_contents(const char* input_file) {
     return buffer;
 }
 
-// Pre-process assignments to build the symbol table
-void process_assignments(const char* file_contents, SymbolTable* symbol_table) {
-    printf("Pre-processing assignments...\n");
-    
-    // Make a copy of the file contents
-    char* buffer = strdup(file_contents);
-    if (!buffer) return;
-    
-    // Process each line
-    char* line = strtok(buffer, "\n");
-    while (line) {
-        // Skip empty lines
-        if (strlen(line) > 0) {
-            // Check if this is a simple assignment (format: VAR = VALUE)
-            // We need to be more strict to avoid misinterpreting expressions like A -> B
-            if (strstr(line, "=") && !strstr(line, "=>") && !strstr(line, "-->") && 
-                !strstr(line, "<->") && !strstr(line, "<==>") && !strstr(line, "IMPLIES") && 
-                !strstr(line, "DOUBLEIMPLIES") && !strstr(line, "IFF")) {
-                // Simple direct parsing for TRUE/FALSE assignments
-                char var_name[MAX_SYMBOL_NAME_LENGTH] = {0};
-                char var_value[20] = {0};
-                
-                if (sscanf(line, "%49s = %19s", var_name, var_value) == 2) {
-                    int value = 0;
-                    
-                    // Check for TRUE/FALSE directly
-                    if (strcmp(var_value, "TRUE") == 0) {
-                        value = 1;
-                    } else if (strcmp(var_value, "FALSE") == 0) {
-                        value = 0;
-                    }
-                    
-                    // Add to symbol table
-                    add_or_update_symbol(symbol_table, var_name, value);
-                    printf("Added variable '%s' with value %d to symbol table\n", var_name, value);
-                    line = strtok(NULL, "\n");
-                    continue;
-                }
-                
-                // If direct parsing fails, use the parser
-                FILE* temp = tmpfile();
-                if (!temp) {
-                    fprintf(stderr, "Error: Failed to create temporary file\n");
-                    line = strtok(NULL, "\n");
-                    continue;
-                }
-                
-                fputs(line, temp);
-                rewind(temp);
-                
-                yyin = temp;
-                parsed_expression = NULL;
-                int parse_result = yyparse();
-                fclose(temp);
-                
-                if (parse_result == 0 && parsed_expression) {
-                    // If it's an assignment, extract the variable name and value
-                    if (parsed_expression->type == NODE_ASSIGN && parsed_expression->name) {
-                        int value = 0;
-                        if (parsed_expression->right) {
-                            if (parsed_expression->right->type == NODE_BOOL) {
-                                value = parsed_expression->right->bool_val;
-                            } else if (parsed_expression->right->type == NODE_VAR) {
-                                if (parsed_expression->right->name) {
-                                    if (strcmp(parsed_expression->right->name, "TRUE") == 0) {
-                                        value = 1;
-                                    } else if (strcmp(parsed_expression->right->name, "FALSE") == 0) {
-                                        value = 0;
-                                    }
-                                }
-                            }
-                        }
-                        
-                        // Add the variable to the symbol table
-                        char* var_name = strdup(parsed_expression->name);
-                        add_or_update_symbol(symbol_table, var_name, value);
-                        printf("Added variable '%s' with value %d to symbol table\n", 
-                               var_name, value);
-                        free(var_name);
-                    }
-                    
-                    // Free the parsed expression
-                    if (parsed_expression) {
-                        free_ast(parsed_expression);
-                        parsed_expression = NULL;
-                    }
-                }
-            }
+// Global variable for optimization level
+int optimization_level = 0;
+
+// Output format of the generated executable
+LLVMOutputFormat output_format = LLVM_OUTPUT_TEXT;
+
+// Number of code generation threads, 0 = one per CPU
+int codegen_jobs = 0;
+
+// Reuse executables and shard objects from the compilation cache
+int use_cache = 1;
+
+// Also write the generated module as textual IR to <output>.ll
+int emit_llvm = 0;
+
+// Replace statements by their cheapest equivalent form before code generation
+int use_egraph = 0;
+
+// Replace statements by a minimal sum of products when that is smaller
+int use_minimize = 0;
+
+// Merge operator chains into n-ary nodes before code generation
+int use_flatten = 0;
+
+// Generate binary results from an optimized And-Inverter Graph
+int use_aig = 0;
+
+// Generate binary results of small-support subexpressions as truth-table lookups
+int use_lookup_tables = 0;
+
+// Generate binary results as branches through a decision diagram of each statement
+int use_decision_diagrams = 0;
+
+// Branch profile the generated program writes, and the one that orders AND and OR operands
+const char* profile_generate_path = NULL;
+const char* profile_use_path = NULL;
+
+// Check two programs for equivalence instead of compiling one
+int equivalence_mode = 0;
+
+// Count the satisfying assignments of each statement instead of compiling
+int count_mode = 0;
+
+// Explain the value of each statement instead of compiling
+int explain_mode = 0;
+
+// Report witnesses and counterexamples of quantified statements instead of compiling
+int witness_mode = 0;
+
+// SAT conflicts --equiv spends on one statement pair before giving up on it
+#define EQUIVALENCE_CONFLICT_LIMIT 100000
+
+// Variables whose values the generated program reads from its environment
+char** runtime_variables = NULL;
+int runtime_variable_count = 0;
+
+// Add the comma-separated names in list to runtime_variables; returns 0 on success
+int add_runtime_variables(const char* list) {
+    char* copy = strdup(list);
+    if (!copy) return 1;
+    
+    for (char* name = strtok(copy, ","); name; name = strtok(NULL, ",")) {
+        if (strlen(name) >= MAX_SYMBOL_NAME_LENGTH) {
+            fprintf(stderr, "Error: Runtime variable name '%s' is too long\n", name);
+            free(copy);
+            return 1;
         }
-        
-        line = strtok(NULL, "\n");
+        char** names = realloc(runtime_variables, (runtime_variable_count + 1) * sizeof(char*));
+        if (!names || !(names[runtime_variable_count] = strdup(name))) {
+            if (names) runtime_variables = names;
+            free(copy);
+            return 1;
+        }
+        runtime_variables = names;
+        runtime_variable_count++;
     }
-    
-    free(buffer);
+    free(copy);
+    return 0;
 }
 
-// Function to read a file line by line and parse each statement
-MultiStatementAST* parse_file_by_lines(const char* input_file, SymbolTable* symbol_table) {
-    MultiStatementAST* ast = init_multi_statement_ast();
-    if (!ast) return NULL;
+void free_runtime_variables(void) {
+    for (int i = 0; i < runtime_variable_count; i++) free(runtime_variables[i]);
+    free(runtime_variables);
+}
+
+// Evaluate the program's assignments in dependency order and enter them
+// into the symbol table; returns 0 on success
+int process_assignments(AssignmentGraph* assignments, SymbolTable* symbol_table) {
+    printf("Pre-processing assignments...\n");
     
-    // First read the entire file
-    char* file_contents = read_file_contents(input_file);
-    if (!file_contents) {
-        free_multi_statement_ast(ast);
-        return NULL;
+    char* error_message = NULL;
+    AssignmentGraphError status = resolve_assignment_graph(assignments, symbol_table, &error_message);
+    if (status == ASSIGNMENT_GRAPH_OK) {
+        status = evaluate_assignment_graph(assignments, symbol_table,
+                                           codegen_jobs > 0 ? codegen_jobs : thread_pool_cpu_count(),
+                                           &error_message);
+    }
+    if (status != ASSIGNMENT_GRAPH_OK) {
+        fprintf(stderr, "Error: %s\n", error_message ? error_message : "Failed to evaluate assignments");
+        free(error_message);
+        return 1;
     }
     
-    // Pre-process assignments to build the symbol table
-    process_assignments(file_contents, symbol_table);
-    
-    // Now parse each line with the complete symbol table
-    char* buffer = strdup(file_contents);
-    if (!buffer) {
-        free(file_contents);
-        free_multi_statement_ast(ast);
-        return NULL;
+    for (int i = 0; i < assignments->count; i++) {
+        printf("Added variable '%s' with value %d to symbol table\n",
+               assignments->definitions[i].assignment->name, assignments->definitions[i].value);
     }
+    return 0;
+}
+
+// Parse every line of input_file, adding statements to ast and assignments
+// to the assignments graph; returns 0 on success
+int parse_program_lines(const char* input_file, MultiStatementAST* ast, AssignmentGraph* assignments) {
+    // First read the entire file
+    char* file_contents = read_file_contents(input_file);
+    if (!file_contents) return 1;
     
     // Process each line
-    char* line = strtok(buffer, "\n");
+    char* line = strtok(file_contents, "\n");
     int line_num = 0;
     
     while (line) {
@@ -251,17 +283,14 @@ MultiStatementAST* parse_file_by_lines(const char* input_file, SymbolTable* symb
         
         // Skip empty lines
         if (strlen(line) > 0) {
-            // Parse the line
-            FILE* temp = tmpfile();
+            // Parse the line straight from memory
+            FILE* temp = fmemopen(line, strlen(line), "r");
             if (!temp) {
-                fprintf(stderr, "Error: Failed to create temporary file\n");
+                fprintf(stderr, "Error: Failed to open line %d for parsing\n", line_num);
                 line = strtok(NULL, "\n");
                 continue;
             }
             
-            fputs(line, temp);
-            rewind(temp);
-            
             yyin = temp;
             parsed_expression = NULL;
             int parse_result = yyparse();
@@ -273,12 +302,11 @@ MultiStatementAST* parse_file_by_lines(const char* input_file, SymbolTable* symb
                 continue;
             }
             
-            // Skip assignment statements as they've already been processed
             if (parsed_expression->type != NODE_ASSIGN) {
                 // Add the statement to our multi-statement AST
                 add_statement(ast, parsed_expression);
-            } else {
-                // Free the parsed assignment statement as it's already been processed
+            } else if (add_assignment(assignments, parsed_expression, line_num) != 0) {
+                fprintf(stderr, "Warning: Invalid assignment at line %d: %s\n", line_num, line);
                 free_ast(parsed_expression);
             }
             parsed_expression = NULL;  // Reset for next parse
@@ -287,14 +315,94 @@ MultiStatementAST* parse_file_by_lines(const char* input_file, SymbolTable* symb
         line = strtok(NULL, "\n");
     }
     
-    free(buffer);
     free(file_contents);
+    return 0;
+}
+
+// Function to read a file line by line and parse each statement
+MultiStatementAST* parse_file_by_lines(const char* input_file, SymbolTable* symbol_table) {
+    MultiStatementAST* ast = init_multi_statement_ast();
+    if (!ast) return NULL;
+    
+    // Assignments may appear in any order, so they are collected here and
+    // evaluated once the whole file has been read
+    AssignmentGraph* assignments = init_assignment_graph();
+    if (!assignments) {
+        free_multi_statement_ast(ast);
+        return NULL;
+    }
+    
+    int status = parse_program_lines(input_file, ast, assignments);
+    if (status == 0) status = process_assignments(assignments, symbol_table);
+    free_assignment_graph(assignments);
+    if (status != 0) {
+        free_multi_statement_ast(ast);
+        return NULL;
+    }
     
     return ast;
 }
 
-// Global variable for optimization level
-int optimization_level = 0;
+// Perform semantic analysis on each expression in the AST, reporting every
+// diagnostic before giving up. Analysis reads a frozen snapshot of the
+// symbols, so statements are independent and checked in parallel. With
+// free_variables, variables missing from symbol_table are not errors.
+// Returns 0 when every expression passes.
+int check_program_semantics(MultiStatementAST* multi_ast, const SymbolTable* symbol_table, int free_variables) {
+    SymbolSnapshot* symbols = snapshot_symbol_table(symbol_table);
+    Node** expressions = malloc((multi_ast->count > 0 ? multi_ast->count : 1) * sizeof(Node*));
+    SemanticAnalysisResult* semantic_results = calloc(multi_ast->count > 0 ? multi_ast->count : 1,
+                                                      sizeof(SemanticAnalysisResult));
+    if (!symbols || !expressions || !semantic_results) {
+        fprintf(stderr, "Error: Failed to initialize semantic analyzer\n");
+        free_symbol_snapshot(symbols);
+        free(expressions);
+        free(semantic_results);
+        return 1;
+    }
+    int expression_count = 0;
+    for (int i = 0; i < multi_ast->count; i++) {
+        Node* expr = multi_ast->statements[i];
+        
+        // Skip assignments since they've already been processed
+        if (expr && expr->type != NODE_ASSIGN) expressions[expression_count++] = expr;
+    }
+    analyze_statements(expressions, expression_count, symbols, codegen_jobs > 0 ? codegen_jobs : thread_pool_cpu_count(), semantic_results);
+    
+    // Report diagnostics in statement order
+    int semantic_errors = 0;
+    for (int i = 0; i < expression_count; i++) {
+        int failed = 0;
+        for (int d = 0; d < semantic_results[i].diagnostic_count; d++) {
+            if (free_variables && semantic_results[i].diagnostics[d].code == SEMANTIC_UNDEFINED_VARIABLE) continue;
+            fprintf(stderr, "Semantic error in expression: %s\n", semantic_results[i].diagnostics[d].message);
+            failed = 1;
+        }
+        semantic_errors += failed;
+        free_semantic_analysis_result(&semantic_results[i]);
+    }
+    free(semantic_results);
+    free(expressions);
+    free_symbol_snapshot(symbols);
+    
+    if (semantic_errors > 0) {
+        fprintf(stderr, "%d expression(s) failed semantic analysis\n", semantic_errors);
+        return 1;
+    }
+    return 0;
+}
+
+// Parse input_file and analyze its statements as compile_file does, for the
+// modes that evaluate the statements instead of compiling them. Returns NULL
+// once the errors are reported.
+MultiStatementAST* load_checked_program(const char* input_file, SymbolTable* symbol_table, int free_variables) {
+    MultiStatementAST* multi_ast = parse_file_by_lines(input_file, symbol_table);
+    if (multi_ast && check_program_semantics(multi_ast, symbol_table, free_variables) != 0) {
+        free_multi_statement_ast(multi_ast);
+        multi_ast = NULL;
+    }
+    return multi_ast;
+}
 
 // Function to compile a logical expression file
 int compile_file(const char* input_file, const char* output_file) {
@@ -322,110 +430,173 @@ int compile_file(const char* input_file, const char* output_file) {
                symbol_table->symbols[i].value ? "TRUE" : "FALSE");
     }
     
-    // Perform semantic analysis on each expression in the AST
-    for (int i = 0; i < multi_ast->count; i++) {
-        Node* expr = multi_ast->statements[i];
-        if (!expr) continue;
-        
-        // Skip assignments since they've already been processed
-        if (expr->type == NODE_ASSIGN) continue;
-        
-        SemanticAnalysisResult semantic_result = perform_semantic_analysis(expr, symbol_table);
-        if (semantic_result.error_code != SEMANTIC_OK) {
-            fprintf(stderr, "Semantic error in expression: %s\n", semantic_result.error_message);
-            if (semantic_result.error_message) free(semantic_result.error_message);
+    // Runtime variables are defined for the analysis, but never get a value
+    // at compile time
+    SymbolTable* analysis_table = symbol_table;
+    if (runtime_variable_count > 0) {
+        analysis_table = init_symbol_table();
+        int failed = !analysis_table;
+        for (int i = 0; i < symbol_table->size && !failed; i++) {
+            failed = add_or_update_symbol(analysis_table, symbol_table->symbols[i].name,
+                                          symbol_table->symbols[i].value) != 0;
+        }
+        for (int i = 0; i < runtime_variable_count && !failed; i++) {
+            if (get_symbol_value(symbol_table, runtime_variables[i]) != ERROR_SYMBOL_NOT_FOUND) {
+                fprintf(stderr, "Error: Runtime variable '%s' is also assigned in the input\n",
+                        runtime_variables[i]);
+                failed = 1;
+            } else {
+                failed = add_or_update_symbol(analysis_table, runtime_variables[i], 0) != 0;
+            }
+        }
+        if (failed) {
+            if (analysis_table) free_symbol_table(analysis_table);
             free_multi_statement_ast(multi_ast);
             free_symbol_table(symbol_table);
             return 1;
         }
     }
     
-    // Generate LLVM IR with optimizations
-    printf("Generating LLVM IR with optimization level -O%d...\n", optimization_level);
-    
-    // Create a temporary directory for intermediate files
-    char temp_dir[] = "/tmp/lec_XXXXXX";
-    if (!mkdtemp(temp_dir)) {
-        perror("Failed to create temporary directory");
+    int semantic_status = check_program_semantics(multi_ast, analysis_table, 0);
+    if (analysis_table != symbol_table) free_symbol_table(analysis_table);
+    if (semantic_status != 0) {
         free_multi_statement_ast(multi_ast);
         free_symbol_table(symbol_table);
         return 1;
     }
     
-    // Generate LLVM IR with the specified optimization level
-    LLVMCodegenResult ir_result = generate_llvm_ir(multi_ast, symbol_table, output_file, optimization_level);
-    if (ir_result.error_code != LLVM_CODEGEN_OK) {
-        fprintf(stderr, "LLVM code generation error: %s\n", 
-                ir_result.error_message ? ir_result.error_message : "Unknown error");
-        free_llvm_codegen_result(&ir_result);
-        free_multi_statement_ast(multi_ast);
-        free_symbol_table(symbol_table);
-        
-        // Clean up temp directory
-        char cmd[2048];
-        snprintf(cmd, sizeof(cmd), "rm -rf %s", temp_dir);
-        system(cmd);
-        return 1;
+    // Statements are optimized before hashing, so the cache key covers the code actually generated
+    if (runtime_variable_count > 0) {
+        int residual = partially_evaluate_statements(multi_ast->statements, multi_ast->count, symbol_table);
+        if (residual < 0) {
+            fprintf(stderr, "Error: Failed to specialize expressions\n");
+            free_multi_statement_ast(multi_ast);
+            free_symbol_table(symbol_table);
+            return 1;
+        }
+        printf("Specialized expressions: %d depend on runtime variables\n", residual);
+    }
+    if (use_minimize) {
+        MinimizeOptions minimize_options;
+        init_minimize_options(&minimize_options);
+        int minimized = minimize_statements(multi_ast->statements, multi_ast->count, &minimize_options,
+                                            codegen_jobs > 0 ? codegen_jobs : thread_pool_cpu_count());
+        printf("Minimized %d expression(s) to sums of products\n", minimized);
+    }
+    if (use_egraph) {
+        EGraphOptions egraph_options;
+        init_egraph_options(&egraph_options);
+        egraph_optimize_statements(multi_ast->statements, multi_ast->count, &egraph_options,
+                                   codegen_jobs > 0 ? codegen_jobs : thread_pool_cpu_count());
+    }
+    if (use_flatten) {
+        int flattened = flatten_statements(multi_ast->statements, multi_ast->count);
+        if (flattened < 0) {
+            fprintf(stderr, "Error: Failed to flatten expressions\n");
+            free_multi_statement_ast(multi_ast);
+            free_symbol_table(symbol_table);
+            return 1;
+        }
+        printf("Flattened %d operator chain(s) into n-ary operations\n", flattened);
     }
     
-    // Create a temporary IR file in the temp directory
-    char temp_ir_filename[2048];
-    snprintf(temp_ir_filename, sizeof(temp_ir_filename), "%s/temp.ll", temp_dir);
+    BranchProfile* profile = NULL;
+    if (profile_use_path) {
+        char* error_message = NULL;
+        profile = load_branch_profile(profile_use_path, &error_message);
+        if (!profile) {
+            fprintf(stderr, "Error: %s\n", error_message ? error_message : "Failed to read branch profile");
+            free(error_message);
+            free_multi_statement_ast(multi_ast);
+            free_symbol_table(symbol_table);
+            return 1;
+        }
+    }
     
-    // Save the IR to the temporary file first
-    LLVMCodegenResult temp_save = save_llvm_ir(ir_result.module, temp_ir_filename);
-    if (temp_save.error_code != LLVM_CODEGEN_OK) {
-        fprintf(stderr, "Warning: Failed to save temporary IR file: %s\n", 
-               temp_save.error_message ? temp_save.error_message : "Unknown error");
-        free_llvm_codegen_result(&temp_save);
-        // Continue anyway as this is not a critical error
+    LLVMCodegenOptions codegen_options = {
+        .optimization_level = optimization_level,
+        .output_format = output_format,
+        .jobs = codegen_jobs > 0 ? codegen_jobs : thread_pool_cpu_count(),
+        .emit_llvm = emit_llvm,
+        .use_aig = use_aig,
+        .use_lookup_tables = use_lookup_tables,
+        .use_decision_diagrams = use_decision_diagrams,
+        .runtime_variables = runtime_variables,
+        .runtime_variable_count = runtime_variable_count,
+        .profile_output = profile_generate_path,
+        .profile = profile,
+    };
+    
+    // Look the whole program up in the compilation cache
+    char* cache_dir = use_cache ? compile_cache_dir() : NULL;
+    char cache_key[CONTENT_HASH_HEX_LENGTH + 1];
+    if (cache_dir) {
+        ContentHash hash;
+        content_hash_init(&hash);
+        llvm_codegen_hash_options(&hash, &codegen_options);
+        content_hash_string(&hash, "program");
+        for (int i = 0; i < multi_ast->count; i++) {
+            content_hash_node(&hash, multi_ast->statements[i], symbol_table);
+        }
+        content_hash_hex(&hash, cache_key);
+        
+        // --emit-llvm needs the module, so it always regenerates
+        if (!emit_llvm && compile_cache_fetch(cache_dir, cache_key, ".exe", output_file)) {
+            printf("Compilation cache hit. Executable created: %s\n", output_file);
+            free(cache_dir);
+            free_branch_profile(profile);
+            free_multi_statement_ast(multi_ast);
+            free_symbol_table(symbol_table);
+            return 0;
+        }
+        codegen_options.cache_dir = cache_dir;
     }
     
-    // Create the output IR filename (same as output file but with .ll extension)
-    char ir_filename[2048];
-    snprintf(ir_filename, sizeof(ir_filename), "%s.ll", output_file);
+    // Generate LLVM IR with optimizations
+    printf("Generating LLVM IR with optimization level -O%d...\n", optimization_level);
     
-    // Save the IR to the final location
-    LLVMCodegenResult save_result = save_llvm_ir(ir_result.module, ir_filename);
-    if (save_result.error_code != LLVM_CODEGEN_OK) {
-        fprintf(stderr, "Failed to save LLVM IR: %s\n", 
-                save_result.error_message ? save_result.error_message : "Unknown error");
+    // Generate LLVM IR with the specified optimization level
+    LLVMCodegenResult ir_result = generate_llvm_ir_with_options(multi_ast, symbol_table, output_file, &codegen_options);
+    free_branch_profile(profile);
+    if (ir_result.error_code != LLVM_CODEGEN_OK) {
+        fprintf(stderr, "LLVM code generation error: %s\n", 
+                ir_result.error_message ? ir_result.error_message : "Unknown error");
+        free(cache_dir);
         free_llvm_codegen_result(&ir_result);
-        free_llvm_codegen_result(&save_result);
         free_multi_statement_ast(multi_ast);
         free_symbol_table(symbol_table);
-        // Clean up temp directory
-        char cmd[2048];
-        snprintf(cmd, sizeof(cmd), "rm -rf %s", temp_dir);
-        system(cmd);
         return 1;
     }
     
-    // Compile and link the generated IR
-    printf("Compiling and linking LLVM IR...\n");
-    LLVMCodegenResult compile_result = compile_and_link_ir(ir_filename, output_file);
-    
-    // Clean up intermediate files
-    char cleanup_cmd[4096];
-    snprintf(cleanup_cmd, sizeof(cleanup_cmd), "rm -rf %s", temp_dir);
-    system(cleanup_cmd);
+    // Link the compiled objects
+    printf("Linking object files...\n");
+    LLVMCodegenResult compile_result = link_object_files(ir_result.object_files, ir_result.object_count, output_file);
     
     if (compile_result.error_code != LLVM_CODEGEN_OK) {
         fprintf(stderr, "Compilation error: %s\n", 
                 compile_result.error_message ? compile_result.error_message : "Unknown error");
+        free(cache_dir);
         free_llvm_codegen_result(&ir_result);
-        free_llvm_codegen_result(&save_result);
         free_llvm_codegen_result(&compile_result);
         free_multi_statement_ast(multi_ast);
         free_symbol_table(symbol_table);
         return 1;
     }
     
+    if (cache_dir) {
+        if (compile_cache_store(cache_dir, cache_key, ".exe", output_file) != 0) {
+            fprintf(stderr, "Warning: Failed to store %s in the compilation cache\n", output_file);
+        }
+        compile_cache_trim(cache_dir, compile_cache_limit());
+        free(cache_dir);
+    }
+    
     // Clean up
     printf("Compilation successful. Executable created: %s\n", output_file);
-    printf("LLVM IR was saved to: %s\n", ir_filename);
+    if (emit_llvm) {
+        printf("LLVM IR was saved to: %s.ll\n", output_file);
+    }
     free_llvm_codegen_result(&ir_result);
-    free_llvm_codegen_result(&save_result);
     free_llvm_codegen_result(&compile_result);
     free_multi_statement_ast(multi_ast);
     free_symbol_table(symbol_table);
@@ -433,6 +604,241 @@ int compile_file(const char* input_file, const char* output_file) {
     return 0;
 }
 
+// Parse input_file for --equiv. Assignments are kept as definitions rather
+// than evaluated, since only definitions over other variables matter;
+// variables that are never assigned are the shared inputs.
+// Returns 0 on success.
+int load_equivalence_program(const char* input_file, MultiStatementAST** ast, AssignmentGraph** definitions) {
+    *ast = init_multi_statement_ast();
+    *definitions = init_assignment_graph();
+    int status = !*ast || !*definitions;
+    if (status != 0) {
+        fprintf(stderr, "Error: Failed to initialize the program structures\n");
+    } else if (parse_program_lines(input_file, *ast, *definitions) != 0) {
+        status = 1;
+    } else {
+        char* error_message = NULL;
+        if (resolve_assignment_graph(*definitions, NULL, &error_message) != ASSIGNMENT_GRAPH_OK) {
+            fprintf(stderr, "Error: %s: %s\n", input_file, error_message ? error_message : "Invalid assignments");
+            free(error_message);
+            status = 1;
+        }
+    }
+    return status;
+}
+
+void print_counterexample(int index, Node* old_statement, Node* new_statement, const EquivalenceResult* result) {
+    char* old_text = node_to_string(old_statement);
+    char* new_text = node_to_string(new_statement);
+    printf("Statement %d differs:\n", index + 1);
+    printf("  old: %s = %s\n", old_text ? old_text : "?", result->old_value ? "TRUE" : "FALSE");
+    printf("  new: %s = %s\n", new_text ? new_text : "?", result->new_value ? "TRUE" : "FALSE");
+    printf("  when");
+    for (int i = 0; i < result->input_count; i++) {
+        printf("%s %s = %s", i > 0 ? "," : "", result->input_names[i], result->input_values[i] ? "TRUE" : "FALSE");
+    }
+    printf("%s\n", result->input_count == 0 ? " always" : "");
+    free(old_text);
+    free(new_text);
+}
+
+// Check the statements of new_file against those of old_file; returns 0
+// when every pair is equivalent
+int check_equivalence_files(const char* old_file, const char* new_file) {
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    printf("Checking equivalence of '%s' and '%s'...\n", old_file, new_file);
+    
+    MultiStatementAST* old_ast = NULL;
+    MultiStatementAST* new_ast = NULL;
+    AssignmentGraph* old_definitions = NULL;
+    AssignmentGraph* new_definitions = NULL;
+    int status = load_equivalence_program(old_file, &old_ast, &old_definitions);
+    if (status == 0) status = load_equivalence_program(new_file, &new_ast, &new_definitions);
+    
+    int count = 0;
+    EquivalenceResult* results = NULL;
+    if (status == 0 && old_ast->count != new_ast->count) {
+        fprintf(stderr, "Error: '%s' has %d statements but '%s' has %d\n",
+                old_file, old_ast->count, new_file, new_ast->count);
+        status = 1;
+    }
+    if (status == 0) {
+        count = old_ast->count;
+        results = calloc(count > 0 ? count : 1, sizeof(EquivalenceResult));
+        if (!results) {
+            fprintf(stderr, "Error: Failed to allocate the equivalence results\n");
+            count = 0;
+            status = 1;
+        }
+    }
+    
+    if (results) {
+        EquivalenceProgram old_program = {old_ast->statements, old_definitions};
+        EquivalenceProgram new_program = {new_ast->statements, new_definitions};
+        char* error_message = NULL;
+        if (check_equivalence(&old_program, &new_program, count, EQUIVALENCE_CONFLICT_LIMIT,
+                              results, &error_message) != 0) {
+            fprintf(stderr, "Error: %s\n", error_message ? error_message : "Equivalence check failed");
+            free(error_message);
+            free(results);
+            results = NULL;
+            status = 1;
+        }
+    }
+    
+    if (results) {
+        int verdicts[EQUIVALENCE_UNDECIDED + 1] = {0};
+        for (int i = 0; i < count; i++) {
+            verdicts[results[i].verdict]++;
+            if (results[i].verdict == EQUIVALENCE_DIFFERENT) {
+                print_counterexample(i, old_ast->statements[i], new_ast->statements[i], &results[i]);
+            } else if (results[i].verdict == EQUIVALENCE_UNDECIDED) {
+                printf("Statement %d: undecided after %d SAT conflicts\n", i + 1, EQUIVALENCE_CONFLICT_LIMIT);
+            }
+            free_equivalence_result(&results[i]);
+        }
+        free(results);
+        
+        clock_gettime(CLOCK_MONOTONIC, &end);
+        printf("%d of %d statement(s) equivalent (%d by structural hashing, %d by sweeping, %d by SAT), "
+               "%d differ, %d undecided, in %.3f seconds\n",
+               verdicts[EQUIVALENT_BY_HASHING] + verdicts[EQUIVALENT_BY_SWEEPING] + verdicts[EQUIVALENT_BY_SAT],
+               count, verdicts[EQUIVALENT_BY_HASHING], verdicts[EQUIVALENT_BY_SWEEPING], verdicts[EQUIVALENT_BY_SAT],
+               verdicts[EQUIVALENCE_DIFFERENT], verdicts[EQUIVALENCE_UNDECIDED],
+               (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9);
+        if (verdicts[EQUIVALENCE_DIFFERENT] > 0 || verdicts[EQUIVALENCE_UNDECIDED] > 0) status = 1;
+    }
+    
+    if (old_ast) free_multi_statement_ast(old_ast);
+    if (new_ast) free_multi_statement_ast(new_ast);
+    if (old_definitions) free_assignment_graph(old_definitions);
+    if (new_definitions) free_assignment_graph(new_definitions);
+    return status;
+}
+
+// Print the number of assignments to its free variables that make each
+// statement of input_file TRUE; returns 0 on success
+int count_file_models(const char* input_file) {
+    SymbolTable* symbol_table = init_symbol_table();
+    if (!symbol_table) {
+        fprintf(stderr, "Error: Failed to initialize symbol table\n");
+        return 1;
+    }
+    MultiStatementAST* multi_ast = load_checked_program(input_file, symbol_table, 1);
+    if (!multi_ast) {
+        free_symbol_table(symbol_table);
+        return 1;
+    }
+    
+    int status = 0;
+    for (int i = 0; i < multi_ast->count; i++) {
+        ModelCount models;
+        char* error_message = NULL;
+        if (count_models(multi_ast->statements[i], symbol_table, &models, &error_message) != 0) {
+            fprintf(stderr, "Error: Statement %d: %s\n", i + 1, error_message ? error_message : "Model counting failed");
+            free(error_message);
+            status = 1;
+            continue;
+        }
+        printf("Statement %d: %s of 2^%d assignments make it TRUE (p = %.6g)\n",
+               i + 1, models.count, models.variable_count, models.fraction);
+        free_model_count(&models);
+    }
+    
+    free_multi_statement_ast(multi_ast);
+    free_symbol_table(symbol_table);
+    return status;
+}
+
+// Print a prime implicant of the value of each statement of input_file
+// under its assignments; returns 0 on success
+int explain_file_statements(const char* input_file) {
+    SymbolTable* symbol_table = init_symbol_table();
+    if (!symbol_table) {
+        fprintf(stderr, "Error: Failed to initialize symbol table\n");
+        return 1;
+    }
+    MultiStatementAST* multi_ast = load_checked_program(input_file, symbol_table, 0);
+    if (!multi_ast) {
+        free_symbol_table(symbol_table);
+        return 1;
+    }
+    
+    int status = 0;
+    for (int i = 0; i < multi_ast->count; i++) {
+        char* error_message = NULL;
+        Explanation explanation;
+        Explainer* explainer = create_explainer(multi_ast->statements[i], &error_message);
+        if (!explainer || explain_statement(explainer, symbol_table, &explanation, &error_message) != 0) {
+            fprintf(stderr, "Error: Statement %d: %s\n", i + 1, error_message ? error_message : "Explanation failed");
+            free(error_message);
+            free_explainer(explainer);
+            status = 1;
+            continue;
+        }
+        
+        printf("Statement %d is %s", i + 1, explanation.outcome ? "TRUE" : "FALSE");
+        for (int j = 0; j < explanation.count; j++) {
+            printf("%s %s = %s", j == 0 ? " because" : (j == explanation.count - 1 ? " and" : ","),
+                   explanation.names[j], explanation.values[j] ? "TRUE" : "FALSE");
+        }
+        printf("%s\n", explanation.count == 0 ? " whatever the variables are" : "");
+        free_explainer(explainer);
+    }
+    
+    free_multi_statement_ast(multi_ast);
+    free_symbol_table(symbol_table);
+    return status;
+}
+
+// Print the value of each statement of input_file under its assignments,
+// with a binding of its leading quantifiers that decides it; returns 0 on
+// success
+int witness_file_statements(const char* input_file) {
+    SymbolTable* symbol_table = init_symbol_table();
+    if (!symbol_table) {
+        fprintf(stderr, "Error: Failed to initialize symbol table\n");
+        return 1;
+    }
+    MultiStatementAST* multi_ast = load_checked_program(input_file, symbol_table, 0);
+    if (!multi_ast) {
+        free_symbol_table(symbol_table);
+        return 1;
+    }
+    
+    int status = 0;
+    for (int i = 0; i < multi_ast->count; i++) {
+        QuantifierWitness witness;
+        char* error_message = NULL;
+        if (find_quantifier_witness(multi_ast->statements[i], symbol_table, &witness, &error_message) != 0) {
+            fprintf(stderr, "Error: Statement %d: %s\n", i + 1, error_message ? error_message : "Witness search failed");
+            free(error_message);
+            status = 1;
+            continue;
+        }
+        
+        printf("Statement %d is %s", i + 1, witness.value ? "TRUE" : "FALSE");
+        if (witness.has_binding) {
+            printf(", %s", witness.value ? "witness" : "counterexample");
+            for (int j = 0; j < witness.count; j++) {
+                printf("%s %s = %s", j == 0 ? "" : ",", witness.names[j], witness.values[j] ? "TRUE" : "FALSE");
+            }
+        } else if (witness.count > 0) {
+            printf(" for every value of");
+            for (int j = 0; j < witness.count; j++) {
+                printf("%s %s", j == 0 ? "" : ",", witness.names[j]);
+            }
+        }
+        printf("\n");
+        free_quantifier_witness(&witness);
+    }
+    
+    free_multi_statement_ast(multi_ast);
+    free_symbol_table(symbol_table);
+    return status;
+}
+
 int main(int argc, char** argv) {
     // Check arguments
     if (argc < 2) {
@@ -441,17 +847,65 @@ int main(int argc, char** argv) {
     }
     
     const char* input_file = NULL;
+    const char* second_file = NULL;
     char* output_file = strdup("output"); // Default output file name
     
     // Parse command line arguments
     for (int i = 1; i < argc; i++) {
-        if (strncmp(argv[i], "-o", 2) == 0) {
+        if (strcmp(argv[i], "--binary-results") == 0) {
+            output_format = LLVM_OUTPUT_BINARY;
+        } else if (strcmp(argv[i], "--no-cache") == 0) {
+            use_cache = 0;
+        } else if (strcmp(argv[i], "--emit-llvm") == 0) {
+            emit_llvm = 1;
+        } else if (strcmp(argv[i], "--egraph") == 0) {
+            use_egraph = 1;
+        } else if (strcmp(argv[i], "--minimize") == 0) {
+            use_minimize = 1;
+        } else if (strcmp(argv[i], "--flatten") == 0) {
+            use_flatten = 1;
+        } else if (strcmp(argv[i], "--aig") == 0) {
+            use_aig = 1;
+        } else if (strcmp(argv[i], "--lookup-tables") == 0) {
+            use_lookup_tables = 1;
+        } else if (strcmp(argv[i], "--bdd") == 0) {
+            use_decision_diagrams = 1;
+        } else if (strcmp(argv[i], "--equiv") == 0) {
+            equivalence_mode = 1;
+        } else if (strcmp(argv[i], "--count") == 0) {
+            count_mode = 1;
+        } else if (strcmp(argv[i], "--explain") == 0) {
+            explain_mode = 1;
+        } else if (strcmp(argv[i], "--witness") == 0) {
+            witness_mode = 1;
+        } else if (strncmp(argv[i], "--profile-generate=", 19) == 0 && argv[i][19]) {
+            profile_generate_path = argv[i] + 19;
+        } else if (strncmp(argv[i], "--profile-use=", 14) == 0 && argv[i][14]) {
+            profile_use_path = argv[i] + 14;
+        } else if (strncmp(argv[i], "--runtime=", 10) == 0) {
+            if (add_runtime_variables(argv[i] + 10) != 0) {
+                fprintf(stderr, "Error: Invalid runtime variable list %s\n", argv[i] + 10);
+                free_runtime_variables();
+                free(output_file);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "-j", 2) == 0 && strlen(argv[i]) > 2) {
+            // Format: -jN (e.g., -j8)
+            codegen_jobs = atoi(argv[i] + 2);
+            if (codegen_jobs < 1) {
+                fprintf(stderr, "Error: Number of jobs must be at least 1\n");
+                free_runtime_variables();
+                free(output_file);
+                return 1;
+            }
+        } else if (strncmp(argv[i], "-o", 2) == 0) {
             // Handle optimization level
             if (strlen(argv[i]) > 2) {
                 // Format: -oN (e.g., -o2)
                 optimization_level = atoi(argv[i] + 2);
                 if (optimization_level < 0 || optimization_level > 3) {
                     fprintf(stderr, "Error: Optimization level must be between 0 and 3\n");
+                    free_runtime_variables();
                     free(output_file);
                     return 1;
                 }
@@ -462,12 +916,14 @@ int main(int argc, char** argv) {
                 input_file = argv[i];
             } else {
                 // Second non-option argument is treated as output file (for backward compatibility)
+                second_file = argv[i];
                 free(output_file);
                 output_file = strdup(argv[i]);
             }
         } else {
             fprintf(stderr, "Error: Unknown option %s\n", argv[i]);
             print_usage();
+            free_runtime_variables();
             free(output_file);
             return 1;
         }
@@ -476,10 +932,33 @@ int main(int argc, char** argv) {
     if (input_file == NULL) {
         fprintf(stderr, "Error: No input file specified\n");
         print_usage();
+        free_runtime_variables();
         free(output_file);
         return 1;
     }
     
+    if (equivalence_mode) {
+        int result = 1;
+        if (second_file == NULL) {
+            fprintf(stderr, "Error: --equiv needs an old and a new input file\n");
+            print_usage();
+        } else {
+            result = check_equivalence_files(input_file, second_file);
+        }
+        free(output_file);
+        free_runtime_variables();
+        return result;
+    }
+    
+    if (count_mode || explain_mode || witness_mode) {
+        int result = count_mode ? count_file_models(input_file)
+                   : explain_mode ? explain_file_statements(input_file)
+                   : witness_file_statements(input_file);
+        free(output_file);
+        free_runtime_variables();
+        return result;
+    }
+    
     printf("Compiling %s with optimization level -O%d\n", input_file, optimization_level);
     
     // Compile the file
@@ -487,6 +966,7 @@ int main(int argc, char** argv) {
     
     // Clean up
     free(output_file);
+    free_runtime_variables();
     
     return result;
 }
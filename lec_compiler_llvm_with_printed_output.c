@@ -8,6 +8,7 @@
 #include "C_Unlinked_Components/semantic_analyzer.h"
 #include "C_Unlinked_Components/multi_statement.h"
 #include "C_Unlinked_Components/llvm_codegen.h"
+#include "C_Unlinked_Components/assignment_graph.h"
 
 // External lexer functions and variables
 extern void print_tokens(void);  // Function to print all tokens (will be implemented in lexer)
@@ -280,100 +281,27 @@ char* read_file_contents(const char* input_file) {
 }
 
 // Pre-process assignments to build the symbol table
-void process_assignments(const char* file_contents, SymbolTable* symbol_table) {
-    // Silently pre-process assignments without printing a stage header
+// Evaluate the program's assignments in dependency order and enter them
+// into the symbol table; returns 0 on success
+int process_assignments(AssignmentGraph* assignments, SymbolTable* symbol_table) {
     printf("Pre-processing assignments...\n");
     
-    // Make a copy of the file contents
-    char* buffer = strdup(file_contents);
-    if (!buffer) return;
-    
-    // Process each line
-    char* line = strtok(buffer, "\n");
-    while (line) {
-        // Skip empty lines
-        if (strlen(line) > 0) {
-            // Check if this is a simple assignment (format: VAR = VALUE)
-            // We need to be more strict to avoid misinterpreting expressions like A -> B
-            if (strstr(line, "=") && !strstr(line, "=>") && !strstr(line, "-->") && 
-                !strstr(line, "<->") && !strstr(line, "<==>") && !strstr(line, "IMPLIES") && 
-                !strstr(line, "DOUBLEIMPLIES") && !strstr(line, "IFF")) {
-                // Simple direct parsing for TRUE/FALSE assignments
-                char var_name[MAX_SYMBOL_NAME_LENGTH] = {0};
-                char var_value[20] = {0};
-                
-                if (sscanf(line, "%49s = %19s", var_name, var_value) == 2) {
-                    int value = 0;
-                    
-                    // Check for TRUE/FALSE directly
-                    if (strcmp(var_value, "TRUE") == 0) {
-                        value = 1;
-                    } else if (strcmp(var_value, "FALSE") == 0) {
-                        value = 0;
-                    }
-                    
-                    // Add to symbol table
-                    add_or_update_symbol(symbol_table, var_name, value);
-                    printf("Added variable '%s' with value %d to symbol table\n", var_name, value);
-                    line = strtok(NULL, "\n");
-                    continue;
-                }
-                
-                // If direct parsing fails, use the parser
-                FILE* temp = tmpfile();
-                if (!temp) {
-                    fprintf(stderr, "Error: Failed to create temporary file\n");
-                    line = strtok(NULL, "\n");
-                    continue;
-                }
-                
-                fputs(line, temp);
-                rewind(temp);
-                
-                yyin = temp;
-                parsed_expression = NULL;
-                int parse_result = yyparse();
-                fclose(temp);
-                
-                if (parse_result == 0 && parsed_expression) {
-                    // If it's an assignment, extract the variable name and value
-                    if (parsed_expression->type == NODE_ASSIGN && parsed_expression->name) {
-                        int value = 0;
-                        if (parsed_expression->right) {
-                            if (parsed_expression->right->type == NODE_BOOL) {
-                                value = parsed_expression->right->bool_val;
-                            } else if (parsed_expression->right->type == NODE_VAR) {
-                                if (parsed_expression->right->name) {
-                                    if (strcmp(parsed_expression->right->name, "TRUE") == 0) {
-                                        value = 1;
-                                    } else if (strcmp(parsed_expression->right->name, "FALSE") == 0) {
-                                        value = 0;
-                                    }
-                                }
-                            }
-                        }
-                        
-                        // Add the variable to the symbol table
-                        char* var_name = strdup(parsed_expression->name);
-                        add_or_update_symbol(symbol_table, var_name, value);
-                        printf("Added variable '%s' with value %d to symbol table\n", 
-                               var_name, value);
-                        free(var_name);
-                    }
-                    
-                    // Free the parsed expression
-                    if (parsed_expression) {
-                        free_ast(parsed_expression);
-                        parsed_expression = NULL;
-                    }
-                }
-            }
-        }
-        
-        line = strtok(NULL, "\n");
+    char* error_message = NULL;
+    AssignmentGraphError status = resolve_assignment_graph(assignments, symbol_table, &error_message);
+    if (status == ASSIGNMENT_GRAPH_OK) {
+        status = evaluate_assignment_graph(assignments, symbol_table, 1, &error_message);
+    }
+    if (status != ASSIGNMENT_GRAPH_OK) {
+        fprintf(stderr, "Error: %s\n", error_message ? error_message : "Failed to evaluate assignments");
+        free(error_message);
+        return 1;
     }
     
-    free(buffer);
+    for (int i = 0; i < assignments->count; i++) {
+        printf("Added variable '%s' with value %d to symbol table\n",
+               assignments->definitions[i].assignment->name, assignments->definitions[i].value);
+    }
+    return 0;
 }
 
 // Function to read a file line by line and parse each statement
@@ -393,19 +321,17 @@ MultiStatementAST* parse_file_by_lines(const char* input_file, SymbolTable* symb
     // Display token summary for the entire file
     display_file_tokens(file_contents);
     
-    // Pre-process assignments to build the symbol table
-    process_assignments(file_contents, symbol_table);
-    
-    // Now parse each line with the complete symbol table
-    char* buffer = strdup(file_contents);
-    if (!buffer) {
+    // Assignments may appear in any order, so they are collected here and
+    // evaluated once the whole file has been read
+    AssignmentGraph* assignments = init_assignment_graph();
+    if (!assignments) {
         free(file_contents);
         free_multi_statement_ast(ast);
         return NULL;
     }
     
     // Process each line
-    char* line = strtok(buffer, "\n");
+    char* line = strtok(file_contents, "\n");
     int line_num = 0;
     
     while (line) {
@@ -413,17 +339,14 @@ MultiStatementAST* parse_file_by_lines(const char* input_file, SymbolTable* symb
         
         // Skip empty lines
         if (strlen(line) > 0) {
-            // Parse the line
-            FILE* temp = tmpfile();
+            // Parse the line straight from memory
+            FILE* temp = fmemopen(line, strlen(line), "r");
             if (!temp) {
-                fprintf(stderr, "Error: Failed to create temporary file\n");
+                fprintf(stderr, "Error: Failed to open line %d for parsing\n", line_num);
                 line = strtok(NULL, "\n");
                 continue;
             }
             
-            fputs(line, temp);
-            rewind(temp);
-            
             // Now parse the expression
             yyin = temp;
             parsed_expression = NULL;
@@ -436,12 +359,11 @@ MultiStatementAST* parse_file_by_lines(const char* input_file, SymbolTable* symb
                 continue;
             }
             
-            // Skip assignment statements as they've already been processed
             if (parsed_expression->type != NODE_ASSIGN) {
                 // Add the statement to our multi-statement AST
                 add_statement(ast, parsed_expression);
-            } else {
-                // Free the parsed assignment statement as it's already been processed
+            } else if (add_assignment(assignments, parsed_expression, line_num) != 0) {
+                fprintf(stderr, "Warning: Invalid assignment at line %d: %s\n", line_num, line);
                 free_ast(parsed_expression);
             }
             parsed_expression = NULL;  // Reset for next parse
@@ -450,9 +372,15 @@ MultiStatementAST* parse_file_by_lines(const char* input_file, SymbolTable* symb
         line = strtok(NULL, "\n");
     }
     
-    free(buffer);
     free(file_contents);
     
+    int status = process_assignments(assignments, symbol_table);
+    free_assignment_graph(assignments);
+    if (status != 0) {
+        free_multi_statement_ast(ast);
+        return NULL;
+    }
+    
     printf("Parsing complete.\n");
     
     // Print the complete AST for all statements
@@ -539,6 +467,15 @@ void print_ast_with_indent(Node* node, int indent_level) {
             printf("FORALL: %s\n", node->name);
             print_ast_with_indent(node->right, indent_level + 1);
             break;
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY:
+            printf("%s: %d\n", node->type == NODE_ATLEAST ? "ATLEAST" : node->type == NODE_ATMOST ? "ATMOST" : "EXACTLY",
+                   node->threshold);
+            for (int i = 0; i < node->child_count; i++) {
+                print_ast_with_indent(node->children[i], indent_level + 1);
+            }
+            break;
         case NODE_ASSIGN:
             printf("ASSIGNMENT: %s = \n", node->name);
             if (node->left) {
@@ -684,6 +621,15 @@ void print_ast_with_values(Node* node, int indent_level, SymbolTable* symbol_tab
             printf("FORALL: %s\n", node->name);
             print_ast_with_values(node->right, indent_level + 1, symbol_table);
             break;
+        case NODE_ATLEAST:
+        case NODE_ATMOST:
+        case NODE_EXACTLY:
+            printf("%s: %d\n", node->type == NODE_ATLEAST ? "ATLEAST" : node->type == NODE_ATMOST ? "ATMOST" : "EXACTLY",
+                   node->threshold);
+            for (int i = 0; i < node->child_count; i++) {
+                print_ast_with_values(node->children[i], indent_level + 1, symbol_table);
+            }
+            break;
         case NODE_ASSIGN:
             printf("ASSIGNMENT: %s = \n", node->name);
             if (node->left) {
@@ -784,24 +730,47 @@ int compile_file(const char* input_file, const char* output_file) {
     // Semantic analysis (skip header, just do the analysis)
     // printf("\n[STAGE 2: SEMANTIC ANALYSIS]\n");
     // printf("Performing semantic analysis...\n");
+    // Analysis reads a frozen snapshot of the symbols, so statements are
+    // independent and can be checked in parallel
+    SymbolSnapshot* symbols = snapshot_symbol_table(symbol_table);
+    Node** expressions = malloc((multi_ast->count > 0 ? multi_ast->count : 1) * sizeof(Node*));
+    SemanticAnalysisResult* semantic_results = calloc(multi_ast->count > 0 ? multi_ast->count : 1,
+                                                      sizeof(SemanticAnalysisResult));
+    if (!symbols || !expressions || !semantic_results) {
+        fprintf(stderr, "Error: Failed to initialize semantic analyzer\n");
+        free_symbol_snapshot(symbols);
+        free(expressions);
+        free(semantic_results);
+        free_multi_statement_ast(multi_ast);
+        free_symbol_table(symbol_table);
+        return 1;
+    }
+    int expression_count = 0;
     for (int i = 0; i < multi_ast->count; i++) {
         Node* expr = multi_ast->statements[i];
-        if (!expr) continue;
         
         // Skip assignments since they've already been processed
-        if (expr->type == NODE_ASSIGN) continue;
-        
-        SemanticAnalysisResult analysis_result = perform_semantic_analysis(expr, symbol_table);
-        if (analysis_result.error_code != SEMANTIC_OK) {
-            fprintf(stderr, "Semantic error: %s\n", 
-                    analysis_result.error_message ? analysis_result.error_message : "Unknown error");
-            if (analysis_result.error_message) {
-                free(analysis_result.error_message);
-            }
-            free_multi_statement_ast(multi_ast);
-            free_symbol_table(symbol_table);
-            return 1;
+        if (expr && expr->type != NODE_ASSIGN) expressions[expression_count++] = expr;
+    }
+    analyze_statements(expressions, expression_count, symbols, 1, semantic_results);
+    
+    // Report diagnostics in statement order
+    int semantic_errors = 0;
+    for (int i = 0; i < expression_count; i++) {
+        for (int d = 0; d < semantic_results[i].diagnostic_count; d++) {
+            fprintf(stderr, "Semantic error: %s\n", semantic_results[i].diagnostics[d].message);
         }
+        if (semantic_results[i].error_code != SEMANTIC_OK) semantic_errors++;
+        free_semantic_analysis_result(&semantic_results[i]);
+    }
+    free(semantic_results);
+    free(expressions);
+    free_symbol_snapshot(symbols);
+    
+    if (semantic_errors > 0) {
+        free_multi_statement_ast(multi_ast);
+        free_symbol_table(symbol_table);
+        return 1;
     }
     
     // Generate LLVM IR
@@ -812,15 +781,6 @@ int compile_file(const char* input_file, const char* output_file) {
     
     printf("Generating LLVM IR...\n");
     
-    // Create a temporary directory for intermediate files
-    char temp_dir[] = "/tmp/lec_XXXXXX";
-    if (!mkdtemp(temp_dir)) {
-        perror("Failed to create temporary directory");
-        free_multi_statement_ast(multi_ast);
-        free_symbol_table(symbol_table);
-        return 1;
-    }
-    
     // Print symbol table for codegen (just once)
     printf("\nSymbol table at codegen time (size: %d):\n", symbol_table->size);
     for (int i = 0; i < symbol_table->size; i++) {
@@ -838,64 +798,24 @@ int compile_file(const char* input_file, const char* output_file) {
         free_llvm_codegen_result(&ir_result);
         free_multi_statement_ast(multi_ast);
         free_symbol_table(symbol_table);
-        
-        // Clean up temp directory
-        char cmd[2048];
-        snprintf(cmd, sizeof(cmd), "rm -rf %s", temp_dir);
-        system(cmd);
         return 1;
     }
     
     // Print semantic analysis results
     print_semantic_analysis_results(multi_ast, symbol_table);
     
-    // Create a temporary IR file in the temp directory
-    char temp_ir_filename[2048];
-    snprintf(temp_ir_filename, sizeof(temp_ir_filename), "%s/temp.ll", temp_dir);
-    
-    // Save the IR to the temporary file first
-    LLVMCodegenResult temp_save = save_llvm_ir(ir_result.module, temp_ir_filename);
-    if (temp_save.error_code != LLVM_CODEGEN_OK) {
-        fprintf(stderr, "Warning: Failed to save temporary IR file: %s\n", 
-               temp_save.error_message ? temp_save.error_message : "Unknown error");
-        free_llvm_codegen_result(&temp_save);
-        // Continue anyway as this is not a critical error
-    }
-    
-    // Create the output IR filename (same as output file but with .ll extension)
+    // generate_llvm_ir writes <output>.ll and compiles the module to objects
     char ir_filename[2048];
     snprintf(ir_filename, sizeof(ir_filename), "%s.ll", output_file);
     
-    // Save the IR to the final location
-    LLVMCodegenResult save_result = save_llvm_ir(ir_result.module, ir_filename);
-    if (save_result.error_code != LLVM_CODEGEN_OK) {
-        fprintf(stderr, "Failed to save LLVM IR: %s\n", 
-                save_result.error_message ? save_result.error_message : "Unknown error");
-        free_llvm_codegen_result(&ir_result);
-        free_llvm_codegen_result(&save_result);
-        free_multi_statement_ast(multi_ast);
-        free_symbol_table(symbol_table);
-        // Clean up temp directory
-        char cmd[2048];
-        snprintf(cmd, sizeof(cmd), "rm -rf %s", temp_dir);
-        system(cmd);
-        return 1;
-    }
-    
-    // Compile and link the generated IR
-    printf("Compiling and linking LLVM IR...\n");
-    LLVMCodegenResult compile_result = compile_and_link_ir(ir_filename, output_file);
-    
-    // Clean up intermediate files
-    char cleanup_cmd[4096];
-    snprintf(cleanup_cmd, sizeof(cleanup_cmd), "rm -rf %s", temp_dir);
-    system(cleanup_cmd);
+    // Link the compiled objects
+    printf("Linking object files...\n");
+    LLVMCodegenResult compile_result = link_object_files(ir_result.object_files, ir_result.object_count, output_file);
     
     if (compile_result.error_code != LLVM_CODEGEN_OK) {
         fprintf(stderr, "Compilation error: %s\n", 
                 compile_result.error_message ? compile_result.error_message : "Unknown error");
         free_llvm_codegen_result(&ir_result);
-        free_llvm_codegen_result(&save_result);
         free_llvm_codegen_result(&compile_result);
         free_multi_statement_ast(multi_ast);
         free_symbol_table(symbol_table);
@@ -906,7 +826,6 @@ int compile_file(const char* input_file, const char* output_file) {
     printf("Compilation successful. Executable created: %s\n", output_file);
     printf("LLVM IR was saved to: %s\n", ir_filename);
     free_llvm_codegen_result(&ir_result);
-    free_llvm_codegen_result(&save_result);
     free_llvm_codegen_result(&compile_result);
     free_multi_statement_ast(multi_ast);
     free_symbol_table(symbol_table);
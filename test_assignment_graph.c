@@ -0,0 +1,205 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "C_Unlinked_Components/assignment_graph.h"
+#include "test_helpers.h"
+
+// Parse each definition into graph, numbering lines from 1; returns 0 on success
+static int add_definitions(AssignmentGraph* graph, const char* const* texts, int count) {
+    for (int i = 0; i < count; i++) {
+        Node* assignment = parse_test_statement(texts[i]);
+        if (!assignment) return -1;
+        if (add_assignment(graph, assignment, i + 1) != 0) {
+            printf("  Error: '%s' is not an assignment\n", texts[i]);
+            free_ast(assignment);
+            test_failures++;
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Layer of every definition, from the resolved order
+static void definition_layers(const AssignmentGraph* graph, int* layers) {
+    for (int layer = 0; layer < graph->layer_count; layer++) {
+        for (int i = graph->layer_offsets[layer]; i < graph->layer_offsets[layer + 1]; i++) {
+            layers[graph->order[i]] = layer;
+        }
+    }
+}
+
+void test_layers_and_values() {
+    printf("Testing layers and values of a resolved graph\n");
+    const char* texts[] = {
+        "E = D XOR C",
+        "C = A AND B",
+        "F = NOT B",
+        "D = C OR F",
+        "G = E_Q Z (Z AND D)",
+    };
+    AssignmentGraph* graph = init_assignment_graph();
+    SymbolTable* symbol_table = init_symbol_table();
+    add_or_update_symbol(symbol_table, "A", 1);
+    add_or_update_symbol(symbol_table, "B", 1);
+    if (add_definitions(graph, texts, 5) != 0) goto cleanup;
+
+    char* error_message = NULL;
+    AssignmentGraphError status = resolve_assignment_graph(graph, symbol_table, &error_message);
+    check(status == ASSIGNMENT_GRAPH_OK, "definitions in any order resolve");
+    if (status != ASSIGNMENT_GRAPH_OK) {
+        printf("  Error: %s\n", error_message ? error_message : "?");
+        free(error_message);
+        goto cleanup;
+    }
+    check(graph->layer_count == 3, "three layers");
+
+    int layers[5];
+    definition_layers(graph, layers);
+    int ordered = 1;
+    for (int i = 0; i < graph->count; i++) {
+        for (int d = 0; d < graph->definitions[i].dependency_count; d++) {
+            if (layers[graph->definitions[i].dependencies[d]] >= layers[i]) ordered = 0;
+        }
+    }
+    check(ordered, "every definition comes after the ones it reads");
+    check(graph->definitions[0].dependency_count == 2, "E reads C and D once each");
+
+    status = evaluate_assignment_graph(graph, symbol_table, 1, &error_message);
+    check(status == ASSIGNMENT_GRAPH_OK, "graph evaluates");
+    check(get_symbol_value(symbol_table, "C") == 1 && get_symbol_value(symbol_table, "F") == 0 &&
+          get_symbol_value(symbol_table, "D") == 1 && get_symbol_value(symbol_table, "E") == 0 &&
+          get_symbol_value(symbol_table, "G") == 1, "values are stored in the symbol table");
+
+    // Redefining a variable replaces its expression for every reader
+    Node* redefinition = parse_test_statement("C = A AND NOT B");
+    if (redefinition && add_assignment(graph, redefinition, 6) == 0) {
+        status = resolve_assignment_graph(graph, symbol_table, &error_message);
+        if (status == ASSIGNMENT_GRAPH_OK) status = evaluate_assignment_graph(graph, symbol_table, 1, &error_message);
+        check(status == ASSIGNMENT_GRAPH_OK && graph->count == 5, "redefinition keeps one definition");
+        check(get_symbol_value(symbol_table, "C") == 0 && get_symbol_value(symbol_table, "D") == 0 &&
+              get_symbol_value(symbol_table, "E") == 0, "readers see the last definition");
+    }
+
+cleanup:
+    free_assignment_graph(graph);
+    free_symbol_table(symbol_table);
+    printf("\n");
+}
+
+void test_errors() {
+    printf("Testing rejected graphs\n");
+    const char* cycle[] = {"X = A AND Y", "Y = Z OR B", "Z = NOT X"};
+    AssignmentGraph* graph = init_assignment_graph();
+    SymbolTable* symbol_table = init_symbol_table();
+    add_or_update_symbol(symbol_table, "A", 1);
+    add_or_update_symbol(symbol_table, "B", 0);
+    if (add_definitions(graph, cycle, 3) == 0) {
+        char* error_message = NULL;
+        AssignmentGraphError status = resolve_assignment_graph(graph, symbol_table, &error_message);
+        check(status == ASSIGNMENT_GRAPH_CYCLE, "cycles are rejected");
+        check(error_message && strstr(error_message, "X -> Y -> Z -> X"), "the cycle is named");
+        free(error_message);
+    }
+    free_assignment_graph(graph);
+
+    const char* undefined[] = {"X = A AND Q"};
+    graph = init_assignment_graph();
+    if (add_definitions(graph, undefined, 1) == 0) {
+        char* error_message = NULL;
+        AssignmentGraphError status = resolve_assignment_graph(graph, symbol_table, &error_message);
+        check(status == ASSIGNMENT_GRAPH_UNDEFINED_VARIABLE, "undefined variables are rejected");
+        check(error_message && strstr(error_message, "'Q'"), "the undefined variable is named");
+        free(error_message);
+    }
+    free_assignment_graph(graph);
+
+    // Without a symbol table, names that are never assigned are free inputs
+    const char* free_inputs[] = {"X = A AND Q", "Y = X OR R"};
+    graph = init_assignment_graph();
+    if (add_definitions(graph, free_inputs, 2) == 0) {
+        char* error_message = NULL;
+        check(resolve_assignment_graph(graph, NULL, &error_message) == ASSIGNMENT_GRAPH_OK && graph->layer_count == 2,
+              "free inputs resolve without a symbol table");
+        free(error_message);
+    }
+    free_assignment_graph(graph);
+
+    graph = init_assignment_graph();
+    if (add_definitions(graph, cycle, 3) == 0) {
+        char* error_message = NULL;
+        check(resolve_assignment_graph(graph, NULL, &error_message) == ASSIGNMENT_GRAPH_CYCLE,
+              "cycles are still rejected without a symbol table");
+        free(error_message);
+    }
+    free_assignment_graph(graph);
+
+    Node* statement = parse_test_statement("A AND B");
+    graph = init_assignment_graph();
+    if (statement) {
+        check(add_assignment(graph, statement, 1) == -1, "only assignments are added");
+        free_ast(statement);
+    }
+    free_assignment_graph(graph);
+    free_symbol_table(symbol_table);
+    printf("\n");
+}
+
+void test_parallel_layers() {
+    printf("Testing wide layers on several threads\n");
+    enum { WIDTH = 400 };
+    AssignmentGraph* sequential = init_assignment_graph();
+    AssignmentGraph* parallel = init_assignment_graph();
+    SymbolTable* sequential_symbols = init_symbol_table();
+    SymbolTable* parallel_symbols = init_symbol_table();
+    add_or_update_symbol(sequential_symbols, "A", 1);
+    add_or_update_symbol(sequential_symbols, "B", 0);
+    add_or_update_symbol(parallel_symbols, "A", 1);
+    add_or_update_symbol(parallel_symbols, "B", 0);
+
+    // WIDTH definitions in the first layer, each read by one in the second
+    char text[64];
+    int added = 1;
+    for (int i = 0; i < WIDTH && added; i++) {
+        snprintf(text, sizeof(text), i % 3 == 0 ? "V%d = A AND NOT B" : "V%d = A AND B", i);
+        Node* first = parse_test_statement(text);
+        Node* second = parse_test_statement(text);
+        snprintf(text, sizeof(text), "W%d = NOT V%d", i, i);
+        Node* reader = parse_test_statement(text);
+        Node* reader_copy = parse_test_statement(text);
+        added = first && second && reader && reader_copy &&
+                add_assignment(sequential, first, 2 * i + 1) == 0 && add_assignment(parallel, second, 2 * i + 1) == 0 &&
+                add_assignment(sequential, reader, 2 * i + 2) == 0 && add_assignment(parallel, reader_copy, 2 * i + 2) == 0;
+    }
+    check(added, "definitions added");
+
+    char* error_message = NULL;
+    int ok = added && resolve_assignment_graph(sequential, sequential_symbols, &error_message) == ASSIGNMENT_GRAPH_OK &&
+             resolve_assignment_graph(parallel, parallel_symbols, &error_message) == ASSIGNMENT_GRAPH_OK &&
+             evaluate_assignment_graph(sequential, sequential_symbols, 1, &error_message) == ASSIGNMENT_GRAPH_OK &&
+             evaluate_assignment_graph(parallel, parallel_symbols, 4, &error_message) == ASSIGNMENT_GRAPH_OK;
+    check(ok && parallel->layer_count == 2, "two layers evaluate on four threads");
+    free(error_message);
+
+    int same = ok;
+    for (int i = 0; i < WIDTH && same; i++) {
+        snprintf(text, sizeof(text), "W%d", i);
+        int value = get_symbol_value(parallel_symbols, text);
+        same = value == get_symbol_value(sequential_symbols, text) && value == (i % 3 != 0);
+    }
+    check(same, "threads compute the sequential values");
+
+    free_assignment_graph(sequential);
+    free_assignment_graph(parallel);
+    free_symbol_table(sequential_symbols);
+    free_symbol_table(parallel_symbols);
+    printf("\n");
+}
+
+int main() {
+    test_layers_and_values();
+    test_errors();
+    test_parallel_layers();
+
+    printf("%s\n", test_failures == 0 ? "All assignment graph tests passed" : "Assignment graph tests FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
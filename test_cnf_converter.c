@@ -0,0 +1,121 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "C_Unlinked_Components/cnf_converter.h"
+#include "test_helpers.h"
+
+// Whether some assignment of the variables after the fixed inputs satisfies
+// every clause of formula; exhaustive, so only for small encodings
+static int formula_satisfiable(const CNFFormula* formula, int variable_count, const int* inputs, int input_count) {
+    int values[32];
+    for (int v = 1; v <= input_count; v++) values[v] = inputs[v - 1];
+    int free_count = variable_count - input_count;
+    for (long rest = 0; rest < (1L << free_count); rest++) {
+        for (int v = input_count + 1; v <= variable_count; v++) values[v] = (rest >> (v - input_count - 1)) & 1;
+        int satisfied = 1;
+        for (long c = 0; c < formula->clause_count && satisfied; c++) {
+            int clause = 0;
+            for (long l = formula->clause_starts[c]; l < formula->clause_starts[c + 1] && !clause; l++) {
+                int literal = formula->literals[l];
+                clause = literal > 0 ? values[literal] : !values[-literal];
+            }
+            satisfied = clause;
+        }
+        if (satisfied) return 1;
+    }
+    return 0;
+}
+
+// The encoding is satisfiable with the inputs fixed exactly when the
+// expression is TRUE there; check every assignment of the inputs
+void test_expression(const char* text) {
+    printf("Testing expression: %s\n", text);
+    Node* node = parse_test_statement(text);
+    if (!node) return;
+
+    char* error_message = NULL;
+    CNFEncoder* encoder = create_cnf_encoder(node, &error_message);
+    if (!encoder) {
+        printf("  Error: %s\n", error_message ? error_message : "Failed to create the encoder");
+        free(error_message);
+        test_failures++;
+        free_ast(node);
+        return;
+    }
+
+    CNFFormula formula = {0};
+    int variable_count = get_cnf_variable_count(encoder);
+    if (emit_cnf_clauses(encoder, cnf_formula_sink, &formula) != 0 || variable_count >= 32) {
+        printf("  Error: Failed to collect the clauses\n");
+        test_failures++;
+    } else {
+        check(formula.clause_count == get_cnf_clause_count(encoder), "clause count is known up front");
+        long last = formula.clause_count - 1;
+        check(last >= 0 && formula.clause_starts[last + 1] - formula.clause_starts[last] == 1,
+              "last clause asserts the expression");
+
+        int input_count = get_cnf_input_count(encoder);
+        int agrees = 1;
+        int inputs[32];
+        for (int assignment = 0; assignment < (1 << input_count); assignment++) {
+            SymbolTable* symbol_table = init_symbol_table();
+            for (int v = 1; v <= input_count; v++) {
+                inputs[v - 1] = (assignment >> (v - 1)) & 1;
+                add_or_update_symbol(symbol_table, get_cnf_input_name(encoder, v), inputs[v - 1]);
+            }
+            int expected = reference_value(node, symbol_table);
+            if (formula_satisfiable(&formula, variable_count, inputs, input_count) != expected) agrees = 0;
+            free_symbol_table(symbol_table);
+        }
+        check(agrees, "satisfiable for exactly the assignments that make it TRUE");
+
+        // The DIMACS header matches the streamed clauses
+        char header[64];
+        snprintf(header, sizeof(header), "p cnf %d %ld\n", variable_count, formula.clause_count);
+        FILE* out = tmpfile();
+        int has_header = 0;
+        if (out && write_dimacs_cnf(encoder, out) == 0) {
+            char line[256];
+            rewind(out);
+            while (fgets(line, sizeof(line), out)) has_header |= strcmp(line, header) == 0;
+        }
+        if (out) fclose(out);
+        check(has_header, "DIMACS header");
+    }
+
+    free_cnf_formula(&formula);
+    free_cnf_encoder(encoder);
+    free_ast(node);
+    printf("\n");
+}
+
+void test_quantifier_rejected() {
+    printf("Testing quantifiers\n");
+    Node* node = parse_test_statement("E_Q Z (Z AND A)");
+    if (!node) return;
+    char* error_message = NULL;
+    CNFEncoder* encoder = create_cnf_encoder(node, &error_message);
+    check(!encoder && error_message, "quantifiers have no encoding");
+    if (encoder) free_cnf_encoder(encoder);
+    free(error_message);
+    free_ast(node);
+    printf("\n");
+}
+
+int main() {
+    test_expression("A AND B");
+    test_expression("(A OR B) AND NOT (A AND B)");
+    test_expression("A AND NOT A");
+    test_expression("(A --> B) AND (B --> C) AND A AND NOT C");
+    test_expression("NOT ((A XOR B) <==> (A XNOR B))");
+    test_expression("(A === B) OR (C IMPLIES NOT A)");
+    test_expression("NOT (A AND (B OR NOT C)) XOR (D <==> A)");
+    test_expression("ATLEAST 2 (A, B, C, D)");
+    test_expression("ATMOST 1 (A, B, C) AND EXACTLY 2 (A, C, D, E)");
+    test_expression("NOT EXACTLY 3 (A, B OR C, NOT D, E, A XOR E)");
+    test_expression("ATLEAST 1 (A, TRUE) AND ATMOST 0 (B, FALSE)");
+    test_quantifier_rejected();
+
+    printf("%s\n", test_failures == 0 ? "All CNF converter tests passed" : "CNF converter tests FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
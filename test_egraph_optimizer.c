@@ -0,0 +1,132 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "C_Unlinked_Components/egraph_optimizer.h"
+#include "test_helpers.h"
+
+// Whether a and b agree on every assignment of the variables A to E
+static int same_function(const Node* a, const Node* b) {
+    const char* names[] = {"A", "B", "C", "D", "E"};
+    for (int assignment = 0; assignment < 32; assignment++) {
+        SymbolTable* symbol_table = init_symbol_table();
+        for (int i = 0; i < 5; i++) add_or_update_symbol(symbol_table, names[i], (assignment >> i) & 1);
+        int same = reference_value(a, symbol_table) == reference_value(b, symbol_table);
+        free_symbol_table(symbol_table);
+        if (!same) return 0;
+    }
+    return 1;
+}
+
+// Optimize text with options, checking the result is equivalent and no
+// more expensive; returns the optimized expression as a string
+static char* optimize(const char* text, const EGraphOptions* options, EGraphStats* stats) {
+    Node* node = parse_test_statement(text);
+    if (!node) return NULL;
+    Node* optimized = egraph_optimize(node, options, stats);
+    char* result = optimized ? node_to_string(optimized) : NULL;
+    printf("  %s => %s (cost %ld -> %ld, %d e-nodes)\n", text, result ? result : "(null)",
+           stats->input_cost, stats->output_cost, stats->node_count);
+    check(optimized && same_function(node, optimized), "optimized form is equivalent");
+    check(stats->output_cost <= stats->input_cost, "cost does not increase");
+    free_ast(optimized);
+    free_ast(node);
+    return result;
+}
+
+void test_known_forms() {
+    printf("Testing cheapest forms\n");
+    EGraphOptions options;
+    init_egraph_options(&options);
+    EGraphStats stats;
+
+    char* result = optimize("(A AND B) OR (A AND C)", &options, &stats);
+    check(result && strcmp(result, "A AND (B OR C)") == 0, "factoring reads A once");
+    free(result);
+
+    result = optimize("NOT (NOT A AND NOT B)", &options, &stats);
+    check(result && strcmp(result, "A OR B") == 0, "De Morgan removes the negations");
+    free(result);
+
+    result = optimize("(A AND TRUE) OR (B AND FALSE)", &options, &stats);
+    check(result && strcmp(result, "A") == 0, "identities fold constants");
+    free(result);
+
+    result = optimize("A AND (A OR B)", &options, &stats);
+    check(result && strcmp(result, "A") == 0, "absorption");
+    free(result);
+    printf("\n");
+}
+
+void test_cost_model() {
+    printf("Testing the cost model\n");
+    EGraphOptions options;
+    init_egraph_options(&options);
+    EGraphStats stats;
+
+    // A chain is deepest; weighting depth alone prefers a balanced tree
+    options.cost_model.gate_weight = 0;
+    options.cost_model.depth_weight = 1;
+    char* result = optimize("((A AND B) AND C) AND D", &options, &stats);
+    check(stats.output_cost == 2, "depth weighting balances the chain");
+    free(result);
+
+    // Making AND expensive turns it into OR and NOT where that is cheaper
+    init_egraph_options(&options);
+    options.cost_model.operator_cost[NODE_AND] = 100;
+    result = optimize("NOT A AND NOT B", &options, &stats);
+    check(result && strcmp(result, "NOT (A OR B)") == 0, "operator costs steer the extraction");
+    free(result);
+    printf("\n");
+}
+
+void test_budget() {
+    printf("Testing the node budget\n");
+    EGraphOptions options;
+    init_egraph_options(&options);
+    options.node_budget = 40;
+    EGraphStats stats;
+    char* result = optimize("((A OR B) AND (C OR D)) XOR ((A AND C) OR (B AND E) OR (D IMPLIES A))", &options, &stats);
+    check(!stats.saturated, "a small budget stops before saturation");
+    free(result);
+    printf("\n");
+}
+
+void test_statements() {
+    printf("Testing statement lists\n");
+    const char* texts[] = {"X = A AND TRUE", "(A AND B) OR (A AND C)", "NOT (NOT A)", "B OR FALSE"};
+    Node* statements[4];
+    Node* originals[4];
+    for (int i = 0; i < 4; i++) {
+        statements[i] = parse_test_statement(texts[i]);
+        originals[i] = parse_test_statement(texts[i]);
+        if (!statements[i] || !originals[i]) return;
+    }
+    EGraphOptions options;
+    init_egraph_options(&options);
+    egraph_optimize_statements(statements, 4, &options, 3);
+
+    char* assignment = node_to_string(get_assignment_expression(statements[0]));
+    check(assignment && strcmp(assignment, "A AND TRUE") == 0, "assignments are left alone");
+    free(assignment);
+    int equivalent = 1;
+    for (int i = 1; i < 4; i++) equivalent &= same_function(statements[i], originals[i]);
+    check(equivalent, "statements keep their value on three threads");
+    char* negation = node_to_string(statements[2]);
+    check(negation && strcmp(negation, "A") == 0, "statements are replaced by their optimized form");
+    free(negation);
+    for (int i = 0; i < 4; i++) {
+        free_ast(statements[i]);
+        free_ast(originals[i]);
+    }
+    printf("\n");
+}
+
+int main() {
+    test_known_forms();
+    test_cost_model();
+    test_budget();
+    test_statements();
+
+    printf("%s\n", test_failures == 0 ? "All e-graph optimizer tests passed" : "E-graph optimizer tests FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,147 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "C_Unlinked_Components/equivalence_checker.h"
+#include "test_helpers.h"
+
+// Resolved definitions parsed from texts, names never assigned being free
+// inputs; NULL on failure
+static AssignmentGraph* parse_definitions(const char* const* texts, int count) {
+    AssignmentGraph* graph = init_assignment_graph();
+    int ok = graph != NULL;
+    for (int i = 0; i < count && ok; i++) {
+        Node* assignment = parse_test_statement(texts[i]);
+        ok = assignment && add_assignment(graph, assignment, i + 1) == 0;
+        if (assignment && !ok) free_ast(assignment);
+    }
+    char* error_message = NULL;
+    if (ok && resolve_assignment_graph(graph, NULL, &error_message) != ASSIGNMENT_GRAPH_OK) {
+        printf("  Error: %s\n", error_message ? error_message : "Invalid definitions");
+        free(error_message);
+        ok = 0;
+    }
+    if (!ok) {
+        if (graph) free_assignment_graph(graph);
+        test_failures++;
+        return NULL;
+    }
+    return graph;
+}
+
+// Compare one statement of each program; returns the verdict, or -1
+static int compare(const char* old_text, const AssignmentGraph* old_definitions, const char* new_text,
+                   const AssignmentGraph* new_definitions) {
+    printf("Comparing %s with %s\n", old_text, new_text);
+    Node* old_statement = parse_test_statement(old_text);
+    Node* new_statement = parse_test_statement(new_text);
+    int verdict = -1;
+    if (old_statement && new_statement) {
+        EquivalenceProgram old_program = {&old_statement, old_definitions};
+        EquivalenceProgram new_program = {&new_statement, new_definitions};
+        EquivalenceResult result;
+        char* error_message = NULL;
+        if (check_equivalence(&old_program, &new_program, 1, 0, &result, &error_message) != 0) {
+            printf("  Error: %s\n", error_message ? error_message : "Failed to compare");
+            free(error_message);
+            test_failures++;
+        } else {
+            verdict = result.verdict;
+            if (verdict == EQUIVALENCE_DIFFERENT && !old_definitions && !new_definitions) {
+                // The counterexample really tells the statements apart
+                SymbolTable* symbol_table = init_symbol_table();
+                for (int i = 0; i < result.input_count; i++) {
+                    add_or_update_symbol(symbol_table, result.input_names[i], result.input_values[i]);
+                }
+                check(reference_value(old_statement, symbol_table) == result.old_value &&
+                      reference_value(new_statement, symbol_table) == result.new_value &&
+                      result.old_value != result.new_value, "the counterexample separates them");
+                free_symbol_table(symbol_table);
+            }
+            free_equivalence_result(&result);
+        }
+    }
+    if (old_statement) free_ast(old_statement);
+    if (new_statement) free_ast(new_statement);
+    return verdict;
+}
+
+static int equivalent(int verdict) {
+    return verdict == EQUIVALENT_BY_HASHING || verdict == EQUIVALENT_BY_SWEEPING || verdict == EQUIVALENT_BY_SAT;
+}
+
+void test_statement_pairs() {
+    printf("Testing statement pairs\n");
+    check(compare("A AND B", NULL, "B AND A", NULL) == EQUIVALENT_BY_HASHING, "operand order is hashed away");
+    check(equivalent(compare("(A AND B) OR (A AND C)", NULL, "A AND (B OR C)", NULL)), "factoring");
+    check(equivalent(compare("A OR NOT A", NULL, "TRUE", NULL)), "tautology against a constant");
+    check(equivalent(compare("((A XOR B) XOR (C XOR D)) XOR E", NULL,
+                             "NOT (A XNOR (B XOR (C XOR (D XOR E))))", NULL)), "reassociated parity");
+    check(equivalent(compare("(A IMPLIES B) AND (B IMPLIES C)", NULL,
+                             "(NOT A OR B) AND (NOT B OR C)", NULL)), "implications");
+    check(compare("A OR B", NULL, "A XOR B", NULL) == EQUIVALENCE_DIFFERENT, "OR differs from XOR");
+    check(compare("(A AND B) OR (C AND D) OR E", NULL, "(A AND B) OR (C AND D)", NULL) == EQUIVALENCE_DIFFERENT,
+          "a dropped term is found");
+    check(compare("A", NULL, "B", NULL) == EQUIVALENCE_DIFFERENT, "inputs are told apart");
+    printf("\n");
+}
+
+void test_definitions() {
+    printf("Testing definitions\n");
+    const char* texts[] = {"K = TRUE", "M = K AND TRUE", "N = M OR K"};
+    AssignmentGraph* definitions = parse_definitions(texts, 3);
+    if (!definitions) return;
+    // K is assigned a constant, so it is an input that both sides share;
+    // M and N stand for their expressions
+    check(equivalent(compare("N AND A", definitions, "K AND A", NULL)), "definitions are expanded");
+    check(compare("M", definitions, "NOT K", NULL) == EQUIVALENCE_DIFFERENT, "expanded definitions can differ");
+    free_assignment_graph(definitions);
+
+    const char* derived[] = {"X = A AND B", "Y = X OR C", "Z = NOT Y"};
+    definitions = parse_definitions(derived, 3);
+    if (!definitions) return;
+    check(equivalent(compare("Y", definitions, "(A AND B) OR C", NULL)), "definitions over free inputs");
+    check(equivalent(compare("Z XOR Y", definitions, "TRUE", NULL)), "definitions read by definitions");
+    check(compare("X", definitions, "A", NULL) == EQUIVALENCE_DIFFERENT, "a derived definition is not an input");
+    free_assignment_graph(definitions);
+    printf("\n");
+}
+
+void test_statement_lists() {
+    printf("Testing several statements at once\n");
+    const char* old_texts[] = {"A AND B", "A OR B", "NOT (A AND B)"};
+    const char* new_texts[] = {"NOT (NOT A OR NOT B)", "B OR A", "A AND NOT B"};
+    Node* old_statements[3];
+    Node* new_statements[3];
+    for (int i = 0; i < 3; i++) {
+        old_statements[i] = parse_test_statement(old_texts[i]);
+        new_statements[i] = parse_test_statement(new_texts[i]);
+        if (!old_statements[i] || !new_statements[i]) return;
+    }
+    EquivalenceProgram old_program = {old_statements, NULL};
+    EquivalenceProgram new_program = {new_statements, NULL};
+    EquivalenceResult results[3];
+    char* error_message = NULL;
+    if (check_equivalence(&old_program, &new_program, 3, 0, results, &error_message) != 0) {
+        printf("  Error: %s\n", error_message ? error_message : "Failed to compare");
+        free(error_message);
+        test_failures++;
+    } else {
+        check(equivalent(results[0].verdict) && equivalent(results[1].verdict) &&
+              results[2].verdict == EQUIVALENCE_DIFFERENT, "each pair gets its own verdict");
+        for (int i = 0; i < 3; i++) free_equivalence_result(&results[i]);
+    }
+    for (int i = 0; i < 3; i++) {
+        free_ast(old_statements[i]);
+        free_ast(new_statements[i]);
+    }
+    printf("\n");
+}
+
+int main() {
+    test_statement_pairs();
+    test_definitions();
+    test_statement_lists();
+
+    printf("%s\n", test_failures == 0 ? "All equivalence checker tests passed" : "Equivalence checker tests FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "C_Unlinked_Components/evaluation_cache.h"
+#include "test_helpers.h"
+
+// Build a cache over one statement; the statement is freed again
+static EvaluationCache* create_test_cache(const char* text, int capacity) {
+    Node* statement = parse_test_statement(text);
+    if (!statement) return NULL;
+    char* error_message = NULL;
+    EvaluationCache* cache = create_evaluation_cache(&statement, 1, NULL, capacity, &error_message);
+    if (!cache) {
+        printf("  Error: %s\n", error_message ? error_message : "Failed to create the cache");
+        free(error_message);
+        test_failures++;
+    }
+    free_ast(statement);
+    return cache;
+}
+
+// Pack assignment, bit i being input i, into a single word
+static void pack_assignment(const EvaluationCache* cache, int assignment, uint64_t* inputs) {
+    inputs[0] = 0;
+    for (int i = 0; i < evaluation_cache_variable_count(cache); i++) {
+        inputs[0] |= (uint64_t)((assignment >> i) & 1) << i;
+    }
+}
+
+void test_results_and_counts() {
+    printf("Testing cached results against the evaluator\n");
+    const char* text = "(A AND NOT B) OR (C XOR A)";
+    EvaluationCache* cache = create_test_cache(text, EVALUATION_CACHE_DEFAULT_CAPACITY);
+    Node* statement = parse_test_statement(text);
+    if (!cache || !statement) {
+        if (cache) free_evaluation_cache(cache);
+        if (statement) free_ast(statement);
+        return;
+    }
+
+    check(evaluation_cache_variable_count(cache) == 3, "three inputs");
+    check(evaluation_cache_variable(cache, "D") == -1, "unread variable has no input");
+
+    const char* names[] = {"A", "B", "C"};
+    int matches = 1;
+    for (int round = 0; round < 2; round++) {
+        for (int assignment = 0; assignment < 8; assignment++) {
+            SymbolTable* symbol_table = init_symbol_table();
+            for (int i = 0; i < 3; i++) {
+                add_or_update_symbol(symbol_table, names[i], (assignment >> i) & 1);
+            }
+            uint64_t inputs[EVALUATION_CACHE_WORDS(3)];
+            pack_evaluation_inputs(cache, symbol_table, inputs);
+            if (evaluate_cached(cache, 0, inputs) != reference_value(statement, symbol_table)) matches = 0;
+            free_symbol_table(symbol_table);
+        }
+    }
+    check(matches, "every assignment matches, cached or not");
+
+    EvaluationCacheStats stats;
+    get_evaluation_cache_stats(cache, &stats);
+    check(stats.misses == 8, "first round misses once per assignment");
+    check(stats.hits == 8, "second round hits every assignment");
+    check(stats.evictions == 0 && stats.uncached == 0, "no evictions or uncached evaluations");
+
+    clear_evaluation_cache(cache);
+    get_evaluation_cache_stats(cache, &stats);
+    check(stats.hits == 0 && stats.misses == 0, "clearing zeroes the counters");
+    uint64_t inputs[1];
+    pack_assignment(cache, 5, inputs);
+    evaluate_cached(cache, 0, inputs);
+    get_evaluation_cache_stats(cache, &stats);
+    check(stats.misses == 1 && stats.hits == 0, "clearing drops the entries");
+
+    free_ast(statement);
+    free_evaluation_cache(cache);
+    printf("\n");
+}
+
+void test_eviction() {
+    printf("Testing eviction from a single set\n");
+    // The smallest cache is one set of EVALUATION_CACHE_WAYS entries
+    EvaluationCache* cache = create_test_cache("A AND (B OR C)", 1);
+    if (!cache) return;
+
+    EvaluationCacheStats stats;
+    get_evaluation_cache_stats(cache, &stats);
+    check(stats.capacity == EVALUATION_CACHE_WAYS, "capacity rounds up to one set");
+
+    uint64_t inputs[1];
+    for (int assignment = 0; assignment < 8; assignment++) {
+        pack_assignment(cache, assignment, inputs);
+        evaluate_cached(cache, 0, inputs);
+    }
+    get_evaluation_cache_stats(cache, &stats);
+    check(stats.misses == 8, "eight distinct assignments miss");
+    check(stats.evictions == 8 - EVALUATION_CACHE_WAYS, "inserts past the capacity evict");
+
+    // Assignments 4 to 7 are left, in insertion order. Hitting 4 marks it,
+    // so the next insert passes over it and evicts 5 instead.
+    pack_assignment(cache, 4, inputs);
+    evaluate_cached(cache, 0, inputs);
+    pack_assignment(cache, 0, inputs);
+    evaluate_cached(cache, 0, inputs);
+    pack_assignment(cache, 4, inputs);
+    evaluate_cached(cache, 0, inputs);
+    get_evaluation_cache_stats(cache, &stats);
+    check(stats.hits == 2 && stats.misses == 9, "recently used entry survives an eviction");
+    pack_assignment(cache, 5, inputs);
+    evaluate_cached(cache, 0, inputs);
+    get_evaluation_cache_stats(cache, &stats);
+    check(stats.misses == 10 && stats.evictions == 10 - EVALUATION_CACHE_WAYS, "evicted entry misses again");
+
+    free_evaluation_cache(cache);
+    printf("\n");
+}
+
+void test_uncached() {
+    printf("Testing statements over more than 64 variables\n");
+    char text[1024];
+    int length = 0;
+    for (int i = 0; i < 65; i++) {
+        length += snprintf(text + length, sizeof(text) - length, "%sV%d", i > 0 ? " OR " : "", i);
+    }
+    EvaluationCache* cache = create_test_cache(text, EVALUATION_CACHE_DEFAULT_CAPACITY);
+    if (!cache) return;
+
+    uint64_t inputs[EVALUATION_CACHE_WORDS(65)] = {0};
+    int all_false = evaluate_cached(cache, 0, inputs);
+    inputs[1] = 1;
+    int last_true = evaluate_cached(cache, 0, inputs);
+    check(all_false == 0 && last_true == 1, "input 64 is read from the second word");
+
+    EvaluationCacheStats stats;
+    get_evaluation_cache_stats(cache, &stats);
+    check(stats.uncached == 2 && stats.hits == 0 && stats.misses == 0, "evaluated without the cache");
+
+    free_evaluation_cache(cache);
+    printf("\n");
+}
+
+int main() {
+    test_results_and_counts();
+    test_eviction();
+    test_uncached();
+
+    printf("%s\n", test_failures == 0 ? "All evaluation cache tests passed" : "Evaluation cache tests FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+#ifndef TEST_HELPERS_H
+#define TEST_HELPERS_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "C_Unlinked_Components/ast.h"
+
+// Shared by the test_*.c programs: parse one statement from a string, and
+// report each check, counting the failures for the exit status
+
+typedef struct yy_buffer_state* YY_BUFFER_STATE;
+extern YY_BUFFER_STATE yy_scan_string(const char* str);
+extern void yy_delete_buffer(YY_BUFFER_STATE buffer);
+extern int yyparse();
+extern Node* parsed_expression;
+
+static int test_failures = 0;
+
+// Parsed statement, owned by the caller, or NULL after printing an error
+static inline Node* parse_test_statement(const char* text) {
+    YY_BUFFER_STATE buffer = yy_scan_string(text);
+    parsed_expression = NULL;
+    int parse_result = yyparse();
+    yy_delete_buffer(buffer);
+    Node* statement = parsed_expression;
+    parsed_expression = NULL;
+    if (parse_result != 0 || !statement) {
+        printf("  Error: Failed to parse '%s'\n", text);
+        test_failures++;
+        return NULL;
+    }
+    return statement;
+}
+
+static inline void check(int condition, const char* description) {
+    printf("  %s: %s\n", condition ? "ok" : "FAILED", description);
+    if (!condition) test_failures++;
+}
+
+// Value of node for the values in symbol_table, by the tree-walking
+// evaluator, or -1 when it does not reduce to a constant
+static inline int reference_value(const Node* node, SymbolTable* symbol_table) {
+    EvaluationSteps* steps = init_evaluation_steps();
+    Node* result = evaluate_node_with_symbol_table(clone_node(node), symbol_table, steps);
+    int value = result && result->type == NODE_BOOL ? result->bool_val != 0 : -1;
+    free_ast(result);
+    free_evaluation_steps(steps);
+    return value;
+}
+
+#endif /* TEST_HELPERS_H */
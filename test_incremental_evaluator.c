@@ -0,0 +1,170 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "C_Unlinked_Components/incremental_evaluator.h"
+#include "test_helpers.h"
+
+#define STATEMENT_COUNT 6
+
+static const char* statement_texts[STATEMENT_COUNT] = {
+    "X = A AND B",
+    "X OR C",
+    "NOT X",
+    "A XOR C",
+    "Y = X IMPLIES C",
+    "U_Q Z (Z OR Y)",
+};
+
+static const char* input_names[] = {"A", "B", "C"};
+
+// Values of a fresh evaluator over the same table, to compare against the
+// incrementally maintained ones; returns 0 on success
+static int evaluate_from_scratch(Node** statements, SymbolTable* symbol_table, int* values) {
+    char* error_message = NULL;
+    IncrementalEvaluator* evaluator = create_incremental_evaluator(statements, STATEMENT_COUNT, symbol_table,
+                                                                   &error_message);
+    if (!evaluator) {
+        printf("  Error: %s\n", error_message ? error_message : "Failed to create the evaluator");
+        free(error_message);
+        return -1;
+    }
+    for (int i = 0; i < STATEMENT_COUNT; i++) values[i] = get_incremental_result(evaluator, i);
+    free_incremental_evaluator(evaluator);
+    return 0;
+}
+
+// Whether evaluator agrees with a fresh evaluation, and its last update
+// reported exactly the statements that differ from before
+static int matches_scratch(const IncrementalEvaluator* evaluator, Node** statements, SymbolTable* symbol_table,
+                           const int* before, int changed) {
+    int expected[STATEMENT_COUNT];
+    if (evaluate_from_scratch(statements, symbol_table, expected) != 0) return 0;
+    int change_count = 0;
+    const int* changes = get_incremental_changes(evaluator, &change_count);
+    int differing = 0;
+    for (int i = 0; i < STATEMENT_COUNT; i++) {
+        if (get_incremental_result(evaluator, i) != expected[i]) return 0;
+        if (before[i] == expected[i]) continue;
+        differing++;
+        int reported = 0;
+        for (int c = 0; c < change_count; c++) reported |= changes[c] == i;
+        if (!reported) return 0;
+    }
+    return changed == differing && change_count == differing;
+}
+
+static void snapshot_results(const IncrementalEvaluator* evaluator, int* values) {
+    for (int i = 0; i < STATEMENT_COUNT; i++) values[i] = get_incremental_result(evaluator, i);
+}
+
+void test_incremental_updates() {
+    printf("Testing incremental updates against full evaluation\n");
+    Node* statements[STATEMENT_COUNT] = {NULL};
+    for (int i = 0; i < STATEMENT_COUNT; i++) {
+        statements[i] = parse_test_statement(statement_texts[i]);
+        if (!statements[i]) goto cleanup;
+    }
+
+    SymbolTable* symbol_table = init_symbol_table();
+    add_or_update_symbol(symbol_table, "A", 1);
+    add_or_update_symbol(symbol_table, "B", 0);
+    add_or_update_symbol(symbol_table, "C", 0);
+
+    char* error_message = NULL;
+    IncrementalEvaluator* evaluator = create_incremental_evaluator(statements, STATEMENT_COUNT, symbol_table,
+                                                                   &error_message);
+    if (!evaluator) {
+        printf("  Error: %s\n", error_message ? error_message : "Failed to create the evaluator");
+        free(error_message);
+        test_failures++;
+        free_symbol_table(symbol_table);
+        goto cleanup;
+    }
+
+    check(reference_value(statements[1], symbol_table) == get_incremental_result(evaluator, 1) &&
+          reference_value(statements[3], symbol_table) == get_incremental_result(evaluator, 3),
+          "initial results match the evaluator");
+    check(get_symbol_value(symbol_table, "X") == 0, "assignment stores its value");
+
+    int before[STATEMENT_COUNT];
+    snapshot_results(evaluator, before);
+    int changed = incremental_update_symbol(evaluator, "B", 1);
+    check(get_symbol_value(symbol_table, "X") == 1, "update reaches the assigned variable");
+    check(get_incremental_result(evaluator, 1) == 1 && get_incremental_result(evaluator, 2) == 0,
+          "readers of the assigned variable follow it");
+    check(matches_scratch(evaluator, statements, symbol_table, before, changed), "changes are reported");
+
+    changed = incremental_update_symbol(evaluator, "B", 1);
+    check(changed == 0, "setting the same value changes nothing");
+
+    check(incremental_update_symbol(evaluator, "X", 0) == ERROR_SYMBOL_DERIVED, "assigned variables are derived");
+
+    const char* rejected_names[] = {"C", NULL};
+    const int rejected_values[] = {1, 1};
+    snapshot_results(evaluator, before);
+    int status = incremental_update_symbols(evaluator, rejected_names, rejected_values, 2);
+    check(status == ERROR_SYMBOL_NOT_DEFINED && get_symbol_value(symbol_table, "C") == 0 &&
+          matches_scratch(evaluator, statements, symbol_table, before, 0), "a rejected batch changes nothing");
+
+    const char* names[] = {"A", "C"};
+    const int values[] = {0, 1};
+    snapshot_results(evaluator, before);
+    changed = incremental_update_symbols(evaluator, names, values, 2);
+    check(matches_scratch(evaluator, statements, symbol_table, before, changed), "batched updates");
+
+    int all_match = 1;
+    srand(1);
+    for (int round = 0; round < 200 && all_match; round++) {
+        snapshot_results(evaluator, before);
+        changed = incremental_update_symbol(evaluator, input_names[rand() % 3], rand() % 2);
+        all_match = matches_scratch(evaluator, statements, symbol_table, before, changed);
+    }
+    check(all_match, "200 random updates match full evaluation");
+
+    free_incremental_evaluator(evaluator);
+    free_symbol_table(symbol_table);
+
+cleanup:
+    for (int i = 0; i < STATEMENT_COUNT; i++) {
+        if (statements[i]) free_ast(statements[i]);
+    }
+    printf("\n");
+}
+
+void test_errors() {
+    printf("Testing rejected programs\n");
+    Node* statements[2] = {parse_test_statement("P = Q AND A"), parse_test_statement("Q = P OR A")};
+    if (!statements[0] || !statements[1]) {
+        if (statements[0]) free_ast(statements[0]);
+        if (statements[1]) free_ast(statements[1]);
+        return;
+    }
+    SymbolTable* symbol_table = init_symbol_table();
+    add_or_update_symbol(symbol_table, "A", 1);
+
+    char* error_message = NULL;
+    IncrementalEvaluator* evaluator = create_incremental_evaluator(statements, 2, symbol_table, &error_message);
+    check(!evaluator && error_message, "circular assignments are rejected");
+    if (evaluator) free_incremental_evaluator(evaluator);
+    free(error_message);
+
+    error_message = NULL;
+    evaluator = create_incremental_evaluator(statements, 1, symbol_table, &error_message);
+    check(!evaluator && error_message, "undefined variables are rejected");
+    if (evaluator) free_incremental_evaluator(evaluator);
+    free(error_message);
+
+    free_symbol_table(symbol_table);
+    free_ast(statements[0]);
+    free_ast(statements[1]);
+    printf("\n");
+}
+
+int main() {
+    test_incremental_updates();
+    test_errors();
+
+    printf("%s\n", test_failures == 0 ? "All incremental evaluator tests passed" :
+                                         "Incremental evaluator tests FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,161 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "C_Unlinked_Components/logic_minimizer.h"
+#include "test_helpers.h"
+
+// Whether a and b agree on every assignment of the variables A to F
+static int same_function(const Node* a, const Node* b) {
+    const char* names[] = {"A", "B", "C", "D", "E", "F"};
+    for (int assignment = 0; assignment < 64; assignment++) {
+        SymbolTable* symbol_table = init_symbol_table();
+        for (int i = 0; i < 6; i++) add_or_update_symbol(symbol_table, names[i], (assignment >> i) & 1);
+        int same = reference_value(a, symbol_table) == reference_value(b, symbol_table);
+        free_symbol_table(symbol_table);
+        if (!same) return 0;
+    }
+    return 1;
+}
+
+// Minimize text, expecting the sum of products expected
+void test_minimum(const char* text, const char* expected) {
+    printf("Testing minimum of: %s\n", text);
+    Node* node = parse_test_statement(text);
+    if (!node) return;
+    MinimizeOptions options;
+    init_minimize_options(&options);
+    Node* minimum = minimize_expression(node, &options);
+    char* result = minimum ? node_to_string(minimum) : NULL;
+    printf("  Result: %s\n", result ? result : "(null)");
+    check(result && strcmp(result, expected) == 0, expected);
+    free(result);
+    free_ast(minimum);
+    free_ast(node);
+    printf("\n");
+}
+
+// Number of products in a sum of products
+static int product_count(const char* text) {
+    int count = 1;
+    for (const char* p = strstr(text, " OR "); p; p = strstr(p + 1, " OR ")) count++;
+    return count;
+}
+
+static char buffer[4096];
+static int length;
+
+static void append(const char* text) {
+    length += snprintf(buffer + length, sizeof(buffer) - length, "%s", text);
+}
+
+// Random expression over A to F
+static void random_expression(int depth) {
+    const char* leaves[] = {"A", "B", "C", "D", "E", "F"};
+    const char* operators[] = {" AND ", " OR ", " XOR ", " IMPLIES "};
+    if (depth == 0 || rand() % 5 == 0) {
+        append(leaves[rand() % 6]);
+    } else if (rand() % 5 == 0) {
+        append("NOT (");
+        random_expression(depth - 1);
+        append(")");
+    } else {
+        append("(");
+        random_expression(depth - 1);
+        append(operators[rand() % 4]);
+        random_expression(depth - 1);
+        append(")");
+    }
+}
+
+// The exact and heuristic minimizers both keep the function, and the
+// heuristic never finds fewer products than the exact minimum
+void test_random_expressions() {
+    printf("Testing random expressions\n");
+    MinimizeOptions exact, heuristic;
+    init_minimize_options(&exact);
+    init_minimize_options(&heuristic);
+    heuristic.exact_variable_limit = 0;
+    int equivalent = 1, minimal = 1;
+    srand(3);
+    for (int round = 0; round < 200; round++) {
+        length = 0;
+        random_expression(4);
+        Node* node = parse_test_statement(buffer);
+        if (!node) continue;
+        Node* first = minimize_expression(node, &exact);
+        Node* second = minimize_expression(node, &heuristic);
+        if (!first || !second || !same_function(node, first) || !same_function(node, second)) {
+            equivalent = 0;
+        } else {
+            char* first_text = node_to_string(first);
+            char* second_text = node_to_string(second);
+            if (!first_text || !second_text || product_count(first_text) > product_count(second_text)) minimal = 0;
+            free(first_text);
+            free(second_text);
+        }
+        free_ast(first);
+        free_ast(second);
+        free_ast(node);
+    }
+    check(equivalent, "both minimizers keep the function");
+    check(minimal, "the exact cover has the fewest products");
+    printf("\n");
+}
+
+void test_limits() {
+    printf("Testing the variable limit\n");
+    Node* node = parse_test_statement("(A AND B) OR (C AND D) OR (E AND F)");
+    if (!node) return;
+    MinimizeOptions options;
+    init_minimize_options(&options);
+    options.variable_limit = 5;
+    Node* minimum = minimize_expression(node, &options);
+    check(minimum == NULL, "too many free variables are left alone");
+    free_ast(minimum);
+    options.variable_limit = 6;
+    minimum = minimize_expression(node, &options);
+    check(minimum && same_function(node, minimum), "the limit is inclusive");
+    free_ast(minimum);
+    free_ast(node);
+    printf("\n");
+}
+
+void test_statements() {
+    printf("Testing statement lists\n");
+    const char* texts[] = {"X = (A AND B) OR (A AND NOT B)", "(A AND B) OR (A AND NOT B)", "A AND B",
+                           "NOT (NOT A OR NOT B) OR (A AND B AND C)"};
+    Node* statements[4];
+    for (int i = 0; i < 4; i++) {
+        statements[i] = parse_test_statement(texts[i]);
+        if (!statements[i]) return;
+    }
+    MinimizeOptions options;
+    init_minimize_options(&options);
+    int replaced = minimize_statements(statements, 4, &options, 2);
+    check(replaced == 2, "only smaller sums of products replace statements");
+    char* results[4];
+    for (int i = 1; i < 4; i++) results[i] = node_to_string(statements[i]);
+    check(results[1] && strcmp(results[1], "A") == 0 && results[2] && strcmp(results[2], "A AND B") == 0 &&
+          results[3] && strcmp(results[3], "A AND B") == 0, "statements hold their minimum");
+    results[0] = node_to_string(get_assignment_expression(statements[0]));
+    check(results[0] && strcmp(results[0], "(A AND B) OR (A AND NOT B)") == 0, "assignments are left alone");
+    for (int i = 0; i < 4; i++) free(results[i]);
+    for (int i = 0; i < 4; i++) free_ast(statements[i]);
+    printf("\n");
+}
+
+int main() {
+    test_minimum("(A AND B) OR (A AND NOT B)", "A");
+    test_minimum("(A AND B) OR (NOT A AND C) OR (B AND C)", "(A AND B) OR (NOT A AND C)");
+    test_minimum("A OR NOT A", "TRUE");
+    test_minimum("A AND NOT A", "FALSE");
+    test_minimum("E_Q Z (Z AND A) OR (B AND NOT B)", "A");
+    test_minimum("(A XOR B) XOR C",
+                 "(A AND NOT B AND NOT C) OR (NOT A AND B AND NOT C) OR (NOT A AND NOT B AND C) OR (A AND B AND C)");
+    test_random_expressions();
+    test_limits();
+    test_statements();
+
+    printf("%s\n", test_failures == 0 ? "All logic minimizer tests passed" : "Logic minimizer tests FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
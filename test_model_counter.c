@@ -0,0 +1,178 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "C_Unlinked_Components/model_counter.h"
+#include "test_helpers.h"
+
+// Count the models of text, expecting count over variable_count variables
+void test_count(const char* text, const char* expected, int variable_count) {
+    printf("Testing model count of: %s\n", text);
+    Node* node = parse_test_statement(text);
+    if (!node) return;
+    ModelCount result;
+    char* error_message = NULL;
+    if (count_models(node, NULL, &result, &error_message) != 0) {
+        printf("  Error: %s\n", error_message ? error_message : "Failed to count");
+        free(error_message);
+        test_failures++;
+    } else {
+        printf("  Result: %s of 2^%d\n", result.count, result.variable_count);
+        check(strcmp(result.count, expected) == 0, expected);
+        check(result.variable_count == variable_count, "variables counted over");
+        free_model_count(&result);
+    }
+    free_ast(node);
+    printf("\n");
+}
+
+static char buffer[8192];
+static int length;
+
+static void append(const char* text) {
+    length += snprintf(buffer + length, sizeof(buffer) - length, "%s", text);
+}
+
+// Random expression over A to F
+static void random_expression(int depth) {
+    const char* leaves[] = {"A", "B", "C", "D", "E", "F", "TRUE"};
+    const char* operators[] = {" AND ", " OR ", " XOR ", " IMPLIES ", " <==> "};
+    if (depth == 0 || rand() % 5 == 0) {
+        append(leaves[rand() % 7]);
+    } else if (rand() % 5 == 0) {
+        append("NOT (");
+        random_expression(depth - 1);
+        append(")");
+    } else {
+        append("(");
+        random_expression(depth - 1);
+        append(operators[rand() % 5]);
+        random_expression(depth - 1);
+        append(")");
+    }
+}
+
+// Exact counts and probabilities agree with enumerating the assignments
+void test_random_expressions() {
+    printf("Testing random expressions against enumeration\n");
+    const char* names[] = {"A", "B", "C", "D", "E", "F"};
+    const double weights[] = {0.5, 0.1, 0.9, 0.25, 0.6, 0.3};
+    SymbolTable* probabilities = init_symbol_table();
+    for (int i = 0; i < 6; i++) add_or_update_symbol(probabilities, names[i], 0);
+    int counts = 1, fractions = 1, weighted = 1;
+    srand(5);
+    for (int round = 0; round < 200; round++) {
+        length = 0;
+        random_expression(4);
+        Node* node = parse_test_statement(buffer);
+        if (!node) continue;
+        ModelCount result;
+        double probability = -1;
+        if (count_models(node, NULL, &result, NULL) != 0 ||
+            weighted_model_count(node, probabilities, weights, &probability, NULL) != 0) {
+            counts = 0;
+            free_ast(node);
+            continue;
+        }
+
+        long expected = 0;
+        double expected_probability = 0;
+        for (int assignment = 0; assignment < (1 << 6); assignment++) {
+            SymbolTable* symbol_table = init_symbol_table();
+            double weight = 1;
+            for (int i = 0; i < 6; i++) {
+                int value = (assignment >> i) & 1;
+                add_or_update_symbol(symbol_table, names[i], value);
+                weight *= value ? weights[i] : 1 - weights[i];
+            }
+            if (reference_value(node, symbol_table)) {
+                expected++;
+                expected_probability += weight;
+            }
+            free_symbol_table(symbol_table);
+        }
+        // Enumeration ranges over all six variables, the count only over
+        // those the expression reads
+        expected >>= 6 - result.variable_count;
+        if (atol(result.count) != expected) counts = 0;
+        if (fabs(result.fraction - (double)expected / (1L << result.variable_count)) > 1e-12) fractions = 0;
+        if (fabs(probability - expected_probability) > 1e-9) weighted = 0;
+        free_model_count(&result);
+        free_ast(node);
+    }
+    free_symbol_table(probabilities);
+    check(counts, "counts match enumeration");
+    check(fractions, "fractions are count / 2^n");
+    check(weighted, "weighted counts match enumeration");
+    printf("\n");
+}
+
+void test_known_variables() {
+    printf("Testing fixed variables\n");
+    Node* node = parse_test_statement("(A AND B) OR (C AND D)");
+    if (!node) return;
+    SymbolTable* known = init_symbol_table();
+    add_or_update_symbol(known, "A", 1);
+    add_or_update_symbol(known, "C", 0);
+    ModelCount result;
+    if (count_models(node, known, &result, NULL) == 0) {
+        check(strcmp(result.count, "2") == 0 && result.variable_count == 2 && result.fraction == 0.5,
+              "fixed variables are not counted");
+        int named = 1;
+        for (int i = 0; i < result.variable_count; i++) {
+            named &= strcmp(result.variables[i], "B") == 0 || strcmp(result.variables[i], "D") == 0;
+        }
+        check(named, "only the free variables are listed");
+        free_model_count(&result);
+    } else {
+        check(0, "count with fixed variables");
+    }
+    free_symbol_table(known);
+    free_ast(node);
+    printf("\n");
+}
+
+void test_weights() {
+    printf("Testing weighted model counts\n");
+    Node* node = parse_test_statement("(A OR B) AND NOT C");
+    if (!node) return;
+    SymbolTable* symbol_table = init_symbol_table();
+    add_or_update_symbol(symbol_table, "A", 0);
+    add_or_update_symbol(symbol_table, "B", 0);
+    const double probabilities[] = {0.3, 0.6};
+    double probability = -1;
+    check(weighted_model_count(node, symbol_table, probabilities, &probability, NULL) == 0 &&
+          fabs(probability - 0.72 * 0.5) < 1e-12, "variables outside the table are TRUE half the time");
+    check(weighted_model_count(node, NULL, NULL, &probability, NULL) == 0 && fabs(probability - 0.375) < 1e-12,
+          "without a table every variable is TRUE half the time");
+    free_symbol_table(symbol_table);
+    free_ast(node);
+    printf("\n");
+}
+
+// Counts beyond 64 bits stay exact
+void test_wide_counts() {
+    char text[2048];
+    int used = 0;
+    for (int i = 0; i < 70; i++) used += snprintf(text + used, sizeof(text) - used, "%sV%d", i ? " OR " : "", i);
+    test_count(text, "1180591620717411303423", 70);
+
+    used = 0;
+    for (int i = 0; i < 30; i++) used += snprintf(text + used, sizeof(text) - used, "%sV%d", i ? " XOR " : "", i);
+    test_count(text, "536870912", 30);
+}
+
+int main() {
+    test_count("A OR B", "3", 2);
+    test_count("A AND NOT A", "0", 1);
+    test_count("TRUE", "1", 0);
+    test_count("E_Q Z (Z AND A)", "1", 1);
+    test_count("U_Q Z (Z OR A) OR (B AND C)", "5", 3);
+    test_wide_counts();
+    test_random_expressions();
+    test_known_variables();
+    test_weights();
+
+    printf("%s\n", test_failures == 0 ? "All model counter tests passed" : "Model counter tests FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
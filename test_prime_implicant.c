@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "C_Unlinked_Components/prime_implicant.h"
+#include "test_helpers.h"
+
+#define VARIABLE_COUNT 5
+
+static const char* names[VARIABLE_COUNT] = {"A", "B", "C", "D", "E"};
+
+// Index of name among names, or -1
+static int variable_index(const char* name) {
+    for (int i = 0; i < VARIABLE_COUNT; i++) {
+        if (strcmp(names[i], name) == 0) return i;
+    }
+    return -1;
+}
+
+// Whether node evaluates to outcome on every assignment agreeing with the
+// fixed values (fixed[i] is -1 for a free variable)
+static int forces(const Node* node, const int* fixed, int outcome) {
+    for (int assignment = 0; assignment < (1 << VARIABLE_COUNT); assignment++) {
+        int consistent = 1;
+        for (int i = 0; i < VARIABLE_COUNT; i++) {
+            if (fixed[i] >= 0 && fixed[i] != ((assignment >> i) & 1)) consistent = 0;
+        }
+        if (!consistent) continue;
+        SymbolTable* symbol_table = init_symbol_table();
+        for (int i = 0; i < VARIABLE_COUNT; i++) add_or_update_symbol(symbol_table, names[i], (assignment >> i) & 1);
+        int value = reference_value(node, symbol_table);
+        free_symbol_table(symbol_table);
+        if (value != outcome) return 0;
+    }
+    return 1;
+}
+
+// Explain text under assignment (bit i is names[i]); checks the explanation
+// is a prime implicant of the outcome and returns its size, or -1
+static int explain(const char* text, int assignment, int print) {
+    Node* node = parse_test_statement(text);
+    if (!node) return -1;
+    int size = -1;
+    char* error_message = NULL;
+    Explainer* explainer = create_explainer(node, &error_message);
+    SymbolTable* symbol_table = init_symbol_table();
+    for (int i = 0; i < VARIABLE_COUNT; i++) add_or_update_symbol(symbol_table, names[i], (assignment >> i) & 1);
+    int expected = reference_value(node, symbol_table);
+    Explanation explanation;
+    if (!explainer || explain_statement(explainer, symbol_table, &explanation, &error_message) != 0) {
+        printf("  Error: %s\n", error_message ? error_message : "Failed to explain");
+        free(error_message);
+        test_failures++;
+    } else {
+        int fixed[VARIABLE_COUNT] = {-1, -1, -1, -1, -1};
+        int valid = explanation.outcome == expected;
+        for (int i = 0; i < explanation.count && valid; i++) {
+            int index = variable_index(explanation.names[i]);
+            valid = index >= 0 && explanation.values[i] == ((assignment >> index) & 1) && fixed[index] < 0;
+            if (valid) fixed[index] = explanation.values[i];
+        }
+        valid = valid && forces(node, fixed, explanation.outcome);
+        // Prime: freeing any one value lets the outcome change
+        for (int i = 0; i < VARIABLE_COUNT && valid; i++) {
+            if (fixed[i] < 0) continue;
+            int value = fixed[i];
+            fixed[i] = -1;
+            valid = !forces(node, fixed, explanation.outcome);
+            fixed[i] = value;
+        }
+        if (print) {
+            printf("  %s is %s because", text, explanation.outcome ? "TRUE" : "FALSE");
+            for (int i = 0; i < explanation.count; i++) {
+                printf("%s %s = %s", i > 0 ? "," : "", explanation.names[i], explanation.values[i] ? "TRUE" : "FALSE");
+            }
+            printf("%s\n", explanation.count == 0 ? " of no value" : "");
+        }
+        size = valid ? explanation.count : -1;
+    }
+    free_symbol_table(symbol_table);
+    if (explainer) free_explainer(explainer);
+    free_ast(node);
+    return size;
+}
+
+void test_known_explanations() {
+    printf("Testing explanations\n");
+    // A = TRUE, B = TRUE, C = FALSE, D = FALSE, E = FALSE
+    check(explain("(A AND B) OR C", 0x3, 1) == 2, "both inputs of the AND");
+    check(explain("A OR B", 0x3, 1) == 1, "one TRUE input of an OR suffices");
+    check(explain("A AND NOT A", 0x3, 1) == 0, "a contradiction needs no values");
+    check(explain("(A AND C) OR (B AND NOT C) OR (A AND B)", 0x3, 1) == 2, "one product is enough");
+    check(explain("A XOR B XOR C", 0x3, 1) == 3, "parity reads every input");
+    check(explain("(C IMPLIES D) AND NOT E", 0x3, 1) == 2, "implications");
+    printf("\n");
+}
+
+static char buffer[4096];
+static int length;
+
+static void append(const char* text) {
+    length += snprintf(buffer + length, sizeof(buffer) - length, "%s", text);
+}
+
+// Random expression over A to E
+static void random_expression(int depth) {
+    const char* operators[] = {" AND ", " OR ", " XOR ", " IMPLIES ", " <==> "};
+    if (depth == 0 || rand() % 5 == 0) {
+        append(names[rand() % VARIABLE_COUNT]);
+    } else if (rand() % 5 == 0) {
+        append("NOT (");
+        random_expression(depth - 1);
+        append(")");
+    } else {
+        append("(");
+        random_expression(depth - 1);
+        append(operators[rand() % 5]);
+        random_expression(depth - 1);
+        append(")");
+    }
+}
+
+void test_random_expressions() {
+    printf("Testing random expressions\n");
+    int valid = 1;
+    srand(9);
+    for (int round = 0; round < 300 && valid; round++) {
+        length = 0;
+        random_expression(4);
+        valid = explain(buffer, rand() % (1 << VARIABLE_COUNT), 0) >= 0;
+        if (!valid) printf("  %s\n", buffer);
+    }
+    check(valid, "every explanation is a prime implicant of the outcome");
+    printf("\n");
+}
+
+void test_reuse() {
+    printf("Testing one explainer for several assignments\n");
+    Node* node = parse_test_statement("(A AND B) OR (C AND D)");
+    if (!node) return;
+    Explainer* explainer = create_explainer(node, NULL);
+    if (!explainer) {
+        free_ast(node);
+        check(0, "explainer created");
+        return;
+    }
+    SymbolTable* symbol_table = init_symbol_table();
+    for (int i = 0; i < 4; i++) add_or_update_symbol(symbol_table, names[i], 1);
+    Explanation explanation;
+    check(explain_statement(explainer, symbol_table, &explanation, NULL) == 0 && explanation.outcome == 1 &&
+          explanation.count == 2, "TRUE by one product");
+    add_or_update_symbol(symbol_table, "A", 0);
+    add_or_update_symbol(symbol_table, "C", 0);
+    check(explain_statement(explainer, symbol_table, &explanation, NULL) == 0 && explanation.outcome == 0 &&
+          explanation.count == 2, "FALSE by one input of each product");
+    free_symbol_table(symbol_table);
+    free_explainer(explainer);
+    free_ast(node);
+    printf("\n");
+}
+
+int main() {
+    test_known_explanations();
+    test_random_expressions();
+    test_reuse();
+
+    printf("%s\n", test_failures == 0 ? "All explainer tests passed" : "Explainer tests FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
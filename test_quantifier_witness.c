@@ -0,0 +1,194 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "C_Unlinked_Components/quantifier_witness.h"
+#include "test_helpers.h"
+
+static char buffer[8192];
+static int length;
+
+static void append(const char* text) {
+    length += snprintf(buffer + length, sizeof(buffer) - length, "%s", text);
+}
+
+// Random expression over the free variables A and B and the bound X, Y, Z
+static void random_expression(int depth) {
+    const char* leaves[] = {"A", "B", "X", "Y", "Z"};
+    const char* operators[] = {" AND ", " OR ", " XOR ", " IMPLIES ", " <==> "};
+    if (depth == 0 || rand() % 5 == 0) {
+        append(leaves[rand() % 5]);
+    } else if (rand() % 5 == 0) {
+        append("NOT (");
+        random_expression(depth - 1);
+        append(")");
+    } else {
+        append("(");
+        random_expression(depth - 1);
+        append(operators[rand() % 5]);
+        random_expression(depth - 1);
+        append(")");
+    }
+}
+
+// Value of body with the free values in symbol_table and the bound
+// variables names set to values
+static int body_value(const Node* body, SymbolTable* symbol_table, char** names, const int* values, int count) {
+    for (int i = 0; i < count; i++) add_or_update_symbol(symbol_table, names[i], values[i]);
+    return reference_value(body, symbol_table);
+}
+
+// The expression under the leading run of quantifiers
+static const Node* quantified_body(const Node* statement) {
+    NodeType type = statement->type;
+    while (statement->type == type && (type == NODE_EXISTS || type == NODE_FORALL)) statement = statement->left;
+    return statement;
+}
+
+// Check find_quantifier_witness on a block of quantifier over X, Y and Z
+// against enumerating the block
+static int check_block(const char* quantifier, int exists) {
+    const char* bound[] = {"X", "Y", "Z"};
+    length = 0;
+    for (int i = 0; i < 3; i++) {
+        append(quantifier);
+        append(bound[i]);
+        append(" (");
+    }
+    random_expression(4);
+    append(")))");
+    Node* statement = parse_test_statement(buffer);
+    if (!statement) return 0;
+    const Node* body = quantified_body(statement);
+
+    int valid = 1;
+    for (int free_values = 0; free_values < 4 && valid; free_values++) {
+        SymbolTable* symbol_table = init_symbol_table();
+        add_or_update_symbol(symbol_table, "A", free_values & 1);
+        add_or_update_symbol(symbol_table, "B", free_values >> 1);
+        QuantifierWitness result;
+        if (find_quantifier_witness(statement, symbol_table, &result, NULL) != 0) {
+            free_symbol_table(symbol_table);
+            valid = 0;
+            break;
+        }
+
+        // EXISTS is TRUE when some binding makes the body TRUE, FORALL is
+        // FALSE when some binding makes it FALSE
+        int found = 0;
+        int values[3];
+        char* names[3] = {"X", "Y", "Z"};
+        for (int binding = 0; binding < 8; binding++) {
+            for (int i = 0; i < 3; i++) values[i] = (binding >> i) & 1;
+            found |= body_value(body, symbol_table, names, values, 3) == exists;
+        }
+        int expected = exists ? found : !found;
+        valid = result.value == expected && result.has_binding == found && result.count == 3;
+        if (valid && result.has_binding) {
+            valid = body_value(body, symbol_table, result.names, result.values, result.count) == exists;
+        }
+        free_quantifier_witness(&result);
+        free_symbol_table(symbol_table);
+    }
+    if (!valid) printf("  %s\n", buffer);
+    free_ast(statement);
+    return valid;
+}
+
+void test_random_blocks() {
+    printf("Testing random quantifier blocks against enumeration\n");
+    int witnesses = 1, counterexamples = 1;
+    srand(13);
+    for (int round = 0; round < 150; round++) {
+        witnesses &= check_block("E_Q ", 1);
+        counterexamples &= check_block("U_Q ", 0);
+    }
+    check(witnesses, "witnesses make EXISTS bodies TRUE");
+    check(counterexamples, "counterexamples make FORALL bodies FALSE");
+    printf("\n");
+}
+
+// Witness of text under A = a, printing it
+static int witness(const char* text, int a, QuantifierWitness* result) {
+    printf("  %s with A = %s:", text, a ? "TRUE" : "FALSE");
+    Node* statement = parse_test_statement(text);
+    if (!statement) return -1;
+    SymbolTable* symbol_table = init_symbol_table();
+    add_or_update_symbol(symbol_table, "A", a);
+    char* error_message = NULL;
+    int status = find_quantifier_witness(statement, symbol_table, result, &error_message);
+    if (status != 0) {
+        printf(" Error: %s\n", error_message ? error_message : "Failed to find a witness");
+        free(error_message);
+    } else {
+        printf(" %s", result->value ? "TRUE" : "FALSE");
+        for (int i = 0; result->has_binding && i < result->count; i++) {
+            printf("%s %s = %s", i > 0 ? "," : " when", result->names[i], result->values[i] ? "TRUE" : "FALSE");
+        }
+        printf("\n");
+    }
+    free_symbol_table(symbol_table);
+    free_ast(statement);
+    return status;
+}
+
+void test_known_witnesses() {
+    printf("Testing witnesses\n");
+    QuantifierWitness result;
+    if (witness("E_Q X (E_Q Y (X AND NOT Y AND A))", 1, &result) == 0) {
+        check(result.value == 1 && result.has_binding && result.count == 2 && result.values[0] == 1 &&
+              result.values[1] == 0 && strcmp(result.names[0], "X") == 0, "the only witness");
+        free_quantifier_witness(&result);
+    }
+    if (witness("E_Q X (E_Q Y (X AND NOT Y AND A))", 0, &result) == 0) {
+        check(result.value == 0 && !result.has_binding, "a FALSE EXISTS has no witness");
+        free_quantifier_witness(&result);
+    }
+    if (witness("U_Q X (U_Q Y (X OR Y OR A))", 0, &result) == 0) {
+        check(result.value == 0 && result.has_binding && result.count == 2 && result.values[0] == 0 &&
+              result.values[1] == 0, "the only counterexample");
+        free_quantifier_witness(&result);
+    }
+    if (witness("E_Q X (U_Q Y (X OR Y))", 0, &result) == 0) {
+        check(result.value == 1 && result.has_binding && result.count == 1 && result.values[0] == 1,
+              "the block stops at the other kind of quantifier");
+        free_quantifier_witness(&result);
+    }
+    if (witness("A AND NOT A", 1, &result) == 0) {
+        check(result.value == 0 && !result.has_binding, "statements without quantifiers are evaluated");
+        free_quantifier_witness(&result);
+    }
+
+    // One witness among 2^24 bindings
+    length = 0;
+    for (int i = 0; i < 24; i++) {
+        char text[32];
+        snprintf(text, sizeof(text), "E_Q V%d (", i);
+        append(text);
+    }
+    for (int i = 0; i < 24; i++) {
+        char text[32];
+        snprintf(text, sizeof(text), "%s%sV%d", i > 0 ? " AND " : "", i % 2 ? "NOT " : "", i);
+        append(text);
+    }
+    for (int i = 0; i < 24; i++) append(")");
+    Node* statement = parse_test_statement(buffer);
+    if (statement) {
+        SymbolTable* symbol_table = init_symbol_table();
+        int found = find_quantifier_witness(statement, symbol_table, &result, NULL) == 0;
+        int matches = found && result.value == 1 && result.has_binding && result.count == 24;
+        for (int i = 0; matches && i < 24; i++) matches = result.values[i] == (i % 2 == 0);
+        check(matches, "a wide block");
+        if (found) free_quantifier_witness(&result);
+        free_symbol_table(symbol_table);
+        free_ast(statement);
+    }
+    printf("\n");
+}
+
+int main() {
+    test_known_witnesses();
+    test_random_blocks();
+
+    printf("%s\n", test_failures == 0 ? "All quantifier witness tests passed" : "Quantifier witness tests FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
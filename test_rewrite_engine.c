@@ -0,0 +1,127 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "C_Unlinked_Components/rewrite_engine.h"
+#include "test_helpers.h"
+
+static int count_nodes(const Node* node) {
+    if (!node) return 0;
+    return 1 + count_nodes(node->left) + count_nodes(node->right);
+}
+
+// Whether a and b agree on every assignment of the variables A to D
+static int same_function(const Node* a, const Node* b) {
+    const char* names[] = {"A", "B", "C", "D"};
+    for (int assignment = 0; assignment < 16; assignment++) {
+        SymbolTable* symbol_table = init_symbol_table();
+        for (int i = 0; i < 4; i++) add_or_update_symbol(symbol_table, names[i], (assignment >> i) & 1);
+        int same = reference_value(a, symbol_table) == reference_value(b, symbol_table);
+        free_symbol_table(symbol_table);
+        if (!same) return 0;
+    }
+    return 1;
+}
+
+static int has_step(const EvaluationSteps* steps, const char* rule) {
+    for (int i = 0; i < steps->step_count; i++) {
+        if (strstr(steps->steps[i]->step_description, rule)) return 1;
+    }
+    return 0;
+}
+
+// Normalize text, expecting the normal form expected and rule among the steps
+void test_rule(RewriteEngine* engine, const char* text, const char* expected, const char* rule) {
+    printf("Testing normal form of: %s\n", text);
+    Node* node = parse_test_statement(text);
+    if (!node) return;
+    EvaluationSteps* steps = init_evaluation_steps();
+    Node* normal = rewrite_to_normal_form(engine, node, steps);
+    char* result = normal ? node_to_string(normal) : NULL;
+    printf("  Result: %s\n", result ? result : "(null)");
+    check(result && strcmp(result, expected) == 0, expected);
+    check(has_step(steps, rule), rule);
+    free(result);
+    free_ast(normal);
+    free_evaluation_steps(steps);
+    free_ast(node);
+    printf("\n");
+}
+
+static char buffer[4096];
+static int length;
+
+static void append(const char* text) {
+    length += snprintf(buffer + length, sizeof(buffer) - length, "%s", text);
+}
+
+// Random expression over A to D, TRUE and FALSE
+static void random_expression(int depth) {
+    const char* leaves[] = {"A", "B", "C", "D", "TRUE", "FALSE"};
+    const char* operators[] = {" AND ", " OR ", " XOR ", " IMPLIES ", " <==> "};
+    if (depth == 0 || rand() % 4 == 0) {
+        append(leaves[rand() % 6]);
+    } else if (rand() % 5 == 0) {
+        append("NOT (");
+        random_expression(depth - 1);
+        append(")");
+    } else {
+        append("(");
+        random_expression(depth - 1);
+        append(operators[rand() % 5]);
+        random_expression(depth - 1);
+        append(")");
+    }
+}
+
+void test_random_expressions(RewriteEngine* engine) {
+    printf("Testing random expressions\n");
+    int equivalent = 1, smaller = 1, stable = 1;
+    srand(7);
+    for (int round = 0; round < 300; round++) {
+        length = 0;
+        random_expression(5);
+        Node* node = parse_test_statement(buffer);
+        if (!node) continue;
+        Node* normal = rewrite_to_normal_form(engine, node, NULL);
+        Node* again = normal ? rewrite_to_normal_form(engine, normal, NULL) : NULL;
+        if (!normal || !same_function(node, normal)) equivalent = 0;
+        if (normal && count_nodes(normal) > count_nodes(node)) smaller = 0;
+        if (normal && again) {
+            char* first = node_to_string(normal);
+            char* second = node_to_string(again);
+            if (!first || !second || strcmp(first, second) != 0) stable = 0;
+            free(first);
+            free(second);
+        }
+        free_ast(again);
+        free_ast(normal);
+        free_ast(node);
+    }
+    check(equivalent, "normal forms are equivalent to their input");
+    check(smaller, "normal forms never grow");
+    check(stable, "normal forms are fixpoints");
+    printf("\n");
+}
+
+int main() {
+    RewriteEngine* engine = create_rewrite_engine();
+    if (!engine) {
+        printf("Error: Failed to create the rewrite engine\n");
+        return 1;
+    }
+    test_rule(engine, "A AND TRUE", "A", "AND identity");
+    test_rule(engine, "NOT (NOT A)", "A", "Double negation");
+    test_rule(engine, "A OR NOT A", "TRUE", "OR complement");
+    test_rule(engine, "A AND (A OR B)", "A", "AND absorption");
+    test_rule(engine, "A OR (NOT A AND B)", "A OR B", "OR absorption of complement");
+    test_rule(engine, "NOT (A XOR B)", "A <-> B", "Negated XOR");
+    test_rule(engine, "(A AND B) OR (A AND C)", "A AND (B OR C)", "Distributive Law: AND over OR");
+    test_rule(engine, "(B OR FALSE) AND (A IMPLIES A)", "B", "Implication self");
+    int rewrites = get_rewrite_count(engine);
+    check(rewrites >= 8, "the engine counts its rewrites");
+    test_random_expressions(engine);
+    free_rewrite_engine(engine);
+
+    printf("%s\n", test_failures == 0 ? "All rewrite engine tests passed" : "Rewrite engine tests FAILED");
+    return test_failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,169 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "C_Unlinked_Components/sat_solver.h"
+#include "test_helpers.h"
+
+#define MAX_VARIABLES 64
+#define MAX_CLAUSES 512
+
+// Clauses of at most 3 literals, kept for checking models
+typedef struct {
+    int literals[MAX_CLAUSES][3];
+    int sizes[MAX_CLAUSES];
+    int count;
+} Clauses;
+
+static SATSolver* create_with_variables(int variable_count) {
+    SATSolver* solver = create_sat_solver();
+    if (!solver) return NULL;
+    for (int v = 0; v < variable_count; v++) {
+        if (sat_new_variable(solver) != v + 1) {
+            free_sat_solver(solver);
+            return NULL;
+        }
+    }
+    return solver;
+}
+
+static int clause_satisfied(const int* literals, int size, const int* values) {
+    for (int l = 0; l < size; l++) {
+        if (literals[l] > 0 ? values[literals[l]] : !values[-literals[l]]) return 1;
+    }
+    return 0;
+}
+
+// Exhaustive satisfiability of clauses over variable_count variables
+static int brute_force_satisfiable(const Clauses* clauses, int variable_count) {
+    int values[MAX_VARIABLES + 1];
+    for (long assignment = 0; assignment < (1L << variable_count); assignment++) {
+        for (int v = 1; v <= variable_count; v++) values[v] = (assignment >> (v - 1)) & 1;
+        int satisfied = 1;
+        for (int c = 0; c < clauses->count && satisfied; c++) {
+            satisfied = clause_satisfied(clauses->literals[c], clauses->sizes[c], values);
+        }
+        if (satisfied) return 1;
+    }
+    return 0;
+}
+
+static int model_satisfies(const SATSolver* solver, const Clauses* clauses, int variable_count) {
+    int values[MAX_VARIABLES + 1];
+    for (int v = 1; v <= variable_count; v++) values[v] = sat_model_value(solver, v);
+    for (int c = 0; c < clauses->count; c++) {
+        if (!clause_satisfied(clauses->literals[c], clauses->sizes[c], values)) return 0;
+    }
+    return 1;
+}
+
+void test_random_formulas() {
+    printf("Testing random 3-SAT formulas against exhaustive search\n");
+    enum { VARIABLES = 12 };
+    static Clauses clauses;
+    int agrees = 1, models = 1, satisfiable = 0, unsatisfiable = 0;
+    srand(11);
+    for (int round = 0; round < 300; round++) {
+        SATSolver* solver = create_with_variables(VARIABLES);
+        if (!solver) {
+            agrees = 0;
+            break;
+        }
+        // Around the threshold ratio of 4.26 both answers are common
+        clauses.count = 40 + rand() % 25;
+        for (int c = 0; c < clauses.count; c++) {
+            clauses.sizes[c] = 3;
+            for (int l = 0; l < 3; l++) {
+                int variable = 1 + rand() % VARIABLES;
+                clauses.literals[c][l] = rand() % 2 ? variable : -variable;
+            }
+            sat_add_clause(solver, clauses.literals[c], 3);
+        }
+        SATResult result = sat_solve(solver, NULL, 0, 0);
+        int expected = brute_force_satisfiable(&clauses, VARIABLES);
+        if (result != (expected ? SAT_SATISFIABLE : SAT_UNSATISFIABLE)) agrees = 0;
+        if (result == SAT_SATISFIABLE && !model_satisfies(solver, &clauses, VARIABLES)) models = 0;
+        satisfiable += expected;
+        unsatisfiable += !expected;
+        free_sat_solver(solver);
+    }
+    printf("  %d satisfiable, %d unsatisfiable\n", satisfiable, unsatisfiable);
+    check(agrees, "answers match exhaustive search");
+    check(models, "models satisfy every clause");
+    check(satisfiable > 0 && unsatisfiable > 0, "both answers occur");
+    printf("\n");
+}
+
+// Pigeon p sits in hole h: variable p * holes + h + 1
+static SATSolver* pigeonhole(int pigeons, int holes) {
+    SATSolver* solver = create_with_variables(pigeons * holes);
+    if (!solver) return NULL;
+    int clause[MAX_VARIABLES];
+    for (int p = 0; p < pigeons; p++) {
+        for (int h = 0; h < holes; h++) clause[h] = p * holes + h + 1;
+        sat_add_clause(solver, clause, holes);
+    }
+    for (int h = 0; h < holes; h++) {
+        for (int p = 0; p < pigeons; p++) {
+            for (int q = p + 1; q < pigeons; q++) {
+                int pair[2] = {-(p * holes + h + 1), -(q * holes + h + 1)};
+                sat_add_clause(solver, pair, 2);
+            }
+        }
+    }
+    return solver;
+}
+
+void test_pigeonhole() {
+    printf("Testing pigeonhole formulas\n");
+    SATSolver* solver = pigeonhole(6, 5);
+    check(solver && sat_solve(solver, NULL, 0, 0) == SAT_UNSATISFIABLE, "six pigeons do not fit five holes");
+    if (solver) free_sat_solver(solver);
+
+    solver = pigeonhole(5, 5);
+    check(solver && sat_solve(solver, NULL, 0, 0) == SAT_SATISFIABLE, "five pigeons fit five holes");
+    if (solver) free_sat_solver(solver);
+
+    solver = pigeonhole(9, 8);
+    check(solver && sat_solve(solver, NULL, 0, 10) == SAT_UNKNOWN, "the conflict limit stops the search");
+    if (solver) free_sat_solver(solver);
+    printf("\n");
+}
+
+void test_incremental() {
+    printf("Testing assumptions and added clauses\n");
+    SATSolver* solver = create_with_variables(3);
+    if (!solver) return;
+    int a_or_b[] = {1, 2};
+    int not_a_or_c[] = {-1, 3};
+    sat_add_clause(solver, a_or_b, 2);
+    sat_add_clause(solver, not_a_or_c, 2);
+
+    int assume_a_not_c[] = {1, -3};
+    check(sat_solve(solver, assume_a_not_c, 2, 0) == SAT_UNSATISFIABLE, "assumptions can make it unsatisfiable");
+    int assume_not_b[] = {-2};
+    check(sat_solve(solver, assume_not_b, 1, 0) == SAT_SATISFIABLE && sat_model_value(solver, 1) == 1 &&
+          sat_model_value(solver, 3) == 1, "the model follows from the assumptions");
+    check(sat_solve(solver, NULL, 0, 0) == SAT_SATISFIABLE, "assumptions only hold for one call");
+
+    int not_c[] = {-3};
+    sat_add_clause(solver, not_c, 1);
+    check(sat_solve(solver, NULL, 0, 0) == SAT_SATISFIABLE && sat_model_value(solver, 1) == 0 &&
+          sat_model_value(solver, 2) == 1, "clauses added between calls");
+    check(sat_solve(solver, assume_not_b, 1, 0) == SAT_UNSATISFIABLE, "learned and added clauses together");
+
+    int unknown[] = {4};
+    check(sat_add_clause(solver, unknown, 1) == -1, "unknown variables are rejected");
+    int variable = sat_new_variable(solver);
+    check(variable == 4, "variables are numbered in order");
+    free_sat_solver(solver);
+    printf("\n");
+}
+
+int main() {
+    test_random_formulas();
+    test_pigeonhole();
+    test_incremental();
+
+    printf("%s\n", test_failures == 0 ? "All SAT solver tests passed" : "SAT solver tests FAILED");
+    return test_failures == 0 ? 0 : 1;
+}